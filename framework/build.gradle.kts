@@ -90,6 +90,17 @@ android {
             // Release 配置
             buildConfigField("boolean", "FW_DEBUG", "false")
             buildConfigField("boolean", "FW_VERBOSE_LOG", "false")
+
+            // Native 优化：ThinLTO + gc-sections + ICF，存在 profile 时启用 PGO
+            // profile 由 src/main/cpp/bench/run_pgo.sh 生成
+            externalNativeBuild {
+                cmake {
+                    arguments += "-DFW_ENABLE_LTO=ON"
+                    if (file("src/main/cpp/pgo/fw_native.profdata").exists()) {
+                        arguments += "-DFW_PGO_MODE=USE"
+                    }
+                }
+            }
         }
     }
 
@@ -1,3 +1,9 @@
 # Consumer ProGuard rules for keeplive module
 -keep class com.keeplive.KeepLive { *; }
 -keep class com.keeplive.core.** { *; }
+
+# 由 Native 代码通过 JNI 构造（FindClass + GetMethodID("<init>")），
+# 应用开启混淆时不能重命名类或移除构造函数
+-keep class com.service.framework.native.FwParcelBuffer {
+    private <init>(long, java.nio.ByteBuffer);
+}
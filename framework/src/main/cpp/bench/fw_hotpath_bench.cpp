@@ -0,0 +1,557 @@
+/**
+ * ============================================================================
+ * fw_hotpath_bench.cpp - Native 热路径基准测试 / PGO 训练负载
+ * ============================================================================
+ *
+ * 功能简介：
+ *   直接链接 fw_native 的热路径源文件，循环执行以下负载并输出每次操作耗时：
+ *   - Parcel：写入接口 token + 整数 + 字符串，再完整读回（startService 形态）
+ *   - Parcel fd：写入 16 个 fd（dup）后取出一半、释放其余（批量关闭）
+ *   - Parcel 移动：内联 / 堆数据区 / 携带 fd 的 Parcel 移动构造与移动赋值，校验内容完整
+ *   - Parcel 外部缓冲区：writeBufferObject 往返，并校验接收侧（ipcSetDataReference）保留对象表
+ *   - Unicode：UTF-8 <-> UTF-16 长度计算与转换、String16 构造、分块流式解码
+ *   - Socket：send_heartbeat + receive_with_timeout 心跳往返
+ *   - RPC：fw_rpc_call 往返（Parcel 帧 + 服务线程），以及附带一个文件描述符的调用
+ *   - 日志：vsnprintf 格式化 与 令牌化编码（fw_tokenlog）单条开销对比
+ *   - 线程：每个任务 pthread_create + join 与 提交到 fw_worker_pool 的开销对比
+ *   - 状态板：读取一个进程槽位（与上面的心跳往返对比）
+ *   - 事件总线：发布一个事件并由一个订阅者取出
+ *   - Binder 超时恢复：同步事务超时 -> 单向事务 -> 同步事务（迟到回复的清理），
+ *     需要 /dev/binder，主机上跳过
+ *
+ *   该程序同时是 PGO 的训练负载（见 run_pgo.sh）：使用 -fprofile-generate
+ *   构建后在设备上运行，生成的 .profraw 合并后用于 -fprofile-use 重新构建。
+ *
+ * 用法：
+ *   fw_hotpath_bench [迭代次数=200000]
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <utility>
+
+#include "cParcel.h"
+#include "data_transact.h"
+#include "fw_event_bus.h"
+#include "fw_rpc.h"
+#include "fw_service_prefetch.h"
+#include "fw_status_board.h"
+#include "fw_tokenlog.h"
+#include "fw_worker_pool.h"
+#include "String16.h"
+#include "Unicode.h"
+
+using namespace android;
+
+// fw_socket.cpp
+extern "C" bool send_heartbeat(int socket_fd);
+extern "C" int receive_with_timeout(int socket_fd, char* buffer, int buffer_size, int timeout_ms);
+
+// 防止编译器消除无副作用的计算
+static volatile uint64_t g_sink = 0;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void report(const char* name, int64_t elapsed_ns, int iterations) {
+    printf("%-18s %10.1f ns/op  (%d ops, %.1f ms)\n",
+           name, (double) elapsed_ns / iterations, iterations, elapsed_ns / 1e6);
+    fflush(stdout);
+}
+
+// ==================== Parcel ====================
+
+static void bench_parcel(int iterations) {
+    const String16 token("android.app.IActivityManager");
+    const String16 package("com.service.framework");
+    uint64_t sum = 0;
+
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        Parcel data;
+        data.writeInterfaceToken(token);
+        data.writeInt32(0);
+        data.writeString16(package);
+        data.writeInt32(i);
+        data.writeInt64(i * 31LL);
+        data.writeCString("com.service.framework.service.FwForegroundService");
+
+        data.setDataPosition(0);
+        sum += data.readInt32();
+        size_t len = 0;
+        const Char16* str = data.readString16Inplace(&len);
+        sum += len + (str != nullptr ? str[0] : 0);
+        sum += data.readInt32();
+        String16 pkg = data.readString16();
+        sum += pkg.size();
+        sum += data.readInt32();
+        sum += data.readInt64();
+        const char* cstr = data.readCString();
+        sum += cstr != nullptr ? cstr[0] : 0;
+    }
+    report("parcel write+read", monotonic_ns() - start, iterations);
+    g_sink += sum;
+}
+
+static void bench_parcel_fds(int iterations) {
+    int fds[2];
+    if (pipe(fds) != 0) return;
+    uint64_t sum = 0;
+
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        Parcel data;
+        for (int j = 0; j < 16; j++) data.writeDupFileDescriptor(fds[j & 1]);
+        data.setDataPosition(0);
+        for (int j = 0; j < 8; j++) {
+            int fd = data.takeFileDescriptor();
+            if (fd >= 0) close(fd);
+        }
+        sum += data.fileDescriptorCount();
+    }
+    report("parcel 16 fds", monotonic_ns() - start, iterations);
+    g_sink += sum;
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * 移动后目标内容与源一致、源为空；覆盖内联（含越过 mDataSize 的数据位置）、
+ * 堆数据区和携带 fd 三种情况
+ */
+static void bench_parcel_move(int iterations) {
+    int fds[2];
+    if (pipe(fds) != 0) return;
+    uint64_t sum = 0;
+    int failures = 0;
+
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        // 内联：数据位置越过 mDataSize 后移动，dataSize() 不变
+        Parcel small;
+        small.writeInt32(i);
+        small.writeInt64(i * 31LL);
+        small.setDataPosition(small.dataSize() + 16);
+        const size_t smallSize = small.dataSize();
+        Parcel movedSmall(std::move(small));
+        bool ok = small.dataSize() == 0 && movedSmall.dataSize() == smallSize;
+        movedSmall.setDataPosition(0);
+        ok = ok && movedSmall.readInt32() == i && movedSmall.readInt64() == i * 31LL;
+
+        // 堆数据区 + fd：移动赋值转移数据区和 fd 所有权
+        Parcel large;
+        for (int j = 0; j < 96; j++) large.writeInt32(i + j);
+        large.writeDupFileDescriptor(fds[0]);
+        Parcel movedLarge;
+        movedLarge.writeInt32(-1);
+        movedLarge = std::move(large);
+        ok = ok && large.dataSize() == 0 && large.fileDescriptorCount() == 0
+             && movedLarge.fileDescriptorCount() == 1;
+        movedLarge.setDataPosition(0);
+        for (int j = 0; j < 96; j++) ok = ok && movedLarge.readInt32() == i + j;
+        const int fd = movedLarge.takeFileDescriptor();
+        ok = ok && fd >= 0;
+        if (fd >= 0) close(fd);
+
+        if (!ok) failures++;
+        sum += movedSmall.dataSize() + movedLarge.dataSize();
+    }
+    report("parcel move", monotonic_ns() - start, iterations);
+    if (failures > 0) {
+        printf("  Parcel 移动校验失败 %d 次\n", failures);
+    }
+    g_sink += sum;
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static void noop_release(Parcel*, const uint8_t*, size_t, const binder_size_t*, size_t, void*) {
+}
+
+/**
+ * binder_buffer_object 占 40 字节：写入后读回的整数不能错位，
+ * 接收侧按对象实际大小校验偏移，不能丢弃对象表
+ */
+static void bench_parcel_buffer_object(int iterations) {
+    uint8_t payload[64];
+    memset(payload, 0x5a, sizeof(payload));
+    uint64_t sum = 0;
+    int failures = 0;
+
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        Parcel data;
+        data.writeInt32(i);
+        data.writeBufferObject(payload, sizeof(payload));
+        data.writeInt32(-i);
+
+        data.setDataPosition(0);
+        bool ok = data.readInt32() == i;
+        const size_t objPos = data.dataPosition();
+        ok = ok && data.readObject(false) == nullptr && data.dataPosition() == objPos;
+        const binder_buffer_object* obj = data.readBufferObject();
+        ok = ok && obj != nullptr && obj->buffer == reinterpret_cast<binder_uintptr_t>(payload)
+             && obj->length == sizeof(payload);
+        ok = ok && data.readInt32() == -i;
+
+        // 接收侧：直接引用发送侧的数据区和对象表
+        Parcel reply;
+        reply.ipcSetDataReference(reinterpret_cast<const uint8_t*>(data.ipcData()),
+                                  data.ipcDataSize(),
+                                  reinterpret_cast<const binder_size_t*>(data.ipcObjects()),
+                                  data.ipcObjectsCount(), noop_release, nullptr);
+        ok = ok && reply.ipcObjectsCount() == data.ipcObjectsCount()
+             && reply.ipcBuffersSize() == sizeof(payload);
+        reply.setDataPosition(objPos);
+        ok = ok && reply.readBufferObject() != nullptr && reply.readInt32() == -i;
+
+        // 与 40 字节对象重叠的偏移（按 24 字节计算会被放过）必须整体拒绝
+        const binder_size_t overlapping[2] = {objPos, objPos + sizeof(flat_binder_object)};
+        Parcel bad;
+        bad.ipcSetDataReference(reinterpret_cast<const uint8_t*>(data.ipcData()),
+                                data.ipcDataSize(), overlapping, 2, noop_release, nullptr);
+        ok = ok && bad.ipcObjectsCount() == 0;
+
+        if (!ok) failures++;
+        sum += data.dataSize();
+    }
+    report("parcel buffer obj", monotonic_ns() - start, iterations);
+    if (failures > 0) {
+        printf("  外部缓冲区往返校验失败 %d 次\n", failures);
+    }
+    g_sink += sum;
+}
+
+// ==================== Unicode ====================
+
+static void bench_unicode(int iterations) {
+    static const char kText[] =
+            "com.service.framework.service.FwForegroundService "
+            "前台服务保活 / MediaRoute 保活 / Binder 直接调用 ✓ 𝄞";
+    const size_t text_len = strlen(kText);
+    Char16 utf16[256];
+    char utf8[512];
+    uint64_t sum = 0;
+
+    int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        ssize_t u16_len = utf8_to_utf16_length((const uint8_t*) kText, text_len);
+        if (u16_len < 0 || (size_t) u16_len >= sizeof(utf16) / sizeof(utf16[0])) abort();
+        utf8_to_utf16((const uint8_t*) kText, text_len, utf16, u16_len + 1);
+
+        ssize_t u8_len = utf16_to_utf8_length(utf16, u16_len);
+        if (u8_len < 0 || (size_t) u8_len >= sizeof(utf8)) abort();
+        utf16_to_utf8(utf16, u16_len, utf8, u8_len + 1);
+        sum += u16_len + u8_len + (uint8_t) utf8[i % u8_len];
+    }
+    report("utf8<->utf16", monotonic_ns() - start, iterations);
+
+    start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        String16 str(kText);
+        sum += str.size();
+    }
+    report("String16(utf8)", monotonic_ns() - start, iterations);
+
+    // 按 7 字节分块流式解码（模拟 socket 读取在字符中间截断），结果与整块转换一致
+    ssize_t block_len = utf8_to_utf16_length((const uint8_t*) kText, text_len);
+    utf8_to_utf16((const uint8_t*) kText, text_len, utf16, block_len + 1);
+    start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        Char16 streamed[256];
+        size_t out = 0;
+        utf8_stream_t state;
+        utf8_stream_init(&state);
+        for (size_t off = 0; off < text_len; off += 7) {
+            size_t chunk = text_len - off < 7 ? text_len - off : 7;
+            out += utf8_stream_decode(&state, (const uint8_t*) kText + off, chunk, nullptr,
+                                      streamed + out, sizeof(streamed) / sizeof(streamed[0]) - out);
+        }
+        out += utf8_stream_finish(&state, streamed + out, sizeof(streamed) / sizeof(streamed[0]) - out);
+        if ((ssize_t) out != block_len || memcmp(streamed, utf16, out * sizeof(Char16)) != 0) abort();
+        sum += out + streamed[i % out];
+    }
+    report("utf8 stream 7B chunks", monotonic_ns() - start, iterations);
+    g_sink += sum;
+}
+
+// ==================== Socket ====================
+
+static void bench_socket(int iterations) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        perror("socketpair");
+        return;
+    }
+
+    char buffer[64];
+    int received = 0;
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        if (!send_heartbeat(sv[0])) break;
+        if (receive_with_timeout(sv[1], buffer, sizeof(buffer), 1000) > 0) {
+            received++;
+        }
+    }
+    report("heartbeat rtt", monotonic_ns() - start, iterations);
+    g_sink += received;
+
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// ==================== RPC ====================
+
+#define RPC_METHOD_ECHO 1
+#define RPC_METHOD_FSTAT 2
+
+static status_t rpc_handler(uint32_t method, const Parcel& data, Parcel* reply, void* cookie) {
+    (void) cookie;
+    switch (method) {
+        case RPC_METHOD_ECHO:
+            reply->writeInt32(data.readInt32() + 1);
+            reply->writeString16(data.readString16());
+            return NO_ERROR;
+        case RPC_METHOD_FSTAT: {
+            int fd = data.readFileDescriptor();
+            reply->writeInt32(fd >= 0 ? fcntl(fd, F_GETFD) : -1);
+            return NO_ERROR;
+        }
+        default:
+            return UNKNOWN_TRANSACTION;
+    }
+}
+
+static void* rpc_server(void* arg) {
+    int fd = *static_cast<int*>(arg);
+    while (fw_rpc_serve_one(fd, rpc_handler, nullptr, -1) == NO_ERROR) {
+    }
+    return nullptr;
+}
+
+static void bench_rpc(int iterations) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        perror("socketpair");
+        return;
+    }
+    pthread_t server;
+    pthread_create(&server, nullptr, rpc_server, &sv[1]);
+
+    const String16 package("com.service.framework");
+    uint64_t sum = 0;
+    int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        Parcel data, reply;
+        data.writeInt32(i);
+        data.writeString16(package);
+        if (fw_rpc_call(sv[0], RPC_METHOD_ECHO, data, &reply, 1000) != NO_ERROR) abort();
+        sum += reply.readInt32();
+        sum += reply.readString16().size();
+    }
+    report("rpc call", monotonic_ns() - start, iterations);
+
+    start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        Parcel data, reply;
+        data.writeFileDescriptor(sv[0]);
+        if (fw_rpc_call(sv[0], RPC_METHOD_FSTAT, data, &reply, 1000) != NO_ERROR) abort();
+        sum += reply.readInt32();
+    }
+    report("rpc call + fd", monotonic_ns() - start, iterations);
+    g_sink += sum;
+
+    shutdown(sv[0], SHUT_RDWR);
+    pthread_join(server, nullptr);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// ==================== 日志 ====================
+
+static void bench_log(int iterations) {
+    static constexpr char kFormat[] = "服务 %s 心跳超时 %d ms, 重试 %d/%d, 间隔 %.1f s";
+    const char* service = "com.service.framework.service.FwForegroundService";
+    char buffer[256];
+    uint64_t sum = 0;
+
+    // 文本日志的主要开销：每条都在调用线程上完整格式化
+    int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        sum += snprintf(buffer, sizeof(buffer), kFormat, service, i, i & 3, 3, 1.5);
+    }
+    report("log snprintf", monotonic_ns() - start, iterations);
+
+    // 令牌化：令牌在编译期求出，运行时只编码参数并写入环形缓冲区
+    constexpr uint32_t kTagToken = fw::tokenlog::hash("FwBench");
+    constexpr uint32_t kFormatToken = fw::tokenlog::hash(kFormat);
+    start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        fw::tokenlog::write(ANDROID_LOG_WARN, kTagToken, kFormatToken, service, i, i & 3, 3, 1.5);
+    }
+    report("log tokenized", monotonic_ns() - start, iterations);
+    g_sink += sum;
+}
+
+static void* noop_thread(void* arg) {
+    g_sink += (uintptr_t) arg;
+    return nullptr;
+}
+
+struct TaskLatch {
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    int remaining = 0;
+};
+
+static void latch_task(void* arg) {
+    TaskLatch* latch = static_cast<TaskLatch*>(arg);
+    pthread_mutex_lock(&latch->lock);
+    if (--latch->remaining == 0) pthread_cond_signal(&latch->cond);
+    pthread_mutex_unlock(&latch->lock);
+}
+
+static void bench_threads(int iterations) {
+    // 每个短任务新建一个线程（默认栈属性）
+    int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, noop_thread, (void*) (uintptr_t) i) == 0) {
+            pthread_join(thread, nullptr);
+        }
+    }
+    report("thread create", monotonic_ns() - start, iterations);
+
+    // 提交到线程池，复用空闲线程
+    fw_worker_pool* pool = fw_worker_pool_create("fw_bench", "bench_pool", 2,
+                                                 64 * 1024, -1);
+    TaskLatch latch;
+    start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        pthread_mutex_lock(&latch.lock);
+        latch.remaining = 1;
+        pthread_mutex_unlock(&latch.lock);
+        fw_worker_pool_submit(pool, latch_task, &latch);
+        pthread_mutex_lock(&latch.lock);
+        while (latch.remaining > 0) pthread_cond_wait(&latch.cond, &latch.lock);
+        pthread_mutex_unlock(&latch.lock);
+    }
+    report("thread pool", monotonic_ns() - start, iterations);
+    fw_worker_pool_destroy(pool);
+}
+
+// ==================== 状态板 ====================
+
+static void bench_status_board(int iterations) {
+    if (!fw_status_board_create()) return;
+    const int slot = fw_status_board_claim("fw_bench");
+    if (slot < 0) return;
+
+    int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        fw_status_board_beat();
+    }
+    report("status board beat", monotonic_ns() - start, iterations);
+
+    fw_status_snapshot snapshot;
+    start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        if (fw_status_board_read(slot, &snapshot)) g_sink += snapshot.heartbeat;
+    }
+    report("status board read", monotonic_ns() - start, iterations);
+    fw_status_board_release();
+}
+
+// ==================== 事件总线 ====================
+
+static void bench_event_bus(int iterations) {
+    fw_event_subscriber* subscriber = fw_event_subscribe(fw_event_mask<fw_socket_event>(),
+                                                         "fw_bench");
+    if (subscriber == nullptr) return;
+
+    fw_event events[16];
+    int received = 0;
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        fw_event_publish(fw_socket_event{FW_SOCKET_EVENT_CLIENT_CONNECTED, i});
+        if ((i & 15) == 15) received += fw_event_poll(subscriber, events, 16);
+    }
+    received += fw_event_poll(subscriber, events, 16);
+    report("event publish+poll", monotonic_ns() - start, iterations);
+    g_sink += received;
+    fw_event_unsubscribe(subscriber);
+}
+
+// ==================== Binder 超时恢复 ====================
+
+#define SM_CHECK_SERVICE_TRANSACTION    1
+#define SM_PING_TRANSACTION             0x5f504e47  // '_PNG'
+
+/**
+ * 超时放弃的同步事务的回复迟到，可能在之后的单向事务进行中到达；
+ * 之后的同步事务必须仍然成功（迟到回复被计数并释放）
+ */
+static void bench_binder_timeout_recovery(int iterations) {
+    int driverFD = open_driver();
+    if (driverFD < 0) {
+        printf("%-18s 跳过（无法打开 /dev/binder）\n", "binder recovery");
+        return;
+    }
+    void* vmStart = MAP_FAILED;
+    initProcessState(driverFD, vmStart);
+
+    Parcel query;
+    fw_service_write_check(query, "activity");
+    const Parcel ping;
+    int failures = 0;
+
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < iterations; i++) {
+        // 截止时间为 0：事务写入驱动后立即超时，ServiceManager 的回复随后到达
+        Parcel abandoned;
+        write_transact_timeout(0, SM_CHECK_SERVICE_TRANSACTION, query, &abandoned, 0, driverFD, 0);
+        write_transact_timeout(0, SM_PING_TRANSACTION, ping, nullptr, TF_ONE_WAY, driverFD,
+                               BINDER_NO_TIMEOUT);
+        if (fw_service_check(query, "activity", driverFD) == 0) failures++;
+    }
+    report("binder recovery", monotonic_ns() - start, iterations);
+    if (failures > 0) {
+        printf("  超时后的同步事务失败 %d 次\n", failures);
+    }
+    unInitProcessState(driverFD, vmStart);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    if (iterations <= 0) iterations = 200000;
+
+    bench_parcel(iterations);
+    bench_parcel_fds(iterations / 10 > 0 ? iterations / 10 : 1);
+    bench_parcel_move(iterations / 10 > 0 ? iterations / 10 : 1);
+    bench_parcel_buffer_object(iterations);
+    bench_unicode(iterations);
+    // 心跳路径包含系统调用和日志输出，迭代次数相应减少
+    bench_socket(iterations / 10 > 0 ? iterations / 10 : 1);
+    bench_rpc(iterations / 10 > 0 ? iterations / 10 : 1);
+    bench_log(iterations);
+    bench_threads(iterations / 100 > 0 ? iterations / 100 : 1);
+    bench_status_board(iterations);
+    bench_event_bus(iterations);
+    bench_binder_timeout_recovery(iterations / 1000 > 0 ? iterations / 1000 : 1);
+    return g_sink == 0xFFFFFFFFFFFFFFFFULL ? 1 : 0;
+}
@@ -0,0 +1,540 @@
+/**
+ * ============================================================================
+ * fw_liveness_bench.cpp - 进程存活检测机制基准测试
+ * ============================================================================
+ *
+ * 功能简介：
+ *   对比项目中（以及候选的）各种进程死亡检测机制的检测延迟和空闲开销，
+ *   为崩溃上报监督进程选择检测机制提供数据。
+ *
+ * 测试的机制：
+ *   1. poll-Nms   : fw_daemon.cpp is_process_alive 的 stat(/proc/pid) + kill(pid, 0) 轮询
+ *   2. pidfd      : pidfd_open + poll(POLLIN)，进程退出时可读（Linux 5.3+）
+ *   3. socket     : fw_socket.cpp 的 socket 断开检测，epoll 等待 EPOLLRDHUP
+ *   4. flock      : fw_force_stop.cpp 的文件锁阻塞等待
+ *   5. pdeathsig  : 子进程 prctl(PR_SET_PDEATHSIG)，父进程死亡时收到信号
+ *
+ * 测量方法：
+ *   - 检测延迟：kill(SIGKILL) 前记录 CLOCK_MONOTONIC，检测方记录检测到的时刻，
+ *     两者之差即为检测延迟。每种机制重复 N 次，随机化 kill 时机以覆盖轮询相位。
+ *   - 空闲开销：目标进程存活期间，检测方线程在 W 秒内消耗的 CPU 时间
+ *     （CLOCK_THREAD_CPUTIME_ID），折算为每小时 CPU 毫秒数，同时统计唤醒次数。
+ *
+ * 用法：
+ *   fw_liveness_bench [每种机制的测量次数=10] [空闲测量秒数=3]
+ *
+ * 注意：
+ *   - 被杀进程由本进程在 kill 后立即 waitpid 回收，与设备上 zygote/init
+ *     及时回收的行为一致（否则僵尸进程会让 kill(pid, 0) 继续返回成功）。
+ *   - 不依赖 Android 库，可在主机和设备上运行。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/file.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#ifndef __NR_pidfd_open
+#if defined(__x86_64__) || defined(__aarch64__) || defined(__arm__) || defined(__i386__)
+#define __NR_pidfd_open 434
+#endif
+#endif
+
+// ==================== 公共工具 ====================
+
+enum Mechanism {
+    MECH_POLL,
+    MECH_PIDFD,
+    MECH_SOCKET,
+    MECH_FLOCK,
+    MECH_PDEATHSIG,
+};
+
+struct BenchCase {
+    const char* name;
+    Mechanism mechanism;
+    int poll_interval_ms;   // 仅 MECH_POLL 使用
+};
+
+struct Sample {
+    int64_t latency_ns;     // 检测延迟，<0 表示该机制不可用
+    int64_t cpu_ns;         // 等待期间消耗的 CPU 时间
+    int64_t wait_ns;        // 等待期间的墙钟时间
+    uint64_t wakeups;       // 等待期间的唤醒次数
+};
+
+static char g_lock_dir[256] = {0};
+
+static int64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t monotonic_ns() {
+    return now_ns(CLOCK_MONOTONIC);
+}
+
+static int64_t thread_cpu_ns() {
+    return now_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+static void sleep_ns(int64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000LL;
+    ts.tv_nsec = ns % 1000000000LL;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static bool write_full(int fd, const void* buf, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool read_full(int fd, void* buf, size_t len) {
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * 与 fw_daemon.cpp 中 is_process_alive 相同的检测逻辑
+ */
+static bool is_process_alive(pid_t pid) {
+    char proc_path[64];
+    snprintf(proc_path, sizeof(proc_path), "/proc/%d", pid);
+
+    struct stat st;
+    if (stat(proc_path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        return true;
+    }
+    return kill(pid, 0) == 0;
+}
+
+static int pidfd_open_compat(pid_t pid) {
+#ifdef __NR_pidfd_open
+    return (int) syscall(__NR_pidfd_open, pid, 0);
+#else
+    (void) pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// ==================== 被监控进程 ====================
+
+/**
+ * 被监控进程的上下文
+ */
+struct Victim {
+    pid_t pid = -1;
+    int socket_fd = -1;         // MECH_SOCKET: 监控方持有的一端
+    int pdeath_pipe = -1;       // MECH_PDEATHSIG: 读取子进程上报的检测结果
+    char lock_path[320] = {0};  // MECH_FLOCK: 锁文件路径
+};
+
+/**
+ * PR_SET_PDEATHSIG 检测子进程
+ *
+ * 设置父进程死亡信号后阻塞在 sigwaitinfo，收到信号时通过管道上报
+ * 检测时刻和等待期间的 CPU 开销。
+ */
+static void pdeath_watcher_main(pid_t parent, int ready_fd, int report_fd) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &set, nullptr);
+
+    if (prctl(PR_SET_PDEATHSIG, SIGUSR1) != 0 || getppid() != parent) {
+        _exit(1);
+    }
+
+    char ready = 'R';
+    write_full(ready_fd, &ready, 1);
+    close(ready_fd);
+
+    const int64_t cpu0 = thread_cpu_ns();
+    const int64_t wait0 = monotonic_ns();
+    siginfo_t info;
+    while (sigwaitinfo(&set, &info) < 0 && errno == EINTR) {
+    }
+
+    Sample sample;
+    const int64_t detected = monotonic_ns();
+    sample.latency_ns = detected;   // 由主进程换算成延迟
+    sample.cpu_ns = thread_cpu_ns() - cpu0;
+    sample.wait_ns = detected - wait0;
+    sample.wakeups = 1;
+    write_full(report_fd, &sample, sizeof(sample));
+    _exit(0);
+}
+
+/**
+ * 创建被监控进程
+ *
+ * 子进程完成机制相关的准备（加锁、创建检测子进程等）后通过管道通知就绪，
+ * 之后一直阻塞直到被 SIGKILL。
+ */
+static bool spawn_victim(Mechanism mechanism, Victim* victim) {
+    int ready_pipe[2];
+    if (pipe(ready_pipe) != 0) return false;
+
+    int sv[2] = {-1, -1};
+    if (mechanism == MECH_SOCKET && socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        return false;
+    }
+
+    int report_pipe[2] = {-1, -1};
+    if (mechanism == MECH_PDEATHSIG && pipe(report_pipe) != 0) {
+        return false;
+    }
+
+    if (mechanism == MECH_FLOCK) {
+        snprintf(victim->lock_path, sizeof(victim->lock_path), "%s/fw_liveness_%d.lock",
+                 g_lock_dir, getpid());
+        int fd = open(victim->lock_path, O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+        if (fd < 0) return false;
+        close(fd);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) return false;
+
+    if (pid == 0) {
+        // ===== 被监控进程 =====
+        close(ready_pipe[0]);
+        if (sv[0] >= 0) close(sv[0]);
+
+        if (mechanism == MECH_FLOCK) {
+            int fd = open(victim->lock_path, O_RDONLY);
+            if (fd < 0 || flock(fd, LOCK_EX) != 0) _exit(1);
+        }
+
+        if (mechanism == MECH_PDEATHSIG) {
+            close(report_pipe[0]);
+            pid_t self = getpid();
+            pid_t watcher = fork();
+            if (watcher < 0) _exit(1);
+            if (watcher == 0) {
+                pdeath_watcher_main(self, ready_pipe[1], report_pipe[1]);
+            }
+            close(report_pipe[1]);
+            // 检测子进程自己通知就绪
+            close(ready_pipe[1]);
+        } else {
+            char ready = 'R';
+            write_full(ready_pipe[1], &ready, 1);
+            close(ready_pipe[1]);
+        }
+
+        for (;;) {
+            pause();
+        }
+    }
+
+    // ===== 基准测试进程 =====
+    close(ready_pipe[1]);
+    if (sv[1] >= 0) close(sv[1]);
+    if (report_pipe[1] >= 0) close(report_pipe[1]);
+
+    char ready = 0;
+    bool ok = read_full(ready_pipe[0], &ready, 1);
+    close(ready_pipe[0]);
+
+    victim->pid = pid;
+    victim->socket_fd = sv[0];
+    victim->pdeath_pipe = report_pipe[0];
+
+    if (!ok) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        return false;
+    }
+    return true;
+}
+
+static void cleanup_victim(Victim* victim) {
+    if (victim->socket_fd >= 0) close(victim->socket_fd);
+    if (victim->pdeath_pipe >= 0) close(victim->pdeath_pipe);
+    if (victim->lock_path[0] != '\0') unlink(victim->lock_path);
+    victim->socket_fd = -1;
+    victim->pdeath_pipe = -1;
+}
+
+// ==================== 检测线程 ====================
+
+struct WatchContext {
+    const BenchCase* bench;
+    Victim* victim;
+    std::atomic<bool> waiting{false};   // 检测线程已进入等待
+    Sample sample{};
+};
+
+static void* watcher_thread(void* arg) {
+    WatchContext* ctx = static_cast<WatchContext*>(arg);
+    const pid_t pid = ctx->victim->pid;
+    uint64_t wakeups = 0;
+    bool ok = true;
+
+    // 先完成与等待无关的准备工作，再开始计量
+    int wait_fd = -1;
+    int epfd = -1;
+    switch (ctx->bench->mechanism) {
+        case MECH_PIDFD:
+            wait_fd = pidfd_open_compat(pid);
+            ok = wait_fd >= 0;
+            break;
+        case MECH_SOCKET: {
+            epfd = epoll_create1(EPOLL_CLOEXEC);
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLRDHUP | EPOLLIN;
+            ev.data.fd = ctx->victim->socket_fd;
+            ok = epfd >= 0 && epoll_ctl(epfd, EPOLL_CTL_ADD, ctx->victim->socket_fd, &ev) == 0;
+            break;
+        }
+        case MECH_FLOCK:
+            wait_fd = open(ctx->victim->lock_path, O_RDONLY | O_CLOEXEC);
+            ok = wait_fd >= 0;
+            break;
+        default:
+            break;
+    }
+
+    const int64_t cpu0 = thread_cpu_ns();
+    const int64_t wait0 = monotonic_ns();
+    ctx->waiting.store(true, std::memory_order_release);
+
+    if (ok) {
+        switch (ctx->bench->mechanism) {
+            case MECH_POLL: {
+                const useconds_t interval_us = ctx->bench->poll_interval_ms * 1000;
+                for (;;) {
+                    usleep(interval_us);
+                    wakeups++;
+                    if (!is_process_alive(pid)) break;
+                }
+                break;
+            }
+            case MECH_PIDFD: {
+                struct pollfd pfd = {wait_fd, POLLIN, 0};
+                while (poll(&pfd, 1, -1) < 0 && errno == EINTR) {
+                }
+                wakeups++;
+                break;
+            }
+            case MECH_SOCKET: {
+                struct epoll_event ev;
+                while (epoll_wait(epfd, &ev, 1, -1) < 0 && errno == EINTR) {
+                }
+                wakeups++;
+                break;
+            }
+            case MECH_FLOCK:
+                while (flock(wait_fd, LOCK_EX) != 0 && errno == EINTR) {
+                }
+                wakeups++;
+                break;
+            default:
+                ok = false;
+                break;
+        }
+    }
+
+    const int64_t detected = monotonic_ns();
+    ctx->sample.latency_ns = ok ? detected : -1;
+    ctx->sample.cpu_ns = thread_cpu_ns() - cpu0;
+    ctx->sample.wait_ns = detected - wait0;
+    ctx->sample.wakeups = wakeups;
+
+    if (wait_fd >= 0) close(wait_fd);
+    if (epfd >= 0) close(epfd);
+    return nullptr;
+}
+
+// ==================== 单次测量 ====================
+
+/**
+ * 执行一次测量
+ *
+ * @param settle_ns kill 前的等待时间（空闲开销测量时即为测量窗口）
+ */
+static bool run_once(const BenchCase& bench, int64_t settle_ns, Sample* out) {
+    Victim victim;
+    if (!spawn_victim(bench.mechanism, &victim)) {
+        fprintf(stderr, "[%s] 创建被监控进程失败: %s\n", bench.name, strerror(errno));
+        cleanup_victim(&victim);
+        return false;
+    }
+
+    WatchContext ctx;
+    ctx.bench = &bench;
+    ctx.victim = &victim;
+
+    pthread_t thread;
+    bool use_thread = bench.mechanism != MECH_PDEATHSIG;
+    if (use_thread) {
+        if (pthread_create(&thread, nullptr, watcher_thread, &ctx) != 0) {
+            kill(victim.pid, SIGKILL);
+            waitpid(victim.pid, nullptr, 0);
+            cleanup_victim(&victim);
+            return false;
+        }
+        while (!ctx.waiting.load(std::memory_order_acquire)) {
+            sched_yield();
+        }
+    }
+
+    sleep_ns(settle_ns);
+
+    const int64_t kill_ns = monotonic_ns();
+    kill(victim.pid, SIGKILL);
+    waitpid(victim.pid, nullptr, 0);
+
+    if (use_thread) {
+        pthread_join(thread, nullptr);
+    } else {
+        ctx.sample.latency_ns = -1;
+        if (!read_full(victim.pdeath_pipe, &ctx.sample, sizeof(ctx.sample))) {
+            ctx.sample.latency_ns = -1;
+        }
+        // 回收检测子进程（已被 init 或 subreaper 收养，这里只做尽力回收）
+        while (waitpid(-1, nullptr, WNOHANG) > 0) {
+        }
+    }
+
+    cleanup_victim(&victim);
+
+    *out = ctx.sample;
+    if (out->latency_ns >= 0) {
+        out->latency_ns -= kill_ns;
+    }
+    return out->latency_ns >= 0;
+}
+
+// ==================== 统计输出 ====================
+
+static double percentile_us(std::vector<int64_t>& values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t idx = (size_t) (p * (values.size() - 1) + 0.5);
+    return values[idx] / 1000.0;
+}
+
+static void run_case(const BenchCase& bench, int runs, int idle_seconds) {
+    std::vector<int64_t> latencies;
+    latencies.reserve(runs);
+
+    for (int i = 0; i < runs; i++) {
+        // 随机化 kill 时机，覆盖轮询的整个相位
+        int64_t settle_ns = 5 * 1000000LL;
+        if (bench.mechanism == MECH_POLL) {
+            settle_ns += (int64_t) (rand() % (bench.poll_interval_ms * 1000)) * 1000;
+        }
+        Sample sample;
+        if (run_once(bench, settle_ns, &sample)) {
+            latencies.push_back(sample.latency_ns);
+        }
+    }
+
+    if (latencies.empty()) {
+        printf("%-12s %s\n", bench.name, "不可用");
+        return;
+    }
+
+    // 空闲开销：目标进程存活 idle_seconds 秒，统计检测方的 CPU 消耗和唤醒次数
+    Sample idle;
+    double cpu_ms_per_hour = -1;
+    double wakeups_per_sec = -1;
+    if (run_once(bench, (int64_t) idle_seconds * 1000000000LL, &idle) && idle.wait_ns > 0) {
+        cpu_ms_per_hour = (double) idle.cpu_ns / idle.wait_ns * 3600.0 * 1000.0;
+        wakeups_per_sec = (double) idle.wakeups / (idle.wait_ns / 1e9);
+    }
+
+    const double min_us = percentile_us(latencies, 0.0);
+    const double p50_us = percentile_us(latencies, 0.5);
+    const double p90_us = percentile_us(latencies, 0.9);
+    const double max_us = percentile_us(latencies, 1.0);
+    printf("%-12s %10.1f %10.1f %10.1f %10.1f %14.2f %12.2f\n",
+           bench.name, min_us, p50_us, p90_us, max_us, cpu_ms_per_hour, wakeups_per_sec);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : 10;
+    int idle_seconds = argc > 2 ? atoi(argv[2]) : 3;
+    if (runs <= 0) runs = 10;
+    if (idle_seconds <= 0) idle_seconds = 3;
+
+    // 锁文件目录：设备上使用 /data/local/tmp，主机上使用 TMPDIR 或 /tmp
+    const char* tmp = getenv("TMPDIR");
+    if (access("/data/local/tmp", W_OK) == 0) {
+        tmp = "/data/local/tmp";
+    } else if (tmp == nullptr || tmp[0] == '\0') {
+        tmp = "/tmp";
+    }
+    snprintf(g_lock_dir, sizeof(g_lock_dir), "%s", tmp);
+
+    // 让 PDEATHSIG 检测子进程在被监控进程死亡后由本进程收养，便于回收
+#ifdef PR_SET_CHILD_SUBREAPER
+    prctl(PR_SET_CHILD_SUBREAPER, 1);
+#endif
+    signal(SIGPIPE, SIG_IGN);
+    srand((unsigned) monotonic_ns());
+
+    static const BenchCase kCases[] = {
+            {"poll-1ms",    MECH_POLL,      1},
+            {"poll-10ms",   MECH_POLL,      10},
+            {"poll-100ms",  MECH_POLL,      100},
+            {"poll-1000ms", MECH_POLL,      1000},
+            {"pidfd",       MECH_PIDFD,     0},
+            {"socket",      MECH_SOCKET,    0},
+            {"flock",       MECH_FLOCK,     0},
+            {"pdeathsig",   MECH_PDEATHSIG, 0},
+    };
+
+    printf("进程存活检测基准: 每种机制 %d 次测量, 空闲窗口 %d 秒\n", runs, idle_seconds);
+    printf("%-12s %10s %10s %10s %10s %14s %12s\n",
+           "mechanism", "min(us)", "p50(us)", "p90(us)", "max(us)", "cpu(ms/hour)", "wakeups/s");
+
+    for (const BenchCase& bench : kCases) {
+        run_case(bench, runs, idle_seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * ============================================================================
+ * fw_startup_bench.cpp - Native 库加载开销基准测试
+ * ============================================================================
+ *
+ * 功能简介：
+ *   测量每个进程加载 Native 库的开销（相当于 System.loadLibrary 中的
+ *   dlopen + 重定位 + 全局构造）。每次测量 fork 一个新进程，
+ *   模拟服务进程冷启动时库尚未被映射的状态。
+ *
+ * 测试的组合：
+ *   - core         : 仅 libfw_native.so（只调用 getOomAdj 等核心方法的进程）
+ *   - core+binder  : libfw_native.so + libfw_binder.so（使用无法强制停止策略的进程）
+ *   - core+diag    : libfw_native.so + libfw_diag.so（开启诊断功能的进程）
+ *   - mediaroute   : libfw_mediaroute.so（依赖 libfw_native.so，由链接器一并加载）
+ *
+ * 用法：
+ *   fw_startup_bench [库目录=/data/local/tmp] [测量次数=50]
+ *
+ *   库目录中需要包含 libfw_native.so / libfw_binder.so / libfw_diag.so / libfw_mediaroute.so
+ *   以及 libc++_shared.so，运行前设置 LD_LIBRARY_PATH 指向该目录：
+ *     adb shell 'cd /data/local/tmp && LD_LIBRARY_PATH=. ./fw_startup_bench'
+ *
+ * 注意：
+ *   liblog / libandroid 在 zygote 中已预加载，测量前先在父进程中加载，
+ *   不计入结果；libc++_shared.so 属于应用自身，计入第一个加载的库。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include <algorithm>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+struct StartupCase {
+    const char* name;
+    const char* libs[3];    // 依次加载，nullptr 结束
+};
+
+struct StartupSample {
+    int64_t load_ns;        // dlopen 总耗时
+    long minor_faults;      // 加载期间的缺页次数
+    bool ok;
+};
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * 子进程：依次加载库
+ *
+ * 没有 JavaVM 无法调用 JNI_OnLoad，只计入其符号查找开销；
+ * fw_native 的 JNI_OnLoad 只打印日志，对结果影响可以忽略。
+ */
+static StartupSample load_libs(const char* dir, const StartupCase& startup) {
+    StartupSample sample = {0, 0, true};
+    struct rusage before;
+    getrusage(RUSAGE_SELF, &before);
+
+    const int64_t start = monotonic_ns();
+    for (int i = 0; i < 3 && startup.libs[i] != nullptr; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, startup.libs[i]);
+        void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr) {
+            fprintf(stderr, "dlopen %s 失败: %s\n", path, dlerror());
+            sample.ok = false;
+            return sample;
+        }
+        (void) dlsym(handle, "JNI_OnLoad");
+    }
+    sample.load_ns = monotonic_ns() - start;
+
+    struct rusage after;
+    getrusage(RUSAGE_SELF, &after);
+    sample.minor_faults = after.ru_minflt - before.ru_minflt;
+    return sample;
+}
+
+static bool measure_once(const char* dir, const StartupCase& startup, StartupSample* out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        StartupSample sample = load_libs(dir, startup);
+        ssize_t written = write(fds[1], &sample, sizeof(sample));
+        _exit(written == (ssize_t) sizeof(sample) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t n;
+    do {
+        n = read(fds[0], out, sizeof(*out));
+    } while (n < 0 && errno == EINTR);
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return n == (ssize_t) sizeof(*out) && out->ok;
+}
+
+static void run_case(const char* dir, const StartupCase& startup, int runs) {
+    std::vector<int64_t> times;
+    std::vector<long> faults;
+
+    // 第一次测量用于预热页缓存，不计入结果
+    StartupSample sample;
+    if (!measure_once(dir, startup, &sample)) {
+        printf("%-14s %s\n", startup.name, "加载失败");
+        return;
+    }
+
+    for (int i = 0; i < runs; i++) {
+        if (measure_once(dir, startup, &sample)) {
+            times.push_back(sample.load_ns);
+            faults.push_back(sample.minor_faults);
+        }
+    }
+    if (times.empty()) return;
+
+    std::sort(times.begin(), times.end());
+    std::sort(faults.begin(), faults.end());
+    const size_t n = times.size();
+    printf("%-14s %10.1f %10.1f %10.1f %10.1f %10ld\n", startup.name,
+           times[0] / 1000.0, times[n / 2] / 1000.0, times[(n * 9) / 10] / 1000.0,
+           times[n - 1] / 1000.0, faults[n / 2]);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = argc > 1 ? argv[1] : "/data/local/tmp";
+    int runs = argc > 2 ? atoi(argv[2]) : 50;
+    if (runs <= 0) runs = 50;
+
+    // 模拟 zygote 预加载的系统库
+    dlopen("liblog.so", RTLD_NOW | RTLD_GLOBAL);
+    dlopen("libandroid.so", RTLD_NOW | RTLD_GLOBAL);
+
+    static const StartupCase kCases[] = {
+            {"core",        {"libfw_native.so", nullptr, nullptr}},
+            {"core+binder", {"libfw_native.so", "libfw_binder.so", nullptr}},
+            {"core+diag",   {"libfw_native.so", "libfw_diag.so", nullptr}},
+            {"mediaroute",  {"libfw_mediaroute.so", nullptr, nullptr}},
+    };
+
+    printf("Native 库加载基准: 目录 %s, 每种组合 %d 次测量\n", dir, runs);
+    printf("%-14s %10s %10s %10s %10s %10s\n",
+           "libraries", "min(us)", "p50(us)", "p90(us)", "max(us)", "minflt");
+
+    for (const StartupCase& startup : kCases) {
+        run_case(dir, startup, runs);
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#!/usr/bin/env bash
+# ============================================================================
+# run_pgo.sh - fw_native PGO 流水线
+# ============================================================================
+#
+# 功能简介：
+#   1. 插桩构建：FW_PGO_MODE=GENERATE 构建 fw_hotpath_bench
+#   2. 训练运行：adb push 到设备运行，收集 .profraw
+#   3. 合并 profile：llvm-profdata merge 生成 pgo/fw_native.profdata
+#   4. 优化构建：FW_PGO_MODE=USE + FW_ENABLE_LTO=ON 重新构建并对比
+#
+#   生成的 profdata 提交到 cpp/pgo/ 后，Gradle release 构建会自动使用。
+#
+# 用法：
+#   ANDROID_NDK=/path/to/ndk bench/run_pgo.sh [abi=arm64-v8a] [iterations=200000]
+#
+# 依赖：
+#   - 已连接设备（adb），ABI 与参数一致
+#   - NDK r23+（自带 llvm-profdata 和 ThinLTO 支持的 lld）
+#
+# @author Pangu-Immortal
+# @github https://github.com/Pangu-Immortal/KeepLiveService
+# @since 2.3.0
+# ============================================================================
+
+set -euo pipefail
+
+ABI="${1:-arm64-v8a}"
+ITERATIONS="${2:-200000}"
+API_LEVEL="${API_LEVEL:-24}"
+
+if [[ -z "${ANDROID_NDK:-}" ]]; then
+    echo "请设置 ANDROID_NDK 环境变量" >&2
+    exit 1
+fi
+
+CPP_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+WORK_DIR="${WORK_DIR:-${CPP_DIR}/../../../build/fw_pgo/${ABI}}"
+DEVICE_DIR="/data/local/tmp/fw_pgo"
+PROFDATA="${CPP_DIR}/pgo/fw_native.profdata"
+LLVM_PROFDATA="$(find "${ANDROID_NDK}/toolchains/llvm/prebuilt" -name llvm-profdata -type f | head -n 1)"
+
+configure_and_build() {
+    local build_dir="$1"
+    shift
+    cmake -S "${CPP_DIR}" -B "${build_dir}" \
+        -DCMAKE_TOOLCHAIN_FILE="${ANDROID_NDK}/build/cmake/android.toolchain.cmake" \
+        -DANDROID_ABI="${ABI}" \
+        -DANDROID_PLATFORM="android-${API_LEVEL}" \
+        -DANDROID_STL=c++_static \
+        -DCMAKE_BUILD_TYPE=Release \
+        -DFW_BUILD_BENCHMARKS=ON \
+        "$@" > /dev/null
+    cmake --build "${build_dir}" -j"$(nproc)" > /dev/null
+}
+
+run_on_device() {
+    local binary="$1"
+    adb push "${binary}" "${DEVICE_DIR}/" > /dev/null
+    adb shell "cd ${DEVICE_DIR} && LLVM_PROFILE_FILE=${DEVICE_DIR}/fw_%p.profraw ./$(basename "${binary}") ${ITERATIONS}"
+}
+
+report_sizes() {
+    local build_dir="$1"
+    for lib in libfw_native.so libfw_binder.so libfw_profiler.so libfw_diag.so libfw_event_bus.so libfw_proc_cache.so mediaroute/libfw_mediaroute.so; do
+        if [[ -f "${build_dir}/${lib}" ]]; then
+            printf "  %-32s %10d bytes\n" "${lib}" "$(stat -c %s "${build_dir}/${lib}")"
+        fi
+    done
+}
+
+adb shell "rm -rf ${DEVICE_DIR} && mkdir -p ${DEVICE_DIR}"
+
+echo "==> [1/4] 基线构建"
+configure_and_build "${WORK_DIR}/baseline"
+report_sizes "${WORK_DIR}/baseline"
+run_on_device "${WORK_DIR}/baseline/bench/fw_hotpath_bench"
+
+echo "==> [2/4] 插桩构建与训练运行"
+configure_and_build "${WORK_DIR}/generate" -DFW_PGO_MODE=GENERATE
+run_on_device "${WORK_DIR}/generate/bench/fw_hotpath_bench" > /dev/null
+
+echo "==> [3/4] 合并 profile"
+rm -rf "${WORK_DIR}/profraw"
+mkdir -p "${WORK_DIR}/profraw" "$(dirname "${PROFDATA}")"
+adb shell "ls ${DEVICE_DIR}/*.profraw" | tr -d '\r' | while read -r file; do
+    adb pull "${file}" "${WORK_DIR}/profraw/" > /dev/null
+done
+"${LLVM_PROFDATA}" merge -o "${PROFDATA}" "${WORK_DIR}"/profraw/*.profraw
+echo "  ${PROFDATA}"
+
+echo "==> [4/4] PGO + ThinLTO 优化构建"
+configure_and_build "${WORK_DIR}/optimized" -DFW_PGO_MODE=USE -DFW_PGO_PROFILE="${PROFDATA}" -DFW_ENABLE_LTO=ON
+report_sizes "${WORK_DIR}/optimized"
+run_on_device "${WORK_DIR}/optimized/bench/fw_hotpath_bench"
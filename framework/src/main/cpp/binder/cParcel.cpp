@@ -12,6 +12,10 @@
  *   - Parcel::write/read 系列：数据序列化/反序列化
  *   - Parcel::writeFileDescriptor：文件描述符写入
  *   - Parcel::ipcSetDataReference：设置 IPC 数据引用
+ *   - Parcel::continueWrite：数据区扩容（先用内联缓冲区，超出后转到堆上）
+ *   - Parcel::moveFrom：移动构造 / 移动赋值
+ *   - Parcel::writeOwnedFileDescriptor / takeFileDescriptor：不经 dup 转移 fd 所有权
+ *   - closeFdsBatched：批量关闭 fd（连续区间合并为一次 close_range）
  *   - acquire_object/release_object：对象引用管理
  *
  * @author Pangu-Immortal
@@ -44,7 +48,9 @@
 //#include <binder/ProcessState.h>
 //#include <binder/TextOutput.h>
 
+#include <algorithm>
 #include <errno.h>
+#include <fcntl.h>
 //#include <utils/Debug.h>
 //#include <utils/Log.h>
 //#include <utils/String8.h>
@@ -62,9 +68,18 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <pthread.h>
 #include <unistd.h>
 
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+#ifndef __NR_close_range
+#define __NR_close_range 436        // Linux 5.9，所有架构相同
+#endif
+
 #ifndef INT32_MAX
 #define INT32_MAX ((int32_t)(2147483647))
 #endif
@@ -94,6 +109,12 @@ static size_t pad_size(size_t s) {
 // Note: must be kept in sync with android/os/Parcel.java's EX_HAS_REPLY_HEADER
 #define EX_HAS_REPLY_HEADER -128
 
+// takeFileDescriptor 取走 fd 后留在对象中的句柄，关闭与统计时跳过
+#define TAKEN_FD_HANDLE ((__u32) -1)
+
+// 批量关闭时一次收集的 fd 数
+#define CLOSE_BATCH_SIZE 64
+
 // XXX This can be made public if we want to provide
 // support for typed data.
 struct small_flat_data {
@@ -141,6 +162,9 @@ namespace android {
 //                if (b != NULL) b.get_refs()->incWeak(who);
                 return;
             }
+            case BINDER_TYPE_PTR:
+                // 外部缓冲区由调用方持有
+                return;
             case BINDER_TYPE_FD: {
                 if (obj.cookie != 0) {
                     if (outAshmemSize != NULL) {
@@ -190,6 +214,8 @@ namespace android {
 //                if (b != NULL) b.get_refs()->decWeak(who);
                 return;
             }
+            case BINDER_TYPE_PTR:
+                return;
             case BINDER_TYPE_FD: {
                 if (outAshmemSize != NULL) {
                     if (obj.cookie != 0) {
@@ -213,6 +239,81 @@ namespace android {
 //    {
 //        release_object(proc, obj, who, NULL);
 //    }
+
+    // ==================== 批量关闭 fd ====================
+
+    // close_range 可用性：0 未知，1 可用，-1 不可用
+    static std::atomic<int> gCloseRangeState(0);
+
+    static bool closeRangeAvailable() {
+        int state = gCloseRangeState.load(std::memory_order_relaxed);
+        if (state == 0) {
+            state = 1;
+#ifdef __ANDROID__
+            // Android 14 之前应用进程的 seccomp 策略不允许 close_range，调用会触发 SIGSYS
+            char sdk[PROP_VALUE_MAX] = {0};
+            if (__system_property_get("ro.build.version.sdk", sdk) <= 0 || atoi(sdk) < 34) {
+                state = -1;
+            }
+#endif
+            gCloseRangeState.store(state, std::memory_order_relaxed);
+        }
+        return state > 0;
+    }
+
+    /**
+     * 关闭 [first, last] 区间的 fd，close_range 不可用时逐个关闭
+     */
+    static void closeRange(int first, int last) {
+        if (first < last && closeRangeAvailable()) {
+            if (syscall(__NR_close_range, (unsigned int) first, (unsigned int) last, 0) == 0) {
+                return;
+            }
+            if (errno == ENOSYS || errno == EPERM) {
+                gCloseRangeState.store(-1, std::memory_order_relaxed);
+            }
+        }
+        for (int fd = first; fd <= last; fd++) {
+            close(fd);
+        }
+    }
+
+    /**
+     * 关闭一组 fd：排序后把连续的编号合并为一次 close_range
+     *
+     * 同一个 Parcel 中的 fd 通常是连续分配的（如一次 recvmsg 收到的一批），
+     * 多个 fd 只需少数几次系统调用。会重排 fds。
+     */
+    static void closeFdsBatched(int *fds, size_t count) {
+        if (count == 0) return;
+        if (count > 1) std::sort(fds, fds + count);
+        size_t start = 0;
+        for (size_t i = 1; i <= count; i++) {
+            if (i < count && (fds[i] == fds[i - 1] + 1 || fds[i] == fds[i - 1])) continue;
+            closeRange(fds[start], fds[i - 1]);
+            start = i;
+        }
+    }
+
+    /**
+     * 遍历对象表时收集待关闭的 fd，满 CLOSE_BATCH_SIZE 个或析构时批量关闭
+     */
+    struct CloseBatch {
+        int fds[CLOSE_BATCH_SIZE];
+        size_t count = 0;
+
+        void add(int fd) {
+            if (count == CLOSE_BATCH_SIZE) flush();
+            fds[count++] = fd;
+        }
+
+        void flush() {
+            closeFdsBatched(fds, count);
+            count = 0;
+        }
+
+        ~CloseBatch() { flush(); }
+    };
 //
 //    inline static status_t finish_flatten_binder(
 //            const sp<IBinder>& /*binder*/, const flat_binder_object& flat, Parcel* out)
@@ -358,7 +459,7 @@ namespace android {
 
 // ---------------------------------------------------------------------------
 
-    Parcel::Parcel() {
+    Parcel::Parcel() : mBorrowCount(0) {
         LOG_ALLOC("Parcel %p: constructing", this);
         initState();
     }
@@ -368,6 +469,21 @@ namespace android {
         LOG_ALLOC("Parcel %p: destroyed", this);
     }
 
+    Parcel::Parcel(Parcel &&o) noexcept : mBorrowCount(0) {
+        LOG_ALLOC("Parcel %p: moving from %p", this, &o);
+        initState();
+        moveFrom(o);
+    }
+
+    Parcel &Parcel::operator=(Parcel &&o) noexcept {
+        if (this != &o) {
+            freeDataNoInit();
+            initState();
+            moveFrom(o);
+        }
+        return *this;
+    }
+
     size_t Parcel::getGlobalAllocSize() {
         pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
         size_t size = gParcelGlobalAllocSize;
@@ -582,6 +698,13 @@ namespace android {
         return mHasFds;
     }
 
+    size_t Parcel::fileDescriptorCount() const {
+        if (!mFdsKnown) {
+            scanForFds();
+        }
+        return mFdCount;
+    }
+
 // Write RPC headers.  (previously just the interface token)
     status_t Parcel::writeInterfaceToken(const String16 &interface) {
         writeInt32(STRICT_MODE_PENALTY_GATHER);
@@ -908,7 +1031,7 @@ namespace android {
     }
 
     status_t Parcel::writeDupFileDescriptor(int fd) {
-        int dupFd = dup(fd);
+        int dupFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
         if (dupFd < 0) {
             return -errno;
         }
@@ -919,6 +1042,15 @@ namespace android {
         return err;
     }
 
+    status_t Parcel::writeOwnedFileDescriptor(int fd) {
+        if (fd < 0) return BAD_VALUE;
+        status_t err = writeFileDescriptor(fd, true /*takeOwnership*/);
+        if (err) {
+            close(fd);
+        }
+        return err;
+    }
+
 //    status_t Parcel::writeBlob(size_t len, bool mutableCopy, WritableBlob* outBlob)
 //    {
 //        if (len > INT32_MAX) {
@@ -1036,7 +1168,9 @@ namespace android {
                     // fail before modifying our object index
                     return FDS_NOT_ALLOWED;
                 }
-                mHasFds = mFdsKnown = true;
+                // 先补齐计数，之后按增量维护
+                if (!mFdsKnown) scanForFds();
+                mHasFds = true;
             }
 
             // Need to write meta-data?
@@ -1044,6 +1178,7 @@ namespace android {
                 mObjects[mObjectsSize] = mDataPos;
                 acquire_object(val, this, &mOpenAshmemSize);
                 mObjectsSize++;
+                if (val.hdr.type == BINDER_TYPE_FD) mFdCount++;
             }
 
             return finishWrite(sizeof(flat_binder_object));
@@ -1066,12 +1201,88 @@ namespace android {
         goto restart_write;
     }
 
+    // 对象表条目在数据区中占用的字节数：BINDER_TYPE_PTR 是 40 字节的 binder_buffer_object，
+    // 其余类型都是 24 字节的 flat_binder_object
+    static size_t objectSize(const binder_object_header *hdr) {
+        return hdr->type == BINDER_TYPE_PTR ? sizeof(binder_buffer_object)
+                                            : sizeof(flat_binder_object);
+    }
+
+    status_t Parcel::writeBufferObject(const void *buffer, size_t size) {
+        if (buffer == NULL && size > 0) return BAD_VALUE;
+
+        // 只允许追加：对象表必须按偏移递增，且不能覆盖已有对象的任何字节
+        if (mObjectsSize > 0) {
+            const binder_size_t last = mObjects[mObjectsSize - 1];
+            if (last + objectSize(reinterpret_cast<const binder_object_header *>(mData + last))
+                > mDataPos) {
+                LOGE("writeBufferObject at %zu overlaps object at %" PRIu64,
+                     mDataPos, (uint64_t) last);
+                return INVALID_OPERATION;
+            }
+        }
+
+        binder_buffer_object obj;
+        memset(&obj, 0, sizeof(obj));
+        obj.hdr.type = BINDER_TYPE_PTR;
+        obj.flags = 0;
+        obj.buffer = reinterpret_cast<binder_uintptr_t>(buffer);
+        obj.length = size;
+
+        if (mDataPos + sizeof(obj) > mDataCapacity) {
+            const status_t err = growData(sizeof(obj));
+            if (err != NO_ERROR) return err;
+        }
+        if (mObjectsSize >= mObjectsCapacity) {
+            size_t newSize = ((mObjectsSize + 2) * 3) / 2;
+            if (newSize * sizeof(binder_size_t) < mObjectsSize) return NO_MEMORY;   // overflow
+            binder_size_t *objects = (binder_size_t *) realloc(mObjects,
+                                                               newSize * sizeof(binder_size_t));
+            if (objects == NULL) return NO_MEMORY;
+            mObjects = objects;
+            mObjectsCapacity = newSize;
+        }
+
+        memcpy(mData + mDataPos, &obj, sizeof(obj));
+        mObjects[mObjectsSize++] = mDataPos;
+        mNextObjectHint = 0;
+        return finishWrite(sizeof(obj));
+    }
+
+    size_t Parcel::ipcBuffersSize() const {
+        size_t total = 0;
+        for (size_t i = 0; i < mObjectsSize; i++) {
+            const binder_object_header *hdr
+                    = reinterpret_cast<const binder_object_header *>(mData + mObjects[i]);
+            if (hdr->type == BINDER_TYPE_PTR) {
+                const binder_buffer_object *obj
+                        = reinterpret_cast<const binder_buffer_object *>(hdr);
+                // 驱动按 8 字节对齐检查每个缓冲区
+                total += (size_t) ((obj->length + 7) & ~(binder_size_t) 7);
+            }
+        }
+        return total;
+    }
+
     status_t Parcel::writeNoException() {
         return writeInt32(0);
     }
 
-    void Parcel::remove(size_t /*start*/, size_t /*amt*/) {
-//        LOG_ALWAYS_FATAL("Parcel::remove() not yet implemented!");
+    void Parcel::remove(size_t start, size_t amt) {
+        // 只支持不含对象的自有缓冲区（talkWithDriver 丢弃 mOut 中驱动已消费的命令）
+        if (mOwner != NULL || mObjectsSize > 0 || isDataBorrowed()) {
+            LOGE("Parcel::remove() 不支持包含对象或外部数据的 Parcel");
+            return;
+        }
+        if (start > mDataSize || amt > mDataSize - start) {
+            LOGE("Parcel::remove() 越界: start=%zu amt=%zu size=%zu", start, amt, mDataSize);
+            return;
+        }
+        memmove(mData + start, mData + start + amt, mDataSize - start - amt);
+        mDataSize -= amt;
+        if (mDataPos > start) {
+            mDataPos = mDataPos >= start + amt ? mDataPos - amt : start;
+        }
     }
 
     status_t Parcel::read(void *outData, size_t len) const {
@@ -1374,6 +1585,30 @@ double Parcel::readDouble() const
         return BAD_TYPE;
     }
 
+    int Parcel::takeFileDescriptor() {
+        const flat_binder_object *flat = readObject(true);
+        if (flat == NULL || flat->hdr.type != BINDER_TYPE_FD || (int) flat->handle < 0) {
+            return BAD_TYPE;
+        }
+        const int fd = (int) flat->handle;
+
+        // 自己持有的 fd，或可写的外部数据（释放函数关闭其中的 fd）：直接转移
+        const bool transferable = mOwner ? mOwnerDataWritable : flat->cookie != 0;
+        if (!transferable) {
+            int dupFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+            return dupFd < 0 ? -errno : dupFd;
+        }
+
+        flat_binder_object *obj = const_cast<flat_binder_object *>(flat);
+        obj->handle = TAKEN_FD_HANDLE;
+        obj->cookie = 0;
+        if (mFdsKnown) {
+            mFdCount--;
+            mHasFds = mFdCount > 0;
+        }
+        return fd;
+    }
+
     status_t Parcel::readBlob(size_t len, ReadableBlob *outBlob) const {
         int32_t blobType;
         status_t status = readInt32(&blobType);
@@ -1422,18 +1657,24 @@ double Parcel::readDouble() const
             fds = new int[fd_count];
         }
 
+        // 与原实现的 dup 语义相同（fd 交给 val），能转移时省去 dup 和之后 Parcel 的 close；
+        // 对象表被修改，因此需要去掉 const
         status_t err = NO_ERROR;
-        for (size_t i = 0; i < fd_count && err == NO_ERROR; i++) {
-            fds[i] = dup(this->readFileDescriptor());
-            if (fds[i] < 0) {
+        size_t taken = 0;
+        for (; taken < fd_count; taken++) {
+            fds[taken] = const_cast<Parcel *>(this)->takeFileDescriptor();
+            if (fds[taken] < 0) {
                 err = BAD_VALUE;
-                LOGE("dup() failed in Parcel::read, i is %zu, fds[i] is %d, fd_count is %zu, error: %s",
-                     i, fds[i], fd_count, strerror(errno));
+                LOGE("takeFileDescriptor() failed in Parcel::read, i is %zu, fd_count is %zu, error: %d",
+                     taken, fd_count, fds[taken]);
+                break;
             }
         }
 
         if (err == NO_ERROR) {
             err = val.unflatten(buf, len, fds, fd_count);
+        } else {
+            closeFdsBatched(fds, taken);
         }
 
         if (fd_count) {
@@ -1448,6 +1689,12 @@ double Parcel::readDouble() const
         if ((DPOS + sizeof(flat_binder_object)) <= mDataSize) {
             const flat_binder_object *obj
                     = reinterpret_cast<const flat_binder_object *>(mData + DPOS);
+            if (obj->hdr.type == BINDER_TYPE_PTR) {
+                // binder_buffer_object 比 flat_binder_object 长，只能用 readBufferObject() 读取
+                LOGW("Attempt to read buffer object from Parcel %p at offset %zu with readObject",
+                     this, DPOS);
+                return NULL;
+            }
             mDataPos = DPOS + sizeof(flat_binder_object);
             if (!nullMetaData && (obj->cookie == 0 && obj->binder == 0)) {
                 // When transferring a NULL object, we don't write it into
@@ -1503,18 +1750,41 @@ double Parcel::readDouble() const
         return NULL;
     }
 
+    const binder_buffer_object *Parcel::readBufferObject() const {
+        const size_t DPOS = mDataPos;
+        if ((DPOS + sizeof(binder_buffer_object)) > mDataSize) return NULL;
+
+        // 对象表按偏移递增，二分查找当前位置
+        const binder_size_t *const begin = mObjects;
+        const binder_size_t *const end = begin + mObjectsSize;
+        const binder_size_t *it = std::lower_bound(begin, end, (binder_size_t) DPOS);
+        if (it == end || *it != DPOS) {
+            LOGW("Attempt to read buffer object from Parcel %p at offset %zu that is not in the object list",
+                 this, DPOS);
+            return NULL;
+        }
+        const binder_buffer_object *obj
+                = reinterpret_cast<const binder_buffer_object *>(mData + DPOS);
+        if (obj->hdr.type != BINDER_TYPE_PTR) return NULL;
+
+        mDataPos = DPOS + sizeof(binder_buffer_object);
+        mNextObjectHint = (it - begin) + 1;
+        return obj;
+    }
+
     void Parcel::closeFileDescriptors() {
         size_t i = mObjectsSize;
         if (i > 0) {
             //ALOGI("Closing file descriptors for %zu objects...", i);
         }
+        CloseBatch batch;
         while (i > 0) {
             i--;
             const flat_binder_object *flat
                     = reinterpret_cast<flat_binder_object *>(mData + mObjects[i]);
-            if (flat->hdr.type == BINDER_TYPE_FD) {
+            if (flat->hdr.type == BINDER_TYPE_FD && (int) flat->handle >= 0) {
                 //ALOGI("Closing fd: %ld", flat->handle);
-                close(flat->handle);
+                batch.add(flat->handle);
             }
         }
     }
@@ -1537,7 +1807,7 @@ double Parcel::readDouble() const
 
     void Parcel::ipcSetDataReference(const uint8_t *data, size_t dataSize,
                                      const binder_size_t *objects, size_t objectsCount,
-                                     release_func relFunc, void *relCookie) {
+                                     release_func relFunc, void *relCookie, bool writable) {
         binder_size_t minOffset = 0;
         freeDataNoInit();
         mError = NO_ERROR;
@@ -1551,6 +1821,7 @@ double Parcel::readDouble() const
         mNextObjectHint = 0;
         mOwner = relFunc;
         mOwnerCookie = relCookie;
+        mOwnerDataWritable = writable;
         for (size_t i = 0; i < mObjectsSize; i++) {
             binder_size_t offset = mObjects[i];
             if (offset < minOffset) {
@@ -1559,7 +1830,19 @@ double Parcel::readDouble() const
                 mObjectsSize = 0;
                 break;
             }
-            minOffset = offset + sizeof(flat_binder_object);
+            if (offset + sizeof(binder_object_header) > dataSize) {
+                LOGE("%s: object offset %" PRIu64 " beyond data size %zu\n",
+                     __func__, (uint64_t) offset, dataSize);
+                mObjectsSize = 0;
+                break;
+            }
+            minOffset = offset + objectSize(reinterpret_cast<const binder_object_header *>(data + offset));
+            if (minOffset > dataSize) {
+                LOGE("%s: object at %" PRIu64 " exceeds data size %zu\n",
+                     __func__, (uint64_t) offset, dataSize);
+                mObjectsSize = 0;
+                break;
+            }
         }
         scanForFds();
     }
@@ -1595,11 +1878,17 @@ double Parcel::readDouble() const
         size_t i = mObjectsSize;
         uint8_t *const data = mData;
         binder_size_t *const objects = mObjects;
+        CloseBatch batch;
         while (i > 0) {
             i--;
             const flat_binder_object *flat
                     = reinterpret_cast<flat_binder_object *>(data + objects[i]);
-            release_object(*flat, this, &mOpenAshmemSize);
+            if (flat->hdr.type == BINDER_TYPE_FD) {
+                // 与 release_object 相同：只关闭自己持有的 fd
+                if (flat->cookie != 0 && (int) flat->handle >= 0) batch.add(flat->handle);
+            } else {
+                release_object(*flat, this, &mOpenAshmemSize);
+            }
         }
     }
 
@@ -1622,6 +1911,9 @@ double Parcel::readDouble() const
     }
 
     void Parcel::freeDataNoInit() {
+        if (isDataBorrowed()) {
+            LOGE("Parcel %p: freeing data while borrowed", this);
+        }
         if (mOwner) {
             LOG_ALLOC("Parcel %p: freeing other owner data", this);
             //ALOGI("Freeing data ref of %p (pid=%d)", this, getpid());
@@ -1629,12 +1921,13 @@ double Parcel::readDouble() const
         } else {
             LOG_ALLOC("Parcel %p: freeing allocated data", this);
             releaseObjects();
-            if (mData) {
+            if (mData && !isInline()) {
                 LOG_ALLOC("Parcel %p: freeing with %zu capacity", this, mDataCapacity);
                 pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
                 gParcelGlobalAllocSize -= mDataCapacity;
                 gParcelGlobalAllocCount--;
                 pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
+                allocTagRecordFree(mAllocTag, mDataCapacity);
                 free(mData);
             }
             if (mObjects) free(mObjects);
@@ -1706,6 +1999,10 @@ double Parcel::readDouble() const
             // inadvertent conversion from a negative int.
             return BAD_VALUE;
         }
+        if (isDataBorrowed()) {
+            LOGE("Parcel %p: data is borrowed, refusing to resize to %zu", this, desired);
+            return INVALID_OPERATION;
+        }
 
         // If shrinking, first adjust for any objects that appear
         // after the new data size.
@@ -1715,7 +2012,9 @@ double Parcel::readDouble() const
                 objectsSize = 0;
             } else {
                 while (objectsSize > 0) {
-                    if (mObjects[objectsSize - 1] < desired)
+                    const binder_size_t last = mObjects[objectsSize - 1];
+                    if (last + objectSize(reinterpret_cast<const binder_object_header *>(mData + last))
+                        <= desired)
                         break;
                     objectsSize--;
                 }
@@ -1731,7 +2030,8 @@ double Parcel::readDouble() const
 
             // If there is a different owner, we need to take
             // posession.
-            uint8_t *data = (uint8_t *) malloc(desired);
+            const bool useInline = desired <= PARCEL_INLINE_CAPACITY;
+            uint8_t *data = useInline ? mInline : (uint8_t *) malloc(desired);
             if (!data) {
                 mError = NO_MEMORY;
                 return NO_MEMORY;
@@ -1741,7 +2041,7 @@ double Parcel::readDouble() const
             if (objectsSize) {
                 objects = (binder_size_t *) calloc(objectsSize, sizeof(binder_size_t));
                 if (!objects) {
-                    free(data);
+                    if (!useInline) free(data);
 
                     mError = NO_MEMORY;
                     return NO_MEMORY;
@@ -1750,6 +2050,7 @@ double Parcel::readDouble() const
                 // Little hack to only acquire references on objects
                 // we will be keeping.
                 size_t oldObjectsSize = mObjectsSize;
+                if (objectsSize < oldObjectsSize) mFdsKnown = false;   // 截掉的部分可能含 fd
                 mObjectsSize = objectsSize;
                 acquireObjects();
                 mObjectsSize = oldObjectsSize;
@@ -1766,16 +2067,20 @@ double Parcel::readDouble() const
             mOwner = NULL;
 
             LOG_ALLOC("Parcel %p: taking ownership of %zu capacity", this, desired);
-            pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
-            gParcelGlobalAllocSize += desired;
-            gParcelGlobalAllocCount++;
-            pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
+            if (!useInline) {
+                pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
+                gParcelGlobalAllocSize += desired;
+                gParcelGlobalAllocCount++;
+                pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
+                mAllocTag = allocTagCurrent();
+                allocTagRecordAlloc(mAllocTag, desired);
+            }
 
             mData = data;
             mObjects = objects;
             mDataSize = (mDataSize < desired) ? mDataSize : desired;
             LOGD("Setting data size of %p to %zu", this, mDataSize);
-            mDataCapacity = desired;
+            mDataCapacity = useInline ? PARCEL_INLINE_CAPACITY : desired;
             mObjectsSize = mObjectsCapacity = objectsSize;
             mNextObjectHint = 0;
 
@@ -1783,34 +2088,60 @@ double Parcel::readDouble() const
             if (objectsSize < mObjectsSize) {
                 // Need to release refs on any objects we are dropping.
 //                const sp<ProcessState> proc(ProcessState::self());
+                CloseBatch batch;
                 for (size_t i = objectsSize; i < mObjectsSize; i++) {
                     const flat_binder_object *flat
                             = reinterpret_cast<flat_binder_object *>(mData + mObjects[i]);
                     if (flat->hdr.type == BINDER_TYPE_FD) {
                         // will need to rescan because we may have lopped off the only FDs
                         mFdsKnown = false;
+                        if (flat->cookie != 0 && (int) flat->handle >= 0) batch.add(flat->handle);
+                    } else {
+                        release_object(*flat, this, &mOpenAshmemSize);
                     }
-                    release_object(*flat, this, &mOpenAshmemSize);
                 }
-                binder_size_t *objects =
-                        (binder_size_t *) realloc(mObjects, objectsSize * sizeof(binder_size_t));
-                if (objects) {
-                    mObjects = objects;
+                if (objectsSize == 0) {
+                    // realloc(p, 0) 会释放 p 并返回 NULL，不能保留原指针
+                    free(mObjects);
+                    mObjects = NULL;
+                    mObjectsCapacity = 0;
+                } else {
+                    binder_size_t *objects =
+                            (binder_size_t *) realloc(mObjects, objectsSize * sizeof(binder_size_t));
+                    if (objects) {
+                        mObjects = objects;
+                        mObjectsCapacity = objectsSize;
+                    }
                 }
                 mObjectsSize = objectsSize;
                 mNextObjectHint = 0;
             }
 
             // We own the data, so we can just do a realloc().
+            // 内联数据区不够用时转到堆上
             if (desired > mDataCapacity) {
-                uint8_t *data = (uint8_t *) realloc(mData, desired);
-                if (data) {
+                const bool wasInline = isInline();
+                uint8_t *data = wasInline ? (uint8_t *) malloc(desired)
+                                          : (uint8_t *) realloc(mData, desired);
+                if (data && wasInline) {
+                    LOG_ALLOC("Parcel %p: spilling from inline to %zu capacity", this, desired);
+                    memcpy(data, mInline, mDataCapacity);
+                    pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
+                    gParcelGlobalAllocSize += desired;
+                    gParcelGlobalAllocCount++;
+                    pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
+                    mAllocTag = allocTagCurrent();
+                    allocTagRecordAlloc(mAllocTag, desired);
+                    mData = data;
+                    mDataCapacity = desired;
+                } else if (data) {
                     LOG_ALLOC("Parcel %p: continue from %zu to %zu capacity", this, mDataCapacity,
                               desired);
                     pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
                     gParcelGlobalAllocSize += desired;
                     gParcelGlobalAllocSize -= mDataCapacity;
                     pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
+                    allocTagRecordResize(mAllocTag, mDataCapacity, desired);
                     mData = data;
                     mDataCapacity = desired;
                 } else if (desired > mDataCapacity) {
@@ -1830,7 +2161,8 @@ double Parcel::readDouble() const
 
         } else {
             // This is the first data.  Easy!
-            uint8_t *data = (uint8_t *) malloc(desired);
+            const bool useInline = desired <= PARCEL_INLINE_CAPACITY;
+            uint8_t *data = useInline ? mInline : (uint8_t *) malloc(desired);
             if (!data) {
                 mError = NO_MEMORY;
                 return NO_MEMORY;
@@ -1842,17 +2174,23 @@ double Parcel::readDouble() const
                      desired);
             }
 
-            LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, desired);
-            pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
-            gParcelGlobalAllocSize += desired;
-            gParcelGlobalAllocCount++;
-            pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
+            if (useInline) {
+                LOG_ALLOC("Parcel %p: using inline %d capacity", this, PARCEL_INLINE_CAPACITY);
+            } else {
+                LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, desired);
+                pthread_mutex_lock(&gParcelGlobalAllocSizeLock);
+                gParcelGlobalAllocSize += desired;
+                gParcelGlobalAllocCount++;
+                pthread_mutex_unlock(&gParcelGlobalAllocSizeLock);
+                mAllocTag = allocTagCurrent();
+                allocTagRecordAlloc(mAllocTag, desired);
+            }
 
             mData = data;
             mDataSize = mDataPos = 0;
             LOGD("Setting data size of %p to %zu", this, mDataSize);
             LOGD("Setting data pos of %p to %zu", this, mDataPos);
-            mDataCapacity = desired;
+            mDataCapacity = useInline ? PARCEL_INLINE_CAPACITY : desired;
         }
 
         return NO_ERROR;
@@ -1873,22 +2211,74 @@ double Parcel::readDouble() const
         mNextObjectHint = 0;
         mHasFds = false;
         mFdsKnown = true;
+        mFdCount = 0;
         mAllowFds = true;
         mOwner = NULL;
+        mOwnerDataWritable = false;
         mOpenAshmemSize = 0;
+        mAllocTag = 0;
+    }
+
+    /**
+     * 接管 o 的全部状态（调用方已 initState），o 重置为空
+     *
+     * 内联数据随对象复制；堆数据、外部数据（mOwner）和对象表只转移指针
+     */
+    void Parcel::moveFrom(Parcel &o) {
+        if (o.isDataBorrowed()) {
+            LOGE("Parcel %p: moving data while borrowed", &o);
+        }
+        if (o.isInline()) {
+            // 复制 max(mDataSize, mDataPos) 字节（即 dataSize()），
+            // 但 setDataPosition 可以越过容量，复制长度不能超出内联区
+            memcpy(mInline, o.mInline, std::min(o.dataSize(), o.mDataCapacity));
+            mData = mInline;
+        } else {
+            mData = o.mData;
+        }
+        mError = o.mError;
+        mDataSize = o.mDataSize;
+        mDataCapacity = o.mDataCapacity;
+        mDataPos = o.mDataPos;
+        mObjects = o.mObjects;
+        mObjectsSize = o.mObjectsSize;
+        mObjectsCapacity = o.mObjectsCapacity;
+        mNextObjectHint = o.mNextObjectHint;
+        mHasFds = o.mHasFds;
+        mFdsKnown = o.mFdsKnown;
+        mFdCount = o.mFdCount;
+        mAllowFds = o.mAllowFds;
+        mOwner = o.mOwner;
+        mOwnerCookie = o.mOwnerCookie;
+        mOwnerDataWritable = o.mOwnerDataWritable;
+        mOpenAshmemSize = o.mOpenAshmemSize;
+        mAllocTag = o.mAllocTag;
+        o.initState();
+    }
+
+    void Parcel::borrowData() const {
+        mBorrowCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Parcel::returnData() const {
+        mBorrowCount.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool Parcel::isDataBorrowed() const {
+        return mBorrowCount.load(std::memory_order_acquire) != 0;
     }
 
     void Parcel::scanForFds() const {
-        bool hasFds = false;
+        size_t count = 0;
         for (size_t i = 0; i < mObjectsSize; i++) {
             const flat_binder_object *flat
                     = reinterpret_cast<const flat_binder_object *>(mData + mObjects[i]);
-            if (flat->hdr.type == BINDER_TYPE_FD) {
-                hasFds = true;
-                break;
+            if (flat->hdr.type == BINDER_TYPE_FD && (int) flat->handle >= 0) {
+                count++;
             }
         }
-        mHasFds = hasFds;
+        mFdCount = count;
+        mHasFds = count > 0;
         mFdsKnown = true;
     }
 
@@ -13,6 +13,9 @@
  *   - Parcel::ReadableBlob/WritableBlob：只读/可写 Blob 封装
  *   - FlattenableHelperInterface：可扁平化对象接口
  *
+ *   Parcel 可移动（不可复制）。数据不超过 PARCEL_INLINE_CAPACITY 时存放在对象内的
+ *   内联缓冲区，不分配堆内存；超出后才转到堆上。
+ *
  * @author Pangu-Immortal
  * @github https://github.com/Pangu-Immortal/KeepLiveService
  * @since 2.1.0
@@ -42,9 +45,14 @@
 #include "../utils/String16.h"
 //#include <utils/Vector.h>
 #include "../utils/Flattenable.h"
+#include "../utils/AllocTag.h"
 #include <linux/android/binder.h>
+#include <atomic>
 #include <stdint.h>
 
+// 内联缓冲区大小：常见的小事务（checkService 查询、回复头、命令缓冲区）不分配堆内存
+#define PARCEL_INLINE_CAPACITY 256
+
 // ---------------------------------------------------------------------------
 namespace android {
 
@@ -65,6 +73,10 @@ namespace android {
         Parcel();
         ~Parcel();
 
+        // 移动后源 Parcel 为空；借出期间（见 borrowData）不得移动（只记录错误日志）
+        Parcel(Parcel&& o) noexcept;
+        Parcel&             operator=(Parcel&& o) noexcept;
+
         const uint8_t*      data() const;
         size_t              dataSize() const;
         size_t              dataAvail() const;
@@ -85,6 +97,8 @@ namespace android {
         void                restoreAllowFds(bool lastValue);
 
         bool                hasFileDescriptors() const;
+        // Parcel 对象表中（尚未取出的）fd 数量，写入 / 取出 / 截断时增量维护
+        size_t              fileDescriptorCount() const;
 
         // Writes the RPC header.
         status_t            writeInterfaceToken(const String16& interface);
@@ -102,6 +116,13 @@ namespace android {
 
         void                freeData();
 
+        // 借出数据区（如包装为 Java DirectByteBuffer），借出期间扩容 / 缩容返回
+        // INVALID_OPERATION，保证外部持有的指针一直有效。可在其它线程归还。
+        // 借出期间不得 freeData / ipcSetDataReference / 析构（只记录错误日志）
+        void                borrowData() const;
+        void                returnData() const;
+        bool                isDataBorrowed() const;
+
     private:
         const binder_size_t* objects() const;
 
@@ -152,6 +173,10 @@ namespace android {
         // will be closed once the parcel is destroyed.
         status_t            writeDupFileDescriptor(int fd);
 
+        // 把 fd 的所有权交给 Parcel，不 dup。无论成功与否调用方都不再持有该 fd
+        // （失败时已关闭），Parcel 释放时关闭。
+        status_t            writeOwnedFileDescriptor(int fd);
+
         // Writes a blob to the parcel.
         // If the blob is small, then it is stored in-place, otherwise it is
         // transferred by way of an anonymous shared memory region.  Prefer sending
@@ -167,6 +192,15 @@ namespace android {
 
         status_t            writeObject(const flat_binder_object& val, bool nullMetaData);
 
+        // 按指针附加外部缓冲区（BINDER_TYPE_PTR）。数据区只写入 binder_buffer_object，
+        // 发送时改用 BC_TRANSACTION_SG，由驱动把缓冲区直接拷贝到目标进程，
+        // 不经过 Parcel 数据区。缓冲区在事务写入驱动之前必须保持有效。
+        // 对端必须按 binder_buffer_object 读取（如 HIDL 服务），普通 AIDL 服务不识别。
+        status_t            writeBufferObject(const void* buffer, size_t size);
+
+        // 所有外部缓冲区按 8 字节对齐后的总大小（binder_transaction_data_sg.buffers_size）
+        size_t              ipcBuffersSize() const;
+
         // Like Parcel.java's writeNoException().  Just writes a zero int32.
         // Currently the native implementation doesn't do any of the StrictMode
         // stack gathering and serialization that the Java implementation does.
@@ -222,13 +256,23 @@ namespace android {
         // in the parcel, which you do not own -- use dup() to get your own copy.
         int                 readFileDescriptor() const;
 
+        // 取出下一个 fd 并取得其所有权（调用方负责关闭），失败返回 BAD_TYPE 或 -errno。
+        // 数据区可写时直接转移：对象标记为已取出，Parcel 不再关闭该 fd；
+        // 引用只读数据（如 Binder 驱动的回复缓冲区）时退化为 dup。
+        int                 takeFileDescriptor();
+
         // Reads a blob from the parcel.
         // The caller should call release() on the blob after reading its contents.
         status_t            readBlob(size_t len, ReadableBlob* outBlob) const;
 
         const flat_binder_object* readObject(bool nullMetaData) const;
 
+        // 读取 writeBufferObject() 写入的 binder_buffer_object（BINDER_TYPE_PTR）。
+        // 当前位置不在对象表中或类型不是 PTR 时返回 NULL；readObject() 不接受 PTR 对象。
+        const binder_buffer_object* readBufferObject() const;
+
         // Explicitly close all file descriptors in the parcel.
+        // 连续的 fd 合并为一次 close_range（内核 / 系统支持时）。
         void                closeFileDescriptors();
 
         // Debugging: get metrics on current allocations.
@@ -245,9 +289,11 @@ namespace android {
         size_t              ipcDataSize() const;
         uintptr_t           ipcObjects() const;
         size_t              ipcObjectsCount() const;
+        // writable：引用的数据区可由 Parcel 修改（如 takeFileDescriptor 直接转移 fd）
         void                ipcSetDataReference(const uint8_t* data, size_t dataSize,
                                                 const binder_size_t* objects, size_t objectsCount,
-                                                release_func relFunc, void* relCookie);
+                                                release_func relFunc, void* relCookie,
+                                                bool writable = false);
 
     public:
 //        void                print(TextOutput& to, uint32_t flags = 0) const;
@@ -267,6 +313,8 @@ namespace android {
         uintptr_t           readPointer() const;
         void                freeDataNoInit();
         void                initState();
+        void                moveFrom(Parcel& o);
+        bool                isInline() const { return mData == mInline; }
         void                scanForFds() const;
 
         template<class T>
@@ -289,10 +337,12 @@ namespace android {
 
         mutable bool        mFdsKnown;
         mutable bool        mHasFds;
+        mutable size_t      mFdCount;       // 对象表中未取出的 fd 数量（mFdsKnown 为 false 时待重新统计）
         bool                mAllowFds;
 
         release_func        mOwner;
         void*               mOwnerCookie;
+        bool                mOwnerDataWritable;     // 见 ipcSetDataReference 的 writable
 
         class Blob {
         public:
@@ -362,6 +412,9 @@ namespace android {
 
     private:
         size_t mOpenAshmemSize;
+        alloc_tag_t mAllocTag;      // mData 分配时的标签（见 AllocTag.h）
+        mutable std::atomic<uint32_t> mBorrowCount;  // 数据区借出次数（见 borrowData）
+        alignas(8) uint8_t mInline[PARCEL_INLINE_CAPACITY];  // 内联数据区（mData 可指向这里）
 
     public:
         // TODO: Remove once ABI can be changed.
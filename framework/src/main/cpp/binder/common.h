@@ -21,6 +21,7 @@
 #define FW_BINDER_COMMON_H
 
 #include <android/log.h>
+#include "../fw_tokenlog.h"
 #include <stdint.h>
 #include <sys/types.h>
 
@@ -28,15 +29,15 @@
 #define TAG        "FwForceStop"
 
 // 日志宏定义
-#define LOGW(...)    __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
-#define LOGE(...)    __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGW(...)    FW_LOG(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+#define LOGE(...)    FW_LOG(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 
 // 调试开关
 #define FW_DEBUG 1
 
 #ifdef FW_DEBUG
-#define LOGI(...)    __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
-#define LOGD(format, ...)   __android_log_print(ANDROID_LOG_DEBUG, TAG, \
+#define LOGI(...)    FW_LOG(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGD(format, ...)   FW_LOG(ANDROID_LOG_DEBUG, TAG, \
                                     "[%s] : %d ---> " format "%s", \
                                     __FUNCTION__, __LINE__, \
                                     ##__VA_ARGS__, "\n")
@@ -10,9 +10,10 @@
  * 主要函数：
  *   - open_driver：打开并初始化 Binder 驱动
  *   - initProcessState/unInitProcessState：进程状态初始化和清理
- *   - write_transact：发起 Binder 事务
+ *   - write_transact / write_transact_timeout：发起 Binder 事务（可带截止时间）
+ *   - 单向事务合并提交：多线程并发的单向事务由一个线程合并为一次 ioctl 写入
  *   - talkWithDriver：与驱动进行读写通信
- *   - waitForResponse：等待并处理驱动响应
+ *   - waitForResponse / waitForResponseUntil：等待并处理驱动响应
  *   - executeCommand：执行 Binder 命令
  *   - freeBuffer：释放事务缓冲区
  *
@@ -21,9 +22,124 @@
  * @since 2.1.0
  */
 
+#include <atomic>
+#include <mutex>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
 #include <sys/mman.h>
 #include <linux/android/binder.h>
 #include "data_transact.h"
+#include "fw_loop_monitor.h"
+#include "fw_service_prefetch.h"
+
+// 超时统计
+static std::atomic<uint64_t> g_transact_timeouts{0};
+
+// 等待单次回复超过该时间视为卡顿（记入 fw_loop_monitor，按线程登记）
+#define BINDER_STALL_THRESHOLD_MS 1000
+
+struct BinderLoopHolder {
+    int id = -1;
+    pid_t pid = 0;      // 登记时的进程，fork 后子进程中的登记已被清除，需要重新登记
+
+    ~BinderLoopHolder() {
+        if (pid == getpid()) fw_loop_unregister(id);
+    }
+};
+
+static thread_local BinderLoopHolder t_binder_loop;
+
+// 驱动 fd 每关闭一次，对应槽位的代数加一（fd 号按槽位数取模，冲突只会多清零一次计数）。
+// fd 号会被下一次 open_driver 复用，只比较 fd 会把旧驱动上放弃的事务算到新驱动上
+#define BINDER_FD_GENERATION_SLOTS 1024
+static std::atomic<uint32_t> g_driver_generation[BINDER_FD_GENERATION_SLOTS];
+
+// 本线程超时后放弃等待、回复尚未取出的同步事务数（按驱动 fd 及其代数记录）
+static thread_local int t_abandoned_fd = -1;
+static thread_local uint32_t t_abandoned_generation = 0;
+static thread_local int t_abandoned_replies = 0;
+
+static uint32_t driverGeneration(int driverFD) {
+    return g_driver_generation[(unsigned) driverFD % BINDER_FD_GENERATION_SLOTS]
+            .load(std::memory_order_acquire);
+}
+
+/**
+ * 驱动 fd 关闭前调用：之前在该 fd 上放弃的事务随旧驱动一起作废
+ */
+static void retireDriver(int driverFD) {
+    g_driver_generation[(unsigned) driverFD % BINDER_FD_GENERATION_SLOTS]
+            .fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * 本线程在该驱动上待清理的迟到回复数；驱动已更换（关闭后重新打开、fork 后重新打开）时清零
+ */
+static int pendingAbandonedReplies(int driverFD) {
+    const uint32_t generation = driverGeneration(driverFD);
+    if (t_abandoned_fd != driverFD || t_abandoned_generation != generation) {
+        t_abandoned_fd = driverFD;
+        t_abandoned_generation = generation;
+        t_abandoned_replies = 0;
+    }
+    return t_abandoned_replies;
+}
+
+/**
+ * 在等待本次事务结果之外取出并释放了一个回复：若本线程有超时放弃的事务，
+ * 这就是其中一个迟到的回复，计数减一，否则之后的每次事务都会等待一个不存在的回复
+ */
+static void consumeAbandonedReply(int driverFD) {
+    if (pendingAbandonedReplies(driverFD) > 0) {
+        t_abandoned_replies--;
+        LOGD("已释放迟到的 Binder 回复, 剩余 %d", t_abandoned_replies);
+    }
+}
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * 等待驱动 fd 可读（本线程有待处理的返回命令）
+ *
+ * 等待回复的线程 transaction_stack 非空，binder_poll 只等待本线程队列，
+ * BR_TRANSACTION_COMPLETE / BR_REPLY 入队时会唤醒。
+ */
+static status_t waitDriverReadable(int driverFD, int64_t deadline_ns) {
+    struct pollfd pfd;
+    pfd.fd = driverFD;
+    pfd.events = POLLIN;
+    for (;;) {
+        int64_t remaining_ns = deadline_ns - monotonic_ns();
+        if (remaining_ns <= 0) return TIMED_OUT;
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, (int) ((remaining_ns + 999999) / 1000000));
+        if (ret > 0) return (pfd.revents & POLLIN) ? NO_ERROR : DEAD_OBJECT;
+        if (ret < 0 && errno != EINTR) return -errno;
+    }
+}
+
+/**
+ * 直接向驱动写入 BC_FREE_BUFFER
+ */
+static void sendFreeBuffer(int driverFD, const uint8_t *data) {
+    uint8_t cmd[sizeof(uint32_t) + sizeof(binder_uintptr_t)];
+    const uint32_t code = BC_FREE_BUFFER;
+    const binder_uintptr_t buffer = (binder_uintptr_t) data;
+    memcpy(cmd, &code, sizeof(code));
+    memcpy(cmd + sizeof(code), &buffer, sizeof(buffer));
+
+    binder_write_read bwr;
+    memset(&bwr, 0, sizeof(bwr));
+    bwr.write_size = sizeof(cmd);
+    bwr.write_buffer = (binder_uintptr_t) cmd;
+    while (ioctl(driverFD, BINDER_WRITE_READ, &bwr) < 0 && errno == EINTR) {
+    }
+}
 
 int open_driver() {
     int fd = open("/dev/binder", O_RDWR | O_CLOEXEC);
@@ -60,6 +176,7 @@ void initProcessState(int mDriverFD, void *mVMStart) {
         if (mVMStart == MAP_FAILED) {
             // *sigh*
             LOGE("Using /dev/binder failed: unable to mmap transaction memory.\n");
+            retireDriver(mDriverFD);
             close(mDriverFD);
             mDriverFD = -1;
         }
@@ -68,6 +185,9 @@ void initProcessState(int mDriverFD, void *mVMStart) {
 
 void unInitProcessState(int mDriverFD, void *mVMStart) {
     if (mDriverFD >= 0) {
+        // 驱动关闭后 handle 全部失效，fd 号可能被下一次 open_driver 复用
+        fw_service_table_reset(mDriverFD);
+        retireDriver(mDriverFD);
         if (mVMStart != MAP_FAILED) {
             munmap(mVMStart, BINDER_VM_SIZE);
         }
@@ -161,8 +281,32 @@ status_t talkWithDriver(bool doReceive, int mDriverFD, Parcel &mOut, Parcel &mIn
 
 status_t
 waitForResponse(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &mOut, Parcel &mIn) {
+    return waitForResponseUntil(reply, acquireResult, mDriverFD, mOut, mIn, -1);
+}
+
+static status_t
+waitForResponseImpl(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &mOut,
+                    Parcel &mIn, int64_t deadline_ns);
+
+status_t
+waitForResponseUntil(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &mOut,
+                     Parcel &mIn, int64_t deadline_ns) {
+    if (t_binder_loop.pid != getpid()) {
+        t_binder_loop.pid = getpid();
+        t_binder_loop.id = fw_loop_register("binder_wait", BINDER_STALL_THRESHOLD_MS);
+    }
+    fw_loop_begin(t_binder_loop.id);
+    status_t err = waitForResponseImpl(reply, acquireResult, mDriverFD, mOut, mIn, deadline_ns);
+    fw_loop_end(t_binder_loop.id);
+    return err;
+}
+
+static status_t
+waitForResponseImpl(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &mOut,
+                    Parcel &mIn, int64_t deadline_ns) {
     uint32_t cmd;
     int32_t err;
+    bool transactionComplete = false;
     LOGD("%lu %lu", mOut.dataSize(), mIn.dataSize());
 
 //    LOGD("BR_TRANSACTION_COMPLETE %d", BR_TRANSACTION_COMPLETE);
@@ -184,6 +328,15 @@ waitForResponse(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &m
 //    err = talkWithDriver(false, mDriverFD, mOut, mIn);
 //    LOGD("talkWithDriver %d", err);
     while (1) {
+        // 有截止时间时：先只写不读，再 poll 等待返回命令，避免阻塞在驱动读取中
+        if (deadline_ns >= 0 && mIn.dataPosition() >= mIn.dataSize()) {
+            if (mOut.dataSize() > 0 &&
+                (err = talkWithDriver(false, mDriverFD, mOut, mIn)) < NO_ERROR) break;
+            if ((err = waitDriverReadable(mDriverFD, deadline_ns)) != NO_ERROR) {
+                if (err == TIMED_OUT) goto timed_out;
+                break;
+            }
+        }
         if ((err = talkWithDriver(true, mDriverFD, mOut, mIn)) < NO_ERROR) break;
 //        err = mIn.errorCheck();
 //        if (err < NO_ERROR) break;
@@ -195,6 +348,7 @@ waitForResponse(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &m
         switch (cmd) {
             case BR_TRANSACTION_COMPLETE:
                 LOGD("BR_TRANSACTION_COMPLETE");
+                transactionComplete = true;
                 if (!reply && !acquireResult) goto finish;
                 LOGD("bingo!");
                 break;
@@ -234,21 +388,23 @@ waitForResponse(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &m
                                 tr.data_size,
                                 reinterpret_cast<const binder_size_t *>(tr.data.ptr.offsets),
                                 tr.offsets_size / sizeof(size_t),
-                                freeBuffer, NULL);
+                                freeBuffer, BINDER_FD_COOKIE(mDriverFD));
                     } else {
                         err = *(const status_t *) (tr.data.ptr.buffer);
                         freeBuffer(NULL,
                                    reinterpret_cast<const uint8_t *>(tr.data.ptr.buffer),
                                    tr.data_size,
                                    reinterpret_cast<const binder_size_t *>(tr.data.ptr.offsets),
-                                   tr.offsets_size / sizeof(size_t), NULL);
+                                   tr.offsets_size / sizeof(size_t), BINDER_FD_COOKIE(mDriverFD));
                     }
                 } else {
+                    // 不等待回复时收到的回复只能是之前超时放弃的事务的
                     freeBuffer(NULL,
                                reinterpret_cast<const uint8_t *>(tr.data.ptr.buffer),
                                tr.data_size,
                                reinterpret_cast<const binder_size_t *>(tr.data.ptr.offsets),
-                               tr.offsets_size / sizeof(size_t), NULL);
+                               tr.offsets_size / sizeof(size_t), BINDER_FD_COOKIE(mDriverFD));
+                    consumeAbandonedReply(mDriverFD);
                     continue;
                 }
                 goto finish;
@@ -261,6 +417,17 @@ waitForResponse(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &m
         }
     }
 
+    goto finish;
+
+    timed_out:
+    g_transact_timeouts.fetch_add(1, std::memory_order_relaxed);
+    // 同步事务的回复会晚些到达，留给本线程下一次事务前清理
+    if (reply || acquireResult) {
+        pendingAbandonedReplies(mDriverFD);
+        t_abandoned_replies++;
+    }
+    LOGW("等待 Binder 响应超时 (transactionComplete=%d)", transactionComplete);
+
     finish:
     if (err != NO_ERROR) {
         LOGE("executeCommand err=%d", err);
@@ -302,45 +469,327 @@ status_t writeTransactionData(int32_t cmd, uint32_t binderFlags,
         return err;
     }
 
+    // 附加了外部缓冲区时改用 SG 命令，驱动按 buffers_size 在目标缓冲区中预留空间
+    const size_t buffersSize = err == NO_ERROR ? data.ipcBuffersSize() : 0;
+    if (buffersSize > 0 && (cmd == BC_TRANSACTION || cmd == BC_REPLY)) {
+        binder_transaction_data_sg sg;
+        sg.transaction_data = tr;
+        sg.buffers_size = buffersSize;
+        mOut.writeInt32(cmd == BC_TRANSACTION ? BC_TRANSACTION_SG : BC_REPLY_SG);
+        mOut.write(&sg, sizeof(sg));
+        return NO_ERROR;
+    }
+
     mOut.writeInt32(cmd);
     mOut.write(&tr, sizeof(tr));
 
     return NO_ERROR;
 }
 
+/**
+ * 取出本线程之前超时放弃的事务的迟到回复并释放
+ *
+ * 驱动中这些事务仍在本线程的 transaction_stack 上，取出回复前本线程的新同步事务
+ * 会被驱动以 BR_FAILED_REPLY 拒绝。
+ */
+static status_t drainAbandonedReplies(int driverFD, Parcel &mOut, Parcel &mIn,
+                                      int64_t deadline_ns) {
+    status_t err = NO_ERROR;
+    while (pendingAbandonedReplies(driverFD) > 0) {
+        if (mIn.dataPosition() >= mIn.dataSize()) {
+            if (deadline_ns >= 0 && (err = waitDriverReadable(driverFD, deadline_ns)) != NO_ERROR) {
+                break;
+            }
+            if ((err = talkWithDriver(true, driverFD, mOut, mIn)) < NO_ERROR) break;
+            if (mIn.dataAvail() == 0) continue;
+        }
+
+        const uint32_t cmd = mIn.readInt32();
+        switch (cmd) {
+            case BR_TRANSACTION_COMPLETE:
+                break;
+            case BR_REPLY: {
+                binder_transaction_data tr;
+                if ((err = mIn.read(&tr, sizeof(tr))) != NO_ERROR) return err;
+                sendFreeBuffer(driverFD, reinterpret_cast<const uint8_t *>(tr.data.ptr.buffer));
+                consumeAbandonedReply(driverFD);
+                break;
+            }
+            case BR_DEAD_REPLY:
+            case BR_FAILED_REPLY:
+                consumeAbandonedReply(driverFD);
+                break;
+            default:
+                if ((err = executeCommand(cmd, mIn, mOut)) != NO_ERROR) return err;
+                break;
+        }
+    }
+    return err;
+}
+
+// ==================== 单向事务合并提交 ====================
+//
+// Flat combining：每个线程占用一个槽位，把待发送的事务发布到槽位中；拿到合并锁的线程
+// 收集所有待发送的槽位，一次 BINDER_WRITE_READ 写入全部 BC_TRANSACTION，再按顺序把
+// 驱动返回的结果填回各槽位。并发压力下 ioctl 次数与合并轮数成正比，而不是与调用次数
+// 成正比。只合并单向事务：同步事务的回复会投递到发起线程，不能由其他线程代发。
+
+#define ONEWAY_SLOT_COUNT   64  // 槽位数，超出的线程走独立路径
+#define ONEWAY_BATCH_MAX    32  // 每轮最多合并的事务数
+#define ONEWAY_MAX_PASSES   4   // 合并线程每次持锁最多执行的轮数
+#define ONEWAY_SPIN_LIMIT   64  // 等待结果时让出 CPU 前的自旋次数
+
+enum {
+    ONEWAY_SLOT_IDLE = 0,
+    ONEWAY_SLOT_PENDING,
+    ONEWAY_SLOT_DONE,
+};
+
+struct OnewaySlot {
+    std::atomic<bool> owned{false};
+    std::atomic<int> state{ONEWAY_SLOT_IDLE};
+    int driverFD = -1;
+    int32_t handle = 0;
+    uint32_t code = 0;
+    uint32_t flags = 0;
+    const Parcel *data = nullptr;
+    status_t result = NO_ERROR;
+};
+
+static OnewaySlot g_oneway_slots[ONEWAY_SLOT_COUNT];
+// 曾被占用的最大槽位下标 + 1，缩短扫描范围
+static std::atomic<int> g_oneway_slot_limit{0};
+static std::mutex g_oneway_combiner;
+
+static std::atomic<uint64_t> g_oneway_calls{0};
+static std::atomic<uint64_t> g_oneway_rounds{0};
+static std::atomic<uint64_t> g_oneway_ioctls{0};
+
+/**
+ * 线程退出时归还槽位
+ */
+struct OnewaySlotHolder {
+    int index = -1;
+
+    ~OnewaySlotHolder() {
+        if (index >= 0) g_oneway_slots[index].owned.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local OnewaySlotHolder t_oneway_slot;
+
+static OnewaySlot *acquireOnewaySlot() {
+    if (t_oneway_slot.index >= 0) return &g_oneway_slots[t_oneway_slot.index];
+
+    for (int i = 0; i < ONEWAY_SLOT_COUNT; i++) {
+        bool expected = false;
+        if (g_oneway_slots[i].owned.compare_exchange_strong(expected, true,
+                                                            std::memory_order_acquire)) {
+            t_oneway_slot.index = i;
+            int limit = g_oneway_slot_limit.load(std::memory_order_relaxed);
+            while (limit < i + 1 &&
+                   !g_oneway_slot_limit.compare_exchange_weak(limit, i + 1,
+                                                              std::memory_order_release)) {
+            }
+            return &g_oneway_slots[i];
+        }
+    }
+    return nullptr;
+}
+
+static inline void finishOnewaySlot(OnewaySlot *slot, status_t result) {
+    slot->result = result;
+    slot->state.store(ONEWAY_SLOT_DONE, std::memory_order_release);
+}
+
+/**
+ * 执行一轮合并（调用方持有 g_oneway_combiner）
+ *
+ * 一轮只处理同一个驱动 fd 的槽位，其他 fd 的留给下一轮。
+ *
+ * @return 本轮处理的槽位数
+ */
+static int combineOnewayRound() {
+    OnewaySlot *batch[ONEWAY_BATCH_MAX];
+    int count = 0;
+    int driverFD = -1;
+
+    const int limit = g_oneway_slot_limit.load(std::memory_order_acquire);
+    for (int i = 0; i < limit && count < ONEWAY_BATCH_MAX; i++) {
+        OnewaySlot &slot = g_oneway_slots[i];
+        if (slot.state.load(std::memory_order_acquire) != ONEWAY_SLOT_PENDING) continue;
+        if (driverFD < 0) {
+            driverFD = slot.driverFD;
+        } else if (slot.driverFD != driverFD) {
+            continue;
+        }
+        batch[count++] = &slot;
+    }
+    if (count == 0) return 0;
+    g_oneway_rounds.fetch_add(1, std::memory_order_relaxed);
+
+    Parcel mOut;
+    mOut.setDataCapacity(count * (sizeof(uint32_t) + sizeof(binder_transaction_data_sg)));
+    Parcel mIn;
+    mIn.setDataCapacity(256);
+
+    int submitted = 0;
+    for (int i = 0; i < count; i++) {
+        OnewaySlot *slot = batch[i];
+        status_t err = writeTransactionData(BC_TRANSACTION, slot->flags, slot->handle, slot->code,
+                                            *slot->data, mOut, NULL);
+        if (err != NO_ERROR) {
+            finishOnewaySlot(slot, err);
+            continue;
+        }
+        batch[submitted++] = slot;
+    }
+
+    // 驱动按顺序处理写入的命令，每个单向事务对应一个结果命令；某个事务失败时驱动停止
+    // 处理后续命令，未写入的部分留在 mOut 中，下一次 talkWithDriver 继续写入
+    int resolved = 0;
+    status_t err = NO_ERROR;
+    while (resolved < submitted) {
+        if (mIn.dataPosition() >= mIn.dataSize()) {
+            g_oneway_ioctls.fetch_add(1, std::memory_order_relaxed);
+            if ((err = talkWithDriver(true, driverFD, mOut, mIn)) < NO_ERROR) break;
+            if (mIn.dataAvail() == 0) continue;
+        }
+
+        const uint32_t cmd = mIn.readInt32();
+        switch (cmd) {
+            case BR_TRANSACTION_COMPLETE:
+                finishOnewaySlot(batch[resolved++], NO_ERROR);
+                break;
+            case BR_DEAD_REPLY:
+                finishOnewaySlot(batch[resolved++], DEAD_OBJECT);
+                break;
+            case BR_FAILED_REPLY:
+                finishOnewaySlot(batch[resolved++], FAILED_TRANSACTION);
+                break;
+            case BR_REPLY: {
+                // 不属于本轮的回复（合并线程提交前已清理迟到回复，正常不会出现），直接释放
+                binder_transaction_data tr;
+                if ((err = mIn.read(&tr, sizeof(tr))) != NO_ERROR) break;
+                sendFreeBuffer(driverFD, reinterpret_cast<const uint8_t *>(tr.data.ptr.buffer));
+                consumeAbandonedReply(driverFD);
+                break;
+            }
+            default:
+                err = executeCommand(cmd, mIn, mOut);
+                break;
+        }
+        if (err != NO_ERROR) break;
+    }
+
+    if (resolved < submitted) {
+        LOGE("合并提交单向事务失败: %d (%d/%d)", err, resolved, submitted);
+        while (resolved < submitted) {
+            finishOnewaySlot(batch[resolved++], err != NO_ERROR ? err : UNKNOWN_ERROR);
+        }
+    }
+    return count;
+}
+
+/**
+ * 通过合并提交发送单向事务
+ *
+ * @return false 表示未处理（无空闲槽位，或本线程有待清理的迟到回复），调用方走独立路径
+ */
+static bool submitOnewayCombined(int32_t handle, uint32_t code, const Parcel &data,
+                                 uint32_t flags, int driverFD, status_t *result) {
+    // 迟到回复留在本线程的驱动队列中，本线程作为合并线程读取时会与本轮结果混在一起
+    if (driverFD <= 0 || pendingAbandonedReplies(driverFD) > 0) return false;
+
+    OnewaySlot *slot = acquireOnewaySlot();
+    if (slot == nullptr) return false;
+
+    slot->driverFD = driverFD;
+    slot->handle = handle;
+    slot->code = code;
+    slot->flags = flags;
+    slot->data = &data;
+    slot->state.store(ONEWAY_SLOT_PENDING, std::memory_order_release);
+    g_oneway_calls.fetch_add(1, std::memory_order_relaxed);
+
+    int spins = 0;
+    while (slot->state.load(std::memory_order_acquire) != ONEWAY_SLOT_DONE) {
+        if (g_oneway_combiner.try_lock()) {
+            for (int pass = 0; pass < ONEWAY_MAX_PASSES; pass++) {
+                if (combineOnewayRound() == 0) break;
+            }
+            g_oneway_combiner.unlock();
+            spins = 0;
+        } else if (++spins >= ONEWAY_SPIN_LIMIT) {
+            sched_yield();
+        }
+    }
+
+    *result = slot->result;
+    slot->data = nullptr;
+    slot->state.store(ONEWAY_SLOT_IDLE, std::memory_order_relaxed);
+    return true;
+}
+
 status_t
 write_transact(int32_t handle, uint32_t code, const Parcel &data, Parcel *reply, uint32_t flags,
                int driverFD) {
+    return write_transact_timeout(handle, code, data, reply, flags, driverFD, BINDER_NO_TIMEOUT);
+}
+
+status_t
+write_transact_timeout(int32_t handle, uint32_t code, const Parcel &data, Parcel *reply,
+                       uint32_t flags, int driverFD, int timeout_ms) {
+    const int64_t deadline_ns = timeout_ms >= 0
+                                ? monotonic_ns() + (int64_t) timeout_ms * 1000000LL : -1;
     flags |= TF_ACCEPT_FDS;
     status_t err = data.errorCheck();
-    Parcel *mOut = new Parcel;
-    mOut->setDataCapacity(256);
-    err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, *mOut, NULL);
-    LOGD("%lu %lu", data.dataSize(), mOut->dataSize());
+    if ((flags & TF_ONE_WAY) != 0 && timeout_ms < 0 &&
+        submitOnewayCombined(handle, code, data, flags, driverFD, &err)) {
+        return err;
+    }
+    // 命令缓冲区放在栈上，256 字节以内使用 Parcel 的内联缓冲区，不分配堆内存
+    Parcel mOut;
+    mOut.setDataCapacity(256);
+    err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, mOut, NULL);
+    LOGD("%lu %lu", data.dataSize(), mOut.dataSize());
     if (err != NO_ERROR) {
         LOGE("writeTransactionData error occurred: %s, %d,%d", strerror(errno), errno, err);
-        delete mOut;
         return err;
     }
 
-    Parcel *mIn = new Parcel;
-    mIn->setDataCapacity(256);
+    Parcel mIn;
+    mIn.setDataCapacity(256);
 //    uint8_t data_in[128];
 //    mIn.setData(data_in, 128);
 //    mIn.setDataCapacity(128);
 //    mIn.setDataPosition(0);
+    if (pendingAbandonedReplies(driverFD) > 0) {
+        // 单向事务同样先清理：否则迟到的 BR_DEAD_REPLY / BR_FAILED_REPLY 与本次事务的结果无法区分，
+        // 迟到的 BR_TRANSACTION_COMPLETE 也会被当作本次事务已提交
+        // 事务数据仍在 mOut 中尚未写入驱动，清理时产生的命令使用单独的输出缓冲区
+        Parcel pendingOut;
+        err = drainAbandonedReplies(driverFD, pendingOut, mIn, deadline_ns);
+        if (err == NO_ERROR && pendingOut.dataSize() > 0) {
+            err = talkWithDriver(false, driverFD, pendingOut, mIn);
+        }
+        if (err != NO_ERROR) {
+            if (err == TIMED_OUT) g_transact_timeouts.fetch_add(1, std::memory_order_relaxed);
+            LOGE("清理迟到的 Binder 回复失败: %d", err);
+            if (reply) reply->setError(err);
+            return err;
+        }
+    }
     if ((flags & TF_ONE_WAY) == 0) {
         if (reply) { // Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &mOut, Parcel &mIn
-            err = waitForResponse(reply, NULL, driverFD, *mOut, *mIn);
+            err = waitForResponseUntil(reply, NULL, driverFD, mOut, mIn, deadline_ns);
         } else {
             Parcel fakeReply;
-            err = waitForResponse(&fakeReply, NULL, driverFD, *mOut, *mIn);
+            err = waitForResponseUntil(&fakeReply, NULL, driverFD, mOut, mIn, deadline_ns);
         }
     } else {
-        err = waitForResponse(NULL, NULL, driverFD, *mOut, *mIn);
+        err = waitForResponseUntil(NULL, NULL, driverFD, mOut, mIn, deadline_ns);
     }
-    delete mIn;
-    delete mOut;
     return err;
 }
 
@@ -584,11 +1033,26 @@ status_t executeCommand(uint32_t cmd, Parcel &mIn, Parcel &mOut) {
 void freeBuffer(Parcel *parcel,
                 const uint8_t *data, size_t /*dataSize*/,
                 const binder_size_t * /*objects*/, size_t /*objectsSize*/,
-                void * /*cookie*/) {
+                void *cookie) {
     //ALOGI("Freeing parcel %p", &parcel);
     LOGD("Writing BC_FREE_BUFFER for %p", data);
     if (parcel != NULL) parcel->closeFileDescriptors();
 //    IPCThreadState* state = self();
 //    state->mOut.writeInt32(BC_FREE_BUFFER);
 //    state->mOut.writePointer((uintptr_t)data);
+    // 没有 IPCThreadState 的 mOut 可以延迟写入，直接写给驱动
+    const int driverFD = (int) reinterpret_cast<intptr_t>(cookie);
+    if (driverFD > 0 && data != NULL) {
+        sendFreeBuffer(driverFD, data);
+    }
+}
+
+uint64_t binder_transact_timeout_count() {
+    return g_transact_timeouts.load(std::memory_order_relaxed);
+}
+
+void binder_oneway_combiner_stats(uint64_t *calls, uint64_t *rounds, uint64_t *ioctls) {
+    if (calls) *calls = g_oneway_calls.load(std::memory_order_relaxed);
+    if (rounds) *rounds = g_oneway_rounds.load(std::memory_order_relaxed);
+    if (ioctls) *ioctls = g_oneway_ioctls.load(std::memory_order_relaxed);
 }
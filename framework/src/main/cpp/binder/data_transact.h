@@ -11,11 +11,14 @@
  *   - open_driver：打开 Binder 驱动
  *   - initProcessState/unInitProcessState：进程状态管理
  *   - write_transact：发起 Binder 事务
+ *   - write_transact_timeout：带截止时间的 Binder 事务
  *   - writeTransactionData：写入事务数据
- *   - waitForResponse：等待响应
+ *   - waitForResponse / waitForResponseUntil：等待响应（可带截止时间）
  *   - talkWithDriver：与驱动通信
  *   - executeCommand：执行命令
  *   - freeBuffer：释放缓冲区
+ *   - binder_transact_timeout_count：事务超时次数
+ *   - binder_oneway_combiner_stats：单向事务合并提交统计
  *
  * @author Pangu-Immortal
  * @github https://github.com/Pangu-Immortal/KeepLiveService
@@ -38,6 +41,12 @@
 #define BINDER_VM_SIZE ((1 * 1024 * 1024) - sysconf(_SC_PAGE_SIZE) * 2)
 #define DEFAULT_MAX_BINDER_THREADS 15
 
+// 不限制等待时间
+#define BINDER_NO_TIMEOUT (-1)
+
+// 把驱动 fd 作为 freeBuffer 的 cookie 传递（与 talkWithDriver 一致，fd <= 0 视为无效）
+#define BINDER_FD_COOKIE(fd) reinterpret_cast<void *>(static_cast<intptr_t>(fd))
+
 using namespace android;
 extern "C" {
 int open_driver();
@@ -49,12 +58,42 @@ status_t
 write_transact(int32_t handle, uint32_t code, const Parcel &data, Parcel *reply, uint32_t flags,
                int driverFD);
 
+/**
+ * 带截止时间的 Binder 事务
+ *
+ * 不限时的单向事务（TF_ONE_WAY）经过合并提交：多个线程同时发送时，由其中一个线程
+ * 把所有待发送的事务合并为一次 BINDER_WRITE_READ 写入驱动，再把各自的结果交还。
+ *
+ * Binder 驱动不支持取消事务。超时后当前线程放弃等待并返回 TIMED_OUT，
+ * 迟到的回复留在本线程的驱动队列中，本线程下一次发起事务前先将其取出并
+ * 通过 BC_FREE_BUFFER 释放（同步和单向事务都是如此），否则驱动会拒绝本线程的新同步事务。
+ * 迟到的回复尚未到达时，清理会等到本次事务的截止时间为止。
+ *
+ * @param timeout_ms 超时时间（毫秒），BINDER_NO_TIMEOUT 表示一直等待
+ */
+status_t
+write_transact_timeout(int32_t handle, uint32_t code, const Parcel &data, Parcel *reply,
+                       uint32_t flags, int driverFD, int timeout_ms);
+
+/**
+ * 写入事务命令
+ *
+ * data 中带有外部缓冲区（Parcel::writeBufferObject）时，BC_TRANSACTION / BC_REPLY
+ * 分别改为 BC_TRANSACTION_SG / BC_REPLY_SG（驱动需支持，Android 8.0 起）
+ */
 status_t writeTransactionData(int32_t cmd, uint32_t binderFlags, int32_t handle, uint32_t code,
                               const Parcel &data, Parcel &mOut, status_t *statusBuffer);
 
 status_t
 waitForResponse(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &mOut, Parcel &mIn);
 
+/**
+ * 等待响应，超过 deadline_ns（CLOCK_MONOTONIC）返回 TIMED_OUT，< 0 表示不限制
+ */
+status_t
+waitForResponseUntil(Parcel *reply, status_t *acquireResult, int mDriverFD, Parcel &mOut,
+                     Parcel &mIn, int64_t deadline_ns);
+
 status_t talkWithDriver(bool doReceive, int mDriverFD, Parcel &mOut, Parcel &mIn);
 
 status_t executeCommand(uint32_t cmd, Parcel &mIn, Parcel &mOut);
@@ -63,9 +102,28 @@ status_t executeCommand(uint32_t cmd, Parcel &mIn, Parcel &mOut);
 //                size_t /*dataSize*/,
 //                const binder_size_t* /*objects*/,
 //                size_t /*objectsSize*/, void* /*cookie*/);
+/**
+ * 释放驱动分配的事务缓冲区
+ *
+ * cookie 为驱动 fd（BINDER_FD_COOKIE），为 NULL 时只关闭文件描述符
+ */
 void freeBuffer(Parcel* parcel,
                 const uint8_t* data, size_t dataSize,
                 const binder_size_t* objects, size_t objectsSize,
                 void* cookie);
+
+/**
+ * 事务超时（返回 TIMED_OUT）的累计次数
+ */
+uint64_t binder_transact_timeout_count();
+
+/**
+ * 单向事务合并提交统计
+ *
+ * @param calls  经过合并提交的事务数
+ * @param rounds 合并轮数
+ * @param ioctls 合并线程发起的 BINDER_WRITE_READ 次数
+ */
+void binder_oneway_combiner_stats(uint64_t *calls, uint64_t *rounds, uint64_t *ioctls);
 }
 #endif //FW_DATA_TRANSACT_H
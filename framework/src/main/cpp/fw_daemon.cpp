@@ -44,14 +44,24 @@
 #include <signal.h>
 #include <errno.h>
 #include <android/log.h>
+#include "fw_tokenlog.h"
+#include "fw_event_bus.h"
+#include "fw_loop_monitor.h"
+#include "fw_status_board.h"
+#include "fw_wakeup.h"
 #include <cstdlib>
 #include <cstring>
 
 #define LOG_TAG "FwNative"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) FW_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// 一次存活检查 + 唤醒尝试超过该时间视为卡顿（am 命令本身需要数百毫秒）
+#define DAEMON_STALL_THRESHOLD_MS 5000
+// 守护进程中看门狗的检查间隔
+#define DAEMON_WATCHDOG_TICK_MS 1000
 
 // 守护进程配置
 struct DaemonConfig {
@@ -186,13 +196,25 @@ static void daemon_main_loop() {
     int consecutive_failures = 0;
     const int max_consecutive_failures = 3;
 
+    // 子进程不继承父进程的看门狗线程，在这里单独启动
+    const int loop_id = fw_loop_register("daemon_main", DAEMON_STALL_THRESHOLD_MS);
+    fw_loop_watchdog_start(DAEMON_WATCHDOG_TICK_MS);
+    const int wakeup_id = fw_wakeup_register("daemon_main");
+    // 状态板映射随 fork 继承，守护进程占用自己的槽位
+    if (fw_status_board_claim("fw_daemon") >= 0) {
+        fw_status_board_set_status(FW_STATUS_OK);
+    }
+
     while (g_daemon_running) {
         // 等待指定间隔
-        usleep(g_config.check_interval_ms * 1000);
+        fw_wakeup_sleep_ms(wakeup_id, g_config.check_interval_ms);
+        fw_loop_begin(loop_id);
+        fw_status_board_beat();
 
         // 检查父进程是否存活
         if (!is_process_alive(g_config.parent_pid)) {
             LOGW("检测到父进程已死亡（PID: %d），尝试唤醒...", g_config.parent_pid);
+            fw_event_publish(fw_daemon_event{FW_DAEMON_EVENT_PARENT_DIED, g_config.parent_pid});
 
             bool success = false;
 
@@ -213,15 +235,17 @@ static void daemon_main_loop() {
             if (success) {
                 LOGI("唤醒尝试完成，等待进程重启...");
                 consecutive_failures = 0;
+                fw_loop_end(loop_id);
 
                 // 等待一段时间让进程启动
-                sleep(5);
+                fw_wakeup_sleep_ms(wakeup_id, 5000);
 
                 // 重新获取父进程 PID（这里需要通过其他方式获取，暂时简化处理）
                 // 实际实现中可以通过 socket 或文件通信获取新的 PID
             } else {
                 consecutive_failures++;
                 LOGE("唤醒失败，连续失败次数: %d", consecutive_failures);
+                fw_event_publish(fw_daemon_event{FW_DAEMON_EVENT_WAKE_FAILED, g_config.parent_pid});
 
                 if (consecutive_failures >= max_consecutive_failures) {
                     LOGE("连续失败次数过多，守护进程退出");
@@ -232,7 +256,10 @@ static void daemon_main_loop() {
             // 父进程存活，重置失败计数
             consecutive_failures = 0;
         }
+        fw_loop_end(loop_id);
     }
+    fw_loop_watchdog_stop();
+    fw_status_board_release();
 
     LOGI("Native 守护进程退出");
 }
@@ -302,6 +329,7 @@ extern "C" int start_daemon(const char* package_name,
     } else {
         // 父进程
         LOGI("守护子进程 PID: %d", pid);
+        fw_event_publish(fw_daemon_event{FW_DAEMON_EVENT_STARTED, pid});
 
         // 不等待子进程，让子进程独立运行
         // waitpid(pid, NULL, WNOHANG);
@@ -316,6 +344,7 @@ extern "C" int start_daemon(const char* package_name,
 extern "C" void stop_daemon() {
     LOGI("请求停止 Native 守护进程");
     g_daemon_running = false;
+    fw_event_publish(fw_daemon_event{FW_DAEMON_EVENT_STOP_REQUESTED, 0});
 }
 
 /**
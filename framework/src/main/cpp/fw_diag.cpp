@@ -0,0 +1,56 @@
+/**
+ * ============================================================================
+ * fw_diag.cpp - Native 诊断模块入口
+ * ============================================================================
+ *
+ * 功能简介：
+ *   与 fw_loop_monitor.cpp、fw_wakeup.cpp、fw_status_board.cpp 一起编译为
+ *   独立的 libfw_diag.so，只导出 fw_diag_module_get。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_diag.h"
+
+// ==================== 模块入口 ====================
+
+/**
+ * 返回函数表（常量初始化的静态对象，不产生全局构造函数）
+ */
+extern "C" FW_EXPORT const FwDiagModule *fw_diag_module_get() {
+    static const FwDiagModule module = {
+            FW_DIAG_MODULE_VERSION,
+            fw_loop_register,
+            fw_loop_unregister,
+            fw_loop_begin,
+            fw_loop_end,
+            fw_loop_watchdog_start,
+            fw_loop_watchdog_stop,
+            fw_loop_dump,
+            fw_wakeup_register,
+            fw_wakeup_begin,
+            fw_wakeup_end,
+            fw_wakeup_select,
+            fw_wakeup_poll,
+            fw_wakeup_epoll_wait,
+            fw_wakeup_sleep_ms,
+            fw_wakeup_get_stats,
+            fw_wakeup_dump,
+            fw_status_board_create,
+            fw_status_board_attach,
+            fw_status_board_fd,
+            fw_status_board_send_fd,
+            fw_status_board_recv_fd,
+            fw_status_board_claim,
+            fw_status_board_release,
+            fw_status_board_beat,
+            fw_status_board_set_status,
+            fw_status_board_set_gauge,
+            fw_status_board_read,
+            fw_status_board_find,
+            fw_status_board_dump,
+    };
+    return &module;
+}
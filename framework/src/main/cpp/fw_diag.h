@@ -0,0 +1,126 @@
+/**
+ * ============================================================================
+ * fw_diag.h - Native 诊断模块
+ * ============================================================================
+ *
+ * 功能简介：
+ *   循环卡顿监控（fw_loop_monitor.h）、唤醒归因（fw_wakeup.h）、跨进程状态板
+ *   （fw_status_board.h）默认都不需要，此前却常驻在 libfw_native.so 中，
+ *   每个进程都要承担它们的加载和重定位开销。
+ *
+ *   三者编译为一个独立的 libfw_diag.so（相互之间有调用，拆成一个模块），
+ *   由 FwNative.enableNativeDiagnostics() 或 startNativeLoopWatchdog() 加载。
+ *   加载前这三组接口由 fw_native 中的同名函数退化处理（见 fw_module_forward.cpp）。
+ *
+ * 限制：
+ *   - 模块加载前登记的循环和唤醒组件 ID 为 -1，加载后也不会被统计，
+ *     需在启动 Socket 服务、守护进程之前开启
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_DIAG_H
+#define FW_DIAG_H
+
+#include "fw_loop_monitor.h"
+#include "fw_module.h"
+#include "fw_status_board.h"
+#include "fw_wakeup.h"
+
+#define FW_DIAG_MODULE_LIB      "libfw_diag.so"
+#define FW_DIAG_MODULE_ENTRY    "fw_diag_module_get"
+#define FW_DIAG_MODULE_VERSION  1
+
+/**
+ * 诊断模块函数表（libfw_diag.so 提供），函数与同名的 fw_loop_* / fw_wakeup_* /
+ * fw_status_board_* 一一对应
+ */
+struct FwDiagModule {
+    uint32_t version;   // FW_DIAG_MODULE_VERSION
+
+    // ==================== 循环卡顿监控 ====================
+
+    int (*loopRegister)(const char *name, int stall_threshold_ms);
+
+    void (*loopUnregister)(int id);
+
+    void (*loopBegin)(int id);
+
+    void (*loopEnd)(int id);
+
+    bool (*loopWatchdogStart)(int tick_ms);
+
+    void (*loopWatchdogStop)();
+
+    size_t (*loopDump)(char *buffer, size_t size);
+
+    // ==================== 唤醒归因 ====================
+
+    int (*wakeupRegister)(const char *component);
+
+    int64_t (*wakeupBegin)(int id);
+
+    void (*wakeupEnd)(int id, int reason, int64_t begin_ns);
+
+    int (*wakeupSelect)(int id, int nfds, fd_set *readfds, fd_set *writefds,
+                        fd_set *exceptfds, struct timeval *timeout);
+
+    int (*wakeupPoll)(int id, struct pollfd *fds, nfds_t nfds, int timeout_ms);
+
+    int (*wakeupEpollWait)(int id, int epfd, struct epoll_event *events,
+                           int max_events, int timeout_ms);
+
+    void (*wakeupSleepMs)(int id, int64_t ms);
+
+    bool (*wakeupGetStats)(int id, fw_wakeup_stats *stats);
+
+    size_t (*wakeupDump)(char *buffer, size_t size);
+
+    // ==================== 跨进程状态板 ====================
+
+    bool (*boardCreate)();
+
+    bool (*boardAttach)(int fd);
+
+    int (*boardFd)();
+
+    bool (*boardSendFd)(int socket_fd);
+
+    bool (*boardRecvFd)(int socket_fd, int timeout_ms);
+
+    int (*boardClaim)(const char *name);
+
+    void (*boardRelease)();
+
+    void (*boardBeat)();
+
+    void (*boardSetStatus)(int status);
+
+    void (*boardSetGauge)(int index, int64_t value);
+
+    bool (*boardRead)(int slot, fw_status_snapshot *snapshot);
+
+    bool (*boardFind)(pid_t pid, fw_status_snapshot *snapshot);
+
+    size_t (*boardDump)(char *buffer, size_t size);
+};
+
+extern "C" {
+
+/**
+ * 获取诊断模块（首次调用时 dlopen，线程安全）
+ *
+ * @return 函数表，加载失败返回 nullptr（失败结果会被缓存，不会重复尝试）
+ */
+const FwDiagModule *fw_diag_module();
+
+/**
+ * 获取已加载的诊断模块（不触发加载），各监控点的转发路径使用
+ */
+const FwDiagModule *fw_diag_module_if_loaded();
+
+}
+
+#endif // FW_DIAG_H
@@ -0,0 +1,420 @@
+/**
+ * ============================================================================
+ * fw_event_bus.cpp - 进程内 Native 事件总线实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   通道是单生产者的覆盖式环形缓冲区，每个槽位 64 字节：
+ *   stamp + 7 个字（类型/大小/通道、seq、时间戳、32 字节负载）。
+ *   写入第 t 个事件时 stamp 先写 2t+1，写完后写 2t+2，再推进 head；
+ *   订阅者读取第 c 个事件时要求读前读后的 stamp 都等于 2c+2，
+ *   否则说明该槽位已被更新的事件覆盖，计为丢弃。
+ *
+ *   所有共享字段都是原子类型，发布者和订阅者之间没有锁。
+ *   订阅 / 取消订阅、通道的首次分配只在各自的慢路径上执行。
+ *
+ *   编译为独立的 libfw_event_bus.so，只导出 fw_event_bus_module_get。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_event_bus.h"
+
+#include <atomic>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <android/log.h>
+#include "fw_tokenlog.h"
+#include "fw_wakeup.h"
+
+#define LOG_TAG "FwEventBus"
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+#define LANE_MASK (FW_EVENT_LANE_CAPACITY - 1)
+#define PAYLOAD_WORDS (FW_EVENT_PAYLOAD_SIZE / sizeof(uint64_t))
+
+static_assert((FW_EVENT_LANE_CAPACITY & LANE_MASK) == 0, "通道容量必须是 2 的幂");
+static_assert(FW_EVENT_PAYLOAD_SIZE % sizeof(uint64_t) == 0, "负载大小必须是 8 的倍数");
+
+// ==================== 通道 ====================
+
+struct alignas(64) LaneSlot {
+    std::atomic<uint64_t> stamp;
+    std::atomic<uint64_t> header;               // type | size << 16 | lane << 32
+    std::atomic<uint64_t> seq;
+    std::atomic<int64_t> timestamp_ns;
+    std::atomic<uint64_t> payload[PAYLOAD_WORDS];
+};
+
+static_assert(sizeof(LaneSlot) == 64, "槽位应为一个缓存行");
+
+struct Lane {
+    std::atomic<pid_t> owner;                   // 占用通道的线程，0 表示空闲
+    std::atomic<uint64_t> head;                 // 下一个写入位置
+    std::atomic<LaneSlot *> slots;              // 首次占用时分配，之后不释放
+};
+
+static Lane g_lanes[FW_EVENT_MAX_LANES];
+static std::atomic<uint64_t> g_next_seq{0};
+static std::atomic<uint64_t> g_published{0};
+static std::atomic<uint64_t> g_no_lane{0};      // 没有可用通道而发布失败的次数
+
+/**
+ * 线程退出时释放通道
+ */
+struct LaneHolder {
+    int index = -1;
+
+    ~LaneHolder() {
+        if (index >= 0) g_lanes[index].owner.store(0, std::memory_order_release);
+    }
+};
+
+static thread_local LaneHolder t_lane;
+
+// ==================== 订阅者 ====================
+
+struct fw_event_subscriber {
+    std::atomic<bool> active;
+    std::atomic<uint32_t> mask;
+    std::atomic<bool> waiting;                  // 订阅者正在等待，发布者需要写 eventfd
+    int event_fd;                               // 首次使用时创建，槽位复用时保留
+    char name[FW_EVENT_NAME_LEN];
+    uint64_t cursors[FW_EVENT_MAX_LANES];       // 只由订阅者线程访问
+    std::atomic<uint64_t> delivered;
+    std::atomic<uint64_t> dropped;
+};
+
+static pthread_mutex_t g_subscriber_lock = PTHREAD_MUTEX_INITIALIZER;
+static fw_event_subscriber g_subscribers[FW_EVENT_MAX_SUBSCRIBERS];
+
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ==================== fork 处理 ====================
+
+static void atfork_prepare() {
+    pthread_mutex_lock(&g_subscriber_lock);
+}
+
+static void atfork_parent() {
+    pthread_mutex_unlock(&g_subscriber_lock);
+}
+
+/**
+ * 子进程中只剩调用 fork 的线程：其它线程的通道和所有订阅者都不再有效
+ */
+static void atfork_child() {
+    for (int i = 0; i < FW_EVENT_MAX_LANES; i++) {
+        if (i != t_lane.index) g_lanes[i].owner.store(0, std::memory_order_relaxed);
+    }
+    for (fw_event_subscriber &subscriber : g_subscribers) {
+        subscriber.active.store(false, std::memory_order_relaxed);
+        subscriber.waiting.store(false, std::memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&g_subscriber_lock);
+}
+
+static void init_once() {
+    pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+}
+
+// ==================== 发布 ====================
+
+/**
+ * 当前线程的通道，首次调用时占用一条（最多尝试 FW_EVENT_MAX_LANES 次 CAS）
+ */
+static int current_lane() {
+    if (t_lane.index >= 0) return t_lane.index;
+
+    const pid_t tid = gettid();
+    for (int i = 0; i < FW_EVENT_MAX_LANES; i++) {
+        Lane &lane = g_lanes[i];
+        pid_t expected = 0;
+        if (lane.owner.load(std::memory_order_relaxed) != 0 ||
+            !lane.owner.compare_exchange_strong(expected, tid, std::memory_order_acquire)) {
+            continue;
+        }
+        if (lane.slots.load(std::memory_order_relaxed) == nullptr) {
+            lane.slots.store(new LaneSlot[FW_EVENT_LANE_CAPACITY](), std::memory_order_release);
+        }
+        t_lane.index = i;
+        return i;
+    }
+    return -1;
+}
+
+static void notify_subscribers(uint32_t bit) {
+    // 与 fw_event_wait 中的屏障配对：要么发布者看到 waiting，要么订阅者看到新事件
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (fw_event_subscriber &subscriber : g_subscribers) {
+        if (!subscriber.active.load(std::memory_order_acquire) ||
+            (subscriber.mask.load(std::memory_order_relaxed) & bit) == 0 ||
+            !subscriber.waiting.load(std::memory_order_relaxed) ||
+            !subscriber.waiting.exchange(false, std::memory_order_relaxed)) {
+            continue;
+        }
+        uint64_t one = 1;
+        ssize_t ignored = write(subscriber.event_fd, &one, sizeof(one));
+        (void) ignored;
+    }
+}
+
+extern "C" bool fw_event_publish_raw(uint16_t type, const void *payload, size_t size) {
+    if (type == 0 || type >= 32 || size > FW_EVENT_PAYLOAD_SIZE ||
+        (size > 0 && payload == nullptr)) {
+        return false;
+    }
+    pthread_once(&g_init_once, init_once);
+
+    const int index = current_lane();
+    if (index < 0) {
+        g_no_lane.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint64_t words[PAYLOAD_WORDS] = {};
+    if (size > 0) memcpy(words, payload, size);
+
+    Lane &lane = g_lanes[index];
+    const uint64_t t = lane.head.load(std::memory_order_relaxed);
+    LaneSlot &slot = lane.slots.load(std::memory_order_relaxed)[t & LANE_MASK];
+
+    slot.stamp.store(2 * t + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.header.store(type | (uint64_t) size << 16 | (uint64_t) index << 32,
+                      std::memory_order_relaxed);
+    slot.seq.store(g_next_seq.fetch_add(1, std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+    slot.timestamp_ns.store(monotonic_ns(), std::memory_order_relaxed);
+    for (size_t w = 0; w < PAYLOAD_WORDS; w++) {
+        slot.payload[w].store(words[w], std::memory_order_relaxed);
+    }
+    slot.stamp.store(2 * t + 2, std::memory_order_release);
+    lane.head.store(t + 1, std::memory_order_release);
+
+    g_published.fetch_add(1, std::memory_order_relaxed);
+    notify_subscribers(1u << type);
+    return true;
+}
+
+// ==================== 订阅 ====================
+
+extern "C" fw_event_subscriber *fw_event_subscribe(uint32_t type_mask, const char *name) {
+    if (type_mask == 0) return nullptr;
+    pthread_once(&g_init_once, init_once);
+
+    pthread_mutex_lock(&g_subscriber_lock);
+    fw_event_subscriber *result = nullptr;
+    for (fw_event_subscriber &subscriber : g_subscribers) {
+        if (subscriber.active.load(std::memory_order_relaxed)) continue;
+
+        if (subscriber.event_fd <= 0) {
+            subscriber.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (subscriber.event_fd < 0) {
+                LOGW("创建 eventfd 失败: %s", strerror(errno));
+                subscriber.event_fd = 0;
+                break;
+            }
+        }
+        strlcpy(subscriber.name, name != nullptr ? name : "", sizeof(subscriber.name));
+        // 只接收订阅之后的事件
+        for (int i = 0; i < FW_EVENT_MAX_LANES; i++) {
+            subscriber.cursors[i] = g_lanes[i].head.load(std::memory_order_acquire);
+        }
+        subscriber.delivered.store(0, std::memory_order_relaxed);
+        subscriber.dropped.store(0, std::memory_order_relaxed);
+        subscriber.waiting.store(false, std::memory_order_relaxed);
+        subscriber.mask.store(type_mask, std::memory_order_relaxed);
+        subscriber.active.store(true, std::memory_order_release);
+        result = &subscriber;
+        break;
+    }
+    pthread_mutex_unlock(&g_subscriber_lock);
+
+    if (result == nullptr) LOGW("订阅失败: %s", name != nullptr ? name : "");
+    return result;
+}
+
+extern "C" void fw_event_unsubscribe(fw_event_subscriber *subscriber) {
+    if (subscriber == nullptr) return;
+    pthread_mutex_lock(&g_subscriber_lock);
+    subscriber->active.store(false, std::memory_order_release);
+    subscriber->waiting.store(false, std::memory_order_relaxed);
+    pthread_mutex_unlock(&g_subscriber_lock);
+}
+
+// ==================== 接收 ====================
+
+extern "C" int fw_event_poll(fw_event_subscriber *subscriber, fw_event *events, int max_events) {
+    if (subscriber == nullptr || events == nullptr || max_events <= 0) return 0;
+    const uint32_t mask = subscriber->mask.load(std::memory_order_relaxed);
+
+    int count = 0;
+    uint64_t dropped = 0;
+    for (int i = 0; i < FW_EVENT_MAX_LANES && count < max_events; i++) {
+        Lane &lane = g_lanes[i];
+        const LaneSlot *slots = lane.slots.load(std::memory_order_acquire);
+        if (slots == nullptr) continue;
+
+        const uint64_t head = lane.head.load(std::memory_order_acquire);
+        uint64_t cursor = subscriber->cursors[i];
+        if (head - cursor > FW_EVENT_LANE_CAPACITY) {
+            // 落后超过通道容量：最旧的事件已被覆盖
+            dropped += head - FW_EVENT_LANE_CAPACITY - cursor;
+            cursor = head - FW_EVENT_LANE_CAPACITY;
+        }
+
+        for (; cursor < head && count < max_events; cursor++) {
+            const LaneSlot &slot = slots[cursor & LANE_MASK];
+            const uint64_t stamp = slot.stamp.load(std::memory_order_acquire);
+            if (stamp != 2 * cursor + 2) {
+                dropped++;
+                continue;
+            }
+
+            const uint64_t header = slot.header.load(std::memory_order_relaxed);
+            fw_event &event = events[count];
+            event.seq = slot.seq.load(std::memory_order_relaxed);
+            event.timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+            uint64_t words[PAYLOAD_WORDS];
+            for (size_t w = 0; w < PAYLOAD_WORDS; w++) {
+                words[w] = slot.payload[w].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.stamp.load(std::memory_order_relaxed) != stamp) {
+                dropped++;
+                continue;
+            }
+
+            event.type = (uint16_t) (header & 0xFFFF);
+            if ((mask & (1u << event.type)) == 0) continue;
+            event.size = (uint16_t) ((header >> 16) & 0xFFFF);
+            event.lane = (uint32_t) (header >> 32);
+            memcpy(event.payload, words, sizeof(event.payload));
+            count++;
+        }
+        subscriber->cursors[i] = cursor;
+    }
+
+    if (count > 0) subscriber->delivered.fetch_add(count, std::memory_order_relaxed);
+    if (dropped > 0) subscriber->dropped.fetch_add(dropped, std::memory_order_relaxed);
+    return count;
+}
+
+static bool has_pending(const fw_event_subscriber *subscriber) {
+    for (int i = 0; i < FW_EVENT_MAX_LANES; i++) {
+        if (g_lanes[i].head.load(std::memory_order_acquire) != subscriber->cursors[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+extern "C" int fw_event_wait(fw_event_subscriber *subscriber, int timeout_ms) {
+    if (subscriber == nullptr) return -EINVAL;
+
+    // 清除已处理过的通知，再登记等待
+    uint64_t value;
+    while (read(subscriber->event_fd, &value, sizeof(value)) > 0) {
+    }
+    subscriber->waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (has_pending(subscriber)) {
+        subscriber->waiting.store(false, std::memory_order_relaxed);
+        return 1;
+    }
+    if (timeout_ms == 0) return 0;
+
+    static const int wakeup_id = fw_wakeup_register("event_bus_wait");
+    struct pollfd pfd = {subscriber->event_fd, POLLIN, 0};
+    int ret = fw_wakeup_poll(wakeup_id, &pfd, 1, timeout_ms);
+    if (ret < 0) {
+        ret = -errno;
+    } else if (ret > 0) {
+        while (read(subscriber->event_fd, &value, sizeof(value)) > 0) {
+        }
+    }
+    subscriber->waiting.store(false, std::memory_order_relaxed);
+    return ret;
+}
+
+extern "C" int fw_event_subscriber_fd(fw_event_subscriber *subscriber) {
+    return subscriber != nullptr ? subscriber->event_fd : -1;
+}
+
+extern "C" uint64_t fw_event_dropped_count(fw_event_subscriber *subscriber) {
+    return subscriber != nullptr ? subscriber->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+// ==================== 统计 ====================
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...)
+        __attribute__((format(printf, 4, 5)));
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...) {
+    if (*used >= size) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + *used, size - *used, format, args);
+    va_end(args);
+    if (n > 0) *used += ((size_t) n < size - *used) ? (size_t) n : size - *used - 1;
+}
+
+extern "C" size_t fw_event_bus_dump(char *buffer, size_t size) {
+    if (buffer == nullptr || size == 0) return 0;
+    buffer[0] = '\0';
+    size_t used = 0;
+
+    int lanes = 0;
+    for (const Lane &lane : g_lanes) {
+        if (lane.owner.load(std::memory_order_relaxed) != 0) lanes++;
+    }
+    append(buffer, size, &used, "published=%llu lanes=%d no_lane=%llu\n",
+           (unsigned long long) g_published.load(std::memory_order_relaxed), lanes,
+           (unsigned long long) g_no_lane.load(std::memory_order_relaxed));
+
+    pthread_mutex_lock(&g_subscriber_lock);
+    for (const fw_event_subscriber &subscriber : g_subscribers) {
+        if (!subscriber.active.load(std::memory_order_relaxed)) continue;
+        append(buffer, size, &used, "%s mask=0x%x delivered=%llu dropped=%llu\n",
+               subscriber.name, subscriber.mask.load(std::memory_order_relaxed),
+               (unsigned long long) subscriber.delivered.load(std::memory_order_relaxed),
+               (unsigned long long) subscriber.dropped.load(std::memory_order_relaxed));
+    }
+    pthread_mutex_unlock(&g_subscriber_lock);
+    return used;
+}
+
+// ==================== 模块入口 ====================
+
+/**
+ * 返回函数表（常量初始化的静态对象，不产生全局构造函数）
+ */
+extern "C" FW_EXPORT const FwEventBusModule *fw_event_bus_module_get() {
+    static const FwEventBusModule module = {
+            FW_EVENT_BUS_MODULE_VERSION,
+            fw_event_publish_raw,
+            fw_event_subscribe,
+            fw_event_unsubscribe,
+            fw_event_poll,
+            fw_event_wait,
+            fw_event_subscriber_fd,
+            fw_event_dropped_count,
+            fw_event_bus_dump,
+    };
+    return &module;
+}
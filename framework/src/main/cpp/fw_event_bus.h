@@ -0,0 +1,230 @@
+/**
+ * ============================================================================
+ * fw_event_bus.h - 进程内 Native 事件总线
+ * ============================================================================
+ *
+ * 功能简介：
+ *   Socket 断开、守护进程启停、MediaRoute 服务启停等事件此前只能通过各模块自己的
+ *   回调获得（或直接丢失）。事件总线让遥测、监控、JNI 分发等任意多个订阅者
+ *   接收同一批事件，而不需要依赖各模块的内部实现。
+ *
+ * 事件类型：
+ *   每种事件是一个可平凡复制的结构体，带 `static constexpr uint16_t kType`，
+ *   大小不超过 FW_EVENT_PAYLOAD_SIZE，由 fw_event_publish / fw_event_get 在编译期检查。
+ *
+ * 实现方式：
+ *   - 每个发布线程占用一条通道（单生产者环形缓冲区），发布只写自己的通道，
+ *     不加锁、不等待订阅者（wait-free），事件只写一次
+ *   - 每个订阅者在每条通道上有自己的读位置，相当于每个订阅者一个 SPSC 队列；
+ *     落后超过通道容量时丢弃最旧的事件并计数，不影响发布者和其它订阅者
+ *   - 订阅者可轮询（fw_event_poll），也可阻塞等待（fw_event_wait）或把
+ *     fw_event_subscriber_fd 加入 poll / epoll；发布者只在订阅者正在等待时写一次 eventfd
+ *
+ * 限制：
+ *   - 同一发布线程的事件保持顺序；不同线程之间按 seq 排序（fw_event_poll 不做合并排序）
+ *   - 同时发布事件的线程超过 FW_EVENT_MAX_LANES 时，超出的线程发布失败并计数
+ *   - fork 后子进程中的订阅全部清除
+ *
+ * 加载方式：
+ *   代码位于按需加载的 libfw_event_bus.so，第一个订阅者调用 fw_event_subscribe
+ *   时加载（见 fw_module.h）。没有订阅者时模块不加载，发布直接丢弃并返回 false。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_EVENT_BUS_H
+#define FW_EVENT_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "fw_module.h"
+
+#define FW_EVENT_PAYLOAD_SIZE       32
+#define FW_EVENT_LANE_CAPACITY      128     // 每条通道的事件数（2 的幂）
+#define FW_EVENT_MAX_LANES          32
+#define FW_EVENT_MAX_SUBSCRIBERS    16
+#define FW_EVENT_NAME_LEN           24
+
+// ==================== 事件类型 ====================
+
+#define FW_EVENT_TYPE_SOCKET        1
+#define FW_EVENT_TYPE_DAEMON        2
+#define FW_EVENT_TYPE_MEDIAROUTE    3
+
+// Socket 事件状态
+#define FW_SOCKET_EVENT_CLIENT_CONNECTED    1   // 服务端接受了新客户端
+#define FW_SOCKET_EVENT_CLIENT_DISCONNECTED 2   // 服务端的客户端断开
+#define FW_SOCKET_EVENT_CONNECTION_LOST     3   // 心跳客户端与服务端的连接断开
+
+struct fw_socket_event {
+    static constexpr uint16_t kType = FW_EVENT_TYPE_SOCKET;
+    int32_t state;              // FW_SOCKET_EVENT_*
+    int32_t fd;
+};
+
+// 守护进程事件状态
+#define FW_DAEMON_EVENT_STARTED             1   // 守护子进程已创建
+#define FW_DAEMON_EVENT_STOP_REQUESTED      2   // 请求停止
+#define FW_DAEMON_EVENT_PARENT_DIED         3   // 守护进程检测到父进程死亡（守护进程内）
+#define FW_DAEMON_EVENT_WAKE_FAILED         4   // 唤醒父进程失败（守护进程内）
+
+struct fw_daemon_event {
+    static constexpr uint16_t kType = FW_EVENT_TYPE_DAEMON;
+    int32_t state;              // FW_DAEMON_EVENT_*
+    int32_t pid;                // 相关进程（守护子进程或父进程）
+};
+
+struct fw_mediaroute_event {
+    static constexpr uint16_t kType = FW_EVENT_TYPE_MEDIAROUTE;
+    int32_t service;            // 1: MediaRouteProviderService, 2: MediaRoute2ProviderService
+    int32_t running;
+};
+
+// ==================== 事件与订阅者 ====================
+
+struct fw_event {
+    uint16_t type;
+    uint16_t size;
+    uint32_t lane;
+    uint64_t seq;               // 全进程发布序号
+    int64_t timestamp_ns;       // CLOCK_MONOTONIC
+    alignas(8) unsigned char payload[FW_EVENT_PAYLOAD_SIZE];
+};
+
+struct fw_event_subscriber;
+
+extern "C" {
+
+/**
+ * 发布事件（wait-free，可在任意线程调用）
+ *
+ * @return 没有可用通道或参数无效时返回 false
+ */
+FW_MODULE_API bool fw_event_publish_raw(uint16_t type, const void *payload, size_t size);
+
+/**
+ * 订阅事件，只接收订阅之后发布的事件
+ *
+ * @param type_mask 事件类型位（1 << type），可用 fw_event_mask<T...>() 生成
+ * @return 订阅者，订阅者已满返回 nullptr
+ */
+FW_MODULE_API fw_event_subscriber *fw_event_subscribe(uint32_t type_mask, const char *name);
+
+/**
+ * 取消订阅（不能与该订阅者的 poll / wait 并发调用）
+ */
+FW_MODULE_API void fw_event_unsubscribe(fw_event_subscriber *subscriber);
+
+/**
+ * 取出待处理的事件（只能由一个线程调用）
+ *
+ * @return 取出的事件数
+ */
+FW_MODULE_API int fw_event_poll(fw_event_subscriber *subscriber, fw_event *events, int max_events);
+
+/**
+ * 等待事件（与 fw_event_poll 在同一线程调用）
+ *
+ * @param timeout_ms -1 表示一直等待；0 时只检查，返回 0 后有新事件会唤醒 eventfd
+ * @return 1 有事件（可能是订阅类型之外的，poll 时会跳过），0 超时，<0 为 -errno
+ */
+FW_MODULE_API int fw_event_wait(fw_event_subscriber *subscriber, int timeout_ms);
+
+/**
+ * 订阅者的 eventfd，可加入 poll / epoll（POLLIN）：
+ * 注册前及每次回调中循环 fw_event_poll，直到 fw_event_wait(subscriber, 0) 返回 0
+ * （即已重新登记等待）
+ */
+FW_MODULE_API int fw_event_subscriber_fd(fw_event_subscriber *subscriber);
+
+/**
+ * 该订阅者因落后而丢弃的事件数
+ */
+FW_MODULE_API uint64_t fw_event_dropped_count(fw_event_subscriber *subscriber);
+
+/**
+ * 输出总线统计：发布数、通道数、每个订阅者的接收 / 丢弃数
+ *
+ * @return 写入的字节数（不含 NUL）
+ */
+FW_MODULE_API size_t fw_event_bus_dump(char *buffer, size_t size);
+
+}
+
+// ==================== 模块 ====================
+
+#define FW_EVENT_BUS_MODULE_LIB     "libfw_event_bus.so"
+#define FW_EVENT_BUS_MODULE_ENTRY   "fw_event_bus_module_get"
+#define FW_EVENT_BUS_MODULE_VERSION 1
+
+/**
+ * 事件总线模块函数表（libfw_event_bus.so 提供），函数与上面同名的 fw_event_* 一一对应
+ */
+struct FwEventBusModule {
+    uint32_t version;   // FW_EVENT_BUS_MODULE_VERSION
+
+    bool (*publishRaw)(uint16_t type, const void *payload, size_t size);
+
+    fw_event_subscriber *(*subscribe)(uint32_t type_mask, const char *name);
+
+    void (*unsubscribe)(fw_event_subscriber *subscriber);
+
+    int (*poll)(fw_event_subscriber *subscriber, fw_event *events, int max_events);
+
+    int (*wait)(fw_event_subscriber *subscriber, int timeout_ms);
+
+    int (*subscriberFd)(fw_event_subscriber *subscriber);
+
+    uint64_t (*droppedCount)(fw_event_subscriber *subscriber);
+
+    size_t (*dump)(char *buffer, size_t size);
+};
+
+extern "C" {
+
+/**
+ * 获取事件总线模块（首次调用时 dlopen，线程安全）
+ *
+ * @return 函数表，加载失败返回 nullptr（失败结果会被缓存，不会重复尝试）
+ */
+const FwEventBusModule *fw_event_bus_module();
+
+/**
+ * 获取已加载的事件总线模块（不触发加载），发布路径使用
+ */
+const FwEventBusModule *fw_event_bus_module_if_loaded();
+
+}
+
+// ==================== 类型化接口 ====================
+
+template <typename... T>
+constexpr uint32_t fw_event_mask() {
+    return (0u | ... | (1u << T::kType));
+}
+
+template <typename T>
+inline bool fw_event_publish(const T &event) {
+    static_assert(std::is_trivially_copyable<T>::value, "事件必须可平凡复制");
+    static_assert(sizeof(T) <= FW_EVENT_PAYLOAD_SIZE, "事件超过 FW_EVENT_PAYLOAD_SIZE");
+    static_assert(T::kType > 0 && T::kType < 32, "事件类型必须在 1 - 31 之间");
+    return fw_event_publish_raw(T::kType, &event, sizeof(T));
+}
+
+/**
+ * 事件类型匹配时复制到 out 并返回 true
+ */
+template <typename T>
+inline bool fw_event_get(const fw_event &event, T *out) {
+    static_assert(std::is_trivially_copyable<T>::value, "事件必须可平凡复制");
+    if (event.type != T::kType || event.size != sizeof(T)) return false;
+    memcpy(out, event.payload, sizeof(T));
+    return true;
+}
+
+#endif // FW_EVENT_BUS_H
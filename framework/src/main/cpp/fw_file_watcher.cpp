@@ -0,0 +1,408 @@
+/**
+ * ============================================================================
+ * fw_file_watcher.cpp - 基于 inotify 的文件变化监听实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   inotify 的 watch descriptor（wd）按 inode 分配，多个监听（或递归监听中的
+ *   多个目录）可能共享同一个 wd，因此按 wd 保存 (监听 ID, 目录路径) 列表，
+ *   读取事件时逐个匹配各监听的事件掩码。添加 wd 时使用 IN_MASK_ADD，
+ *   不会覆盖其他监听在同一 inode 上的掩码。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_file_watcher.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <android/log.h>
+#include "fw_tokenlog.h"
+#include "fw_wakeup.h"
+
+#define LOG_TAG "FwFileWatcher"
+#define LOGD(...) FW_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// 单次 read 的缓冲区，至少能容纳一个带最长文件名的事件
+#define INOTIFY_BUFFER_SIZE 4096
+
+// inotify 不可用时的退化检查间隔
+#define WAIT_FALLBACK_INTERVAL_US 10000
+
+struct WatchNode {
+    int watch_id;
+    std::string path;   // 该 wd 对应的路径
+};
+
+struct Watch {
+    std::string root;
+    uint32_t events;
+    uint32_t flags;
+    fw_file_watch_callback callback;
+    void *data;
+    std::vector<int> wds;
+};
+
+/**
+ * 在锁外执行的回调
+ */
+struct PendingEvent {
+    fw_file_watch_callback callback;
+    void *data;
+    int watch_id;
+    uint32_t event;
+    std::string path;
+};
+
+struct fw_file_watcher {
+    fw_looper *looper = nullptr;
+    int inotify_fd = -1;
+    std::mutex lock;
+    int next_id = 1;
+    std::map<int, Watch> watches;
+    std::unordered_map<int, std::vector<WatchNode>> nodes;
+};
+
+// ==================== 事件掩码转换 ====================
+
+static uint32_t to_inotify_mask(uint32_t events, uint32_t flags) {
+    uint32_t mask = 0;
+    if (events & FW_FILE_EVENT_CREATE) mask |= IN_CREATE | IN_MOVED_TO;
+    if (events & FW_FILE_EVENT_DELETE) mask |= IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF;
+    if (events & FW_FILE_EVENT_MODIFY) mask |= IN_MODIFY;
+    if (events & FW_FILE_EVENT_CLOSE_WRITE) mask |= IN_CLOSE_WRITE;
+    // 递归监听需要知道新建的子目录
+    if (flags & FW_FILE_WATCH_RECURSIVE) mask |= IN_CREATE | IN_MOVED_TO;
+    return mask;
+}
+
+static uint32_t to_file_event(uint32_t mask) {
+    if (mask & (IN_CREATE | IN_MOVED_TO)) return FW_FILE_EVENT_CREATE;
+    if (mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF)) return FW_FILE_EVENT_DELETE;
+    if (mask & IN_MODIFY) return FW_FILE_EVENT_MODIFY;
+    if (mask & IN_CLOSE_WRITE) return FW_FILE_EVENT_CLOSE_WRITE;
+    return 0;
+}
+
+static bool is_directory(const std::string &path, unsigned char d_type) {
+    if (d_type == DT_DIR) return true;
+    if (d_type != DT_UNKNOWN) return false;
+    struct stat st;
+    return lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// ==================== 监听管理（持有 watcher->lock） ====================
+
+static int add_wd_locked(fw_file_watcher *watcher, int watch_id, Watch &watch,
+                         const std::string &path) {
+    const uint32_t mask = to_inotify_mask(watch.events, watch.flags) | IN_MASK_ADD;
+    int wd = inotify_add_watch(watcher->inotify_fd, path.c_str(), mask);
+    if (wd < 0) return -errno;
+
+    std::vector<WatchNode> &list = watcher->nodes[wd];
+    for (const WatchNode &node : list) {
+        if (node.watch_id == watch_id) return wd;
+    }
+    list.push_back(WatchNode{watch_id, path});
+    watch.wds.push_back(wd);
+    return wd;
+}
+
+/**
+ * 监听 dir 及其所有子目录
+ *
+ * @param created 非空时，把遍历到的已有条目作为 CREATE 事件补发（新建目录在加入监听前
+ *                可能已经有内容）
+ */
+static void add_tree_locked(fw_file_watcher *watcher, int watch_id, Watch &watch,
+                            const std::string &dir, std::vector<PendingEvent> *created) {
+    if (add_wd_locked(watcher, watch_id, watch, dir) < 0) return;
+
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        const std::string child = dir + "/" + entry->d_name;
+        const bool child_is_dir = is_directory(child, entry->d_type);
+        if (created != nullptr && (watch.events & FW_FILE_EVENT_CREATE)) {
+            created->push_back(PendingEvent{
+                    watch.callback, watch.data, watch_id,
+                    FW_FILE_EVENT_CREATE | (child_is_dir ? FW_FILE_EVENT_ISDIR : 0u), child});
+        }
+        if (child_is_dir) {
+            add_tree_locked(watcher, watch_id, watch, child, created);
+        }
+    }
+    closedir(d);
+}
+
+/**
+ * 从 wd 上移除某个监听，wd 不再被任何监听使用时从 inotify 移除
+ */
+static void drop_wd_locked(fw_file_watcher *watcher, int watch_id, int wd) {
+    auto it = watcher->nodes.find(wd);
+    if (it == watcher->nodes.end()) return;
+    std::vector<WatchNode> &list = it->second;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i].watch_id == watch_id) {
+            list.erase(list.begin() + i);
+            break;
+        }
+    }
+    if (list.empty()) {
+        watcher->nodes.erase(it);
+        inotify_rm_watch(watcher->inotify_fd, wd);
+    }
+}
+
+// ==================== 事件读取 ====================
+
+static void handle_event_locked(fw_file_watcher *watcher, const struct inotify_event *event,
+                                std::vector<PendingEvent> *pending) {
+    if (event->mask & IN_Q_OVERFLOW) {
+        LOGW("inotify 事件队列溢出");
+        for (auto &entry : watcher->watches) {
+            pending->push_back(PendingEvent{entry.second.callback, entry.second.data, entry.first,
+                                            FW_FILE_EVENT_OVERFLOW, entry.second.root});
+        }
+        return;
+    }
+
+    auto it = watcher->nodes.find(event->wd);
+    if (it == watcher->nodes.end()) return;
+
+    if (event->mask & IN_IGNORED) {
+        // 被监听的 inode 已删除或所在文件系统已卸载，内核已移除该 wd
+        for (const WatchNode &node : it->second) {
+            auto watch = watcher->watches.find(node.watch_id);
+            if (watch == watcher->watches.end()) continue;
+            std::vector<int> &wds = watch->second.wds;
+            for (size_t i = 0; i < wds.size(); i++) {
+                if (wds[i] == event->wd) {
+                    wds.erase(wds.begin() + i);
+                    break;
+                }
+            }
+        }
+        watcher->nodes.erase(it);
+        return;
+    }
+
+    const uint32_t file_event = to_file_event(event->mask);
+    const uint32_t dir_flag = (event->mask & IN_ISDIR) ? FW_FILE_EVENT_ISDIR : 0;
+
+    // 复制节点列表：递归监听会在遍历过程中向 nodes 添加新的 wd
+    const std::vector<WatchNode> nodes = it->second;
+    for (const WatchNode &node : nodes) {
+        auto found = watcher->watches.find(node.watch_id);
+        if (found == watcher->watches.end()) continue;
+        Watch &watch = found->second;
+
+        // 递归监听中子目录被删除时，父目录已报告 DELETE，子目录自身的 DELETE_SELF 不再重复报告
+        if ((event->mask & IN_DELETE_SELF) && node.path != watch.root) continue;
+
+        const std::string path = event->len > 0 ? node.path + "/" + event->name : node.path;
+        if (file_event != 0 && (watch.events & file_event)) {
+            pending->push_back(PendingEvent{watch.callback, watch.data, node.watch_id,
+                                            file_event | dir_flag, path});
+        }
+        if ((watch.flags & FW_FILE_WATCH_RECURSIVE) && dir_flag &&
+            (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+            add_tree_locked(watcher, node.watch_id, watch, path, pending);
+        }
+    }
+}
+
+static int on_inotify_readable(int fd, uint32_t /* events */, void *data) {
+    fw_file_watcher *watcher = static_cast<fw_file_watcher *>(data);
+    alignas(struct inotify_event) char buffer[INOTIFY_BUFFER_SIZE];
+    std::vector<PendingEvent> pending;
+
+    for (;;) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) LOGE("读取 inotify 事件失败: errno=%d", errno);
+            break;
+        }
+        if (n == 0) break;
+
+        std::lock_guard<std::mutex> guard(watcher->lock);
+        for (ssize_t offset = 0; offset < n;) {
+            const struct inotify_event *event =
+                    reinterpret_cast<const struct inotify_event *>(buffer + offset);
+            handle_event_locked(watcher, event, &pending);
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    for (const PendingEvent &event : pending) {
+        event.callback(event.watch_id, event.event, event.path.c_str(), event.data);
+    }
+    return 1;
+}
+
+// ==================== 公开接口 ====================
+
+extern "C" fw_file_watcher *fw_file_watcher_create(fw_looper *looper) {
+    if (looper == nullptr) return nullptr;
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        LOGE("inotify_init1 失败: errno=%d", errno);
+        return nullptr;
+    }
+
+    fw_file_watcher *watcher = new fw_file_watcher;
+    watcher->looper = looper;
+    watcher->inotify_fd = fd;
+    int result = fw_looper_add_fd(looper, fd, EPOLLIN, on_inotify_readable, watcher);
+    if (result != 0) {
+        LOGE("注册 inotify fd 失败: %d", result);
+        close(fd);
+        delete watcher;
+        return nullptr;
+    }
+    return watcher;
+}
+
+extern "C" void fw_file_watcher_destroy(fw_file_watcher *watcher) {
+    if (watcher == nullptr) return;
+    fw_looper_remove_fd(watcher->looper, watcher->inotify_fd);
+    // 关闭 inotify fd 会一并移除所有 wd
+    close(watcher->inotify_fd);
+    delete watcher;
+}
+
+extern "C" int fw_file_watcher_add(fw_file_watcher *watcher, const char *path, uint32_t events,
+                                   uint32_t flags, fw_file_watch_callback callback, void *data) {
+    if (watcher == nullptr || path == nullptr || callback == nullptr ||
+        (events & FW_FILE_EVENT_ALL) == 0) {
+        return -EINVAL;
+    }
+
+    std::string root(path);
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+
+    std::lock_guard<std::mutex> guard(watcher->lock);
+    const int id = watcher->next_id++;
+    Watch &watch = watcher->watches[id];
+    watch.root = root;
+    watch.events = events & FW_FILE_EVENT_ALL;
+    watch.flags = flags;
+    watch.callback = callback;
+    watch.data = data;
+
+    int result = add_wd_locked(watcher, id, watch, root);
+    if (result < 0) {
+        LOGW("监听 %s 失败: errno=%d", path, -result);
+        watcher->watches.erase(id);
+        return result;
+    }
+
+    if (flags & FW_FILE_WATCH_RECURSIVE) {
+        DIR *d = opendir(root.c_str());
+        if (d != nullptr) {
+            struct dirent *entry;
+            while ((entry = readdir(d)) != nullptr) {
+                if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+                const std::string child = root + "/" + entry->d_name;
+                if (is_directory(child, entry->d_type)) {
+                    add_tree_locked(watcher, id, watch, child, nullptr);
+                }
+            }
+            closedir(d);
+        }
+    }
+    LOGD("监听 %s (id=%d, wd 数=%zu)", path, id, watch.wds.size());
+    return id;
+}
+
+extern "C" int fw_file_watcher_remove(fw_file_watcher *watcher, int watch_id) {
+    if (watcher == nullptr) return -EINVAL;
+
+    std::lock_guard<std::mutex> guard(watcher->lock);
+    auto it = watcher->watches.find(watch_id);
+    if (it == watcher->watches.end()) return -ENOENT;
+    for (int wd : it->second.wds) {
+        drop_wd_locked(watcher, watch_id, wd);
+    }
+    watcher->watches.erase(it);
+    return 0;
+}
+
+// ==================== 等待文件出现 ====================
+
+struct WaitContext {
+    const char *name;   // 等待的文件名（不含目录）
+    bool found;
+};
+
+static void on_wait_event(int /* watch_id */, uint32_t event, const char *path, void *data) {
+    WaitContext *ctx = static_cast<WaitContext *>(data);
+    const char *slash = strrchr(path, '/');
+    const char *name = slash != nullptr ? slash + 1 : path;
+    if ((event & FW_FILE_EVENT_CREATE) && strcmp(name, ctx->name) == 0) {
+        ctx->found = true;
+    }
+}
+
+static int64_t monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+extern "C" bool fw_file_wait_exists(const char *path, int timeout_ms) {
+    if (path == nullptr) return false;
+    if (access(path, F_OK) == 0) return true;
+
+    const int64_t deadline = timeout_ms >= 0 ? monotonic_ms() + timeout_ms : -1;
+    const char *slash = strrchr(path, '/');
+    const std::string dir = slash == nullptr ? "." : slash == path ? "/" : std::string(path, slash);
+    WaitContext ctx = {slash != nullptr ? slash + 1 : path, false};
+
+    fw_looper *looper = fw_looper_create();
+    fw_file_watcher *watcher = looper != nullptr ? fw_file_watcher_create(looper) : nullptr;
+    int id = watcher != nullptr
+             ? fw_file_watcher_add(watcher, dir.c_str(), FW_FILE_EVENT_CREATE, 0, on_wait_event, &ctx)
+             : -ENOSYS;
+
+    // 添加监听之前文件可能刚好出现
+    ctx.found = access(path, F_OK) == 0;
+    while (!ctx.found) {
+        int wait_ms = -1;
+        if (deadline >= 0) {
+            const int64_t remaining = deadline - monotonic_ms();
+            if (remaining <= 0) break;
+            wait_ms = (int) remaining;
+        }
+        if (id > 0) {
+            if (fw_looper_poll_once(looper, wait_ms) < 0) break;
+        } else {
+            static const int wakeup_id = fw_wakeup_register("file_wait_fallback");
+            fw_wakeup_sleep_ms(wakeup_id, WAIT_FALLBACK_INTERVAL_US / 1000);
+            ctx.found = access(path, F_OK) == 0;
+        }
+    }
+
+    fw_file_watcher_destroy(watcher);
+    fw_looper_destroy(looper);
+    return ctx.found;
+}
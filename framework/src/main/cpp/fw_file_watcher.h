@@ -0,0 +1,103 @@
+/**
+ * ============================================================================
+ * fw_file_watcher.h - 基于 inotify 的文件变化监听
+ * ============================================================================
+ *
+ * 功能简介：
+ *   把 inotify fd 注册到 fw_looper 上，文件 / 目录发生变化时在事件循环线程回调。
+ *   等待文件出现或变化不再需要 open()/usleep() 轮询，空闲时不占用 CPU。
+ *
+ * 事件：
+ *   - FW_FILE_EVENT_CREATE      创建或移入
+ *   - FW_FILE_EVENT_DELETE      删除或移出（包括被监听路径本身）
+ *   - FW_FILE_EVENT_MODIFY      内容被修改
+ *   - FW_FILE_EVENT_CLOSE_WRITE 以写方式打开的文件被关闭
+ *   - FW_FILE_EVENT_OVERFLOW    内核事件队列溢出，有事件丢失，调用方应重新扫描
+ *   目录产生的事件额外带有 FW_FILE_EVENT_ISDIR。
+ *
+ * 递归监听（FW_FILE_WATCH_RECURSIVE）：
+ *   监听目录下现有的所有子目录；新建或移入的子目录自动加入监听，
+ *   加入监听前已在其中创建的条目补发 CREATE 事件。不跟随符号链接。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_FILE_WATCHER_H
+#define FW_FILE_WATCHER_H
+
+#include <stdint.h>
+
+#include "fw_looper.h"
+
+// 事件位
+#define FW_FILE_EVENT_CREATE        0x01
+#define FW_FILE_EVENT_DELETE        0x02
+#define FW_FILE_EVENT_MODIFY        0x04
+#define FW_FILE_EVENT_CLOSE_WRITE   0x08
+#define FW_FILE_EVENT_OVERFLOW      0x100
+#define FW_FILE_EVENT_ISDIR         0x200
+
+#define FW_FILE_EVENT_ALL \
+    (FW_FILE_EVENT_CREATE | FW_FILE_EVENT_DELETE | FW_FILE_EVENT_MODIFY | FW_FILE_EVENT_CLOSE_WRITE)
+
+// 监听选项
+#define FW_FILE_WATCH_RECURSIVE     0x1
+
+struct fw_file_watcher;
+
+/**
+ * 文件事件回调（在事件循环线程执行，不持有内部锁，可在回调中增删监听）
+ *
+ * @param event 单个事件位，目录事件附加 FW_FILE_EVENT_ISDIR
+ * @param path  发生变化的完整路径；OVERFLOW 时为监听的根路径
+ */
+typedef void (*fw_file_watch_callback)(int watch_id, uint32_t event, const char *path,
+                                       void *data);
+
+extern "C" {
+
+/**
+ * 创建监听器并注册到事件循环
+ *
+ * @return 失败（如 inotify 不可用）返回 nullptr
+ */
+fw_file_watcher *fw_file_watcher_create(fw_looper *looper);
+
+/**
+ * 从事件循环注销并释放所有监听
+ */
+void fw_file_watcher_destroy(fw_file_watcher *watcher);
+
+/**
+ * 添加监听
+ *
+ * @param path   文件或目录（目录时事件针对其中的条目）
+ * @param events FW_FILE_EVENT_* 组合
+ * @param flags  FW_FILE_WATCH_* 组合
+ * @return 监听 ID（> 0），失败返回 -errno
+ */
+int fw_file_watcher_add(fw_file_watcher *watcher, const char *path, uint32_t events,
+                        uint32_t flags, fw_file_watch_callback callback, void *data);
+
+/**
+ * 移除监听
+ *
+ * @return 0 成功，不存在返回 -ENOENT
+ */
+int fw_file_watcher_remove(fw_file_watcher *watcher, int watch_id);
+
+/**
+ * 阻塞等待文件出现（监听父目录的 CREATE 事件）
+ *
+ * inotify 不可用时退化为 10ms 间隔的 access() 检查。
+ *
+ * @param timeout_ms < 0 表示一直等待
+ * @return 文件存在返回 true，超时返回 false
+ */
+bool fw_file_wait_exists(const char *path, int timeout_ms);
+
+}
+
+#endif // FW_FILE_WATCHER_H
@@ -25,6 +25,9 @@
  *   2. AMS Binder 直接调用 - 跳过 Java 层，直接构造 Parcel 调用
  *   3. fork() 创建守护进程 - 与主进程互相守护
  *
+ * 模块化：
+ *   编译为独立的 libfw_binder.so，由 fw_native 在首次调用时 dlopen 加载（见 fw_module.h）
+ *
  * @author Pangu-Immortal
  * @github https://github.com/Pangu-Immortal/KeepLiveService
  * @since 2.1.0
@@ -33,6 +36,7 @@
 #include <jni.h>
 #include <sys/wait.h>
 #include <android/log.h>
+#include "fw_tokenlog.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -40,17 +44,24 @@
 #include <linux/android/binder.h>
 #include <sys/mman.h>
 #include <string.h>
+#include <utility>
 #include "binder/data_transact.h"
 #include "binder/cParcel.h"
+#include "utils/AllocTag.h"
+#include "fw_module.h"
+#include "fw_parcel_buffer.h"
+#include "fw_parcel_cache.h"
+#include "fw_service_prefetch.h"
+#include "fw_file_watcher.h"
 
 using namespace android;
 
 // 日志标签
 #define LOG_TAG "FwForceStop"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) FW_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 
 // ==================== Intent 构造函数 ====================
 
@@ -133,46 +144,61 @@ static void writeStartServiceParcel(Parcel &out, const char *packageName,
     }
 }
 
-// ==================== Binder 服务获取 ====================
+// ==================== 预序列化 Parcel 缓存 ====================
+
+#define PARCEL_CACHE_FILE "fw_parcel_cache"
+#define CHECK_SERVICE_CACHE_KEY "checkService/activity"
 
-#define CHECK_SERVICE_TRANSACTION 1  // ServiceManager 的 checkService 事务码
+/**
+ * 缓存文件与指示器文件放在同一目录
+ */
+static bool buildParcelCachePath(const char *indicatorPath, char *out, size_t size) {
+    const char *slash = strrchr(indicatorPath, '/');
+    if (slash == NULL) return false;
+    int n = snprintf(out, size, "%.*s/%s", (int) (slash - indicatorPath), indicatorPath,
+                     PARCEL_CACHE_FILE);
+    return n > 0 && (size_t) n < size;
+}
 
 /**
- * 通过 ServiceManager 获取指定服务的 Binder handle
+ * 取得守护进程启动所需的事务数据
  *
- * 原理：
- * 1. ServiceManager 的 Binder handle 固定为 0
- * 2. 通过 CHECK_SERVICE_TRANSACTION 查询服务
- * 3. 返回的 flat_binder_object 包含目标服务的 handle
+ * 命中缓存时两个 Parcel 直接引用映射区，不做序列化；否则现场构造并写回缓存，
+ * 供下一次启动使用。
  *
- * @param serviceName 服务名（如 "activity"）
- * @param driverFD Binder 驱动文件描述符
- * @return 服务的 Binder handle，失败返回 0
+ * @return 缓存句柄（两个 Parcel 释放后再关闭），未命中时返回 NULL
  */
-static uint32_t getServiceHandle(const char *serviceName, int driverFD) {
-    Parcel *data = new Parcel;
-    Parcel *reply = new Parcel;
-
-    // 构造查询数据
-    data->writeInterfaceToken(String16("android.os.IServiceManager"));
-    data->writeString16(String16(serviceName));
-
-    // 调用 ServiceManager (handle=0) 的 checkService
-    status_t status = write_transact(0, CHECK_SERVICE_TRANSACTION, *data, reply, 0, driverFD);
-
-    // 从返回数据中读取服务的 Binder 对象
-    const flat_binder_object *flat = reply->readObject(false);
-    uint32_t handle = 0;
-    if (flat) {
-        handle = flat->handle;
-        LOGD("获取服务 [%s] handle = %u", serviceName, handle);
-    } else {
-        LOGE("获取服务 [%s] 失败", serviceName);
+static fw_parcel_cache *loadStartupParcels(const char *cachePath, const char *packageName,
+                                           const char *serviceName, int sdkVersion,
+                                           Parcel &checkService, Parcel &startService) {
+    char startKey[512];
+    snprintf(startKey, sizeof(startKey), "startService/%s/%s", packageName, serviceName);
+
+    fw_parcel_cache *cache = cachePath != NULL ? fw_parcel_cache_open(cachePath) : NULL;
+    if (cache != NULL &&
+        fw_parcel_cache_get(cache, CHECK_SERVICE_CACHE_KEY, sdkVersion, &checkService) == NO_ERROR &&
+        fw_parcel_cache_get(cache, startKey, sdkVersion, &startService) == NO_ERROR) {
+        LOGD("启动事务数据命中 Parcel 缓存");
+        return cache;
     }
 
-    delete data;
-    delete reply;
-    return handle;
+    // 现场构造后移动给调用方；移动赋值同时释放部分命中时已引用的映射区，之后才能关闭缓存
+    Parcel builtCheck;
+    Parcel builtStart;
+    fw_service_write_check(builtCheck, "activity");
+    writeStartServiceParcel(builtStart, packageName, serviceName, sdkVersion);
+    checkService = std::move(builtCheck);
+    startService = std::move(builtStart);
+    fw_parcel_cache_close(cache);
+
+    if (cachePath != NULL) {
+        const fw_parcel_cache_item items[] = {
+                {CHECK_SERVICE_CACHE_KEY, sdkVersion, &checkService},
+                {startKey,                sdkVersion, &startService},
+        };
+        fw_parcel_cache_write(cachePath, items, sizeof(items) / sizeof(items[0]));
+    }
+    return NULL;
 }
 
 // ==================== 文件锁操作 ====================
@@ -259,15 +285,13 @@ static bool waitForFileLock(const char *lockFilePath) {
  */
 static void notifyAndWaitFor(const char *observerSelfPath, const char *observerDaemonPath) {
     // 创建自己的观察者文件
-    int fd = open(observerSelfPath, O_RDONLY | O_LARGEFILE);
-    if (fd == -1) {
-        fd = open(observerSelfPath, O_CREAT, S_IRUSR | S_IWUSR);
+    int fd = open(observerSelfPath, O_RDONLY | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd != -1) {
+        close(fd);
     }
 
-    // 等待对方的观察者文件
-    while (open(observerDaemonPath, O_RDONLY | O_LARGEFILE) == -1) {
-        usleep(1000);  // 1ms
-    }
+    // 等待对方的观察者文件（inotify 监听所在目录，等待期间不占用 CPU）
+    fw_file_wait_exists(observerDaemonPath, -1);
 
     // 删除对方的文件，表示同步完成
     remove(observerDaemonPath);
@@ -341,12 +365,21 @@ static void doDaemon(const char *indicatorSelfPath,
     void *vmStart = MAP_FAILED;
     initProcessState(driverFD, vmStart);
 
-    // 4. 获取 AMS 的 Binder handle
-    uint32_t amsHandle = getServiceHandle("activity", driverFD);
-
-    // 5. 预先构造 startService 调用数据
-    Parcel *data = new Parcel;
-    writeStartServiceParcel(*data, packageName, serviceName, sdkVersion);
+    // 4. 取得 checkService / startService 调用数据（优先使用预序列化缓存）
+    ALLOC_TAG_SCOPE("startService");
+    char cachePath[256];
+    Parcel query;
+    Parcel data;
+    fw_parcel_cache *cache = loadStartupParcels(
+            buildParcelCachePath(indicatorSelfPath, cachePath, sizeof(cachePath)) ? cachePath : NULL,
+            packageName, serviceName, sdkVersion, query, data);
+
+    // 5. 预取所需服务的 Binder handle（多个服务时并发查询，只等一次 IPC 往返）
+    const fw_service_query services[] = {
+            {"activity", &query},
+    };
+    fw_service_prefetch_queries(services, sizeof(services) / sizeof(services[0]), driverFD);
+    uint32_t amsHandle = fw_service_handle("activity", driverFD);
 
     // 6. 等待对方进程死亡（阻塞在 flock）
     LOGI("开始监控对方进程...");
@@ -357,7 +390,7 @@ static void doDaemon(const char *indicatorSelfPath,
         LOGW("检测到守护进程死亡，立即拉活！");
 
         // 7. 通过 Binder 直接调用 AMS.startService
-        status_t status = write_transact(amsHandle, transactCode, *data, NULL, 1, driverFD);
+        status_t status = write_transact(amsHandle, transactCode, data, NULL, 1, driverFD);
         LOGD("startService 调用结果: %d", status);
 
         // 清理观察者文件，防止死锁
@@ -370,12 +403,14 @@ static void doDaemon(const char *indicatorSelfPath,
         }
     }
 
-    delete data;
+    // 引用缓存映射区的 Parcel 要在关闭缓存之前释放
+    query.freeData();
+    data.freeData();
+    fw_parcel_cache_close(cache);
 }
 
-// ==================== JNI 接口 ====================
-
-extern "C" {
+// ==================== 模块接口 ====================
+// 以下函数通过 FwBinderModule 函数表导出，由 fw_native 中同名 JNI 方法转发调用
 
 /**
  * 设置进程名
@@ -390,27 +425,17 @@ static void setProcessName(JNIEnv *env, const char *name) {
 /**
  * JNI 方法: 锁定文件
  */
-JNIEXPORT void JNICALL
-Java_com_service_framework_native_FwNative_lockFile(
+static void jniLockFile(
         JNIEnv *env, jobject /* this */, jstring lockFilePath) {
     const char *path = env->GetStringUTFChars(lockFilePath, 0);
     lockFile(path);
     env->ReleaseStringUTFChars(lockFilePath, path);
 }
 
-/**
- * JNI 方法: 设置会话 ID（脱离父进程）
- */
-JNIEXPORT void JNICALL
-Java_com_service_framework_native_FwNative_nativeSetSid(JNIEnv *env, jobject /* this */) {
-    setsid();
-}
-
 /**
  * JNI 方法: 等待文件锁
  */
-JNIEXPORT void JNICALL
-Java_com_service_framework_native_FwNative_waitFileLock(
+static void jniWaitFileLock(
         JNIEnv *env, jobject /* this */, jstring lockFilePath) {
     const char *path = env->GetStringUTFChars(lockFilePath, 0);
     LOGD("waitFileLock: %s", path);
@@ -434,8 +459,7 @@ Java_com_service_framework_native_FwNative_waitFileLock(
  * @param serviceName 服务类全名
  * @param sdkVersion SDK 版本号
  */
-JNIEXPORT void JNICALL
-Java_com_service_framework_native_FwNative_startForceStopDaemon(
+static void jniStartForceStopDaemon(
         JNIEnv *env,
         jobject /* this */,
         jstring indicatorSelfPath,
@@ -542,39 +566,95 @@ Java_com_service_framework_native_FwNative_startForceStopDaemon(
  *
  * 仅用于测试 Binder 驱动访问是否正常
  */
-JNIEXPORT void JNICALL
-Java_com_service_framework_native_FwNative_testBinderCall(
+static void jniTestBinderCall(
         JNIEnv *env,
         jobject /* this */,
         jstring packageName,
         jstring serviceName,
         jint sdkVersion) {
 
+    ALLOC_TAG_SCOPE("testBinderCall");
+
     // 打开 Binder 驱动
     int driverFD = open_driver();
     void *vmStart = MAP_FAILED;
     initProcessState(driverFD, vmStart);
 
     // 获取 AMS handle
-    uint32_t amsHandle = getServiceHandle("activity", driverFD);
+    uint32_t amsHandle = fw_service_handle("activity", driverFD);
     LOGI("AMS handle = %u", amsHandle);
 
     // 构造并发送 startService
     const char *pkgName = env->GetStringUTFChars(packageName, 0);
     const char *svcName = env->GetStringUTFChars(serviceName, 0);
 
-    Parcel *data = new Parcel;
-    writeStartServiceParcel(*data, pkgName, svcName, sdkVersion);
+    Parcel data;
+    writeStartServiceParcel(data, pkgName, svcName, sdkVersion);
 
     uint32_t transactCode = getStartServiceTransactionCode(sdkVersion);
-    status_t status = write_transact(amsHandle, transactCode, *data, NULL, 1, driverFD);
+    status_t status = write_transact(amsHandle, transactCode, data, NULL, 1, driverFD);
     LOGI("测试调用结果: %d", status);
 
-    delete data;
     unInitProcessState(driverFD, vmStart);
 
     env->ReleaseStringUTFChars(packageName, pkgName);
     env->ReleaseStringUTFChars(serviceName, svcName);
 }
 
-} // extern "C"
+/**
+ * JNI 方法: 获取按标签统计的 Parcel / SharedBuffer 内存分配
+ */
+static jstring jniGetAllocTagStats(JNIEnv *env, jobject /* this */) {
+    char buffer[2048];
+    allocTagDump(buffer, sizeof(buffer));
+    return env->NewStringUTF(buffer);
+}
+
+static jlong jniGetBinderTimeoutCount(JNIEnv * /* env */, jobject /* this */) {
+    return (jlong) binder_transact_timeout_count();
+}
+
+/**
+ * JNI 方法: 构造 startService 事务数据，零拷贝交给 Kotlin 检查
+ */
+static jobject jniBuildStartServiceParcel(JNIEnv *env, jobject /* this */,
+                                          jstring packageName, jstring serviceName,
+                                          jint sdkVersion) {
+    if (packageName == NULL || serviceName == NULL) return NULL;
+
+    const char *pkgName = env->GetStringUTFChars(packageName, 0);
+    const char *svcName = env->GetStringUTFChars(serviceName, 0);
+    Parcel *parcel = new Parcel;
+    writeStartServiceParcel(*parcel, pkgName, svcName, sdkVersion);
+    env->ReleaseStringUTFChars(packageName, pkgName);
+    env->ReleaseStringUTFChars(serviceName, svcName);
+
+    return fw_parcel_buffer_wrap(env, parcel);
+}
+
+/**
+ * JNI 方法: 释放 FwParcelBuffer 持有的 Parcel
+ */
+static void jniReleaseParcelBuffer(JNIEnv * /* env */, jobject /* this */, jlong handle) {
+    fw_parcel_buffer_release(handle);
+}
+
+/**
+ * 模块入口：返回函数表
+ *
+ * 函数表为常量初始化的静态对象，不产生全局构造函数
+ */
+extern "C" FW_EXPORT const FwBinderModule *fw_binder_module_get() {
+    static const FwBinderModule module = {
+            FW_BINDER_MODULE_VERSION,
+            jniLockFile,
+            jniWaitFileLock,
+            jniStartForceStopDaemon,
+            jniTestBinderCall,
+            jniGetAllocTagStats,
+            jniGetBinderTimeoutCount,
+            jniBuildStartServiceParcel,
+            jniReleaseParcelBuffer,
+    };
+    return &module;
+}
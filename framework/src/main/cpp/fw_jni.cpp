@@ -13,7 +13,16 @@
  *   - setProcessPriority / getProcessPriority: 进程优先级操作
  *   - getProcessStatus / getMemoryInfo: 进程和内存信息获取
  *   - checkRoot / getProcessCount: 系统状态检测
+ *   - setProcCacheTtl / getProcCacheStats: /proc 采样缓存配置与统计（按需加载的缓存模块）
  *   - startSocketServer / stopSocketServer / connectSocket / sendHeartbeat: Socket 操作
+ *   - lockFile / waitFileLock / startForceStopDaemon / testBinderCall: 转发到按需加载的 Binder 模块
+ *   - getNativeThreadReport / startNativeThreadMonitor: Native 线程诊断
+ *   - startNativeProfiler / stopNativeProfiler: Native CPU 采样
+ *   - enableNativeDiagnostics: 加载诊断模块（循环监控、状态板、唤醒归因）
+ *   - startNativeLoopWatchdog / getNativeLoopReport: Native 循环卡顿监控
+ *   - setNativeHealth / setNativeGauge / getNativeStatusBoard: 跨进程状态板
+ *   - subscribeNativeEvents / getNativeEventBusReport: Native 事件订阅与事件总线统计
+ *   - getNativeWakeupReport: Native 唤醒归因统计
  *
  * @author Pangu-Immortal
  * @github https://github.com/Pangu-Immortal/KeepLiveService
@@ -22,12 +31,25 @@
 
 #include <jni.h>
 #include <string>
+#include <string.h>
 #include <android/log.h>
+#include "fw_tokenlog.h"
+#include <unistd.h>
+#include "fw_module.h"
+#include "fw_diag.h"
+#include "fw_event_bus.h"
+#include "fw_jni_dispatch.h"
+#include "fw_loop_monitor.h"
+#include "fw_proc_cache.h"
+#include "fw_profiler.h"
+#include "fw_status_board.h"
+#include "fw_thread.h"
+#include "fw_wakeup.h"
 
 #define LOG_TAG "FwNative"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) FW_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 // 外部函数声明
 extern "C" {
@@ -37,14 +59,10 @@ extern "C" {
     bool is_daemon_running();
 
     // fw_process.cpp
-    int get_oom_adj();
     bool set_oom_adj(int adj);
     bool set_process_priority(int priority);
     int get_process_priority();
-    void get_process_status(char* buffer, int buffer_size);
-    void get_memory_info(long* total_kb, long* free_kb, long* available_kb);
     bool check_root();
-    int get_process_count();
 
     // fw_socket.cpp
     int create_socket_server(const char* socket_name);
@@ -121,7 +139,7 @@ Java_com_service_framework_native_FwNative_getOomAdj(
         JNIEnv* /* env */,
         jobject /* this */) {
 
-    return get_oom_adj();
+    return fw_proc_cache_oom_adj();
 }
 
 /**
@@ -135,7 +153,9 @@ Java_com_service_framework_native_FwNative_setOomAdj(
         jobject /* this */,
         jint adj) {
 
-    return set_oom_adj(adj) ? JNI_TRUE : JNI_FALSE;
+    bool result = set_oom_adj(adj);
+    fw_proc_cache_invalidate(FW_PROC_METRIC_OOM_ADJ);
+    return result ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
@@ -176,7 +196,7 @@ Java_com_service_framework_native_FwNative_getProcessStatus(
         jobject /* this */) {
 
     char buffer[4096];
-    get_process_status(buffer, sizeof(buffer));
+    fw_proc_cache_process_status(buffer, sizeof(buffer));
     return env->NewStringUTF(buffer);
 }
 
@@ -192,7 +212,7 @@ Java_com_service_framework_native_FwNative_getMemoryInfo(
         jobject /* this */) {
 
     long total_kb = 0, free_kb = 0, available_kb = 0;
-    get_memory_info(&total_kb, &free_kb, &available_kb);
+    fw_proc_cache_memory_info(&total_kb, &free_kb, &available_kb);
 
     jlongArray result = env->NewLongArray(3);
     if (result == nullptr) {
@@ -228,7 +248,37 @@ Java_com_service_framework_native_FwNative_getProcessCount(
         JNIEnv* /* env */,
         jobject /* this */) {
 
-    return get_process_count();
+    return fw_proc_cache_process_count();
+}
+
+/**
+ * JNI 方法: setProcCacheTtl
+ *
+ * 设置 /proc 采样缓存的有效期
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_service_framework_native_FwNative_setProcCacheTtl(
+        JNIEnv* /* env */,
+        jobject /* this */,
+        jint metric,
+        jint ttlMs) {
+
+    return fw_proc_cache_set_ttl(metric, ttlMs) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * JNI 方法: getProcCacheStats
+ *
+ * 获取 /proc 采样缓存的命中率和陈旧时间
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_service_framework_native_FwNative_getProcCacheStats(
+        JNIEnv* env,
+        jobject /* this */) {
+
+    char buffer[1024];
+    fw_proc_cache_dump(buffer, sizeof(buffer));
+    return env->NewStringUTF(buffer);
 }
 
 /**
@@ -301,6 +351,408 @@ Java_com_service_framework_native_FwNative_sendHeartbeat(
     return send_heartbeat(socketFd) ? JNI_TRUE : JNI_FALSE;
 }
 
+// ==================== Binder 模块转发 ====================
+
+/**
+ * 获取 Binder 模块，加载失败时记录错误
+ */
+static const FwBinderModule* require_binder_module(const char* method) {
+    const FwBinderModule* module = fw_binder_module();
+    if (module == nullptr) {
+        LOGE("JNI: %s - Binder 模块不可用", method);
+    }
+    return module;
+}
+
+/**
+ * JNI 方法: lockFile
+ *
+ * 锁定文件（Binder 模块）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_lockFile(
+        JNIEnv* env,
+        jobject thiz,
+        jstring lockFilePath) {
+
+    const FwBinderModule* module = require_binder_module("lockFile");
+    if (module != nullptr) {
+        module->lockFile(env, thiz, lockFilePath);
+    }
+}
+
+/**
+ * JNI 方法: nativeSetSid
+ *
+ * 设置会话 ID（脱离父进程），不依赖 Binder 模块
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_nativeSetSid(
+        JNIEnv* /* env */,
+        jobject /* this */) {
+
+    setsid();
+}
+
+/**
+ * JNI 方法: waitFileLock
+ *
+ * 等待文件锁（Binder 模块）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_waitFileLock(
+        JNIEnv* env,
+        jobject thiz,
+        jstring lockFilePath) {
+
+    const FwBinderModule* module = require_binder_module("waitFileLock");
+    if (module != nullptr) {
+        module->waitFileLock(env, thiz, lockFilePath);
+    }
+}
+
+/**
+ * JNI 方法: startForceStopDaemon
+ *
+ * 启动无法强制停止守护进程（Binder 模块）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_startForceStopDaemon(
+        JNIEnv* env,
+        jobject thiz,
+        jstring indicatorSelfPath,
+        jstring indicatorDaemonPath,
+        jstring observerSelfPath,
+        jstring observerDaemonPath,
+        jstring packageName,
+        jstring serviceName,
+        jint sdkVersion) {
+
+    const FwBinderModule* module = require_binder_module("startForceStopDaemon");
+    if (module != nullptr) {
+        module->startForceStopDaemon(env, thiz, indicatorSelfPath, indicatorDaemonPath,
+                                     observerSelfPath, observerDaemonPath,
+                                     packageName, serviceName, sdkVersion);
+    }
+}
+
+/**
+ * JNI 方法: testBinderCall
+ *
+ * 测试 Binder 直接调用（Binder 模块）
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_testBinderCall(
+        JNIEnv* env,
+        jobject thiz,
+        jstring packageName,
+        jstring serviceName,
+        jint sdkVersion) {
+
+    const FwBinderModule* module = require_binder_module("testBinderCall");
+    if (module != nullptr) {
+        module->testBinderCall(env, thiz, packageName, serviceName, sdkVersion);
+    }
+}
+
+/**
+ * JNI 方法: getAllocTagStats
+ *
+ * 按标签统计的 Parcel / SharedBuffer 内存分配，Binder 模块未加载时返回空字符串
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_service_framework_native_FwNative_getAllocTagStats(
+        JNIEnv* env,
+        jobject thiz) {
+
+    const FwBinderModule* module = fw_binder_module_if_loaded();
+    if (module == nullptr) {
+        return env->NewStringUTF("");
+    }
+    return module->getAllocTagStats(env, thiz);
+}
+
+/**
+ * JNI 方法: getBinderTimeoutCount
+ *
+ * Binder 事务等待超时的累计次数，Binder 模块未加载时返回 0
+ */
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_service_framework_native_FwNative_getBinderTimeoutCount(
+        JNIEnv* env,
+        jobject thiz) {
+
+    const FwBinderModule* module = fw_binder_module_if_loaded();
+    if (module == nullptr) {
+        return 0;
+    }
+    return module->getBinderTimeoutCount(env, thiz);
+}
+
+/**
+ * JNI 方法: buildStartServiceParcel
+ *
+ * 构造 startService 事务数据，返回零拷贝的 FwParcelBuffer（Binder 模块）
+ */
+extern "C" JNIEXPORT jobject JNICALL
+Java_com_service_framework_native_FwNative_buildStartServiceParcel(
+        JNIEnv* env,
+        jobject thiz,
+        jstring packageName,
+        jstring serviceName,
+        jint sdkVersion) {
+
+    const FwBinderModule* module = require_binder_module("buildStartServiceParcel");
+    if (module == nullptr) {
+        return nullptr;
+    }
+    return module->buildStartServiceParcel(env, thiz, packageName, serviceName, sdkVersion);
+}
+
+/**
+ * JNI 方法: releaseParcelBuffer
+ *
+ * FwParcelBuffer 关闭或被回收时调用；句柄只可能来自已加载的 Binder 模块
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_releaseParcelBuffer(
+        JNIEnv* env,
+        jobject thiz,
+        jlong handle) {
+
+    const FwBinderModule* module = fw_binder_module_if_loaded();
+    if (module != nullptr) {
+        module->releaseParcelBuffer(env, thiz, handle);
+    }
+}
+
+/**
+ * JNI 方法: dumpTokenizedLog
+ *
+ * 导出令牌化日志缓冲区，非 FW_TOKENIZED_LOG 构建返回 false
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_service_framework_native_FwNative_dumpTokenizedLog(
+        JNIEnv* env,
+        jobject /* thiz */,
+        jstring path) {
+
+    if (!fw_tokenlog_enabled() || path == nullptr) {
+        return JNI_FALSE;
+    }
+
+    const char* path_str = env->GetStringUTFChars(path, nullptr);
+    if (path_str == nullptr) {
+        return JNI_FALSE;
+    }
+    bool ok = fw_tokenlog_dump(path_str);
+    env->ReleaseStringUTFChars(path, path_str);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * JNI 方法: getNativeThreadReport
+ *
+ * 先执行一次线程检查，再附上登记表
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_service_framework_native_FwNative_getNativeThreadReport(
+        JNIEnv* env,
+        jobject /* thiz */) {
+
+    char buffer[4096];
+    fw_thread_check(buffer, sizeof(buffer));
+    size_t used = strlen(buffer);
+    fw_thread_dump(buffer + used, sizeof(buffer) - used);
+    return env->NewStringUTF(buffer);
+}
+
+/**
+ * JNI 方法: startNativeThreadMonitor
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_service_framework_native_FwNative_startNativeThreadMonitor(
+        JNIEnv* /* env */,
+        jobject /* thiz */,
+        jint interval_ms) {
+
+    return fw_thread_monitor_start(interval_ms) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * JNI 方法: startNativeProfiler
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_service_framework_native_FwNative_startNativeProfiler(
+        JNIEnv* /* env */,
+        jobject /* thiz */,
+        jint frequency_hz,
+        jint max_samples,
+        jint max_samples_per_sec,
+        jboolean all_threads) {
+
+    // 首次开启采样时加载 libfw_profiler.so
+    const FwProfilerModule* module = fw_profiler_module();
+    if (module == nullptr) {
+        return JNI_FALSE;
+    }
+
+    fw_profiler_config config;
+    config.frequency_hz = frequency_hz;
+    config.max_samples = max_samples;
+    config.max_samples_per_sec = max_samples_per_sec;
+    config.all_threads = all_threads == JNI_TRUE;
+    return module->start(&config) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * JNI 方法: stopNativeProfiler
+ *
+ * 停止采样并写出 folded 文件，返回样本数，从未开启过采样或写文件失败返回 -1
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_service_framework_native_FwNative_stopNativeProfiler(
+        JNIEnv* env,
+        jobject /* thiz */,
+        jstring path) {
+
+    // 从未开启过采样时不加载模块
+    const FwProfilerModule* module = fw_profiler_module_if_loaded();
+    if (module == nullptr) {
+        return -1;
+    }
+
+    int samples = module->stop();
+    if (path == nullptr) {
+        return -1;
+    }
+
+    const char* path_str = env->GetStringUTFChars(path, nullptr);
+    if (path_str == nullptr) {
+        return -1;
+    }
+    bool ok = module->writeFolded(path_str);
+    env->ReleaseStringUTFChars(path, path_str);
+    return ok ? samples : -1;
+}
+
+/**
+ * JNI 方法: enableNativeDiagnostics
+ *
+ * 加载诊断模块（循环卡顿监控、唤醒归因、状态板）
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_service_framework_native_FwNative_enableNativeDiagnostics(
+        JNIEnv* /* env */,
+        jobject /* thiz */) {
+
+    return fw_diag_module() != nullptr ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * JNI 方法: startNativeLoopWatchdog
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_service_framework_native_FwNative_startNativeLoopWatchdog(
+        JNIEnv* /* env */,
+        jobject /* thiz */,
+        jint tick_ms) {
+
+    // 看门狗属于诊断模块，未加载时在这里加载
+    if (fw_diag_module() == nullptr) return JNI_FALSE;
+    return fw_loop_watchdog_start(tick_ms) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * JNI 方法: getNativeLoopReport
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_service_framework_native_FwNative_getNativeLoopReport(
+        JNIEnv* env,
+        jobject /* thiz */) {
+
+    char buffer[4096];
+    fw_loop_dump(buffer, sizeof(buffer));
+    return env->NewStringUTF(buffer);
+}
+
+/**
+ * JNI 方法: setNativeHealth
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_setNativeHealth(
+        JNIEnv* /* env */,
+        jobject /* thiz */,
+        jint status) {
+
+    fw_status_board_set_status(status);
+}
+
+/**
+ * JNI 方法: setNativeGauge
+ */
+extern "C" JNIEXPORT void JNICALL
+Java_com_service_framework_native_FwNative_setNativeGauge(
+        JNIEnv* /* env */,
+        jobject /* thiz */,
+        jint index,
+        jlong value) {
+
+    fw_status_board_set_gauge(index, value);
+}
+
+/**
+ * JNI 方法: getNativeStatusBoard
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_service_framework_native_FwNative_getNativeStatusBoard(
+        JNIEnv* env,
+        jobject /* thiz */) {
+
+    char buffer[4096];
+    fw_status_board_dump(buffer, sizeof(buffer));
+    return env->NewStringUTF(buffer);
+}
+
+/**
+ * JNI 方法: getNativeEventBusReport
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_service_framework_native_FwNative_getNativeEventBusReport(
+        JNIEnv* env,
+        jobject /* thiz */) {
+
+    char buffer[2048];
+    fw_event_bus_dump(buffer, sizeof(buffer));
+    return env->NewStringUTF(buffer);
+}
+
+/**
+ * JNI 方法: subscribeNativeEvents
+ *
+ * 订阅事件总线，把 Socket / 守护进程 / MediaRoute 事件投递到 Java 层
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_service_framework_native_FwNative_subscribeNativeEvents(
+        JNIEnv* /* env */,
+        jobject /* thiz */) {
+
+    return fw_dispatch_subscribe_events() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * JNI 方法: getNativeWakeupReport
+ */
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_service_framework_native_FwNative_getNativeWakeupReport(
+        JNIEnv* env,
+        jobject /* thiz */) {
+
+    char buffer[4096];
+    fw_wakeup_dump(buffer, sizeof(buffer));
+    return env->NewStringUTF(buffer);
+}
+
 /**
  * JNI_OnLoad
  *
@@ -313,6 +765,11 @@ JNIEXPORT jint JNI_OnLoad(JavaVM* vm, void* /* reserved */) {
         return JNI_ERR;
     }
 
+    // 缓存事件回调的类和方法，失败不影响其它功能
+    if (!fw_dispatch_init(vm, env)) {
+        LOGE("JNI_OnLoad: 事件分发初始化失败");
+    }
+
     LOGI("JNI_OnLoad: fw_native 库已加载");
     return JNI_VERSION_1_6;
 }
@@ -328,4 +785,5 @@ JNIEXPORT void JNI_OnUnload(JavaVM* /* vm */, void* /* reserved */) {
     // 清理资源
     stop_daemon();
     stop_socket_server();
+    fw_dispatch_shutdown();
 }
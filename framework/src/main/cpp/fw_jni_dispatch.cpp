@@ -0,0 +1,450 @@
+/**
+ * ============================================================================
+ * fw_jni_dispatch.cpp - Native -> Java 事件分发实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   有界环形队列 + 单个分发线程。投递方只在锁内写入队列，分发线程被唤醒后
+ *   等待一个很短的合并窗口，再一次取出全部事件，通过一次
+ *   CallStaticVoidMethod 交给 Java 层。突发事件只产生一次 JNI 调用。
+ *
+ *   分发线程在第一次投递时才创建，不增加库加载的开销。
+ *
+ *   分发线程空闲时在 poll 中等待两个 fd：投递方在队列从空变为非空时写的 eventfd，
+ *   以及事件总线订阅者的 eventfd（fw_event_wait(subscriber, 0) 登记等待后，
+ *   有新事件时由发布者写入）。总线事件在分发线程上取出、转换为事件码后入队，
+ *   与直接投递的事件一起合并批次。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_jni_dispatch.h"
+
+#include <atomic>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <android/log.h>
+#include "fw_event_bus.h"
+#include "fw_thread.h"
+#include "fw_tokenlog.h"
+#include "fw_wakeup.h"
+
+#define LOG_TAG "FwNative"
+#define LOGD(...) FW_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// JNI 类路径与回调方法
+#define JNI_CLASS_PATH "com/service/framework/native/FwNative"
+#define ON_EVENTS_METHOD "onNativeEvents"
+#define ON_EVENTS_SIGNATURE "([I[J)V"
+
+// 合并窗口：分发线程被唤醒后再等待这段时间，让同一突发中的事件进入同一批次
+#define BATCH_WINDOW_NS (5 * 1000000L)
+
+// 分发线程每次从事件总线取出的事件数，未取完的在下一轮继续取
+#define BUS_POLL_BATCH 32
+
+struct DispatchEvent {
+    int32_t code;           // 事件码
+    int64_t timestamp_ms;   // CLOCK_BOOTTIME 毫秒，与 SystemClock.elapsedRealtime() 一致
+};
+
+// JNI 缓存（JNI_OnLoad 中初始化）
+static JavaVM *g_vm = nullptr;
+static jclass g_native_class = nullptr;
+static jmethodID g_on_events_method = nullptr;
+static pthread_key_t g_env_key;
+static bool g_env_key_created = false;
+
+// 事件队列
+static pthread_mutex_t g_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static DispatchEvent g_queue[FW_DISPATCH_QUEUE_CAPACITY];
+static size_t g_queue_head = 0;
+static size_t g_queue_size = 0;
+static uint64_t g_dropped_count = 0;
+
+// 分发线程
+static pthread_t g_dispatch_thread;
+static bool g_dispatch_started = false;
+static bool g_dispatch_stopping = false;
+static int g_wake_fd = -1;                  // 队列从空变为非空、停止时写入
+
+// 事件总线订阅（只在 g_subscribe_lock 内设置，分发线程读取）
+static pthread_mutex_t g_subscribe_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::atomic<fw_event_subscriber *> g_subscriber{nullptr};
+
+static int64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t boottime_ms() {
+    return clock_ns(CLOCK_BOOTTIME) / 1000000;
+}
+
+/**
+ * 线程退出时自动分离（只对 fw_jni_env 附加的线程生效）
+ */
+static void detach_current_thread(void *env) {
+    if (env != nullptr && g_vm != nullptr) {
+        g_vm->DetachCurrentThread();
+    }
+}
+
+extern "C" JNIEnv *fw_jni_env(const char *thread_name) {
+    if (g_vm == nullptr || !g_env_key_created) return nullptr;
+
+    JNIEnv *env = static_cast<JNIEnv *>(pthread_getspecific(g_env_key));
+    if (env != nullptr) return env;
+
+    // Java 线程或已由其它代码附加的线程，直接使用，不负责分离
+    if (g_vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        return env;
+    }
+
+    JavaVMAttachArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.name = thread_name;
+    args.group = nullptr;
+    if (g_vm->AttachCurrentThread(&env, &args) != JNI_OK) {
+        LOGE("AttachCurrentThread 失败");
+        return nullptr;
+    }
+
+    pthread_setspecific(g_env_key, env);
+    LOGD("线程已附加到 JVM: %s", thread_name != nullptr ? thread_name : "(unnamed)");
+    return env;
+}
+
+/**
+ * 将一批事件交给 Java 层（一次 JNI 调用）
+ */
+static void deliver_batch(JNIEnv *env, const DispatchEvent *events, size_t count) {
+    jint codes[FW_DISPATCH_QUEUE_CAPACITY];
+    jlong timestamps[FW_DISPATCH_QUEUE_CAPACITY];
+    for (size_t i = 0; i < count; i++) {
+        codes[i] = events[i].code;
+        timestamps[i] = events[i].timestamp_ms;
+    }
+
+    jintArray code_array = env->NewIntArray((jsize) count);
+    jlongArray timestamp_array = env->NewLongArray((jsize) count);
+    if (code_array == nullptr || timestamp_array == nullptr) {
+        LOGE("分配事件数组失败, 丢弃 %zu 个事件", count);
+        env->ExceptionClear();
+    } else {
+        env->SetIntArrayRegion(code_array, 0, (jsize) count, codes);
+        env->SetLongArrayRegion(timestamp_array, 0, (jsize) count, timestamps);
+        env->CallStaticVoidMethod(g_native_class, g_on_events_method, code_array, timestamp_array);
+        if (env->ExceptionCheck()) {
+            LOGW("onNativeEvents 抛出异常");
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+    }
+
+    if (code_array != nullptr) env->DeleteLocalRef(code_array);
+    if (timestamp_array != nullptr) env->DeleteLocalRef(timestamp_array);
+}
+
+/**
+ * 入队（调用方持有 g_queue_lock）
+ *
+ * @return 是否入队；队列满时丢弃并计数
+ */
+static bool enqueue_locked(int32_t code, int64_t timestamp_ms) {
+    if (g_queue_size == FW_DISPATCH_QUEUE_CAPACITY) {
+        g_dropped_count++;
+        return false;
+    }
+    DispatchEvent &event = g_queue[(g_queue_head + g_queue_size) % FW_DISPATCH_QUEUE_CAPACITY];
+    event.code = code;
+    event.timestamp_ms = timestamp_ms;
+    g_queue_size++;
+    return true;
+}
+
+static void wake_dispatch_thread() {
+    uint64_t one = 1;
+    ssize_t ignored = write(g_wake_fd, &one, sizeof(one));
+    (void) ignored;
+}
+
+/**
+ * 总线事件转换为事件码，不需要投递的事件返回 0
+ */
+static int32_t bus_event_code(const fw_event &event) {
+    fw_socket_event socket_event;
+    if (fw_event_get(event, &socket_event)) {
+        switch (socket_event.state) {
+            case FW_SOCKET_EVENT_CLIENT_CONNECTED: return FW_EVENT_SOCKET_CLIENT_CONNECTED;
+            case FW_SOCKET_EVENT_CLIENT_DISCONNECTED: return FW_EVENT_SOCKET_CLIENT_DISCONNECTED;
+            case FW_SOCKET_EVENT_CONNECTION_LOST: return FW_EVENT_SOCKET_CONNECTION_LOST;
+            default: return 0;
+        }
+    }
+
+    // 父进程死亡、唤醒失败只在守护进程内发布，那里没有 Java 层
+    fw_daemon_event daemon_event;
+    if (fw_event_get(event, &daemon_event)) {
+        switch (daemon_event.state) {
+            case FW_DAEMON_EVENT_STARTED: return FW_EVENT_DAEMON_STARTED;
+            case FW_DAEMON_EVENT_STOP_REQUESTED: return FW_EVENT_DAEMON_STOP_REQUESTED;
+            default: return 0;
+        }
+    }
+
+    fw_mediaroute_event route_event;
+    if (fw_event_get(event, &route_event)) {
+        if (route_event.service == 1) {
+            return route_event.running ? FW_EVENT_MEDIAROUTE_STARTED : FW_EVENT_MEDIAROUTE_STOPPED;
+        }
+        if (route_event.service == 2) {
+            return route_event.running ? FW_EVENT_MEDIAROUTE2_STARTED : FW_EVENT_MEDIAROUTE2_STOPPED;
+        }
+    }
+    return 0;
+}
+
+/**
+ * 从事件总线取出一批事件并入队（分发线程调用）
+ */
+static void drain_bus_events(fw_event_subscriber *subscriber) {
+    if (subscriber == nullptr) return;
+    fw_event events[BUS_POLL_BATCH];
+    const int count = fw_event_poll(subscriber, events, BUS_POLL_BATCH);
+    if (count <= 0) return;
+
+    // 总线时间戳为 CLOCK_MONOTONIC，换算到 Java 层使用的 CLOCK_BOOTTIME
+    const int64_t offset_ns = clock_ns(CLOCK_BOOTTIME) - clock_ns(CLOCK_MONOTONIC);
+    pthread_mutex_lock(&g_queue_lock);
+    for (int i = 0; i < count; i++) {
+        const int32_t code = bus_event_code(events[i]);
+        if (code != 0) enqueue_locked(code, (events[i].timestamp_ns + offset_ns) / 1000000);
+    }
+    pthread_mutex_unlock(&g_queue_lock);
+}
+
+/**
+ * 队列为空时等待投递通知或总线事件
+ */
+static void wait_for_events(int wakeup_id, fw_event_subscriber *subscriber) {
+    struct pollfd fds[2];
+    fds[0] = {g_wake_fd, POLLIN, 0};
+    nfds_t nfds = 1;
+    if (subscriber != nullptr) {
+        // 登记等待；总线上还有未取出的事件时直接返回去取
+        const int pending = fw_event_wait(subscriber, 0);
+        if (pending > 0) return;
+        if (pending == 0) {
+            fds[1] = {fw_event_subscriber_fd(subscriber), POLLIN, 0};
+            nfds = 2;
+        }
+    }
+
+    if (fw_wakeup_poll(wakeup_id, fds, nfds, -1) > 0 && (fds[0].revents & POLLIN) != 0) {
+        uint64_t value;
+        ssize_t ignored = read(g_wake_fd, &value, sizeof(value));
+        (void) ignored;
+    }
+}
+
+/**
+ * 分发线程
+ */
+static void *dispatch_thread(void *arg) {
+    (void) arg;
+    JNIEnv *env = fw_jni_env("FwNativeDispatch");
+    if (env == nullptr) {
+        LOGE("分发线程无法附加到 JVM, 事件将被丢弃");
+    }
+
+    const int wakeup_id = fw_wakeup_register("jni_dispatch");
+    DispatchEvent batch[FW_DISPATCH_QUEUE_CAPACITY];
+    for (;;) {
+        fw_event_subscriber *subscriber = g_subscriber.load(std::memory_order_acquire);
+        drain_bus_events(subscriber);
+
+        pthread_mutex_lock(&g_queue_lock);
+        if (g_queue_size == 0) {
+            const bool stopping = g_dispatch_stopping;
+            pthread_mutex_unlock(&g_queue_lock);
+            if (stopping) break;
+            // 解锁后入队的事件会写 eventfd，不会丢失唤醒
+            wait_for_events(wakeup_id, subscriber);
+            continue;
+        }
+
+        // 合并窗口：不持锁等待，投递方可以继续入队
+        if (!g_dispatch_stopping && g_queue_size < FW_DISPATCH_QUEUE_CAPACITY) {
+            pthread_mutex_unlock(&g_queue_lock);
+            struct timespec window = {0, BATCH_WINDOW_NS};
+            nanosleep(&window, nullptr);
+            drain_bus_events(subscriber);
+            pthread_mutex_lock(&g_queue_lock);
+        }
+
+        size_t count = g_queue_size;
+        for (size_t i = 0; i < count; i++) {
+            batch[i] = g_queue[(g_queue_head + i) % FW_DISPATCH_QUEUE_CAPACITY];
+        }
+        g_queue_head = (g_queue_head + count) % FW_DISPATCH_QUEUE_CAPACITY;
+        g_queue_size = 0;
+        pthread_mutex_unlock(&g_queue_lock);
+
+        if (env != nullptr && count > 0) {
+            deliver_batch(env, batch, count);
+        }
+    }
+
+    LOGI("事件分发线程退出");
+    return nullptr;
+}
+
+/**
+ * 首次使用时创建 eventfd 和分发线程（调用方持有 g_queue_lock）
+ */
+static bool start_dispatch_thread_locked() {
+    if (g_dispatch_started) return true;
+
+    if (g_wake_fd < 0) {
+        g_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (g_wake_fd < 0) {
+            LOGE("创建 eventfd 失败: %s", strerror(errno));
+            return false;
+        }
+    }
+
+    int ret = fw_thread_create(&g_dispatch_thread, "fw_dispatch", "jni_dispatch",
+                               FW_THREAD_STACK_JNI, false,
+                               dispatch_thread, nullptr);
+    if (ret != 0) {
+        LOGE("创建事件分发线程失败: %s", strerror(ret));
+        return false;
+    }
+    g_dispatch_started = true;
+    return true;
+}
+
+extern "C" bool fw_dispatch_init(JavaVM *vm, JNIEnv *env) {
+    g_vm = vm;
+
+    if (!g_env_key_created) {
+        if (pthread_key_create(&g_env_key, detach_current_thread) != 0) {
+            LOGE("pthread_key_create 失败");
+            return false;
+        }
+        g_env_key_created = true;
+    }
+
+    jclass clazz = env->FindClass(JNI_CLASS_PATH);
+    if (clazz == nullptr) {
+        env->ExceptionClear();
+        LOGE("找不到类 %s, 事件分发不可用", JNI_CLASS_PATH);
+        return false;
+    }
+
+    jmethodID method = env->GetStaticMethodID(clazz, ON_EVENTS_METHOD, ON_EVENTS_SIGNATURE);
+    if (method == nullptr) {
+        env->ExceptionClear();
+        env->DeleteLocalRef(clazz);
+        LOGE("找不到方法 %s%s, 事件分发不可用", ON_EVENTS_METHOD, ON_EVENTS_SIGNATURE);
+        return false;
+    }
+
+    g_native_class = static_cast<jclass>(env->NewGlobalRef(clazz));
+    g_on_events_method = method;
+    env->DeleteLocalRef(clazz);
+    return g_native_class != nullptr;
+}
+
+extern "C" void fw_dispatch_shutdown() {
+    pthread_mutex_lock(&g_queue_lock);
+    bool started = g_dispatch_started;
+    g_dispatch_stopping = true;
+    if (started) wake_dispatch_thread();
+    pthread_mutex_unlock(&g_queue_lock);
+
+    if (started) {
+        pthread_join(g_dispatch_thread, nullptr);
+    }
+
+    pthread_mutex_lock(&g_subscribe_lock);
+    fw_event_subscriber *subscriber = g_subscriber.exchange(nullptr, std::memory_order_acq_rel);
+    if (subscriber != nullptr) fw_event_unsubscribe(subscriber);
+    pthread_mutex_unlock(&g_subscribe_lock);
+
+    JNIEnv *env = nullptr;
+    if (g_vm != nullptr && g_native_class != nullptr &&
+        g_vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) == JNI_OK) {
+        env->DeleteGlobalRef(g_native_class);
+    }
+    g_native_class = nullptr;
+    g_on_events_method = nullptr;
+}
+
+extern "C" bool fw_dispatch_post(int32_t code) {
+    if (g_on_events_method == nullptr) return false;
+
+    const int64_t timestamp_ms = boottime_ms();
+
+    pthread_mutex_lock(&g_queue_lock);
+    if (g_dispatch_stopping || !start_dispatch_thread_locked()) {
+        pthread_mutex_unlock(&g_queue_lock);
+        return false;
+    }
+
+    bool queued = enqueue_locked(code, timestamp_ms);
+    // 队列从空变为非空时才需要唤醒，分发线程在合并窗口或投递中时不会等待 eventfd
+    if (queued && g_queue_size == 1) {
+        wake_dispatch_thread();
+    }
+    pthread_mutex_unlock(&g_queue_lock);
+    return queued;
+}
+
+extern "C" bool fw_dispatch_subscribe_events() {
+    if (g_on_events_method == nullptr) return false;
+
+    // 订阅可能触发事件总线模块的加载，不在 g_queue_lock 内进行，避免阻塞投递方
+    pthread_mutex_lock(&g_subscribe_lock);
+    if (g_subscriber.load(std::memory_order_relaxed) == nullptr) {
+        fw_event_subscriber *subscriber = fw_event_subscribe(
+                fw_event_mask<fw_socket_event, fw_daemon_event, fw_mediaroute_event>(),
+                "jni_dispatch");
+        if (subscriber != nullptr) {
+            pthread_mutex_lock(&g_queue_lock);
+            if (!g_dispatch_stopping && start_dispatch_thread_locked()) {
+                g_subscriber.store(subscriber, std::memory_order_release);
+                // 分发线程可能正在只等待 eventfd，唤醒后把订阅者的 fd 加入等待
+                wake_dispatch_thread();
+            }
+            pthread_mutex_unlock(&g_queue_lock);
+            if (g_subscriber.load(std::memory_order_relaxed) == nullptr) {
+                fw_event_unsubscribe(subscriber);
+            }
+        } else {
+            LOGW("订阅事件总线失败, Native 事件不会投递到 Java 层");
+        }
+    }
+    const bool subscribed = g_subscriber.load(std::memory_order_relaxed) != nullptr;
+    pthread_mutex_unlock(&g_subscribe_lock);
+    return subscribed;
+}
+
+extern "C" uint64_t fw_dispatch_dropped_count() {
+    pthread_mutex_lock(&g_queue_lock);
+    uint64_t dropped = g_dropped_count;
+    pthread_mutex_unlock(&g_queue_lock);
+    return dropped;
+}
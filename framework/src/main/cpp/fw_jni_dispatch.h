@@ -0,0 +1,96 @@
+/**
+ * ============================================================================
+ * fw_jni_dispatch.h - Native -> Java 事件分发
+ * ============================================================================
+ *
+ * 功能简介：
+ *   将 Native 层事件（Socket 断开等）批量投递到 Java 层
+ *   FwNative.onNativeEvents(IntArray, LongArray)。
+ *
+ * 事件来源：
+ *   - 事件总线（fw_event_bus.h）：Java 层注册第一个监听器时 fw_dispatch_subscribe_events
+ *     订阅 Socket / 守护进程 / MediaRoute 事件，由分发线程取出并转换为 FW_EVENT_*
+ *   - fw_dispatch_post：直接投递事件码
+ *
+ * 设计要点：
+ *   - JavaVM、FwNative 类和回调方法 ID 在 JNI_OnLoad 中缓存为全局引用，
+ *     投递时不再 FindClass / GetMethodID
+ *   - 每个 Native 线程只 AttachCurrentThread 一次，JNIEnv 保存在 TLS 中，
+ *     线程退出时由 pthread key 析构函数自动 DetachCurrentThread
+ *   - fw_dispatch_post 只写入有界环形队列，不做 JNI 调用，可在任意 Native 线程调用
+ *   - 分发线程一次取出队列中所有事件，一批事件只产生一次 JNI 调用
+ *   - 分发线程空闲时在 poll 中同时等待投递通知（eventfd）和总线订阅者的 fd
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_JNI_DISPATCH_H
+#define FW_JNI_DISPATCH_H
+
+#include <jni.h>
+#include <stdint.h>
+
+// ==================== 事件码（与 FwNative.kt 中 EVENT_* 常量一致） ====================
+
+#define FW_EVENT_SOCKET_CONNECTION_LOST     1   // 心跳客户端与服务端的连接断开
+#define FW_EVENT_SOCKET_CLIENT_CONNECTED    2   // Socket 服务端接受了新客户端
+#define FW_EVENT_SOCKET_CLIENT_DISCONNECTED 3   // Socket 服务端的客户端断开
+#define FW_EVENT_DAEMON_STARTED             4   // 守护子进程已创建
+#define FW_EVENT_DAEMON_STOP_REQUESTED      5   // 请求停止守护进程
+#define FW_EVENT_MEDIAROUTE_STARTED         6   // MediaRouteProviderService 启动
+#define FW_EVENT_MEDIAROUTE_STOPPED         7   // MediaRouteProviderService 停止
+#define FW_EVENT_MEDIAROUTE2_STARTED        8   // MediaRoute2ProviderService 启动
+#define FW_EVENT_MEDIAROUTE2_STOPPED        9   // MediaRoute2ProviderService 停止
+
+// 环形队列容量，队列满时丢弃新事件并计数
+#define FW_DISPATCH_QUEUE_CAPACITY 256
+
+extern "C" {
+
+/**
+ * 缓存 JavaVM 和回调方法（在 JNI_OnLoad 中调用）
+ *
+ * @return 是否成功；失败时事件投递被禁用，其它功能不受影响
+ */
+bool fw_dispatch_init(JavaVM *vm, JNIEnv *env);
+
+/**
+ * 停止分发线程并释放全局引用（在 JNI_OnUnload 中调用）
+ */
+void fw_dispatch_shutdown();
+
+/**
+ * 获取当前线程的 JNIEnv，未附加时附加一次（Native 线程使用）
+ *
+ * @param thread_name 附加时使用的 Java 线程名，可为 nullptr
+ * @return JNIEnv，失败返回 nullptr
+ */
+JNIEnv *fw_jni_env(const char *thread_name);
+
+/**
+ * 投递事件（非阻塞，不进行 JNI 调用）
+ *
+ * @param code 事件码 FW_EVENT_*
+ * @return 是否入队；未初始化或队列满时返回 false
+ */
+bool fw_dispatch_post(int32_t code);
+
+/**
+ * 订阅事件总线上的 Socket / 守护进程 / MediaRoute 事件并投递到 Java 层
+ *
+ * 首次调用时加载事件总线模块并启动分发线程，重复调用无副作用
+ *
+ * @return 是否已订阅；未初始化或事件总线不可用时返回 false
+ */
+bool fw_dispatch_subscribe_events();
+
+/**
+ * 获取因队列满而丢弃的事件数
+ */
+uint64_t fw_dispatch_dropped_count();
+
+}
+
+#endif // FW_JNI_DISPATCH_H
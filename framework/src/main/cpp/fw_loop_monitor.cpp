@@ -0,0 +1,353 @@
+/**
+ * ============================================================================
+ * fw_loop_monitor.cpp - Native 循环卡顿监控实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   fw_loop_begin / fw_loop_end 只做原子操作，不加锁。看门狗发现卡顿后用 CAS
+ *   标记该迭代已报告，迭代在两次检查之间结束时由 fw_loop_end 计数，不会重复计数。
+ *   调用栈采集和日志输出都在看门狗线程中进行。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_loop_monitor.h"
+
+#include <atomic>
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <android/log.h>
+#include "fw_profiler.h"
+#include "fw_thread.h"
+#include "fw_tokenlog.h"
+#include "fw_wakeup.h"
+
+#define LOG_TAG "FwLoopMonitor"
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+// 看门狗线程的 nice 值
+#define WATCHDOG_NICE 10
+// 卡顿调用栈采集等待时间
+#define STALL_CAPTURE_TIMEOUT_MS 100
+#define STALL_STACK_LEN 512
+
+struct LoopSlot {
+    std::atomic<bool> used;
+    char name[FW_LOOP_NAME_LEN];
+    pid_t tid;
+    int64_t stall_threshold_ns;
+    std::atomic<uint64_t> iterations;
+    std::atomic<int64_t> begin_ns;              // 0 表示不在迭代中
+    std::atomic<uint64_t> reported;             // 已计入卡顿的迭代序号
+    std::atomic<int64_t> max_ns;
+    std::atomic<uint32_t> stalls;
+    std::atomic<uint32_t> hist[FW_LOOP_HIST_BUCKETS];
+    // 以下由 g_loop_lock 保护
+    int64_t last_stall_ms;
+    char last_stall_stack[STALL_STACK_LEN];
+};
+
+static pthread_mutex_t g_loop_lock = PTHREAD_MUTEX_INITIALIZER;
+static LoopSlot g_loops[FW_LOOP_MAX];
+
+// 看门狗
+static pthread_mutex_t g_watchdog_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t g_watchdog_thread;
+static bool g_watchdog_running = false;
+static std::atomic<bool> g_watchdog_stop{false};
+static std::atomic<int> g_tick_ms{FW_LOOP_DEFAULT_TICK_MS};
+static std::atomic<uint64_t> g_ticks{0};
+static std::atomic<int64_t> g_max_drift_ns{0};
+static std::atomic<uint32_t> g_drift_hist[FW_LOOP_HIST_BUCKETS];
+
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int hist_bucket(int64_t ns) {
+    int64_t ms = ns / 1000000;
+    int bucket = 0;
+    while (ms > 0 && bucket < FW_LOOP_HIST_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void update_max(std::atomic<int64_t> *max, int64_t value) {
+    int64_t current = max->load(std::memory_order_relaxed);
+    while (value > current &&
+           !max->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// ==================== fork 处理 ====================
+
+static void atfork_prepare() {
+    pthread_mutex_lock(&g_watchdog_lock);
+    pthread_mutex_lock(&g_loop_lock);
+}
+
+static void atfork_parent() {
+    pthread_mutex_unlock(&g_loop_lock);
+    pthread_mutex_unlock(&g_watchdog_lock);
+}
+
+/**
+ * 子进程中登记循环的线程都不存在
+ */
+static void atfork_child() {
+    for (LoopSlot &slot : g_loops) {
+        slot.used.store(false, std::memory_order_relaxed);
+    }
+    g_watchdog_running = false;
+    pthread_mutex_unlock(&g_loop_lock);
+    pthread_mutex_unlock(&g_watchdog_lock);
+}
+
+static void init_once() {
+    pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+}
+
+// ==================== 登记与打点 ====================
+
+extern "C" int fw_loop_register(const char *name, int stall_threshold_ms) {
+    if (name == nullptr || stall_threshold_ms <= 0) return -1;
+    pthread_once(&g_init_once, init_once);
+
+    pthread_mutex_lock(&g_loop_lock);
+    for (int i = 0; i < FW_LOOP_MAX; i++) {
+        LoopSlot &slot = g_loops[i];
+        if (slot.used.load(std::memory_order_relaxed)) continue;
+
+        strlcpy(slot.name, name, sizeof(slot.name));
+        slot.tid = gettid();
+        slot.stall_threshold_ns = (int64_t) stall_threshold_ms * 1000000LL;
+        slot.iterations.store(0, std::memory_order_relaxed);
+        slot.begin_ns.store(0, std::memory_order_relaxed);
+        slot.reported.store(0, std::memory_order_relaxed);
+        slot.max_ns.store(0, std::memory_order_relaxed);
+        slot.stalls.store(0, std::memory_order_relaxed);
+        for (auto &bucket : slot.hist) bucket.store(0, std::memory_order_relaxed);
+        slot.last_stall_ms = 0;
+        slot.last_stall_stack[0] = '\0';
+        slot.used.store(true, std::memory_order_release);
+        pthread_mutex_unlock(&g_loop_lock);
+        return i;
+    }
+    pthread_mutex_unlock(&g_loop_lock);
+    LOGW("循环登记表已满，忽略 %s", name);
+    return -1;
+}
+
+extern "C" void fw_loop_unregister(int id) {
+    if (id < 0 || id >= FW_LOOP_MAX) return;
+    pthread_mutex_lock(&g_loop_lock);
+    g_loops[id].begin_ns.store(0, std::memory_order_relaxed);
+    g_loops[id].used.store(false, std::memory_order_release);
+    pthread_mutex_unlock(&g_loop_lock);
+}
+
+extern "C" void fw_loop_begin(int id) {
+    if (id < 0 || id >= FW_LOOP_MAX) return;
+    LoopSlot &slot = g_loops[id];
+    slot.iterations.fetch_add(1, std::memory_order_relaxed);
+    slot.begin_ns.store(monotonic_ns(), std::memory_order_release);
+}
+
+extern "C" void fw_loop_end(int id) {
+    if (id < 0 || id >= FW_LOOP_MAX) return;
+    LoopSlot &slot = g_loops[id];
+    const int64_t begin = slot.begin_ns.exchange(0, std::memory_order_acq_rel);
+    if (begin == 0) return;
+
+    const int64_t duration = monotonic_ns() - begin;
+    slot.hist[hist_bucket(duration)].fetch_add(1, std::memory_order_relaxed);
+    update_max(&slot.max_ns, duration);
+
+    // 在两次看门狗检查之间开始并结束的卡顿
+    if (duration > slot.stall_threshold_ns) {
+        uint64_t iteration = slot.iterations.load(std::memory_order_relaxed);
+        uint64_t reported = slot.reported.load(std::memory_order_relaxed);
+        if (reported != iteration &&
+            slot.reported.compare_exchange_strong(reported, iteration,
+                                                  std::memory_order_relaxed)) {
+            slot.stalls.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// ==================== 看门狗 ====================
+
+/**
+ * 检查一个循环，当前迭代超过阈值且未报告时采集调用栈
+ */
+static void check_loop(int id, int64_t now) {
+    LoopSlot &slot = g_loops[id];
+    if (!slot.used.load(std::memory_order_acquire)) return;
+    const int64_t begin = slot.begin_ns.load(std::memory_order_acquire);
+    if (begin == 0 || now - begin <= slot.stall_threshold_ns) return;
+
+    uint64_t iteration = slot.iterations.load(std::memory_order_relaxed);
+    uint64_t reported = slot.reported.load(std::memory_order_relaxed);
+    if (reported == iteration ||
+        !slot.reported.compare_exchange_strong(reported, iteration, std::memory_order_relaxed)) {
+        return;
+    }
+    slot.stalls.fetch_add(1, std::memory_order_relaxed);
+
+    // 第一次卡顿时在看门狗线程中加载 libfw_profiler.so，加载失败则只记录耗时
+    const FwProfilerModule *profiler = fw_profiler_module();
+    uintptr_t pcs[FW_PROFILER_MAX_DEPTH];
+    const int depth = profiler != nullptr
+                      ? profiler->captureThread(slot.tid, pcs, FW_PROFILER_MAX_DEPTH,
+                                                STALL_CAPTURE_TIMEOUT_MS)
+                      : 0;
+    char stack[STALL_STACK_LEN];
+    if (depth > 0) {
+        profiler->formatStack(pcs, depth, stack, sizeof(stack));
+    } else {
+        strlcpy(stack, "<无法采集>", sizeof(stack));
+    }
+
+    const int64_t elapsed_ms = (now - begin) / 1000000;
+    LOGW("循环 %s (tid=%d) 卡顿 %lld ms: %s", slot.name, slot.tid, (long long) elapsed_ms, stack);
+
+    pthread_mutex_lock(&g_loop_lock);
+    slot.last_stall_ms = elapsed_ms;
+    strlcpy(slot.last_stall_stack, stack, sizeof(slot.last_stall_stack));
+    pthread_mutex_unlock(&g_loop_lock);
+}
+
+static void *watchdog_thread(void * /* arg */) {
+    setpriority(PRIO_PROCESS, gettid(), WATCHDOG_NICE);
+
+    const int wakeup_id = fw_wakeup_register("loop_watchdog");
+    int64_t next = monotonic_ns();
+    while (!g_watchdog_stop.load(std::memory_order_acquire)) {
+        next += (int64_t) g_tick_ms.load(std::memory_order_relaxed) * 1000000LL;
+        struct timespec deadline;
+        deadline.tv_sec = next / 1000000000LL;
+        deadline.tv_nsec = next % 1000000000LL;
+        int ret;
+        do {
+            const int64_t begin = fw_wakeup_begin(wakeup_id);
+            ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+            fw_wakeup_end(wakeup_id, ret == 0 ? FW_WAKEUP_TIMEOUT
+                                   : ret == EINTR ? FW_WAKEUP_INTERRUPTED : FW_WAKEUP_ERROR, begin);
+        } while (ret == EINTR);
+        if (g_watchdog_stop.load(std::memory_order_acquire)) break;
+
+        // 计划唤醒时间与实际唤醒时间的偏差
+        const int64_t now = monotonic_ns();
+        const int64_t drift = now - next;
+        g_ticks.fetch_add(1, std::memory_order_relaxed);
+        g_drift_hist[hist_bucket(drift)].fetch_add(1, std::memory_order_relaxed);
+        update_max(&g_max_drift_ns, drift);
+        // 落后超过一个间隔时不补齐错过的检查
+        if (drift > (int64_t) g_tick_ms.load(std::memory_order_relaxed) * 1000000LL) {
+            next = now;
+        }
+
+        for (int i = 0; i < FW_LOOP_MAX; i++) {
+            check_loop(i, now);
+        }
+    }
+    return nullptr;
+}
+
+extern "C" bool fw_loop_watchdog_start(int tick_ms) {
+    pthread_once(&g_init_once, init_once);
+    g_tick_ms.store(tick_ms > 0 ? tick_ms : FW_LOOP_DEFAULT_TICK_MS, std::memory_order_relaxed);
+
+    pthread_mutex_lock(&g_watchdog_lock);
+    if (g_watchdog_running) {
+        pthread_mutex_unlock(&g_watchdog_lock);
+        return true;
+    }
+    g_watchdog_stop.store(false, std::memory_order_release);
+    int ret = fw_thread_create(&g_watchdog_thread, "fw_loop_wd", "loop_watchdog",
+                               FW_THREAD_STACK_MEDIUM, false, watchdog_thread, nullptr);
+    g_watchdog_running = ret == 0;
+    pthread_mutex_unlock(&g_watchdog_lock);
+    if (ret != 0) return false;
+    LOGI("循环看门狗已启动，间隔 %d ms", g_tick_ms.load());
+    return true;
+}
+
+extern "C" void fw_loop_watchdog_stop() {
+    pthread_mutex_lock(&g_watchdog_lock);
+    if (!g_watchdog_running) {
+        pthread_mutex_unlock(&g_watchdog_lock);
+        return;
+    }
+    g_watchdog_stop.store(true, std::memory_order_release);
+    // 看门狗最多再睡一个间隔
+    pthread_join(g_watchdog_thread, nullptr);
+    g_watchdog_running = false;
+    pthread_mutex_unlock(&g_watchdog_lock);
+}
+
+// ==================== 输出 ====================
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...)
+        __attribute__((format(printf, 4, 5)));
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...) {
+    if (*used >= size) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + *used, size - *used, format, args);
+    va_end(args);
+    if (n > 0) *used += ((size_t) n < size - *used) ? (size_t) n : size - *used - 1;
+}
+
+static void append_hist(char *buffer, size_t size, size_t *used,
+                        const std::atomic<uint32_t> *hist) {
+    append(buffer, size, used, " hist=");
+    for (int b = 0; b < FW_LOOP_HIST_BUCKETS; b++) {
+        append(buffer, size, used, b == 0 ? "%u" : ",%u", hist[b].load(std::memory_order_relaxed));
+    }
+    append(buffer, size, used, "\n");
+}
+
+extern "C" size_t fw_loop_dump(char *buffer, size_t size) {
+    if (buffer == nullptr || size == 0) return 0;
+    buffer[0] = '\0';
+    size_t used = 0;
+
+    pthread_mutex_lock(&g_loop_lock);
+    for (const LoopSlot &slot : g_loops) {
+        if (!slot.used.load(std::memory_order_acquire)) continue;
+        append(buffer, size, &used, "%s tid=%d iterations=%llu stalls=%u max=%lldms",
+               slot.name, slot.tid,
+               (unsigned long long) slot.iterations.load(std::memory_order_relaxed),
+               slot.stalls.load(std::memory_order_relaxed),
+               (long long) (slot.max_ns.load(std::memory_order_relaxed) / 1000000));
+        append_hist(buffer, size, &used, slot.hist);
+        if (slot.last_stall_stack[0] != '\0') {
+            append(buffer, size, &used, "  stall %lldms: %s\n", (long long) slot.last_stall_ms,
+                   slot.last_stall_stack);
+        }
+    }
+    pthread_mutex_unlock(&g_loop_lock);
+
+    append(buffer, size, &used, "watchdog ticks=%llu max_drift=%lldms",
+           (unsigned long long) g_ticks.load(std::memory_order_relaxed),
+           (long long) (g_max_drift_ns.load(std::memory_order_relaxed) / 1000000));
+    append_hist(buffer, size, &used, g_drift_hist);
+    return used;
+}
@@ -0,0 +1,94 @@
+/**
+ * ============================================================================
+ * fw_loop_monitor.h - Native 循环卡顿监控
+ * ============================================================================
+ *
+ * 功能简介：
+ *   Socket 服务循环、守护进程主循环、Binder 等待回复等 Native 循环可能卡在
+ *   慢系统调用或阻塞的回调上，此前没有任何记录。
+ *
+ *   - 循环在每次迭代的工作部分前后调用 fw_loop_begin / fw_loop_end：
+ *     记录迭代次数（心跳计数）、耗时直方图和最大耗时
+ *   - 低优先级看门狗线程按固定间隔醒来：
+ *     - 记录自身 计划唤醒时间 与 实际唤醒时间 的偏差直方图（反映调度延迟）
+ *     - 某个循环的当前迭代超过卡顿阈值时，向该线程发送信号采集一次调用栈
+ *       （fw_profiler_capture_thread，首次卡顿时按需加载 libfw_profiler.so），
+ *       输出警告日志并保留最近一次卡顿的调用栈
+ *
+ *   直方图按 2 的幂分桶（毫秒）：桶 0 为 <1ms，桶 i 为 [2^(i-1), 2^i) ms，
+ *   最后一个桶包含更大的值。
+ *
+ * fork：
+ *   子进程中登记的循环全部清除，看门狗需要在子进程中重新启动。
+ *
+ * 加载方式：
+ *   代码位于按需加载的 libfw_diag.so（见 fw_diag.h）。模块加载前 fw_loop_register
+ *   返回 -1、其余函数为空操作；模块加载前登记的循环不会被监控。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_LOOP_MONITOR_H
+#define FW_LOOP_MONITOR_H
+
+#include <stddef.h>
+
+#include "fw_module.h"
+
+#define FW_LOOP_MAX                 16
+#define FW_LOOP_NAME_LEN            24
+#define FW_LOOP_HIST_BUCKETS        14
+#define FW_LOOP_DEFAULT_TICK_MS     100
+
+extern "C" {
+
+/**
+ * 登记循环（由循环所在线程调用）
+ *
+ * @param stall_threshold_ms 单次迭代超过该时间视为卡顿
+ * @return 循环 ID，登记表已满返回 -1（此时 begin / end 为空操作）
+ */
+FW_MODULE_API int fw_loop_register(const char *name, int stall_threshold_ms);
+
+/**
+ * 注销循环
+ */
+FW_MODULE_API void fw_loop_unregister(int id);
+
+/**
+ * 迭代开始：心跳计数加 1，记录开始时间
+ */
+FW_MODULE_API void fw_loop_begin(int id);
+
+/**
+ * 迭代结束：记录耗时（未在迭代中时为空操作）
+ */
+FW_MODULE_API void fw_loop_end(int id);
+
+/**
+ * 启动看门狗线程，重复调用只更新间隔
+ *
+ * @param tick_ms 检查间隔，<= 0 使用 FW_LOOP_DEFAULT_TICK_MS
+ */
+FW_MODULE_API bool fw_loop_watchdog_start(int tick_ms);
+
+/**
+ * 停止看门狗线程
+ */
+FW_MODULE_API void fw_loop_watchdog_stop();
+
+/**
+ * 输出统计：每个循环一行
+ * `name tid=<tid> iterations=<n> stalls=<n> max=<ms>ms hist=<b0>,<b1>,...`，
+ * 有卡顿时下一行为 `  stall <ms>ms: <调用栈>`，末行为看门狗唤醒偏差
+ * `watchdog ticks=<n> max_drift=<ms>ms hist=...`
+ *
+ * @return 写入的字节数（不含 NUL）
+ */
+FW_MODULE_API size_t fw_loop_dump(char *buffer, size_t size);
+
+}
+
+#endif // FW_LOOP_MONITOR_H
@@ -0,0 +1,177 @@
+/**
+ * ============================================================================
+ * fw_looper.cpp - Native 事件循环实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   epoll + eventfd 唤醒。注册表按 fd 保存回调，分发时在锁外调用回调；
+ *   每次注册分配新的序号，回调返回 0 时只注销同一次注册，
+ *   不会误删回调执行期间重新注册的同一个 fd。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_looper.h"
+
+#include <atomic>
+#include <errno.h>
+#include <mutex>
+#include <unistd.h>
+#include <unordered_map>
+#include <sys/eventfd.h>
+#include <android/log.h>
+#include "fw_tokenlog.h"
+#include "fw_wakeup.h"
+
+#define LOG_TAG "FwLooper"
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+struct LooperRequest {
+    fw_looper_callback callback;
+    void *data;
+    uint64_t seq;
+};
+
+struct fw_looper {
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::mutex lock;
+    std::unordered_map<int, LooperRequest> requests;
+    uint64_t next_seq = 1;
+    std::atomic<bool> quit{false};
+};
+
+extern "C" fw_looper *fw_looper_create() {
+    fw_looper *looper = new fw_looper;
+    looper->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    looper->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (looper->epoll_fd < 0 || looper->wake_fd < 0) {
+        LOGE("创建事件循环失败: errno=%d", errno);
+        fw_looper_destroy(looper);
+        return nullptr;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = looper->wake_fd;
+    if (epoll_ctl(looper->epoll_fd, EPOLL_CTL_ADD, looper->wake_fd, &ev) != 0) {
+        LOGE("注册唤醒 fd 失败: errno=%d", errno);
+        fw_looper_destroy(looper);
+        return nullptr;
+    }
+    return looper;
+}
+
+extern "C" void fw_looper_destroy(fw_looper *looper) {
+    if (looper == nullptr) return;
+    if (looper->epoll_fd >= 0) close(looper->epoll_fd);
+    if (looper->wake_fd >= 0) close(looper->wake_fd);
+    delete looper;
+}
+
+extern "C" int fw_looper_add_fd(fw_looper *looper, int fd, uint32_t events,
+                                fw_looper_callback callback, void *data) {
+    if (looper == nullptr || fd < 0 || callback == nullptr) return -EINVAL;
+
+    std::lock_guard<std::mutex> guard(looper->lock);
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    const bool exists = looper->requests.count(fd) != 0;
+    if (epoll_ctl(looper->epoll_fd, exists ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev) != 0) {
+        return -errno;
+    }
+    looper->requests[fd] = LooperRequest{callback, data, looper->next_seq++};
+    return 0;
+}
+
+/**
+ * 注销 fd，seq 非 0 时只注销对应的那一次注册
+ */
+static int remove_fd_locked(fw_looper *looper, int fd, uint64_t seq) {
+    auto it = looper->requests.find(fd);
+    if (it == looper->requests.end()) return -ENOENT;
+    if (seq != 0 && it->second.seq != seq) return 0;
+    looper->requests.erase(it);
+    // fd 可能已被调用方关闭，此时内核已自动从 epoll 中移除
+    if (epoll_ctl(looper->epoll_fd, EPOLL_CTL_DEL, fd, nullptr) != 0 && errno != EBADF &&
+        errno != ENOENT) {
+        LOGW("从 epoll 注销 fd=%d 失败: errno=%d", fd, errno);
+    }
+    return 0;
+}
+
+extern "C" int fw_looper_remove_fd(fw_looper *looper, int fd) {
+    if (looper == nullptr) return -EINVAL;
+    std::lock_guard<std::mutex> guard(looper->lock);
+    return remove_fd_locked(looper, fd, 0);
+}
+
+extern "C" int fw_looper_poll_once(fw_looper *looper, int timeout_ms) {
+    if (looper == nullptr) return -EINVAL;
+
+    static const int wakeup_id = fw_wakeup_register("looper");
+    struct epoll_event events[FW_LOOPER_MAX_EVENTS];
+    int count = fw_wakeup_epoll_wait(wakeup_id, looper->epoll_fd, events, FW_LOOPER_MAX_EVENTS,
+                                     timeout_ms);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -errno;
+    }
+
+    int dispatched = 0;
+    for (int i = 0; i < count; i++) {
+        const int fd = events[i].data.fd;
+        if (fd == looper->wake_fd) {
+            uint64_t value;
+            while (read(looper->wake_fd, &value, sizeof(value)) > 0) {
+            }
+            continue;
+        }
+
+        LooperRequest request;
+        {
+            std::lock_guard<std::mutex> guard(looper->lock);
+            auto it = looper->requests.find(fd);
+            // 同一批事件中前面的回调可能已经注销了该 fd
+            if (it == looper->requests.end()) continue;
+            request = it->second;
+        }
+
+        dispatched++;
+        if (request.callback(fd, events[i].events, request.data) == 0) {
+            std::lock_guard<std::mutex> guard(looper->lock);
+            remove_fd_locked(looper, fd, request.seq);
+        }
+    }
+    return dispatched;
+}
+
+extern "C" void fw_looper_wake(fw_looper *looper) {
+    if (looper == nullptr) return;
+    const uint64_t value = 1;
+    ssize_t n;
+    do {
+        n = write(looper->wake_fd, &value, sizeof(value));
+    } while (n < 0 && errno == EINTR);
+}
+
+extern "C" void fw_looper_run(fw_looper *looper) {
+    if (looper == nullptr) return;
+    while (!looper->quit.load(std::memory_order_acquire)) {
+        int result = fw_looper_poll_once(looper, -1);
+        if (result < 0) {
+            LOGE("事件循环异常退出: %d", result);
+            break;
+        }
+    }
+    looper->quit.store(false, std::memory_order_release);
+}
+
+extern "C" void fw_looper_quit(fw_looper *looper) {
+    if (looper == nullptr) return;
+    looper->quit.store(true, std::memory_order_release);
+    fw_looper_wake(looper);
+}
@@ -0,0 +1,101 @@
+/**
+ * ============================================================================
+ * fw_looper.h - Native 事件循环
+ * ============================================================================
+ *
+ * 功能简介：
+ *   基于 epoll 的最小事件循环（Reactor），Native 组件把需要等待的 fd
+ *   （inotify、socket、eventfd 等）注册到同一个循环上，空闲时线程阻塞在
+ *   epoll_wait 中，不产生任何唤醒。
+ *
+ * 使用方式：
+ *   - fw_looper_add_fd 注册 fd 与回调，回调返回 0 时自动注销
+ *   - 在任意线程上循环调用 fw_looper_poll_once，或调用 fw_looper_run 直到 fw_looper_quit
+ *   - 注册 / 注销 / 唤醒可在任意线程调用；回调在调用 poll 的线程上执行，
+ *     执行期间不持有内部锁，回调中可以再注册或注销 fd
+ *
+ * 编译位置：
+ *   目前只有无法强制停止策略使用，与 fw_file_watcher 一起编译进按需加载的
+ *   libfw_binder.so，不从任何库导出。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_LOOPER_H
+#define FW_LOOPER_H
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+
+// 单次 epoll_wait 最多取出的事件数
+#define FW_LOOPER_MAX_EVENTS 16
+
+struct fw_looper;
+
+/**
+ * fd 就绪回调
+ *
+ * @param events epoll 事件位（EPOLLIN / EPOLLOUT / EPOLLERR / EPOLLHUP ...）
+ * @return 1 继续监听，0 注销该 fd（fd 本身由调用方关闭）
+ */
+typedef int (*fw_looper_callback)(int fd, uint32_t events, void *data);
+
+extern "C" {
+
+/**
+ * 创建事件循环
+ *
+ * @return 失败返回 nullptr
+ */
+fw_looper *fw_looper_create();
+
+/**
+ * 销毁事件循环（不关闭已注册的 fd），不能与 poll 并发调用
+ */
+void fw_looper_destroy(fw_looper *looper);
+
+/**
+ * 注册或更新 fd
+ *
+ * @param events 需要监听的 epoll 事件位
+ * @return 0 成功，失败返回 -errno
+ */
+int fw_looper_add_fd(fw_looper *looper, int fd, uint32_t events,
+                     fw_looper_callback callback, void *data);
+
+/**
+ * 注销 fd
+ *
+ * @return 0 成功，未注册返回 -ENOENT
+ */
+int fw_looper_remove_fd(fw_looper *looper, int fd);
+
+/**
+ * 等待并分发一次事件
+ *
+ * @param timeout_ms 等待超时，< 0 表示一直等待
+ * @return 执行的回调数（超时或被唤醒时为 0），失败返回 -errno
+ */
+int fw_looper_poll_once(fw_looper *looper, int timeout_ms);
+
+/**
+ * 唤醒阻塞在 fw_looper_poll_once 中的线程
+ */
+void fw_looper_wake(fw_looper *looper);
+
+/**
+ * 在当前线程运行事件循环，直到 fw_looper_quit
+ */
+void fw_looper_run(fw_looper *looper);
+
+/**
+ * 让 fw_looper_run 返回（可在任意线程调用）
+ */
+void fw_looper_quit(fw_looper *looper);
+
+}
+
+#endif // FW_LOOPER_H
@@ -0,0 +1,184 @@
+/**
+ * ============================================================================
+ * fw_module.cpp - Native 功能模块按需加载实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   通过 dlopen 按需加载功能模块，使用 pthread_once 保证只加载一次。
+ *   模块以 RTLD_LOCAL 加载，符号不会污染全局命名空间，
+ *   核心库只通过模块导出的函数表访问模块功能。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_module.h"
+
+#include <atomic>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <time.h>
+#include <android/log.h>
+#include "fw_diag.h"
+#include "fw_event_bus.h"
+#include "fw_proc_cache.h"
+#include "fw_profiler.h"
+#include "fw_tokenlog.h"
+
+#define LOG_TAG "FwNative"
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+static pthread_once_t g_binder_module_once = PTHREAD_ONCE_INIT;
+static std::atomic<const FwBinderModule *> g_binder_module{nullptr};
+static pthread_once_t g_profiler_module_once = PTHREAD_ONCE_INIT;
+static std::atomic<const FwProfilerModule *> g_profiler_module{nullptr};
+static pthread_once_t g_diag_module_once = PTHREAD_ONCE_INIT;
+static std::atomic<const FwDiagModule *> g_diag_module{nullptr};
+static pthread_once_t g_event_bus_module_once = PTHREAD_ONCE_INIT;
+static std::atomic<const FwEventBusModule *> g_event_bus_module{nullptr};
+static pthread_once_t g_proc_cache_module_once = PTHREAD_ONCE_INIT;
+static std::atomic<const FwProcCacheModule *> g_proc_cache_module{nullptr};
+
+static long elapsed_us(const struct timespec &start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1000000L + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+/**
+ * 加载功能模块并取得函数表
+ *
+ * 应用的 native 库目录在 classloader 命名空间的搜索路径中，
+ * 直接使用库文件名即可找到与 libfw_native.so 一起打包的模块。
+ * 各模块函数表的第一个字段都是版本号。
+ *
+ * @return 函数表，加载失败或版本不一致返回 nullptr
+ */
+static const void *open_module(const char *lib, const char *entry, uint32_t version) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    void *handle = dlopen(lib, RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        LOGE("加载 %s 失败: %s", lib, dlerror());
+        return nullptr;
+    }
+
+    typedef const void *(*module_get_fn)();
+    module_get_fn get_module = reinterpret_cast<module_get_fn>(dlsym(handle, entry));
+    if (get_module == nullptr) {
+        LOGE("%s 缺少入口 %s: %s", lib, entry, dlerror());
+        dlclose(handle);
+        return nullptr;
+    }
+
+    const void *module = get_module();
+    const uint32_t actual = module != nullptr ? *static_cast<const uint32_t *>(module) : 0;
+    if (actual != version) {
+        LOGE("%s 版本不匹配: 期望 %u, 实际 %u", lib, version, actual);
+        dlclose(handle);
+        return nullptr;
+    }
+
+    // 模块加载后常驻，不再 dlclose
+    LOGI("%s 已加载, 耗时 %ld us", lib, elapsed_us(start));
+    return module;
+}
+
+/**
+ * 加载 Binder 功能模块
+ */
+static void load_binder_module() {
+    g_binder_module.store(static_cast<const FwBinderModule *>(
+                                  open_module(FW_BINDER_MODULE_LIB, FW_BINDER_MODULE_ENTRY,
+                                              FW_BINDER_MODULE_VERSION)),
+                          std::memory_order_release);
+}
+
+/**
+ * 加载 CPU 采样模块
+ */
+static void load_profiler_module() {
+    g_profiler_module.store(static_cast<const FwProfilerModule *>(
+                                    open_module(FW_PROFILER_MODULE_LIB, FW_PROFILER_MODULE_ENTRY,
+                                                FW_PROFILER_MODULE_VERSION)),
+                            std::memory_order_release);
+}
+
+/**
+ * 加载诊断模块
+ */
+static void load_diag_module() {
+    g_diag_module.store(static_cast<const FwDiagModule *>(
+                                open_module(FW_DIAG_MODULE_LIB, FW_DIAG_MODULE_ENTRY,
+                                            FW_DIAG_MODULE_VERSION)),
+                        std::memory_order_release);
+}
+
+/**
+ * 加载事件总线模块
+ */
+static void load_event_bus_module() {
+    g_event_bus_module.store(static_cast<const FwEventBusModule *>(
+                                     open_module(FW_EVENT_BUS_MODULE_LIB, FW_EVENT_BUS_MODULE_ENTRY,
+                                                 FW_EVENT_BUS_MODULE_VERSION)),
+                             std::memory_order_release);
+}
+
+/**
+ * 加载 /proc 采样缓存模块
+ */
+static void load_proc_cache_module() {
+    g_proc_cache_module.store(static_cast<const FwProcCacheModule *>(
+                                      open_module(FW_PROC_CACHE_MODULE_LIB,
+                                                  FW_PROC_CACHE_MODULE_ENTRY,
+                                                  FW_PROC_CACHE_MODULE_VERSION)),
+                              std::memory_order_release);
+}
+
+extern "C" const FwBinderModule *fw_binder_module() {
+    pthread_once(&g_binder_module_once, load_binder_module);
+    return g_binder_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwBinderModule *fw_binder_module_if_loaded() {
+    return g_binder_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwProfilerModule *fw_profiler_module() {
+    pthread_once(&g_profiler_module_once, load_profiler_module);
+    return g_profiler_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwProfilerModule *fw_profiler_module_if_loaded() {
+    return g_profiler_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwDiagModule *fw_diag_module() {
+    pthread_once(&g_diag_module_once, load_diag_module);
+    return g_diag_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwDiagModule *fw_diag_module_if_loaded() {
+    return g_diag_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwEventBusModule *fw_event_bus_module() {
+    pthread_once(&g_event_bus_module_once, load_event_bus_module);
+    return g_event_bus_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwEventBusModule *fw_event_bus_module_if_loaded() {
+    return g_event_bus_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwProcCacheModule *fw_proc_cache_module() {
+    pthread_once(&g_proc_cache_module_once, load_proc_cache_module);
+    return g_proc_cache_module.load(std::memory_order_acquire);
+}
+
+extern "C" const FwProcCacheModule *fw_proc_cache_module_if_loaded() {
+    return g_proc_cache_module.load(std::memory_order_acquire);
+}
@@ -0,0 +1,104 @@
+/**
+ * ============================================================================
+ * fw_module.h - Native 功能模块按需加载接口
+ * ============================================================================
+ *
+ * 功能简介：
+ *   fw_native 只包含常驻的核心功能（守护进程、进程管理、Socket 通信），
+ *   Binder 直接调用 / Parcel / Unicode 等较重的代码拆分到独立的
+ *   libfw_binder.so 中，首次调用相关 JNI 方法时才 dlopen 加载。
+ *   只调用 getOomAdj 之类核心方法的进程不再承担这部分加载和重定位开销。
+ *   默认关闭的 CPU 采样同样拆分为 libfw_profiler.so（函数表见 fw_profiler.h），
+ *   其它默认关闭的诊断 / 可选功能也各自拆分：
+ *   - libfw_diag.so：循环卡顿监控、唤醒归因、跨进程状态板（fw_diag.h）
+ *   - libfw_event_bus.so：进程内事件总线（fw_event_bus.h）
+ *   - libfw_proc_cache.so：/proc 采样缓存（fw_proc_cache.h）
+ *
+ * 模块约定：
+ *   - 模块只导出一个符号 FW_BINDER_MODULE_ENTRY，返回函数表
+ *   - 函数表带版本号，核心库与模块版本不一致时拒绝使用
+ *   - 函数表中的函数签名与对应的 JNI 方法一致，核心库直接转发
+ *   - 可选功能模块的 C 接口保持原名：fw_native 中的同名函数（fw_module_forward.cpp）
+ *     在模块已加载时转发到函数表，未加载时退化为空操作或不带统计的系统调用，
+ *     调用方无需关心模块是否已加载
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_MODULE_H
+#define FW_MODULE_H
+
+#include <jni.h>
+#include <stdint.h>
+
+// 导出符号（全局使用 -fvisibility=hidden）
+#define FW_EXPORT __attribute__((visibility("default")))
+
+// 可选功能模块的 C 接口：在 fw_native 中是导出的转发函数，
+// 在模块内部（以 FW_MODULE_IMPL 编译）是只能通过函数表访问的实现
+#ifdef FW_MODULE_IMPL
+#define FW_MODULE_API
+#else
+#define FW_MODULE_API FW_EXPORT
+#endif
+
+// ==================== Binder 功能模块 ====================
+
+#define FW_BINDER_MODULE_LIB     "libfw_binder.so"
+#define FW_BINDER_MODULE_ENTRY   "fw_binder_module_get"
+#define FW_BINDER_MODULE_VERSION 4
+
+/**
+ * Binder 功能模块函数表（libfw_binder.so 提供）
+ */
+struct FwBinderModule {
+    uint32_t version;   // FW_BINDER_MODULE_VERSION
+
+    void (*lockFile)(JNIEnv *env, jobject thiz, jstring lockFilePath);
+
+    void (*waitFileLock)(JNIEnv *env, jobject thiz, jstring lockFilePath);
+
+    void (*startForceStopDaemon)(JNIEnv *env, jobject thiz,
+                                 jstring indicatorSelfPath, jstring indicatorDaemonPath,
+                                 jstring observerSelfPath, jstring observerDaemonPath,
+                                 jstring packageName, jstring serviceName, jint sdkVersion);
+
+    void (*testBinderCall)(JNIEnv *env, jobject thiz,
+                           jstring packageName, jstring serviceName, jint sdkVersion);
+
+    // 版本 2
+    jstring (*getAllocTagStats)(JNIEnv *env, jobject thiz);
+
+    // 版本 3
+    jlong (*getBinderTimeoutCount)(JNIEnv *env, jobject thiz);
+
+    // 版本 4
+    jobject (*buildStartServiceParcel)(JNIEnv *env, jobject thiz,
+                                       jstring packageName, jstring serviceName, jint sdkVersion);
+
+    void (*releaseParcelBuffer)(JNIEnv *env, jobject thiz, jlong handle);
+};
+
+typedef const FwBinderModule *(*fw_binder_module_get_fn)();
+
+extern "C" {
+
+/**
+ * 获取 Binder 功能模块（首次调用时 dlopen，线程安全）
+ *
+ * @return 函数表，加载失败返回 nullptr（失败结果会被缓存，不会重复尝试）
+ */
+const FwBinderModule *fw_binder_module();
+
+/**
+ * 获取已加载的 Binder 功能模块（不触发加载）
+ *
+ * 用于只读查询：模块未加载说明相关功能从未使用过
+ */
+const FwBinderModule *fw_binder_module_if_loaded();
+
+}
+
+#endif // FW_MODULE_H
@@ -0,0 +1,299 @@
+/**
+ * ============================================================================
+ * fw_module_forward.cpp - 可选功能模块的转发接口
+ * ============================================================================
+ *
+ * 功能简介：
+ *   fw_loop_* / fw_wakeup_* / fw_status_board_* / fw_event_* / fw_proc_cache_*
+ *   的实现位于按需加载的模块中（见 fw_module.h）。这里提供同名的导出函数，
+ *   Socket 服务、守护进程、Binder 模块等调用方不需要关心模块是否已加载：
+ *   - 模块已加载：经函数表转发（每次调用一次原子读取）
+ *   - 模块未加载：退化为空操作、返回失败，或直接执行不带统计的系统调用
+ *
+ *   除 fw_event_subscribe（第一个订阅者）外，这里的函数都不会触发加载，
+ *   由 JNI 入口（enableNativeDiagnostics / startNativeLoopWatchdog / setProcCacheTtl）
+ *   显式加载。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_diag.h"
+#include "fw_event_bus.h"
+#include "fw_proc_cache.h"
+
+#include <errno.h>
+#include <time.h>
+
+/**
+ * 模块未加载时 dump 接口输出空字符串
+ */
+static size_t dump_empty(char *buffer, size_t size) {
+    if (buffer != nullptr && size > 0) buffer[0] = '\0';
+    return 0;
+}
+
+// ==================== 循环卡顿监控（libfw_diag.so） ====================
+
+extern "C" int fw_loop_register(const char *name, int stall_threshold_ms) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->loopRegister(name, stall_threshold_ms) : -1;
+}
+
+extern "C" void fw_loop_unregister(int id) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->loopUnregister(id);
+}
+
+extern "C" void fw_loop_begin(int id) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->loopBegin(id);
+}
+
+extern "C" void fw_loop_end(int id) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->loopEnd(id);
+}
+
+extern "C" bool fw_loop_watchdog_start(int tick_ms) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->loopWatchdogStart(tick_ms);
+}
+
+extern "C" void fw_loop_watchdog_stop() {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->loopWatchdogStop();
+}
+
+extern "C" size_t fw_loop_dump(char *buffer, size_t size) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->loopDump(buffer, size) : dump_empty(buffer, size);
+}
+
+// ==================== 唤醒归因（libfw_diag.so） ====================
+
+extern "C" int fw_wakeup_register(const char *component) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->wakeupRegister(component) : -1;
+}
+
+extern "C" int64_t fw_wakeup_begin(int id) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->wakeupBegin(id) : 0;
+}
+
+extern "C" void fw_wakeup_end(int id, int reason, int64_t begin_ns) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->wakeupEnd(id, reason, begin_ns);
+}
+
+extern "C" int fw_wakeup_select(int id, int nfds, fd_set *readfds, fd_set *writefds,
+                                fd_set *exceptfds, struct timeval *timeout) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) return diag->wakeupSelect(id, nfds, readfds, writefds, exceptfds, timeout);
+    return select(nfds, readfds, writefds, exceptfds, timeout);
+}
+
+extern "C" int fw_wakeup_poll(int id, struct pollfd *fds, nfds_t nfds, int timeout_ms) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) return diag->wakeupPoll(id, fds, nfds, timeout_ms);
+    return poll(fds, nfds, timeout_ms);
+}
+
+extern "C" int fw_wakeup_epoll_wait(int id, int epfd, struct epoll_event *events,
+                                    int max_events, int timeout_ms) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) return diag->wakeupEpollWait(id, epfd, events, max_events, timeout_ms);
+    return epoll_wait(epfd, events, max_events, timeout_ms);
+}
+
+extern "C" void fw_wakeup_sleep_ms(int id, int64_t ms) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) {
+        diag->wakeupSleepMs(id, ms);
+        return;
+    }
+    if (ms <= 0) return;
+    // 与模块实现相同：被信号中断时睡完剩余时间
+    struct timespec request;
+    request.tv_sec = ms / 1000;
+    request.tv_nsec = (ms % 1000) * 1000000L;
+    struct timespec remaining;
+    while (nanosleep(&request, &remaining) != 0 && errno == EINTR) {
+        request = remaining;
+    }
+}
+
+extern "C" bool fw_wakeup_get_stats(int id, fw_wakeup_stats *stats) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->wakeupGetStats(id, stats);
+}
+
+extern "C" size_t fw_wakeup_dump(char *buffer, size_t size) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->wakeupDump(buffer, size) : dump_empty(buffer, size);
+}
+
+// ==================== 跨进程状态板（libfw_diag.so） ====================
+
+extern "C" bool fw_status_board_create() {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->boardCreate();
+}
+
+extern "C" bool fw_status_board_attach(int fd) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->boardAttach(fd);
+}
+
+extern "C" int fw_status_board_fd() {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->boardFd() : -1;
+}
+
+extern "C" bool fw_status_board_send_fd(int socket_fd) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->boardSendFd(socket_fd);
+}
+
+extern "C" bool fw_status_board_recv_fd(int socket_fd, int timeout_ms) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->boardRecvFd(socket_fd, timeout_ms);
+}
+
+extern "C" int fw_status_board_claim(const char *name) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->boardClaim(name) : -1;
+}
+
+extern "C" void fw_status_board_release() {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->boardRelease();
+}
+
+extern "C" void fw_status_board_beat() {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->boardBeat();
+}
+
+extern "C" void fw_status_board_set_status(int status) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->boardSetStatus(status);
+}
+
+extern "C" void fw_status_board_set_gauge(int index, int64_t value) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    if (diag != nullptr) diag->boardSetGauge(index, value);
+}
+
+extern "C" bool fw_status_board_read(int slot, fw_status_snapshot *snapshot) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->boardRead(slot, snapshot);
+}
+
+extern "C" bool fw_status_board_find(pid_t pid, fw_status_snapshot *snapshot) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr && diag->boardFind(pid, snapshot);
+}
+
+extern "C" size_t fw_status_board_dump(char *buffer, size_t size) {
+    const FwDiagModule *diag = fw_diag_module_if_loaded();
+    return diag != nullptr ? diag->boardDump(buffer, size) : dump_empty(buffer, size);
+}
+
+// ==================== 事件总线（libfw_event_bus.so） ====================
+
+extern "C" bool fw_event_publish_raw(uint16_t type, const void *payload, size_t size) {
+    // 没有订阅者时模块不会加载，事件直接丢弃
+    const FwEventBusModule *bus = fw_event_bus_module_if_loaded();
+    return bus != nullptr && bus->publishRaw(type, payload, size);
+}
+
+extern "C" fw_event_subscriber *fw_event_subscribe(uint32_t type_mask, const char *name) {
+    const FwEventBusModule *bus = fw_event_bus_module();
+    return bus != nullptr ? bus->subscribe(type_mask, name) : nullptr;
+}
+
+// 以下函数的订阅者只能来自已加载的模块
+
+extern "C" void fw_event_unsubscribe(fw_event_subscriber *subscriber) {
+    const FwEventBusModule *bus = fw_event_bus_module_if_loaded();
+    if (bus != nullptr) bus->unsubscribe(subscriber);
+}
+
+extern "C" int fw_event_poll(fw_event_subscriber *subscriber, fw_event *events, int max_events) {
+    const FwEventBusModule *bus = fw_event_bus_module_if_loaded();
+    return bus != nullptr ? bus->poll(subscriber, events, max_events) : 0;
+}
+
+extern "C" int fw_event_wait(fw_event_subscriber *subscriber, int timeout_ms) {
+    const FwEventBusModule *bus = fw_event_bus_module_if_loaded();
+    return bus != nullptr ? bus->wait(subscriber, timeout_ms) : -EINVAL;
+}
+
+extern "C" int fw_event_subscriber_fd(fw_event_subscriber *subscriber) {
+    const FwEventBusModule *bus = fw_event_bus_module_if_loaded();
+    return bus != nullptr ? bus->subscriberFd(subscriber) : -1;
+}
+
+extern "C" uint64_t fw_event_dropped_count(fw_event_subscriber *subscriber) {
+    const FwEventBusModule *bus = fw_event_bus_module_if_loaded();
+    return bus != nullptr ? bus->droppedCount(subscriber) : 0;
+}
+
+extern "C" size_t fw_event_bus_dump(char *buffer, size_t size) {
+    const FwEventBusModule *bus = fw_event_bus_module_if_loaded();
+    return bus != nullptr ? bus->dump(buffer, size) : dump_empty(buffer, size);
+}
+
+// ==================== /proc 采样缓存（libfw_proc_cache.so） ====================
+
+extern "C" bool fw_proc_cache_set_ttl(int metric, int ttl_ms) {
+    // 设置 TTL 表示调用方需要缓存，首次调用时加载模块
+    const FwProcCacheModule *cache = fw_proc_cache_module();
+    return cache != nullptr && cache->setTtl(metric, ttl_ms);
+}
+
+extern "C" void fw_proc_cache_invalidate(int metric) {
+    const FwProcCacheModule *cache = fw_proc_cache_module_if_loaded();
+    if (cache != nullptr) cache->invalidate(metric);
+}
+
+extern "C" void fw_proc_cache_memory_info(long *total_kb, long *free_kb, long *available_kb) {
+    const FwProcCacheModule *cache = fw_proc_cache_module_if_loaded();
+    if (cache != nullptr) {
+        cache->memoryInfo(total_kb, free_kb, available_kb);
+    } else if (total_kb != nullptr && free_kb != nullptr && available_kb != nullptr) {
+        get_memory_info(total_kb, free_kb, available_kb);
+    }
+}
+
+extern "C" void fw_proc_cache_process_status(char *buffer, int buffer_size) {
+    const FwProcCacheModule *cache = fw_proc_cache_module_if_loaded();
+    if (cache != nullptr) {
+        cache->processStatus(buffer, buffer_size);
+    } else if (buffer != nullptr && buffer_size > 0) {
+        get_process_status(buffer, buffer_size);
+    }
+}
+
+extern "C" int fw_proc_cache_oom_adj() {
+    const FwProcCacheModule *cache = fw_proc_cache_module_if_loaded();
+    return cache != nullptr ? cache->oomAdj() : get_oom_adj();
+}
+
+extern "C" int fw_proc_cache_process_count() {
+    const FwProcCacheModule *cache = fw_proc_cache_module_if_loaded();
+    return cache != nullptr ? cache->processCount() : get_process_count();
+}
+
+extern "C" bool fw_proc_cache_get_stats(int metric, fw_proc_cache_stats *stats) {
+    const FwProcCacheModule *cache = fw_proc_cache_module_if_loaded();
+    return cache != nullptr && cache->getStats(metric, stats);
+}
+
+extern "C" size_t fw_proc_cache_dump(char *buffer, size_t size) {
+    const FwProcCacheModule *cache = fw_proc_cache_module_if_loaded();
+    return cache != nullptr ? cache->dump(buffer, size) : dump_empty(buffer, size);
+}
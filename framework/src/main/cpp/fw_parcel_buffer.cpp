@@ -0,0 +1,64 @@
+/**
+ * ============================================================================
+ * fw_parcel_buffer.cpp - Parcel 数据区零拷贝暴露给 Kotlin 实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   NewDirectByteBuffer 直接指向 Parcel::data()，句柄为 Parcel 指针。
+ *   编译进 libfw_binder.so（依赖 Parcel）。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_parcel_buffer.h"
+
+#include "common.h"
+
+using namespace android;
+
+extern "C" jobject fw_parcel_buffer_wrap(JNIEnv *env, Parcel *parcel) {
+    if (parcel == nullptr) return nullptr;
+
+    parcel->borrowData();
+    const jlong handle = reinterpret_cast<jlong>(parcel);
+
+    // 空 Parcel 的 data() 为 NULL，NewDirectByteBuffer 要求非空地址
+    static uint8_t empty;
+    void *address = parcel->dataSize() > 0
+                    ? const_cast<uint8_t *>(parcel->data()) : &empty;
+
+    jclass clazz = nullptr;
+    jobject result = nullptr;
+    jobject buffer = env->NewDirectByteBuffer(address, (jlong) parcel->dataSize());
+    if (buffer != nullptr) {
+        clazz = env->FindClass(PARCEL_BUFFER_CLASS_PATH);
+    }
+    if (clazz != nullptr) {
+        jmethodID ctor = env->GetMethodID(clazz, "<init>", PARCEL_BUFFER_CTOR_SIGNATURE);
+        if (ctor != nullptr) {
+            result = env->NewObject(clazz, ctor, handle, buffer);
+        }
+    }
+
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+    if (clazz != nullptr) env->DeleteLocalRef(clazz);
+    if (buffer != nullptr) env->DeleteLocalRef(buffer);
+
+    if (result == nullptr) {
+        LOGE("创建 FwParcelBuffer 失败 (size=%zu)", parcel->dataSize());
+        fw_parcel_buffer_release(handle);
+    }
+    return result;
+}
+
+extern "C" void fw_parcel_buffer_release(jlong handle) {
+    Parcel *parcel = reinterpret_cast<Parcel *>(handle);
+    if (parcel == nullptr) return;
+    parcel->returnData();
+    delete parcel;
+}
@@ -0,0 +1,49 @@
+/**
+ * ============================================================================
+ * fw_parcel_buffer.h - Parcel 数据区零拷贝暴露给 Kotlin
+ * ============================================================================
+ *
+ * 功能简介：
+ *   把 Parcel 的数据区包装为 Java DirectByteBuffer（只读、小端），
+ *   返回 com.service.framework.native.FwParcelBuffer 对象，Kotlin 侧直接读取
+ *   Native 内存，不复制到 jbyteArray。
+ *
+ * 生命周期：
+ *   - 包装时 Parcel 被借出（Parcel::borrowData），借出期间不会重新分配数据区
+ *   - Parcel 的所有权转移给 FwParcelBuffer，close() 或对象被回收时归还并释放
+ *   - 适用于自行构造的 Parcel、fw_rpc 接收的 Parcel，以及 Binder 回复
+ *     （数据位于驱动 mmap 区，释放时才发送 BC_FREE_BUFFER）
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_PARCEL_BUFFER_H
+#define FW_PARCEL_BUFFER_H
+
+#include <jni.h>
+#include "cParcel.h"
+
+// Kotlin 包装类
+#define PARCEL_BUFFER_CLASS_PATH "com/service/framework/native/FwParcelBuffer"
+#define PARCEL_BUFFER_CTOR_SIGNATURE "(JLjava/nio/ByteBuffer;)V"
+
+extern "C" {
+
+/**
+ * 包装 Parcel 数据区
+ *
+ * @param parcel new 出来的 Parcel，所有权转移（失败时同样被释放）
+ * @return FwParcelBuffer 对象，失败返回 nullptr
+ */
+jobject fw_parcel_buffer_wrap(JNIEnv *env, android::Parcel *parcel);
+
+/**
+ * 归还并释放 fw_parcel_buffer_wrap 借出的 Parcel（FwParcelBuffer 的句柄）
+ */
+void fw_parcel_buffer_release(jlong handle);
+
+}
+
+#endif // FW_PARCEL_BUFFER_H
@@ -0,0 +1,223 @@
+/**
+ * ============================================================================
+ * fw_parcel_cache.cpp - 预序列化 Parcel 缓存实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   缓存文件的 mmap 读取、格式校验和原子写入。
+ *   编译进 libfw_binder.so（依赖 Parcel）。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_parcel_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "common.h"
+
+#define CACHE_ALIGN(x) (((x) + 7) & ~static_cast<size_t>(7))
+
+struct fw_parcel_cache {
+    const uint8_t *base;
+    size_t size;
+    const fw_parcel_cache_header *header;
+    const fw_parcel_cache_entry *entries;
+};
+
+/**
+ * 映射区由缓存句柄持有，Parcel 释放时不做任何事
+ */
+static void release_mapped_parcel(Parcel * /* parcel */, const uint8_t * /* data */,
+                                  size_t /* dataSize */, const binder_size_t * /* objects */,
+                                  size_t /* objectsSize */, void * /* cookie */) {
+}
+
+static bool in_bounds(size_t offset, size_t length, size_t total) {
+    return offset <= total && length <= total - offset;
+}
+
+// ==================== 读取 ====================
+
+/**
+ * 校验头部与条目表，所有偏移都必须落在文件内
+ */
+static bool validate(const uint8_t *base, size_t size) {
+    if (size < sizeof(fw_parcel_cache_header)) return false;
+    const fw_parcel_cache_header *header =
+            reinterpret_cast<const fw_parcel_cache_header *>(base);
+    if (header->magic != FW_PARCEL_CACHE_MAGIC) return false;
+    if (header->version != FW_PARCEL_CACHE_VERSION) {
+        LOGI("Parcel 缓存版本 %u 已过期（当前 %d）", header->version, FW_PARCEL_CACHE_VERSION);
+        return false;
+    }
+    if (header->file_size != size || header->entry_count > FW_PARCEL_CACHE_MAX_ENTRIES) {
+        return false;
+    }
+
+    const size_t table_size = header->entry_count * sizeof(fw_parcel_cache_entry);
+    if (!in_bounds(sizeof(*header), table_size, size)) return false;
+    const fw_parcel_cache_entry *entries =
+            reinterpret_cast<const fw_parcel_cache_entry *>(base + sizeof(*header));
+    for (uint32_t i = 0; i < header->entry_count; i++) {
+        const fw_parcel_cache_entry &entry = entries[i];
+        if (!in_bounds(entry.key_offset, entry.key_size, size) ||
+            !in_bounds(entry.data_offset, entry.data_size, size) ||
+            (entry.data_offset & 7) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+extern "C" fw_parcel_cache *fw_parcel_cache_open(const char *path) {
+    if (path == nullptr) return nullptr;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size <= FW_PARCEL_CACHE_MAX_SIZE) {
+        base = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) return nullptr;
+
+    const size_t size = (size_t) st.st_size;
+    if (!validate(static_cast<const uint8_t *>(base), size)) {
+        LOGW("Parcel 缓存无效: %s", path);
+        munmap(base, size);
+        return nullptr;
+    }
+
+    fw_parcel_cache *cache = static_cast<fw_parcel_cache *>(malloc(sizeof(fw_parcel_cache)));
+    if (cache == nullptr) {
+        munmap(base, size);
+        return nullptr;
+    }
+    cache->base = static_cast<const uint8_t *>(base);
+    cache->size = size;
+    cache->header = reinterpret_cast<const fw_parcel_cache_header *>(base);
+    cache->entries = reinterpret_cast<const fw_parcel_cache_entry *>(
+            cache->base + sizeof(fw_parcel_cache_header));
+    return cache;
+}
+
+extern "C" void fw_parcel_cache_close(fw_parcel_cache *cache) {
+    if (cache == nullptr) return;
+    munmap(const_cast<uint8_t *>(cache->base), cache->size);
+    free(cache);
+}
+
+extern "C" status_t fw_parcel_cache_get(const fw_parcel_cache *cache, const char *key, int sdk,
+                                        Parcel *out) {
+    if (cache == nullptr || key == nullptr || out == nullptr) return BAD_VALUE;
+
+    const size_t key_size = strlen(key);
+    for (uint32_t i = 0; i < cache->header->entry_count; i++) {
+        const fw_parcel_cache_entry &entry = cache->entries[i];
+        if (entry.sdk != sdk || entry.key_size != key_size ||
+            memcmp(cache->base + entry.key_offset, key, key_size) != 0) {
+            continue;
+        }
+        out->ipcSetDataReference(cache->base + entry.data_offset, entry.data_size,
+                                 nullptr, 0, release_mapped_parcel, nullptr);
+        return NO_ERROR;
+    }
+    return NAME_NOT_FOUND;
+}
+
+// ==================== 写入 ====================
+
+extern "C" status_t fw_parcel_cache_write(const char *path, const fw_parcel_cache_item *items,
+                                          size_t count) {
+    if (path == nullptr || (items == nullptr && count > 0)) return BAD_VALUE;
+    if (count > FW_PARCEL_CACHE_MAX_ENTRIES) return BAD_VALUE;
+
+    // 布局：头部、条目表、键、按 8 字节对齐的数据
+    size_t keys_size = 0;
+    size_t data_size = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (items[i].key == nullptr || items[i].parcel == nullptr) return BAD_VALUE;
+        if (items[i].parcel->ipcObjectsCount() > 0) {
+            LOGE("Parcel 缓存不支持包含对象的 Parcel: %s", items[i].key);
+            return BAD_TYPE;
+        }
+        keys_size += strlen(items[i].key);
+        data_size += CACHE_ALIGN(items[i].parcel->ipcDataSize());
+    }
+    const size_t keys_offset = sizeof(fw_parcel_cache_header) + count * sizeof(fw_parcel_cache_entry);
+    const size_t data_offset = CACHE_ALIGN(keys_offset + keys_size);
+    const size_t total = data_offset + data_size;
+    if (total > FW_PARCEL_CACHE_MAX_SIZE) return BAD_VALUE;
+
+    uint8_t *image = static_cast<uint8_t *>(calloc(1, total));
+    if (image == nullptr) return NO_MEMORY;
+
+    fw_parcel_cache_header *header = reinterpret_cast<fw_parcel_cache_header *>(image);
+    header->magic = FW_PARCEL_CACHE_MAGIC;
+    header->version = FW_PARCEL_CACHE_VERSION;
+    header->entry_count = (uint32_t) count;
+    header->file_size = (uint32_t) total;
+
+    fw_parcel_cache_entry *entries =
+            reinterpret_cast<fw_parcel_cache_entry *>(image + sizeof(fw_parcel_cache_header));
+    size_t key_pos = keys_offset;
+    size_t data_pos = data_offset;
+    for (size_t i = 0; i < count; i++) {
+        const size_t key_size = strlen(items[i].key);
+        const size_t size = items[i].parcel->ipcDataSize();
+        memcpy(image + key_pos, items[i].key, key_size);
+        memcpy(image + data_pos, reinterpret_cast<const void *>(items[i].parcel->ipcData()), size);
+        entries[i].key_offset = (uint32_t) key_pos;
+        entries[i].key_size = (uint32_t) key_size;
+        entries[i].sdk = items[i].sdk;
+        entries[i].data_offset = (uint32_t) data_pos;
+        entries[i].data_size = (uint32_t) size;
+        key_pos += key_size;
+        data_pos += CACHE_ALIGN(size);
+    }
+
+    // 临时文件名带 pid，多个进程同时写入时互不干扰，rename 保证读取方不会看到半个文件
+    char tmp_path[512];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, getpid()) >= (int) sizeof(tmp_path)) {
+        free(image);
+        return BAD_VALUE;
+    }
+
+    status_t result = NO_ERROR;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        result = -errno;
+    } else {
+        size_t written = 0;
+        while (written < total) {
+            ssize_t n = write(fd, image + written, total - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                result = -errno;
+                break;
+            }
+            written += (size_t) n;
+        }
+        if (result == NO_ERROR && fsync(fd) != 0) result = -errno;
+        close(fd);
+        if (result == NO_ERROR && rename(tmp_path, path) != 0) result = -errno;
+        if (result != NO_ERROR) unlink(tmp_path);
+    }
+    free(image);
+
+    if (result != NO_ERROR) {
+        LOGE("写入 Parcel 缓存失败: %s (%d)", path, result);
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+/**
+ * ============================================================================
+ * fw_parcel_cache.h - 预序列化 Parcel 缓存
+ * ============================================================================
+ *
+ * 功能简介：
+ *   把启动时固定不变的事务数据（接口描述符、自身组件的 Intent、ServiceManager 查询）
+ *   序列化一次写入磁盘，之后的进程启动直接 mmap 缓存文件，Parcel 通过
+ *   ipcSetDataReference 引用映射区，不做任何序列化工作。
+ *
+ * 文件格式（小端，与 Parcel 线格式一致）：
+ *   fw_parcel_cache_header | fw_parcel_cache_entry[entry_count] | 键字符串 | Parcel 数据
+ *
+ *   - 条目以（键，SDK 版本）区分，数据按 8 字节对齐
+ *   - 只缓存不含对象（Binder / fd / 外部缓冲区）的 Parcel，对象无法跨进程复用
+ *   - 写入时先写临时文件再 rename，读取方看到的始终是完整文件
+ *   - 序列化格式（如 writeIntent）变化时必须增大 FW_PARCEL_CACHE_VERSION，旧文件自动作废
+ *
+ * 生命周期：
+ *   从缓存取得的 Parcel 引用映射区，必须在 fw_parcel_cache_close 之前释放。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_PARCEL_CACHE_H
+#define FW_PARCEL_CACHE_H
+
+#include <stdint.h>
+#include "cParcel.h"
+
+#define FW_PARCEL_CACHE_MAGIC       0x43505746  // "FWPC"
+#define FW_PARCEL_CACHE_VERSION     1
+#define FW_PARCEL_CACHE_MAX_ENTRIES 64
+#define FW_PARCEL_CACHE_MAX_SIZE    (256 * 1024)
+
+using namespace android;
+
+struct fw_parcel_cache_header {
+    uint32_t magic;         // FW_PARCEL_CACHE_MAGIC
+    uint32_t version;       // FW_PARCEL_CACHE_VERSION
+    uint32_t entry_count;   // 条目数
+    uint32_t file_size;     // 文件总长度，用于发现截断
+};
+
+struct fw_parcel_cache_entry {
+    uint32_t key_offset;    // 键（不含结尾 NUL）在文件中的偏移
+    uint32_t key_size;      // 键长度
+    int32_t sdk;            // SDK 版本
+    uint32_t data_offset;   // Parcel 数据在文件中的偏移（8 字节对齐）
+    uint32_t data_size;     // Parcel 数据字节数
+};
+
+/**
+ * 写入缓存时的条目描述
+ */
+struct fw_parcel_cache_item {
+    const char *key;
+    int sdk;
+    const Parcel *parcel;
+};
+
+struct fw_parcel_cache;
+
+extern "C" {
+
+/**
+ * 映射并校验缓存文件
+ *
+ * @return 缓存句柄；文件不存在、版本不符或格式错误时返回 nullptr
+ */
+fw_parcel_cache *fw_parcel_cache_open(const char *path);
+
+/**
+ * 解除映射
+ */
+void fw_parcel_cache_close(fw_parcel_cache *cache);
+
+/**
+ * 取出缓存的 Parcel，out 以只读方式引用映射区
+ *
+ * @return NO_ERROR / NAME_NOT_FOUND
+ */
+status_t fw_parcel_cache_get(const fw_parcel_cache *cache, const char *key, int sdk,
+                             Parcel *out);
+
+/**
+ * 写入缓存文件（整体替换）
+ *
+ * @return NO_ERROR；Parcel 含对象时返回 BAD_TYPE，超出上限返回 BAD_VALUE，IO 失败返回 -errno
+ */
+status_t fw_parcel_cache_write(const char *path, const fw_parcel_cache_item *items,
+                               size_t count);
+
+}
+
+#endif // FW_PARCEL_CACHE_H
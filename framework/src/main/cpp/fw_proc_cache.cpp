@@ -0,0 +1,284 @@
+/**
+ * ============================================================================
+ * fw_proc_cache.cpp - /proc 采样缓存实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   每项指标一个缓存项（互斥锁 + 条件变量 + 结果）。读取 /proc 时不持有锁：
+ *   读取方先把缓存项标记为读取中，完成后写入结果并唤醒等待者。
+ *   等待者被唤醒后直接使用这一次的结果，不再检查 TTL；读取期间缓存被失效时
+ *   （如刚修改了 OOM adj），这次结果不进入缓存，等待者重新读取。
+ *
+ *   编译为独立的 libfw_proc_cache.so，只导出 fw_proc_cache_module_get。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_proc_cache.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define STATUS_BUFFER_SIZE 4096
+
+union ProcValue {
+    long memory[3];                     // total, free, available
+    int number;                         // OOM adj / 进程数
+    char status[STATUS_BUFFER_SIZE];
+};
+
+typedef void (*proc_loader)(ProcValue *value);
+
+struct ProcEntry {
+    const char *name;
+    proc_loader load;
+    int ttl_ms;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool loading;
+    bool valid;
+    uint64_t generation;                // 每次读取完成加 1，等待者据此判断结果已更新
+    uint64_t invalidations;             // 每次失效加 1
+    int64_t loaded_ns;
+    ProcValue value;
+    fw_proc_cache_stats stats;
+};
+
+static void load_memory(ProcValue *value) {
+    get_memory_info(&value->memory[0], &value->memory[1], &value->memory[2]);
+}
+
+static void load_status(ProcValue *value) {
+    get_process_status(value->status, sizeof(value->status));
+}
+
+static void load_oom_adj(ProcValue *value) {
+    value->number = get_oom_adj();
+}
+
+static void load_process_count(ProcValue *value) {
+    value->number = get_process_count();
+}
+
+#define PROC_ENTRY(name, loader, ttl) \
+    {name, loader, ttl, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, \
+     false, false, 0, 0, 0, {}, {}}
+
+static ProcEntry g_entries[FW_PROC_METRIC_COUNT] = {
+    PROC_ENTRY("memory", load_memory, FW_PROC_TTL_MEMORY_MS),
+    PROC_ENTRY("status", load_status, FW_PROC_TTL_STATUS_MS),
+    PROC_ENTRY("oom_adj", load_oom_adj, FW_PROC_TTL_OOM_ADJ_MS),
+    PROC_ENTRY("process_count", load_process_count, FW_PROC_TTL_PROCESS_COUNT_MS),
+};
+
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ==================== fork 处理 ====================
+
+static void atfork_prepare() {
+    for (ProcEntry &entry : g_entries) pthread_mutex_lock(&entry.lock);
+}
+
+static void atfork_parent() {
+    for (ProcEntry &entry : g_entries) pthread_mutex_unlock(&entry.lock);
+}
+
+/**
+ * 子进程中正在读取的线程不存在，结果也属于父进程
+ */
+static void atfork_child() {
+    for (ProcEntry &entry : g_entries) {
+        entry.loading = false;
+        entry.valid = false;
+        pthread_cond_init(&entry.cond, nullptr);
+        pthread_mutex_unlock(&entry.lock);
+    }
+}
+
+static void init_once() {
+    pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+}
+
+// ==================== 读取 ====================
+
+/**
+ * 取得指标的当前结果（可能来自缓存），由 copy 复制给调用方
+ */
+template <typename Copy>
+static void sample(int metric, Copy copy) {
+    pthread_once(&g_init_once, init_once);
+    ProcEntry &entry = g_entries[metric];
+
+    pthread_mutex_lock(&entry.lock);
+    for (;;) {
+        const int64_t age_ns = monotonic_ns() - entry.loaded_ns;
+        if (entry.valid && age_ns < (int64_t) entry.ttl_ms * 1000000LL) {
+            entry.stats.hits++;
+            if (age_ns / 1000000 > entry.stats.max_served_age_ms) {
+                entry.stats.max_served_age_ms = age_ns / 1000000;
+            }
+            copy(entry.value);
+            pthread_mutex_unlock(&entry.lock);
+            return;
+        }
+        if (!entry.loading) break;
+
+        // 单飞：等待正在进行的读取，直接使用其结果
+        entry.stats.waits++;
+        const uint64_t generation = entry.generation;
+        while (entry.loading && entry.generation == generation) {
+            pthread_cond_wait(&entry.cond, &entry.lock);
+        }
+        if (entry.generation != generation && entry.valid) {
+            copy(entry.value);
+            pthread_mutex_unlock(&entry.lock);
+            return;
+        }
+        // 读取期间缓存被失效（或被 fork 重置），重新判断
+    }
+
+    entry.loading = true;
+    entry.stats.loads++;
+    const uint64_t invalidations = entry.invalidations;
+    pthread_mutex_unlock(&entry.lock);
+
+    ProcValue value;
+    entry.load(&value);
+
+    pthread_mutex_lock(&entry.lock);
+    memcpy(&entry.value, &value, sizeof(ProcValue));
+    entry.loaded_ns = monotonic_ns();
+    // 读取期间被失效时结果只交给本次调用方
+    entry.valid = entry.invalidations == invalidations;
+    entry.loading = false;
+    entry.generation++;
+    pthread_cond_broadcast(&entry.cond);
+    pthread_mutex_unlock(&entry.lock);
+    copy(value);
+}
+
+extern "C" void fw_proc_cache_memory_info(long *total_kb, long *free_kb, long *available_kb) {
+    if (total_kb == nullptr || free_kb == nullptr || available_kb == nullptr) return;
+    sample(FW_PROC_METRIC_MEMORY, [=](const ProcValue &value) {
+        *total_kb = value.memory[0];
+        *free_kb = value.memory[1];
+        *available_kb = value.memory[2];
+    });
+}
+
+extern "C" void fw_proc_cache_process_status(char *buffer, int buffer_size) {
+    if (buffer == nullptr || buffer_size <= 0) return;
+    sample(FW_PROC_METRIC_STATUS, [=](const ProcValue &value) {
+        strlcpy(buffer, value.status, buffer_size);
+    });
+}
+
+extern "C" int fw_proc_cache_oom_adj() {
+    int adj = 0;
+    sample(FW_PROC_METRIC_OOM_ADJ, [&adj](const ProcValue &value) { adj = value.number; });
+    return adj;
+}
+
+extern "C" int fw_proc_cache_process_count() {
+    int count = 0;
+    sample(FW_PROC_METRIC_PROCESS_COUNT, [&count](const ProcValue &value) {
+        count = value.number;
+    });
+    return count;
+}
+
+// ==================== 配置与统计 ====================
+
+extern "C" bool fw_proc_cache_set_ttl(int metric, int ttl_ms) {
+    if (metric < 0 || metric >= FW_PROC_METRIC_COUNT || ttl_ms < 0) return false;
+    ProcEntry &entry = g_entries[metric];
+    pthread_mutex_lock(&entry.lock);
+    entry.ttl_ms = ttl_ms;
+    pthread_mutex_unlock(&entry.lock);
+    return true;
+}
+
+extern "C" void fw_proc_cache_invalidate(int metric) {
+    for (int i = 0; i < FW_PROC_METRIC_COUNT; i++) {
+        if (metric >= 0 && metric != i) continue;
+        ProcEntry &entry = g_entries[i];
+        pthread_mutex_lock(&entry.lock);
+        entry.valid = false;
+        entry.invalidations++;
+        pthread_mutex_unlock(&entry.lock);
+    }
+}
+
+extern "C" bool fw_proc_cache_get_stats(int metric, fw_proc_cache_stats *stats) {
+    if (metric < 0 || metric >= FW_PROC_METRIC_COUNT || stats == nullptr) return false;
+    ProcEntry &entry = g_entries[metric];
+    pthread_mutex_lock(&entry.lock);
+    *stats = entry.stats;
+    stats->ttl_ms = entry.ttl_ms;
+    stats->age_ms = entry.valid ? (monotonic_ns() - entry.loaded_ns) / 1000000 : -1;
+    pthread_mutex_unlock(&entry.lock);
+    return true;
+}
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...)
+        __attribute__((format(printf, 4, 5)));
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...) {
+    if (*used >= size) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + *used, size - *used, format, args);
+    va_end(args);
+    if (n > 0) *used += ((size_t) n < size - *used) ? (size_t) n : size - *used - 1;
+}
+
+extern "C" size_t fw_proc_cache_dump(char *buffer, size_t size) {
+    if (buffer == nullptr || size == 0) return 0;
+    buffer[0] = '\0';
+    size_t used = 0;
+
+    for (int i = 0; i < FW_PROC_METRIC_COUNT; i++) {
+        fw_proc_cache_stats stats;
+        fw_proc_cache_get_stats(i, &stats);
+        const uint64_t total = stats.hits + stats.loads + stats.waits;
+        append(buffer, size, &used,
+               "%s ttl=%d hits=%llu loads=%llu waits=%llu hit_rate=%.1f%% age=%lld "
+               "max_served_age=%lld\n",
+               g_entries[i].name, stats.ttl_ms, (unsigned long long) stats.hits,
+               (unsigned long long) stats.loads, (unsigned long long) stats.waits,
+               total > 0 ? 100.0 * (double) (stats.hits + stats.waits) / (double) total : 0.0,
+               (long long) stats.age_ms, (long long) stats.max_served_age_ms);
+    }
+    return used;
+}
+
+// ==================== 模块入口 ====================
+
+/**
+ * 返回函数表（常量初始化的静态对象，不产生全局构造函数）
+ */
+extern "C" FW_EXPORT const FwProcCacheModule *fw_proc_cache_module_get() {
+    static const FwProcCacheModule module = {
+            FW_PROC_CACHE_MODULE_VERSION,
+            fw_proc_cache_set_ttl,
+            fw_proc_cache_invalidate,
+            fw_proc_cache_memory_info,
+            fw_proc_cache_process_status,
+            fw_proc_cache_oom_adj,
+            fw_proc_cache_process_count,
+            fw_proc_cache_get_stats,
+            fw_proc_cache_dump,
+    };
+    return &module;
+}
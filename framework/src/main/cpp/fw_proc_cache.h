@@ -0,0 +1,144 @@
+/**
+ * ============================================================================
+ * fw_proc_cache.h - /proc 采样缓存
+ * ============================================================================
+ *
+ * 功能简介：
+ *   getMemoryInfo / getProcessStatus / getOomAdj / getProcessCount 此前每次调用
+ *   都直接读取 /proc，而上层组件经常在几毫秒内重复调用。
+ *
+ *   - 每项指标单独设置缓存有效期（TTL），有效期内直接返回上一次的结果
+ *   - 单飞（single-flight）：缓存过期时只有一个调用方读取 /proc，
+ *     同时到达的其它调用方等待这一次读取的结果，不会重复读取
+ *   - 统计命中、读取、等待次数，以及返回结果的最大陈旧时间
+ *
+ *   TTL 为 0 时每次都读取（仍然合并并发调用）。
+ *   fork 后子进程的缓存全部失效（OOM adj、进程状态都是按进程的）。
+ *
+ * 加载方式：
+ *   代码位于按需加载的 libfw_proc_cache.so，首次调用 fw_proc_cache_set_ttl 时加载
+ *   （见 fw_module.h）。模块加载前读取函数每次直接读取 /proc（与 TTL 为 0 相同但不合并
+ *   并发调用），统计为空。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_PROC_CACHE_H
+#define FW_PROC_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fw_module.h"
+
+// 指标
+#define FW_PROC_METRIC_MEMORY           0   // /proc/meminfo
+#define FW_PROC_METRIC_STATUS           1   // /proc/self/status
+#define FW_PROC_METRIC_OOM_ADJ          2   // /proc/self/oom_score_adj
+#define FW_PROC_METRIC_PROCESS_COUNT    3   // /proc 下的进程目录
+#define FW_PROC_METRIC_COUNT            4
+
+// 默认 TTL（毫秒）
+#define FW_PROC_TTL_MEMORY_MS           500
+#define FW_PROC_TTL_STATUS_MS           200
+#define FW_PROC_TTL_OOM_ADJ_MS          1000
+#define FW_PROC_TTL_PROCESS_COUNT_MS    2000
+
+struct fw_proc_cache_stats {
+    uint64_t hits;              // 有效期内直接返回
+    uint64_t loads;             // 实际读取 /proc
+    uint64_t waits;             // 等待其它调用方正在进行的读取
+    int ttl_ms;
+    int64_t age_ms;             // 当前缓存结果的陈旧时间，没有结果时为 -1
+    int64_t max_served_age_ms;  // 命中时返回结果的最大陈旧时间
+};
+
+extern "C" {
+
+/**
+ * 设置指标的 TTL（毫秒），0 表示不缓存
+ */
+FW_MODULE_API bool fw_proc_cache_set_ttl(int metric, int ttl_ms);
+
+/**
+ * 使缓存失效，metric 为 -1 时全部失效（如修改 OOM adj 之后）
+ */
+FW_MODULE_API void fw_proc_cache_invalidate(int metric);
+
+/**
+ * 与 fw_process.cpp 中同名函数（去掉 fw_proc_cache_ 前缀）的结果相同
+ */
+FW_MODULE_API void fw_proc_cache_memory_info(long *total_kb, long *free_kb, long *available_kb);
+FW_MODULE_API void fw_proc_cache_process_status(char *buffer, int buffer_size);
+FW_MODULE_API int fw_proc_cache_oom_adj();
+FW_MODULE_API int fw_proc_cache_process_count();
+
+/**
+ * 获取指标统计
+ */
+FW_MODULE_API bool fw_proc_cache_get_stats(int metric, fw_proc_cache_stats *stats);
+
+/**
+ * 输出所有指标的统计，每行
+ * `<metric> ttl=<ms> hits=<n> loads=<n> waits=<n> hit_rate=<%> age=<ms> max_served_age=<ms>`
+ *
+ * @return 写入的字节数（不含 NUL）
+ */
+FW_MODULE_API size_t fw_proc_cache_dump(char *buffer, size_t size);
+
+}
+
+// ==================== 模块 ====================
+
+#define FW_PROC_CACHE_MODULE_LIB     "libfw_proc_cache.so"
+#define FW_PROC_CACHE_MODULE_ENTRY   "fw_proc_cache_module_get"
+#define FW_PROC_CACHE_MODULE_VERSION 1
+
+/**
+ * /proc 采样缓存模块函数表（libfw_proc_cache.so 提供），函数与上面同名的 fw_proc_cache_* 一一对应
+ */
+struct FwProcCacheModule {
+    uint32_t version;   // FW_PROC_CACHE_MODULE_VERSION
+
+    bool (*setTtl)(int metric, int ttl_ms);
+
+    void (*invalidate)(int metric);
+
+    void (*memoryInfo)(long *total_kb, long *free_kb, long *available_kb);
+
+    void (*processStatus)(char *buffer, int buffer_size);
+
+    int (*oomAdj)();
+
+    int (*processCount)();
+
+    bool (*getStats)(int metric, fw_proc_cache_stats *stats);
+
+    size_t (*dump)(char *buffer, size_t size);
+};
+
+extern "C" {
+
+/**
+ * 获取 /proc 采样缓存模块（首次调用时 dlopen，线程安全）
+ *
+ * @return 函数表，加载失败返回 nullptr（失败结果会被缓存，不会重复尝试）
+ */
+const FwProcCacheModule *fw_proc_cache_module();
+
+/**
+ * 获取已加载的 /proc 采样缓存模块（不触发加载）
+ */
+const FwProcCacheModule *fw_proc_cache_module_if_loaded();
+
+// fw_process.cpp：不经过缓存直接读取 /proc，供模块和未加载模块时使用
+FW_EXPORT int get_oom_adj();
+FW_EXPORT void get_process_status(char *buffer, int buffer_size);
+FW_EXPORT void get_memory_info(long *total_kb, long *free_kb, long *available_kb);
+FW_EXPORT int get_process_count();
+
+}
+
+#endif // FW_PROC_CACHE_H
@@ -0,0 +1,539 @@
+/**
+ * ============================================================================
+ * fw_profiler.cpp - 进程内 CPU 采样实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   SIGPROF 处理函数只做异步信号安全的操作：原子计数、clock_gettime、
+ *   gettid、process_vm_readv。样本槽位通过原子递增的下标分配，写完后置 ready，
+ *   停止后再由普通线程聚合、按 /proc/self/maps 换算为 模块+偏移。
+ *
+ *   单次采集请求通过 rt_tgsigqueueinfo 发送带标记值的 SIGPROF（SI_QUEUE），
+ *   与定时器信号（SI_TIMER）区分；请求状态用 CAS 切换，超时后迟到的信号被忽略。
+ *
+ *   编译为独立的 libfw_profiler.so，只导出 fw_profiler_module_get。
+ *
+ *   SIGPROF 处理函数安装后不再卸载：定时器删除时可能仍有已发出的信号未递送，
+ *   恢复默认处理会导致进程被终止。未在采样时收到的信号交给原处理函数。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_profiler.h"
+
+#include <atomic>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <android/log.h>
+#include "fw_tokenlog.h"
+
+#define LOG_TAG "FwProfiler"
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+// 线程 CPU 时钟 ID（内核 MAKE_THREAD_CPUCLOCK(tid, CPUCLOCK_SCHED)）
+#define THREAD_CPU_CLOCK(tid) ((clockid_t) ((~(unsigned int) (tid)) << 3) | 6)
+
+struct ProfileSample {
+    std::atomic<uint32_t> ready;
+    pid_t tid;
+    uint32_t depth;
+    uintptr_t pcs[FW_PROFILER_MAX_DEPTH];      // pcs[0] 为叶帧
+};
+
+struct ProfiledThread {
+    pid_t tid;
+    timer_t timer;
+    char name[16];
+};
+
+static pthread_mutex_t g_profiler_lock = PTHREAD_MUTEX_INITIALIZER;
+static ProfiledThread g_threads[FW_PROFILER_MAX_THREADS];
+static int g_thread_count = 0;
+static bool g_running = false;
+
+// 信号处理函数访问的状态
+static std::atomic<bool> g_active{false};
+static std::atomic<int> g_in_handler{0};            // 正在写样本的处理函数数
+static ProfileSample *g_samples = nullptr;
+static size_t g_samples_bytes = 0;
+static uint32_t g_capacity = 0;
+static std::atomic<uint32_t> g_next_sample{0};
+static std::atomic<uint64_t> g_dropped{0};
+static std::atomic<uint64_t> g_throttled{0};
+static int g_budget_per_sec = 0;
+static std::atomic<int64_t> g_budget_window_sec{0};
+static std::atomic<int> g_budget_used{0};
+
+static struct sigaction g_old_action;
+static bool g_handler_installed = false;
+
+// 单次采集
+#define CAPTURE_MAGIC 0x46574350    // "FWCP"
+
+enum {
+    CAPTURE_IDLE = 0,
+    CAPTURE_REQUESTED = 1,
+    CAPTURE_RUNNING = 2,
+    CAPTURE_DONE = 3,
+};
+
+static pthread_mutex_t g_capture_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::atomic<int> g_capture_state{CAPTURE_IDLE};
+static pid_t g_capture_tid = 0;
+static uintptr_t g_capture_pcs[FW_PROFILER_MAX_DEPTH];
+static uint32_t g_capture_depth = 0;
+
+// ==================== 信号处理（异步信号安全） ====================
+
+/**
+ * 读取本进程内存，地址无效时返回 false 而不是触发 SIGSEGV
+ */
+static bool safe_read(uintptr_t address, void *out, size_t size) {
+    struct iovec local = {out, size};
+    struct iovec remote = {reinterpret_cast<void *>(address), size};
+    return syscall(__NR_process_vm_readv, getpid(), &local, 1, &remote, 1, 0) ==
+           (ssize_t) size;
+}
+
+static uint32_t capture_stack(const ucontext_t *context, uintptr_t *pcs) {
+    uintptr_t pc, fp, sp;
+#if defined(__aarch64__)
+    pc = context->uc_mcontext.pc;
+    fp = context->uc_mcontext.regs[29];
+    sp = context->uc_mcontext.sp;
+#elif defined(__arm__)
+    pc = context->uc_mcontext.arm_pc;
+    fp = context->uc_mcontext.arm_r7;   // Thumb 帧指针
+    sp = context->uc_mcontext.arm_sp;
+#elif defined(__x86_64__)
+    pc = context->uc_mcontext.gregs[REG_RIP];
+    fp = context->uc_mcontext.gregs[REG_RBP];
+    sp = context->uc_mcontext.gregs[REG_RSP];
+#elif defined(__i386__)
+    pc = context->uc_mcontext.gregs[REG_EIP];
+    fp = context->uc_mcontext.gregs[REG_EBP];
+    sp = context->uc_mcontext.gregs[REG_ESP];
+#else
+    (void) context;
+    return 0;
+#endif
+
+    uint32_t depth = 0;
+    pcs[depth++] = pc;
+    // 帧记录：[fp] = 上一帧 fp，[fp + 指针大小] = 返回地址；栈向低地址增长，fp 逐帧递增
+    while (depth < FW_PROFILER_MAX_DEPTH) {
+        if (fp < sp || (fp & (sizeof(uintptr_t) - 1)) != 0) break;
+        uintptr_t frame[2];
+        if (!safe_read(fp, frame, sizeof(frame))) break;
+        if (frame[1] == 0) break;
+        pcs[depth++] = frame[1];
+        if (frame[0] <= fp) break;
+        sp = fp;
+        fp = frame[0];
+    }
+    return depth;
+}
+
+/**
+ * 每秒样本上限，超出返回 false
+ */
+static bool take_budget() {
+    if (g_budget_per_sec <= 0) return true;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    int64_t window = g_budget_window_sec.load(std::memory_order_relaxed);
+    if (now.tv_sec != window &&
+        g_budget_window_sec.compare_exchange_strong(window, now.tv_sec,
+                                                    std::memory_order_relaxed)) {
+        g_budget_used.store(0, std::memory_order_relaxed);
+    }
+    return g_budget_used.fetch_add(1, std::memory_order_relaxed) < g_budget_per_sec;
+}
+
+static void sigprof_handler(int signo, siginfo_t *info, void *context) {
+    const int saved_errno = errno;
+
+    if (info->si_code == SI_QUEUE && info->si_value.sival_int == CAPTURE_MAGIC) {
+        int expected = CAPTURE_REQUESTED;
+        if (gettid() == g_capture_tid &&
+            g_capture_state.compare_exchange_strong(expected, CAPTURE_RUNNING,
+                                                    std::memory_order_acquire)) {
+            g_capture_depth = capture_stack(static_cast<const ucontext_t *>(context),
+                                            g_capture_pcs);
+            g_capture_state.store(CAPTURE_DONE, std::memory_order_release);
+        }
+        errno = saved_errno;
+        return;
+    }
+
+    if (!g_active.load(std::memory_order_acquire) || info->si_code != SI_TIMER) {
+        if ((g_old_action.sa_flags & SA_SIGINFO) != 0 && g_old_action.sa_sigaction != nullptr) {
+            g_old_action.sa_sigaction(signo, info, context);
+        } else if (g_old_action.sa_handler != SIG_DFL && g_old_action.sa_handler != SIG_IGN &&
+                   g_old_action.sa_handler != nullptr) {
+            g_old_action.sa_handler(signo);
+        }
+        errno = saved_errno;
+        return;
+    }
+
+    if (!take_budget()) {
+        g_throttled.fetch_add(1, std::memory_order_relaxed);
+        errno = saved_errno;
+        return;
+    }
+
+    g_in_handler.fetch_add(1, std::memory_order_acquire);
+    const uint32_t index = g_next_sample.fetch_add(1, std::memory_order_relaxed);
+    if (index < g_capacity && g_active.load(std::memory_order_acquire)) {
+        ProfileSample &sample = g_samples[index];
+        sample.tid = gettid();
+        sample.depth = capture_stack(static_cast<const ucontext_t *>(context), sample.pcs);
+        sample.ready.store(1, std::memory_order_release);
+    } else {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    g_in_handler.fetch_sub(1, std::memory_order_release);
+    errno = saved_errno;
+}
+
+// ==================== 开始 / 停止 ====================
+
+static bool install_handler() {
+    if (g_handler_installed) return true;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = sigprof_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &g_old_action) != 0) {
+        LOGE("安装 SIGPROF 处理函数失败: %s", strerror(errno));
+        return false;
+    }
+    g_handler_installed = true;
+    return true;
+}
+
+static void read_task_name(pid_t tid, char *name, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    name[0] = '\0';
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ssize_t n = read(fd, name, size - 1);
+    close(fd);
+    if (n <= 0) return;
+    name[n] = '\0';
+    if (name[n - 1] == '\n') name[n - 1] = '\0';
+}
+
+/**
+ * 为线程创建 CPU 时间定时器
+ */
+static bool arm_thread_timer(ProfiledThread *thread, int frequency_hz) {
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = thread->tid;
+    if (timer_create(THREAD_CPU_CLOCK(thread->tid), &event, &thread->timer) != 0) {
+        return false;
+    }
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_interval.tv_nsec = 1000000000L / frequency_hz;
+    spec.it_value = spec.it_interval;
+    if (timer_settime(thread->timer, 0, &spec, nullptr) != 0) {
+        timer_delete(thread->timer);
+        return false;
+    }
+    return true;
+}
+
+extern "C" bool fw_profiler_start(const fw_profiler_config *config) {
+    if (config == nullptr || config->frequency_hz <= 0 ||
+        config->frequency_hz > FW_PROFILER_MAX_HZ || config->max_samples <= 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&g_profiler_lock);
+    if (g_running || !install_handler()) {
+        pthread_mutex_unlock(&g_profiler_lock);
+        return false;
+    }
+
+    // 等待上一次采样中已进入处理函数的信号写完，再重新分配样本缓冲区
+    while (g_in_handler.load(std::memory_order_acquire) > 0) {
+        sched_yield();
+    }
+    if (g_samples != nullptr) munmap(g_samples, g_samples_bytes);
+    g_samples_bytes = (size_t) config->max_samples * sizeof(ProfileSample);
+    void *buffer = mmap(nullptr, g_samples_bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        g_samples = nullptr;
+        g_capacity = 0;
+        pthread_mutex_unlock(&g_profiler_lock);
+        LOGE("分配样本缓冲区失败: %s", strerror(errno));
+        return false;
+    }
+    g_samples = static_cast<ProfileSample *>(buffer);
+    g_capacity = (uint32_t) config->max_samples;
+    g_next_sample.store(0, std::memory_order_relaxed);
+    g_dropped.store(0, std::memory_order_relaxed);
+    g_throttled.store(0, std::memory_order_relaxed);
+    g_budget_per_sec = config->max_samples_per_sec;
+    g_budget_window_sec.store(0, std::memory_order_relaxed);
+    g_budget_used.store(0, std::memory_order_relaxed);
+    g_active.store(true, std::memory_order_release);
+
+    // 为现有线程启动定时器
+    g_thread_count = 0;
+    DIR *dir = opendir("/proc/self/task");
+    if (dir != nullptr) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr && g_thread_count < FW_PROFILER_MAX_THREADS) {
+            if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+            ProfiledThread &thread = g_threads[g_thread_count];
+            thread.tid = (pid_t) atoi(entry->d_name);
+            read_task_name(thread.tid, thread.name, sizeof(thread.name));
+            if (!config->all_threads && strncmp(thread.name, "fw_", 3) != 0) continue;
+            if (arm_thread_timer(&thread, config->frequency_hz)) g_thread_count++;
+        }
+        closedir(dir);
+    }
+
+    g_running = true;
+    pthread_mutex_unlock(&g_profiler_lock);
+    LOGI("CPU 采样已开始: %d 个线程, %d Hz", g_thread_count, config->frequency_hz);
+    return true;
+}
+
+extern "C" int fw_profiler_stop() {
+    pthread_mutex_lock(&g_profiler_lock);
+    if (!g_running) {
+        pthread_mutex_unlock(&g_profiler_lock);
+        return 0;
+    }
+    g_active.store(false, std::memory_order_release);
+    for (int i = 0; i < g_thread_count; i++) {
+        timer_delete(g_threads[i].timer);
+    }
+    g_running = false;
+    const uint32_t next = g_next_sample.load(std::memory_order_relaxed);
+    const int samples = (int) (next < g_capacity ? next : g_capacity);
+    pthread_mutex_unlock(&g_profiler_lock);
+    LOGI("CPU 采样已停止: %d 个样本, 丢弃 %llu, 限流 %llu", samples,
+         (unsigned long long) g_dropped.load(), (unsigned long long) g_throttled.load());
+    return samples;
+}
+
+extern "C" void fw_profiler_get_stats(fw_profiler_stats *stats) {
+    if (stats == nullptr) return;
+    pthread_mutex_lock(&g_profiler_lock);
+    const uint32_t next = g_next_sample.load(std::memory_order_relaxed);
+    stats->threads = g_thread_count;
+    stats->samples = next < g_capacity ? next : g_capacity;
+    stats->dropped = g_dropped.load(std::memory_order_relaxed);
+    stats->throttled = g_throttled.load(std::memory_order_relaxed);
+    pthread_mutex_unlock(&g_profiler_lock);
+}
+
+// ==================== 单次采集 ====================
+
+extern "C" int fw_profiler_capture_thread(pid_t tid, uintptr_t *pcs, int max_depth,
+                                          int timeout_ms) {
+    if (tid <= 0 || pcs == nullptr || max_depth <= 0) return 0;
+
+    pthread_mutex_lock(&g_profiler_lock);
+    const bool installed = install_handler();
+    pthread_mutex_unlock(&g_profiler_lock);
+    if (!installed) return 0;
+
+    pthread_mutex_lock(&g_capture_lock);
+    g_capture_tid = tid;
+    g_capture_state.store(CAPTURE_REQUESTED, std::memory_order_release);
+
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGPROF;
+    info.si_code = SI_QUEUE;
+    info.si_pid = getpid();
+    info.si_uid = getuid();
+    info.si_value.sival_int = CAPTURE_MAGIC;
+    int depth = 0;
+    if (syscall(__NR_rt_tgsigqueueinfo, getpid(), tid, SIGPROF, &info) == 0) {
+        struct timespec pause = {0, 1000000L};
+        for (int waited = 0; waited < timeout_ms; waited++) {
+            if (g_capture_state.load(std::memory_order_acquire) == CAPTURE_DONE) break;
+            nanosleep(&pause, nullptr);
+        }
+    }
+
+    // 超时：信号还未处理时撤销请求；处理函数已开始采集则等它写完
+    int expected = CAPTURE_REQUESTED;
+    if (!g_capture_state.compare_exchange_strong(expected, CAPTURE_IDLE,
+                                                 std::memory_order_acq_rel)) {
+        while (g_capture_state.load(std::memory_order_acquire) != CAPTURE_DONE) {
+            sched_yield();
+        }
+        depth = (int) g_capture_depth < max_depth ? (int) g_capture_depth : max_depth;
+        memcpy(pcs, g_capture_pcs, depth * sizeof(uintptr_t));
+        g_capture_state.store(CAPTURE_IDLE, std::memory_order_release);
+    }
+    pthread_mutex_unlock(&g_capture_lock);
+    return depth;
+}
+
+// ==================== 输出 ====================
+
+struct ModuleMapping {
+    uintptr_t start;
+    uintptr_t end;
+    uintptr_t offset;
+    std::string name;
+};
+
+/**
+ * 读取可执行映射
+ */
+static std::vector<ModuleMapping> read_executable_mappings() {
+    std::vector<ModuleMapping> mappings;
+    FILE *maps = fopen("/proc/self/maps", "re");
+    if (maps == nullptr) return mappings;
+
+    char line[512];
+    while (fgets(line, sizeof(line), maps) != nullptr) {
+        unsigned long start, end, offset;
+        char perms[8];
+        int path_pos = 0;
+        if (sscanf(line, "%lx-%lx %7s %lx %*s %*s %n", &start, &end, perms, &offset,
+                   &path_pos) < 4 || perms[2] != 'x') {
+            continue;
+        }
+        char *path = line + path_pos;
+        path[strcspn(path, "\n")] = '\0';
+        const char *slash = strrchr(path, '/');
+        mappings.push_back(ModuleMapping{start, end, offset,
+                                         *path ? (slash ? slash + 1 : path) : "[anon]"});
+    }
+    fclose(maps);
+    return mappings;
+}
+
+static void append_frame(std::string *out, const std::vector<ModuleMapping> &mappings,
+                         uintptr_t pc) {
+    char frame[160];
+    for (const ModuleMapping &mapping : mappings) {
+        if (pc >= mapping.start && pc < mapping.end) {
+            snprintf(frame, sizeof(frame), "%s+0x%llx", mapping.name.c_str(),
+                     (unsigned long long) (pc - mapping.start + mapping.offset));
+            out->append(frame);
+            return;
+        }
+    }
+    snprintf(frame, sizeof(frame), "[unknown]+0x%llx", (unsigned long long) pc);
+    out->append(frame);
+}
+
+extern "C" size_t fw_profiler_format_stack(const uintptr_t *pcs, int depth, char *buffer,
+                                           size_t size) {
+    if (buffer == nullptr || size == 0) return 0;
+    const std::vector<ModuleMapping> mappings = read_executable_mappings();
+    std::string text;
+    for (int i = 0; i < depth; i++) {
+        if (i > 0) text.append(" < ");
+        append_frame(&text, mappings, i == 0 ? pcs[0] : pcs[i] - 1);
+    }
+    return strlcpy(buffer, text.c_str(), size) < size ? text.size() : size - 1;
+}
+
+extern "C" bool fw_profiler_write_folded(const char *path) {
+    if (path == nullptr) return false;
+
+    pthread_mutex_lock(&g_profiler_lock);
+    if (g_running || g_samples == nullptr) {
+        pthread_mutex_unlock(&g_profiler_lock);
+        return false;
+    }
+
+    const std::vector<ModuleMapping> mappings = read_executable_mappings();
+    const uint32_t next = g_next_sample.load(std::memory_order_relaxed);
+    const uint32_t count = next < g_capacity ? next : g_capacity;
+
+    std::map<std::string, uint64_t> stacks;
+    std::string key;
+    for (uint32_t i = 0; i < count; i++) {
+        const ProfileSample &sample = g_samples[i];
+        if (sample.ready.load(std::memory_order_acquire) == 0 || sample.depth == 0) continue;
+
+        key.clear();
+        const char *name = nullptr;
+        for (int t = 0; t < g_thread_count && name == nullptr; t++) {
+            if (g_threads[t].tid == sample.tid) name = g_threads[t].name;
+        }
+        key.append(name != nullptr && name[0] != '\0' ? name : "thread");
+        // 根帧在前；返回地址减 1 落在调用指令内，符号化时行号才准确
+        for (uint32_t d = sample.depth; d > 0; d--) {
+            key.push_back(';');
+            append_frame(&key, mappings, d == 1 ? sample.pcs[0] : sample.pcs[d - 1] - 1);
+        }
+        stacks[key]++;
+    }
+    pthread_mutex_unlock(&g_profiler_lock);
+
+    FILE *file = fopen(path, "we");
+    if (file == nullptr) {
+        LOGE("无法写入 %s: %s", path, strerror(errno));
+        return false;
+    }
+    for (const auto &entry : stacks) {
+        fprintf(file, "%s %llu\n", entry.first.c_str(), (unsigned long long) entry.second);
+    }
+    const bool ok = fclose(file) == 0;
+    LOGI("CPU 采样结果已写入 %s: %zu 个不同调用栈", path, stacks.size());
+    return ok;
+}
+
+// ==================== 模块入口 ====================
+
+/**
+ * 返回函数表（常量初始化的静态对象，不产生全局构造函数）
+ */
+extern "C" FW_EXPORT const FwProfilerModule *fw_profiler_module_get() {
+    static const FwProfilerModule module = {
+            FW_PROFILER_MODULE_VERSION,
+            fw_profiler_start,
+            fw_profiler_stop,
+            fw_profiler_write_folded,
+            fw_profiler_get_stats,
+            fw_profiler_capture_thread,
+            fw_profiler_format_stack,
+    };
+    return &module;
+}
@@ -0,0 +1,158 @@
+/**
+ * ============================================================================
+ * fw_profiler.h - 进程内 CPU 采样
+ * ============================================================================
+ *
+ * 功能简介：
+ *   线上设备无法运行 simpleperf 时，用于统计 Native 线程的 CPU 时间花在哪里。
+ *   默认关闭，由调用方按需开启（例如只对一小部分设备开启）。
+ *
+ * 实现方式：
+ *   - 每个线程一个 timer_create 定时器，基于该线程的 CPU 时钟，到期时向该线程发送
+ *     SIGPROF（SIGEV_THREAD_ID），线程不占用 CPU 时不产生样本
+ *   - 信号处理函数沿帧指针回溯调用栈，读取栈内存使用 process_vm_readv，
+ *     帧链损坏时返回错误而不是崩溃；样本写入预分配的无锁缓冲区
+ *   - 停止后输出 folded 格式（每行 `线程;根帧;...;叶帧 次数`），帧为 `模块+0x偏移`，
+ *     在主机端用 tools/fw_profile.py 符号化后可直接生成火焰图
+ *   - fw_profiler_capture_thread 以同一个信号处理函数单次采集指定线程的调用栈
+ *     （如卡顿检测），不需要开启采样
+ *
+ * 开销控制：
+ *   - frequency_hz：每个线程每 CPU 秒的采样次数
+ *   - max_samples_per_sec：全进程每秒样本上限，超出的样本直接丢弃（计入 throttled）
+ *   - max_samples：缓冲区容量，写满后丢弃后续样本（计入 dropped）
+ *
+ * 加载方式：
+ *   采样默认关闭，代码位于独立的 libfw_profiler.so 中，与 libfw_binder.so 相同，
+ *   首次使用时由 fw_native 通过 fw_profiler_module() dlopen 加载（见 fw_module.h），
+ *   模块只导出函数表入口。下面的 fw_profiler_* 函数只在模块内部可见。
+ *
+ * 限制：
+ *   - 只对开始采样时已存在的线程生效
+ *   - 依赖帧指针：arm64 默认保留帧记录；其它架构需以 -DFW_FRAME_POINTERS=ON 构建，
+ *     arm32 按 Thumb 代码的 r7 帧指针回溯
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_PROFILER_H
+#define FW_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "fw_module.h"
+
+#define FW_PROFILER_MAX_DEPTH       32
+#define FW_PROFILER_MAX_THREADS     256
+#define FW_PROFILER_MAX_HZ          1000
+
+struct fw_profiler_config {
+    int frequency_hz;           // 每线程每 CPU 秒采样次数（1 - FW_PROFILER_MAX_HZ）
+    int max_samples;            // 缓冲区容量
+    int max_samples_per_sec;    // 全进程每秒样本上限，0 表示不限制
+    bool all_threads;           // false 时只采样 "fw_" 开头的线程
+};
+
+struct fw_profiler_stats {
+    int threads;                // 已启动定时器的线程数
+    uint64_t samples;           // 写入缓冲区的样本数
+    uint64_t dropped;           // 缓冲区已满丢弃的样本数
+    uint64_t throttled;         // 超过每秒上限丢弃的样本数
+};
+
+#define FW_PROFILER_MODULE_LIB      "libfw_profiler.so"
+#define FW_PROFILER_MODULE_ENTRY    "fw_profiler_module_get"
+#define FW_PROFILER_MODULE_VERSION  1
+
+/**
+ * 采样模块函数表（libfw_profiler.so 提供），函数与下面同名的 fw_profiler_* 一一对应
+ */
+struct FwProfilerModule {
+    uint32_t version;   // FW_PROFILER_MODULE_VERSION
+
+    bool (*start)(const fw_profiler_config *config);
+
+    int (*stop)();
+
+    bool (*writeFolded)(const char *path);
+
+    void (*getStats)(fw_profiler_stats *stats);
+
+    int (*captureThread)(pid_t tid, uintptr_t *pcs, int max_depth, int timeout_ms);
+
+    size_t (*formatStack)(const uintptr_t *pcs, int depth, char *buffer, size_t size);
+};
+
+typedef const FwProfilerModule *(*fw_profiler_module_get_fn)();
+
+extern "C" {
+
+// ==================== 模块加载（fw_native） ====================
+
+/**
+ * 获取采样模块（首次调用时 dlopen，线程安全）
+ *
+ * 循环卡顿监控（libfw_diag.so）也通过它加载，因此导出
+ *
+ * @return 函数表，加载失败返回 nullptr（失败结果会被缓存，不会重复尝试）
+ */
+FW_EXPORT const FwProfilerModule *fw_profiler_module();
+
+/**
+ * 获取已加载的采样模块（不触发加载）
+ *
+ * 模块未加载说明从未开启过采样
+ */
+const FwProfilerModule *fw_profiler_module_if_loaded();
+
+// ==================== 模块实现（libfw_profiler.so） ====================
+
+/**
+ * 开始采样（清空上一次的样本）
+ *
+ * @return 已在采样或参数无效返回 false
+ */
+bool fw_profiler_start(const fw_profiler_config *config);
+
+/**
+ * 停止采样，样本保留到下一次开始
+ *
+ * @return 采集到的样本数
+ */
+int fw_profiler_stop();
+
+/**
+ * 把上一次采样的结果以 folded 格式写入文件（须先停止）
+ *
+ * @return 是否成功
+ */
+bool fw_profiler_write_folded(const char *path);
+
+/**
+ * 获取当前或上一次采样的统计
+ */
+void fw_profiler_get_stats(fw_profiler_stats *stats);
+
+/**
+ * 采集本进程内指定线程当前的调用栈（向该线程发送 SIGPROF，同一时间只处理一个请求）
+ *
+ * @param pcs       输出地址，pcs[0] 为叶帧
+ * @param max_depth 最多 FW_PROFILER_MAX_DEPTH
+ * @return 帧数，线程不存在或超时返回 0
+ */
+int fw_profiler_capture_thread(pid_t tid, uintptr_t *pcs, int max_depth, int timeout_ms);
+
+/**
+ * 把调用栈格式化为 `模块+0x偏移 < 模块+0x偏移 ...`（叶帧在前）
+ *
+ * @return 写入的字节数（不含 NUL）
+ */
+size_t fw_profiler_format_stack(const uintptr_t *pcs, int depth, char *buffer, size_t size);
+
+}
+
+#endif // FW_PROFILER_H
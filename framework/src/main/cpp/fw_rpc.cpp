@@ -0,0 +1,338 @@
+/**
+ * ============================================================================
+ * fw_rpc.cpp - 基于 Parcel 的本地 Socket RPC 实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   帧的收发、文件描述符与 Parcel 对象表的映射、请求 / 回复匹配。
+ *   编译进 libfw_binder.so（依赖 Parcel）。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_rpc.h"
+
+#include <atomic>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "common.h"
+
+static std::atomic<uint32_t> g_next_request_id{1};
+
+// ==================== 发送 ====================
+
+extern "C" status_t fw_rpc_send(int socket_fd, const fw_rpc_header &header, const Parcel &data) {
+    const uint8_t *payload = reinterpret_cast<const uint8_t *>(data.ipcData());
+    const binder_size_t *objects = reinterpret_cast<const binder_size_t *>(data.ipcObjects());
+    const size_t data_size = data.ipcDataSize();
+    const size_t objects_count = data.ipcObjectsCount();
+    if (data_size > FW_RPC_MAX_PAYLOAD) return BAD_VALUE;
+
+    // 从对象表收集文件描述符
+    int fds[FW_RPC_MAX_FDS];
+    size_t fd_count = 0;
+    for (size_t i = 0; i < objects_count; i++) {
+        const flat_binder_object *flat =
+                reinterpret_cast<const flat_binder_object *>(payload + objects[i]);
+        if (flat->hdr.type != BINDER_TYPE_FD) {
+            LOGE("不支持通过 socket 传递对象类型 0x%08x", flat->hdr.type);
+            return BAD_TYPE;
+        }
+        if (fd_count == FW_RPC_MAX_FDS) {
+            LOGE("单帧文件描述符超过上限 %d", FW_RPC_MAX_FDS);
+            return BAD_VALUE;
+        }
+        fds[fd_count++] = static_cast<int>(flat->handle);
+    }
+
+    fw_rpc_header frame = header;
+    frame.magic = FW_RPC_MAGIC;
+    frame.data_size = static_cast<uint32_t>(data_size);
+    frame.objects_count = static_cast<uint32_t>(objects_count);
+
+    // 头部、数据区、对象表直接作为 iovec，不拷贝到中间缓冲区
+    struct iovec iov[3];
+    iov[0].iov_base = &frame;
+    iov[0].iov_len = sizeof(frame);
+    iov[1].iov_base = const_cast<uint8_t *>(payload);
+    iov[1].iov_len = data_size;
+    iov[2].iov_base = const_cast<binder_size_t *>(objects);
+    iov[2].iov_len = objects_count * sizeof(binder_size_t);
+
+    union {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int) * FW_RPC_MAX_FDS)];
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 3;
+    if (fd_count > 0) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+    }
+
+    struct iovec *cur = iov;
+    size_t remaining = 3;
+    while (remaining > 0) {
+        ssize_t n = sendmsg(socket_fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOGE("sendmsg 失败: %s", strerror(errno));
+            return errno == EPIPE || errno == ECONNRESET ? DEAD_OBJECT : -errno;
+        }
+
+        // 部分发送：文件描述符已随第一个字节发出，剩余部分只发送数据
+        msg.msg_control = nullptr;
+        msg.msg_controllen = 0;
+        size_t sent = static_cast<size_t>(n);
+        while (remaining > 0 && sent >= cur->iov_len) {
+            sent -= cur->iov_len;
+            cur++;
+            remaining--;
+        }
+        if (remaining > 0) {
+            cur->iov_base = static_cast<uint8_t *>(cur->iov_base) + sent;
+            cur->iov_len -= sent;
+        }
+        msg.msg_iov = cur;
+        msg.msg_iovlen = remaining;
+    }
+    return NO_ERROR;
+}
+
+// ==================== 接收 ====================
+
+static status_t wait_readable(int socket_fd, int timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = socket_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    for (;;) {
+        int ret = poll(&pfd, 1, timeout_ms);
+        if (ret > 0) return NO_ERROR;
+        if (ret == 0) return TIMED_OUT;
+        if (errno != EINTR) return -errno;
+    }
+}
+
+/**
+ * 读取固定长度，第一段可同时接收 SCM_RIGHTS
+ *
+ * 读到一半超时返回 BAD_VALUE：数据流已错位，不能再当作普通超时重试
+ */
+static status_t read_full(int socket_fd, void *buffer, size_t size, int timeout_ms,
+                          int *fds, size_t *fd_count) {
+    uint8_t *p = static_cast<uint8_t *>(buffer);
+    while (size > 0) {
+        status_t err = wait_readable(socket_fd, timeout_ms);
+        if (err == TIMED_OUT && p != buffer) return BAD_VALUE;
+        if (err != NO_ERROR) return err;
+
+        union {
+            struct cmsghdr header;
+            char buffer[CMSG_SPACE(sizeof(int) * FW_RPC_MAX_FDS)];
+        } control;
+
+        struct iovec iov;
+        iov.iov_base = p;
+        iov.iov_len = size;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = sizeof(control.buffer);
+
+        ssize_t n = recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return errno == ECONNRESET ? DEAD_OBJECT : -errno;
+        }
+        if (n == 0) return DEAD_OBJECT;
+
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+            size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int *received = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+            for (size_t i = 0; i < count; i++) {
+                if (fds != nullptr && *fd_count < FW_RPC_MAX_FDS) {
+                    fds[(*fd_count)++] = received[i];
+                } else {
+                    close(received[i]);
+                }
+            }
+        }
+        if ((msg.msg_flags & MSG_CTRUNC) != 0) {
+            LOGW("控制消息被截断, 部分文件描述符丢失");
+        }
+
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return NO_ERROR;
+}
+
+static void close_fds(const int *fds, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        close(fds[i]);
+    }
+}
+
+/**
+ * 接收缓冲区释放函数（Parcel 析构或重置时调用）
+ */
+static void free_frame_buffer(Parcel *parcel, const uint8_t *data, size_t /* dataSize */,
+                              const binder_size_t * /* objects */, size_t /* objectsSize */,
+                              void * /* cookie */) {
+    if (parcel != nullptr) {
+        parcel->closeFileDescriptors();
+    }
+    free(const_cast<uint8_t *>(data));
+}
+
+extern "C" status_t fw_rpc_recv(int socket_fd, fw_rpc_header *header, Parcel *data,
+                                int timeout_ms) {
+    int fds[FW_RPC_MAX_FDS];
+    size_t fd_count = 0;
+
+    status_t err = read_full(socket_fd, header, sizeof(*header), timeout_ms, fds, &fd_count);
+    if (err != NO_ERROR) {
+        close_fds(fds, fd_count);
+        return err;
+    }
+    if (header->magic != FW_RPC_MAGIC || header->data_size > FW_RPC_MAX_PAYLOAD ||
+        header->objects_count > FW_RPC_MAX_FDS) {
+        LOGE("无效的帧头: magic=0x%08x size=%u objects=%u",
+             header->magic, header->data_size, header->objects_count);
+        close_fds(fds, fd_count);
+        return BAD_VALUE;
+    }
+
+    // 数据区和对象表放在同一块内存中，对象表按 binder_size_t 对齐
+    const size_t data_size = header->data_size;
+    const size_t objects_offset = (data_size + sizeof(binder_size_t) - 1) &
+                                  ~(sizeof(binder_size_t) - 1);
+    const size_t objects_size = header->objects_count * sizeof(binder_size_t);
+    uint8_t *buffer = static_cast<uint8_t *>(malloc(objects_offset + objects_size + 1));
+    if (buffer == nullptr) {
+        close_fds(fds, fd_count);
+        return NO_MEMORY;
+    }
+    binder_size_t *objects = reinterpret_cast<binder_size_t *>(buffer + objects_offset);
+
+    err = read_full(socket_fd, buffer, data_size, timeout_ms, nullptr, nullptr);
+    if (err == NO_ERROR) {
+        err = read_full(socket_fd, objects, objects_size, timeout_ms, nullptr, nullptr);
+    }
+    if (err != NO_ERROR) {
+        free(buffer);
+        close_fds(fds, fd_count);
+        return err == TIMED_OUT ? BAD_VALUE : err;  // 头部已读完，负载超时同样视为错位
+    }
+
+    // 校验对象表，并把收到的 fd 按顺序填回对象
+    if (header->objects_count != fd_count) {
+        LOGE("文件描述符数量不匹配: 对象 %u, 收到 %zu", header->objects_count, fd_count);
+        err = BAD_VALUE;
+    }
+    binder_size_t min_offset = 0;
+    for (size_t i = 0; err == NO_ERROR && i < header->objects_count; i++) {
+        const binder_size_t offset = objects[i];
+        // 不写成 offset + sizeof > data_size：offset 来自对端，接近 2^64 时加法回绕
+        if (offset < min_offset || data_size < sizeof(flat_binder_object) ||
+            offset > data_size - sizeof(flat_binder_object) || (offset & 3) != 0) {
+            LOGE("无效的对象偏移 %llu", (unsigned long long) offset);
+            err = BAD_VALUE;
+            break;
+        }
+        flat_binder_object *flat = reinterpret_cast<flat_binder_object *>(buffer + offset);
+        if (flat->hdr.type != BINDER_TYPE_FD) {
+            LOGE("无效的对象类型 0x%08x", flat->hdr.type);
+            err = BAD_VALUE;
+            break;
+        }
+        flat->handle = static_cast<uint32_t>(fds[i]);
+        flat->cookie = 1;   // 接收方持有
+        min_offset = offset + sizeof(flat_binder_object);
+    }
+    if (err != NO_ERROR) {
+        free(buffer);
+        close_fds(fds, fd_count);
+        return err;
+    }
+
+    // 缓冲区归本帧所有，takeFileDescriptor 可以直接取走其中的 fd
+    data->ipcSetDataReference(buffer, data_size, objects, header->objects_count,
+                              free_frame_buffer, nullptr, true);
+    return NO_ERROR;
+}
+
+// ==================== 调用 / 服务 ====================
+
+extern "C" status_t fw_rpc_call(int socket_fd, uint32_t method, const Parcel &data, Parcel *reply,
+                                int timeout_ms) {
+    fw_rpc_header header;
+    memset(&header, 0, sizeof(header));
+    header.flags = reply == nullptr ? FW_RPC_FLAG_ONEWAY : 0;
+    header.method = method;
+    header.request_id = g_next_request_id.fetch_add(1, std::memory_order_relaxed);
+
+    status_t err = fw_rpc_send(socket_fd, header, data);
+    if (err != NO_ERROR || reply == nullptr) return err;
+
+    for (;;) {
+        fw_rpc_header response;
+        err = fw_rpc_recv(socket_fd, &response, reply, timeout_ms);
+        if (err != NO_ERROR) return err;
+        if ((response.flags & FW_RPC_FLAG_REPLY) == 0) {
+            LOGE("等待回复时收到请求帧 (method=%u)", response.method);
+            return INVALID_OPERATION;
+        }
+        if (response.request_id == header.request_id) {
+            return response.status;
+        }
+        // 之前超时的调用迟到的回复，丢弃
+        LOGW("丢弃过期回复 (request=%u, 期望 %u)", response.request_id, header.request_id);
+    }
+}
+
+extern "C" status_t fw_rpc_serve_one(int socket_fd, fw_rpc_handler handler, void *cookie,
+                                     int timeout_ms) {
+    fw_rpc_header request;
+    Parcel data;
+    status_t err = fw_rpc_recv(socket_fd, &request, &data, timeout_ms);
+    if (err != NO_ERROR) return err;
+    if ((request.flags & FW_RPC_FLAG_REPLY) != 0) {
+        LOGW("服务端收到回复帧, 忽略 (request=%u)", request.request_id);
+        return NO_ERROR;
+    }
+
+    const bool oneway = (request.flags & FW_RPC_FLAG_ONEWAY) != 0;
+    Parcel reply;
+    status_t status = handler(request.method, data, oneway ? nullptr : &reply, cookie);
+    if (oneway) return NO_ERROR;
+
+    fw_rpc_header response;
+    memset(&response, 0, sizeof(response));
+    response.flags = FW_RPC_FLAG_REPLY;
+    response.method = request.method;
+    response.request_id = request.request_id;
+    response.status = status;
+    return fw_rpc_send(socket_fd, response, reply);
+}
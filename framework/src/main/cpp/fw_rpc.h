@@ -0,0 +1,97 @@
+/**
+ * ============================================================================
+ * fw_rpc.h - 基于 Parcel 的本地 Socket RPC
+ * ============================================================================
+ *
+ * 功能简介：
+ *   在 Unix Domain Socket（SOCK_STREAM）上以 Parcel 作为线格式传输结构化请求，
+ *   进程间不经过 Java Binder 栈即可完成方法调用。
+ *
+ * 帧格式：
+ *   fw_rpc_header | Parcel 数据（data_size 字节）| 对象偏移表（objects_count 个 binder_size_t）
+ *
+ *   - 发送：一次 sendmsg，iovec 直接指向 Parcel 的数据区和对象表，不做额外拷贝
+ *   - 文件描述符：Parcel 对象表中的 BINDER_TYPE_FD 对象按顺序通过 SCM_RIGHTS 传递，
+ *     接收端把收到的 fd 填回对应对象，readFileDescriptor() 直接可用
+ *     （takeFileDescriptor() 直接取得所有权，不需要 dup）
+ *   - 接收：头部和负载读入同一块内存，通过 ipcSetDataReference 交给 Parcel，
+ *     Parcel 释放时关闭其中的 fd 并释放内存（与 Binder 驱动的 freeBuffer 语义一致）
+ *
+ * 使用约定：
+ *   - 每个 socket 一端调用 fw_rpc_call，另一端循环 fw_rpc_serve_one
+ *   - 同一个 socket 上的调用不能并发（请求 ID 用于丢弃超时后迟到的回复）
+ *   - 返回 BAD_VALUE / DEAD_OBJECT 后数据流已不可用，调用方应关闭 socket
+ *   - 只允许传递文件描述符，Binder 对象在 socket 上没有意义，发送时返回 BAD_TYPE
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_RPC_H
+#define FW_RPC_H
+
+#include <stdint.h>
+#include "cParcel.h"
+
+#define FW_RPC_MAGIC        0x50525746  // "FWRP"
+#define FW_RPC_MAX_FDS      16          // 单帧最多传递的文件描述符
+#define FW_RPC_MAX_PAYLOAD  (1024 * 1024)
+
+// 帧标志
+#define FW_RPC_FLAG_REPLY   0x1         // 回复帧
+#define FW_RPC_FLAG_ONEWAY  0x2         // 单向请求，服务端不回复
+
+using namespace android;
+
+struct fw_rpc_header {
+    uint32_t magic;         // FW_RPC_MAGIC
+    uint32_t flags;         // FW_RPC_FLAG_*
+    uint32_t method;        // 方法 ID（回复帧中与请求一致）
+    uint32_t request_id;    // 请求 ID（回复帧中与请求一致）
+    int32_t status;         // 回复帧：服务端处理结果；请求帧：0
+    uint32_t data_size;     // Parcel 数据字节数
+    uint32_t objects_count; // 对象偏移表条目数
+};
+
+/**
+ * 服务端方法处理函数
+ *
+ * @param reply 单向请求时为 nullptr
+ * @return 处理结果，原样放入回复帧的 status
+ */
+typedef status_t (*fw_rpc_handler)(uint32_t method, const Parcel &data, Parcel *reply,
+                                   void *cookie);
+
+extern "C" {
+
+/**
+ * 发送一帧
+ */
+status_t fw_rpc_send(int socket_fd, const fw_rpc_header &header, const Parcel &data);
+
+/**
+ * 接收一帧
+ *
+ * @param timeout_ms 等待超时，< 0 表示一直等待
+ * @return NO_ERROR / TIMED_OUT / DEAD_OBJECT（对端关闭）/ BAD_VALUE（帧格式错误）
+ */
+status_t fw_rpc_recv(int socket_fd, fw_rpc_header *header, Parcel *data, int timeout_ms);
+
+/**
+ * 发起调用并等待回复
+ *
+ * @param reply 为 nullptr 时以单向请求发送，不等待回复
+ * @return 传输错误或服务端返回的 status
+ */
+status_t fw_rpc_call(int socket_fd, uint32_t method, const Parcel &data, Parcel *reply,
+                     int timeout_ms);
+
+/**
+ * 接收并处理一个请求，需要时发送回复
+ */
+status_t fw_rpc_serve_one(int socket_fd, fw_rpc_handler handler, void *cookie, int timeout_ms);
+
+}
+
+#endif // FW_RPC_H
@@ -0,0 +1,256 @@
+/**
+ * ============================================================================
+ * fw_service_prefetch.cpp - 服务 handle 批量预取实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   一批查询共用一个批次结构：参与的线程用原子下标领取下一个查询，
+ *   结果写入批次的 handle 数组。提交给线程池的任务结束时在锁内递减计数，
+ *   调用线程等计数归零后才释放批次（批次位于调用线程的栈上）。
+ *   线程池提交失败时，少提交的部分由调用线程自己完成。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_service_prefetch.h"
+
+#include <atomic>
+#include <pthread.h>
+#include <string.h>
+#include "common.h"
+#include "binder/data_transact.h"
+#include "fw_worker_pool.h"
+#include "utils/AllocTag.h"
+
+#define CHECK_SERVICE_TRANSACTION 1  // ServiceManager 的 checkService 事务码
+
+struct ServiceEntry {
+    char name[FW_SERVICE_NAME_LEN];
+    int driverFD;           // -1 表示空闲
+    uint32_t handle;
+};
+
+static pthread_mutex_t g_table_lock = PTHREAD_MUTEX_INITIALIZER;
+static ServiceEntry g_table[FW_SERVICE_TABLE_SIZE];
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+// ==================== fork 处理 ====================
+
+static void atfork_prepare() {
+    pthread_mutex_lock(&g_table_lock);
+}
+
+static void atfork_parent() {
+    pthread_mutex_unlock(&g_table_lock);
+}
+
+/**
+ * 驱动只接受打开它的进程的事务，子进程必须重新打开驱动，旧 handle 全部作废
+ */
+static void atfork_child() {
+    for (ServiceEntry &entry : g_table) entry.driverFD = -1;
+    pthread_mutex_unlock(&g_table_lock);
+}
+
+static void init_once() {
+    for (ServiceEntry &entry : g_table) entry.driverFD = -1;
+    pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+}
+
+// ==================== handle 表 ====================
+
+/**
+ * 查找条目（调用方持有 g_table_lock）
+ */
+static ServiceEntry *find_locked(const char *name, int driverFD) {
+    for (ServiceEntry &entry : g_table) {
+        if (entry.driverFD == driverFD && strcmp(entry.name, name) == 0) return &entry;
+    }
+    return nullptr;
+}
+
+static bool table_lookup(const char *name, int driverFD, uint32_t *handle) {
+    pthread_once(&g_init_once, init_once);
+    pthread_mutex_lock(&g_table_lock);
+    const ServiceEntry *entry = find_locked(name, driverFD);
+    if (entry != nullptr) *handle = entry->handle;
+    pthread_mutex_unlock(&g_table_lock);
+    return entry != nullptr;
+}
+
+static void table_store(const char *name, int driverFD, uint32_t handle) {
+    if (handle == 0 || strlen(name) >= FW_SERVICE_NAME_LEN) return;
+    pthread_once(&g_init_once, init_once);
+    pthread_mutex_lock(&g_table_lock);
+    ServiceEntry *entry = find_locked(name, driverFD);
+    for (int i = 0; entry == nullptr && i < FW_SERVICE_TABLE_SIZE; i++) {
+        if (g_table[i].driverFD < 0) entry = &g_table[i];
+    }
+    if (entry != nullptr) {
+        strlcpy(entry->name, name, sizeof(entry->name));
+        entry->driverFD = driverFD;
+        entry->handle = handle;
+    } else {
+        LOGW("服务 handle 表已满，[%s] 不缓存", name);
+    }
+    pthread_mutex_unlock(&g_table_lock);
+}
+
+extern "C" void fw_service_table_reset(int driverFD) {
+    pthread_once(&g_init_once, init_once);
+    pthread_mutex_lock(&g_table_lock);
+    for (ServiceEntry &entry : g_table) {
+        if (driverFD < 0 || entry.driverFD == driverFD) entry.driverFD = -1;
+    }
+    pthread_mutex_unlock(&g_table_lock);
+}
+
+// ==================== 单次查询 ====================
+
+extern "C" void fw_service_write_check(Parcel &out, const char *name) {
+    out.writeInterfaceToken(String16("android.os.IServiceManager"));
+    out.writeString16(String16(name));
+}
+
+extern "C" uint32_t fw_service_check(const Parcel &query, const char *name, int driverFD) {
+    ALLOC_TAG_SCOPE("getServiceHandle");
+    Parcel reply;
+
+    // 调用 ServiceManager (handle=0) 的 checkService
+    write_transact_timeout(0, CHECK_SERVICE_TRANSACTION, query, &reply, 0, driverFD,
+                           FW_SERVICE_CHECK_TIMEOUT_MS);
+
+    // 从返回数据中读取服务的 Binder 对象
+    const flat_binder_object *flat = reply.readObject(false);
+    uint32_t handle = 0;
+    if (flat) {
+        handle = flat->handle;
+        LOGD("获取服务 [%s] handle = %u", name, handle);
+    } else {
+        LOGE("获取服务 [%s] 失败", name);
+    }
+    return handle;
+}
+
+extern "C" uint32_t fw_service_handle(const char *name, int driverFD) {
+    if (name == nullptr) return 0;
+    uint32_t handle = 0;
+    if (table_lookup(name, driverFD, &handle)) return handle;
+
+    Parcel query;
+    fw_service_write_check(query, name);
+    handle = fw_service_check(query, name, driverFD);
+    table_store(name, driverFD, handle);
+    return handle;
+}
+
+// ==================== 批量预取 ====================
+
+struct PrefetchBatch {
+    const fw_service_query *queries;
+    int count;
+    int driverFD;
+    uint32_t handles[FW_SERVICE_TABLE_SIZE] = {};
+    std::atomic<int> next{0};
+
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+    int running_tasks = 0;      // 已提交给线程池、尚未结束的任务数
+};
+
+/**
+ * 领取并执行查询，直到批次中没有剩余
+ */
+static void prefetch_run(PrefetchBatch *batch) {
+    int i;
+    while ((i = batch->next.fetch_add(1, std::memory_order_relaxed)) < batch->count) {
+        const fw_service_query &item = batch->queries[i];
+        if (item.query != nullptr) {
+            batch->handles[i] = fw_service_check(*item.query, item.name, batch->driverFD);
+        } else {
+            Parcel query;
+            fw_service_write_check(query, item.name);
+            batch->handles[i] = fw_service_check(query, item.name, batch->driverFD);
+        }
+    }
+}
+
+static void prefetch_task(void *arg) {
+    PrefetchBatch *batch = (PrefetchBatch *) arg;
+    prefetch_run(batch);
+
+    // 解锁之后不再访问批次
+    pthread_mutex_lock(&batch->lock);
+    if (--batch->running_tasks == 0) pthread_cond_signal(&batch->done);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+extern "C" int fw_service_prefetch_queries(const fw_service_query *queries, int count,
+                                           int driverFD) {
+    if (queries == nullptr || count <= 0 || driverFD < 0) return 0;
+
+    // 只查询表中还没有的服务
+    fw_service_query pending[FW_SERVICE_TABLE_SIZE];
+    int pendingCount = 0;
+    int resolved = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t handle;
+        if (queries[i].name == nullptr) continue;
+        if (table_lookup(queries[i].name, driverFD, &handle)) {
+            resolved++;
+        } else if (pendingCount < FW_SERVICE_TABLE_SIZE) {
+            pending[pendingCount++] = queries[i];
+        }
+    }
+    if (pendingCount == 0) return resolved;
+
+    PrefetchBatch batch;
+    batch.queries = pending;
+    batch.count = pendingCount;
+    batch.driverFD = driverFD;
+
+    // 调用线程自己也执行查询，只需 pendingCount - 1 个帮手
+    int helpers = pendingCount - 1;
+    if (helpers > FW_SERVICE_PREFETCH_HELPERS) helpers = FW_SERVICE_PREFETCH_HELPERS;
+    fw_worker_pool *pool = helpers > 0 ? fw_worker_pool_shared() : nullptr;
+    for (int i = 0; pool != nullptr && i < helpers; i++) {
+        pthread_mutex_lock(&batch.lock);
+        batch.running_tasks++;
+        pthread_mutex_unlock(&batch.lock);
+        if (!fw_worker_pool_submit(pool, prefetch_task, &batch)) {
+            pthread_mutex_lock(&batch.lock);
+            batch.running_tasks--;
+            pthread_mutex_unlock(&batch.lock);
+            break;
+        }
+    }
+
+    prefetch_run(&batch);
+
+    pthread_mutex_lock(&batch.lock);
+    while (batch.running_tasks > 0) pthread_cond_wait(&batch.done, &batch.lock);
+    pthread_mutex_unlock(&batch.lock);
+    pthread_mutex_destroy(&batch.lock);
+    pthread_cond_destroy(&batch.done);
+
+    for (int i = 0; i < pendingCount; i++) {
+        if (batch.handles[i] == 0) continue;
+        table_store(pending[i].name, driverFD, batch.handles[i]);
+        resolved++;
+    }
+    LOGD("预取服务 handle: 查询 %d 个，可用 %d 个", pendingCount, resolved);
+    return resolved;
+}
+
+extern "C" int fw_service_prefetch(const char *const *names, int count, int driverFD) {
+    if (names == nullptr || count <= 0) return 0;
+    fw_service_query queries[FW_SERVICE_TABLE_SIZE];
+    if (count > FW_SERVICE_TABLE_SIZE) count = FW_SERVICE_TABLE_SIZE;
+    for (int i = 0; i < count; i++) {
+        queries[i].name = names[i];
+        queries[i].query = nullptr;
+    }
+    return fw_service_prefetch_queries(queries, count, driverFD);
+}
@@ -0,0 +1,91 @@
+/**
+ * ============================================================================
+ * fw_service_prefetch.h - 服务 handle 批量预取
+ * ============================================================================
+ *
+ * 功能简介：
+ *   进程启动时需要的每个系统服务都要向 ServiceManager 做一次 checkService，
+ *   逐个串行查询时预热耗时为 N 次 IPC 往返。
+ *
+ *   - fw_service_prefetch 一次接收多个服务名，并发发起 checkService，
+ *     所有结果写入 handle 表后返回，预热耗时约为一次 IPC 往返
+ *   - fw_service_handle 优先查表，未命中时同步查询并写入表中
+ *
+ * 并发方式：
+ *   同步 Binder 事务在一个线程上必须等到回复后才能发起下一个，无法在同一线程流水线化。
+ *   因此查询分给共享线程池（fw_worker_pool_shared）的线程和调用线程同时执行，
+ *   每个线程各自与驱动交互（data_transact 的线程状态都是按线程的）。
+ *
+ * 限制：
+ *   - handle 按驱动 fd 区分；unInitProcessState 关闭驱动时清除该 fd 的所有条目
+ *   - 查询失败（服务未注册或超时）不写入表，下次使用时重新查询
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_SERVICE_PREFETCH_H
+#define FW_SERVICE_PREFETCH_H
+
+#include <stdint.h>
+#include "cParcel.h"
+
+#define FW_SERVICE_TABLE_SIZE           32
+#define FW_SERVICE_NAME_LEN             64
+#define FW_SERVICE_PREFETCH_HELPERS     4       // 调用线程之外最多使用的线程池线程数
+#define FW_SERVICE_CHECK_TIMEOUT_MS     3000    // ServiceManager 无响应时不无限阻塞
+
+using namespace android;
+
+/**
+ * 预取条目
+ */
+struct fw_service_query {
+    const char *name;           // 服务名（如 "activity"）
+    const Parcel *query;        // 已构造好的查询数据（如来自 Parcel 缓存），nullptr 时现场构造
+};
+
+extern "C" {
+
+/**
+ * 构造 checkService 查询数据
+ */
+void fw_service_write_check(Parcel &out, const char *name);
+
+/**
+ * 向 ServiceManager 查询一次（不查表、不写表）
+ *
+ * @return 服务的 Binder handle，失败返回 0
+ */
+uint32_t fw_service_check(const Parcel &query, const char *name, int driverFD);
+
+/**
+ * 并发查询一批服务并写入 handle 表，全部完成（或超时）后返回
+ *
+ * 已在表中的服务不再查询。
+ *
+ * @return 表中已有 handle 的服务数
+ */
+int fw_service_prefetch_queries(const fw_service_query *queries, int count, int driverFD);
+
+/**
+ * 同 fw_service_prefetch_queries，查询数据全部现场构造
+ */
+int fw_service_prefetch(const char *const *names, int count, int driverFD);
+
+/**
+ * 取得服务 handle：表中有则直接返回，否则同步查询并写入表中
+ *
+ * @return 服务的 Binder handle，失败返回 0
+ */
+uint32_t fw_service_handle(const char *name, int driverFD);
+
+/**
+ * 清除驱动 fd 对应的所有条目，driverFD 为 -1 时全部清除
+ */
+void fw_service_table_reset(int driverFD);
+
+}
+
+#endif // FW_SERVICE_PREFETCH_H
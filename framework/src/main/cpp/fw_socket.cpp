@@ -38,26 +38,42 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <android/log.h>
+#include "fw_tokenlog.h"
 #include <cstdlib>
 #include <cstring>
 #include <pthread.h>
+#include "fw_diag.h"
+#include "fw_event_bus.h"
+#include "fw_loop_monitor.h"
+#include "fw_status_board.h"
+#include "fw_thread.h"
+#include "fw_wakeup.h"
 
 #define LOG_TAG "FwNative"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGD(...) FW_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 // 心跳消息
 #define HEARTBEAT_MSG "HB"
 #define HEARTBEAT_ACK "OK"
+// 客户端请求状态板 fd（服务端以 SCM_RIGHTS 回复）
+#define STATUS_BOARD_REQ "SB"
+
+// 心跳处理单次迭代超过该时间视为卡顿
+#define SOCKET_STALL_THRESHOLD_MS 500
 
 // Socket 配置
 static int g_server_socket = -1;
 static int g_client_socket = -1;
 static char g_socket_path[256] = {0};
 static volatile bool g_socket_running = false;
-static pthread_t g_socket_thread;
+
+// 服务循环在独立的登记线程中执行（长期阻塞，不占用共享线程池的工作线程），停止时等待其结束
+static pthread_mutex_t g_socket_task_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_socket_task_cond = PTHREAD_COND_INITIALIZER;
+static bool g_socket_task_active = false;
 
 // 回调函数指针
 typedef void (*on_connection_lost_callback)(void);
@@ -176,9 +192,10 @@ extern "C" bool send_heartbeat(int socket_fd) {
 }
 
 /**
- * 接收数据（带超时）
+ * 接收数据（带超时），等待计入 wakeup_id 对应的组件
  */
-extern "C" int receive_with_timeout(int socket_fd, char* buffer, int buffer_size, int timeout_ms) {
+static int receive_tracked(int wakeup_id, int socket_fd, char* buffer, int buffer_size,
+                           int timeout_ms) {
     if (socket_fd < 0 || buffer == nullptr || buffer_size <= 0) return -1;
 
     fd_set read_fds;
@@ -189,7 +206,7 @@ extern "C" int receive_with_timeout(int socket_fd, char* buffer, int buffer_size
     tv.tv_sec = timeout_ms / 1000;
     tv.tv_usec = (timeout_ms % 1000) * 1000;
 
-    int ret = select(socket_fd + 1, &read_fds, nullptr, nullptr, &tv);
+    int ret = fw_wakeup_select(wakeup_id, socket_fd + 1, &read_fds, nullptr, nullptr, &tv);
     if (ret < 0) {
         LOGE("select 失败: %s", strerror(errno));
         return -1;
@@ -214,13 +231,23 @@ extern "C" int receive_with_timeout(int socket_fd, char* buffer, int buffer_size
 }
 
 /**
- * Socket 服务线程
+ * 接收数据（带超时）
+ */
+extern "C" int receive_with_timeout(int socket_fd, char* buffer, int buffer_size, int timeout_ms) {
+    static const int wakeup_id = fw_wakeup_register("socket_receive");
+    return receive_tracked(wakeup_id, socket_fd, buffer, buffer_size, timeout_ms);
+}
+
+/**
+ * Socket 服务循环（fw_socket_srv 线程）
  *
  * 接受连接并处理心跳
  */
 static void* socket_server_thread(void* arg) {
     (void)arg;
     LOGI("Socket 服务线程启动");
+    const int loop_id = fw_loop_register("socket_server", SOCKET_STALL_THRESHOLD_MS);
+    const int wakeup_id = fw_wakeup_register("socket_server");
 
     while (g_socket_running && g_server_socket >= 0) {
         // 接受连接
@@ -236,13 +263,16 @@ static void* socket_server_thread(void* arg) {
         tv.tv_sec = 1;
         tv.tv_usec = 0;
 
-        int ret = select(g_server_socket + 1, &read_fds, nullptr, nullptr, &tv);
+        int ret = fw_wakeup_select(wakeup_id, g_server_socket + 1, &read_fds, nullptr, nullptr, &tv);
+        fw_status_board_beat();
         if (ret <= 0) {
             continue;
         }
 
+        fw_loop_begin(loop_id);
         int client_fd = accept(g_server_socket, (struct sockaddr*)&client_addr, &client_len);
         if (client_fd < 0) {
+            fw_loop_end(loop_id);
             if (errno != EAGAIN && errno != EWOULDBLOCK) {
                 LOGW("接受连接失败: %s", strerror(errno));
             }
@@ -250,24 +280,40 @@ static void* socket_server_thread(void* arg) {
         }
 
         LOGI("新客户端连接: fd=%d", client_fd);
+        fw_event_publish(fw_socket_event{FW_SOCKET_EVENT_CLIENT_CONNECTED, client_fd});
+        fw_loop_end(loop_id);
 
         // 处理心跳
         char buffer[64];
         while (g_socket_running) {
-            int received = receive_with_timeout(client_fd, buffer, sizeof(buffer), 5000);
+            int received = receive_tracked(wakeup_id, client_fd, buffer, sizeof(buffer), 5000);
             if (received < 0) {
                 LOGW("客户端断开连接");
                 break;
             } else if (received > 0) {
-                // 收到心跳，回复
-                send(client_fd, HEARTBEAT_ACK, strlen(HEARTBEAT_ACK), MSG_NOSIGNAL);
+                // 收到心跳，回复（等待心跳的时间不计入迭代耗时）
+                fw_loop_begin(loop_id);
+                fw_status_board_beat();
+                bool board_request = received >= (int) strlen(STATUS_BOARD_REQ) &&
+                        memcmp(buffer, STATUS_BOARD_REQ, strlen(STATUS_BOARD_REQ)) == 0;
+                if (!board_request || !fw_status_board_send_fd(client_fd)) {
+                    send(client_fd, HEARTBEAT_ACK, strlen(HEARTBEAT_ACK), MSG_NOSIGNAL);
+                }
+                fw_loop_end(loop_id);
             }
         }
 
         close(client_fd);
+        fw_event_publish(fw_socket_event{FW_SOCKET_EVENT_CLIENT_DISCONNECTED, client_fd});
     }
 
     LOGI("Socket 服务线程退出");
+    fw_loop_unregister(loop_id);
+
+    pthread_mutex_lock(&g_socket_task_lock);
+    g_socket_task_active = false;
+    pthread_cond_broadcast(&g_socket_task_cond);
+    pthread_mutex_unlock(&g_socket_task_lock);
     return nullptr;
 }
 
@@ -284,12 +330,27 @@ extern "C" bool start_socket_server_thread(const char* socket_name) {
         return false;
     }
 
+    // 状态板随 Socket 服务创建，连接上来的心跳客户端从这里取得 fd
+    if (fw_status_board_create()) {
+        fw_status_board_claim(nullptr);
+        fw_status_board_set_status(FW_STATUS_OK);
+    }
+
     g_socket_running = true;
 
-    int ret = pthread_create(&g_socket_thread, nullptr, socket_server_thread, nullptr);
+    pthread_mutex_lock(&g_socket_task_lock);
+    g_socket_task_active = true;
+    pthread_mutex_unlock(&g_socket_task_lock);
+
+    // 循环只做系统调用和日志，使用小栈
+    int ret = fw_thread_create(nullptr, "fw_socket_srv", "socket_server", FW_THREAD_STACK_SMALL,
+                               true, socket_server_thread, nullptr);
     if (ret != 0) {
-        LOGE("创建 socket 线程失败: %s", strerror(ret));
+        LOGE("创建 socket 服务线程失败: %s", strerror(ret));
         g_socket_running = false;
+        pthread_mutex_lock(&g_socket_task_lock);
+        g_socket_task_active = false;
+        pthread_mutex_unlock(&g_socket_task_lock);
         close(g_server_socket);
         g_server_socket = -1;
         return false;
@@ -317,8 +378,12 @@ extern "C" void stop_socket_server() {
         g_client_socket = -1;
     }
 
-    // 等待线程结束
-    pthread_join(g_socket_thread, nullptr);
+    // 等待服务循环结束
+    pthread_mutex_lock(&g_socket_task_lock);
+    while (g_socket_task_active) {
+        pthread_cond_wait(&g_socket_task_cond, &g_socket_task_lock);
+    }
+    pthread_mutex_unlock(&g_socket_task_lock);
 
     LOGI("Socket 服务已停止");
 }
@@ -330,6 +395,16 @@ extern "C" void set_connection_lost_callback(on_connection_lost_callback callbac
     g_connection_lost_callback = callback;
 }
 
+/**
+ * 通知连接丢失：调用 Native 回调并发布到事件总线（Java 层监听器经 fw_jni_dispatch 收到）
+ */
+static void notify_connection_lost() {
+    if (g_connection_lost_callback != nullptr) {
+        g_connection_lost_callback();
+    }
+    fw_event_publish(fw_socket_event{FW_SOCKET_EVENT_CONNECTION_LOST, g_client_socket});
+}
+
 /**
  * 心跳检测客户端
  *
@@ -338,35 +413,44 @@ extern "C" void set_connection_lost_callback(on_connection_lost_callback callbac
  */
 extern "C" bool start_heartbeat_client(const char* socket_name, int interval_ms) {
     LOGI("启动心跳客户端: %s, 间隔: %d ms", socket_name, interval_ms);
+    const int wakeup_id = fw_wakeup_register("heartbeat_client");
 
     if (connect_socket_server(socket_name) < 0) {
         return false;
     }
 
+    // 先取得状态板，之后不经过 IPC 即可读取服务端进程的状态；
+    // 诊断模块未加载时不发请求，否则服务端的回复会混入心跳响应
+    if (fw_diag_module_if_loaded() != nullptr && fw_status_board_fd() < 0 &&
+        send(g_client_socket, STATUS_BOARD_REQ, strlen(STATUS_BOARD_REQ), MSG_NOSIGNAL) > 0 &&
+        !fw_status_board_recv_fd(g_client_socket, interval_ms)) {
+        LOGW("未取得状态板");
+    }
+    if (fw_status_board_claim(nullptr) >= 0) {
+        fw_status_board_set_status(FW_STATUS_OK);
+    }
+
     // 简化实现：同步发送心跳
     // 实际应用中应该在单独线程中运行
     while (g_client_socket >= 0) {
         if (!send_heartbeat(g_client_socket)) {
             LOGW("心跳发送失败，连接可能已断开");
-            if (g_connection_lost_callback != nullptr) {
-                g_connection_lost_callback();
-            }
+            notify_connection_lost();
             break;
         }
 
         // 等待响应
         char buffer[64];
-        int received = receive_with_timeout(g_client_socket, buffer, sizeof(buffer), interval_ms);
+        int received = receive_tracked(wakeup_id, g_client_socket, buffer, sizeof(buffer), interval_ms);
         if (received < 0) {
             LOGW("未收到心跳响应，连接可能已断开");
-            if (g_connection_lost_callback != nullptr) {
-                g_connection_lost_callback();
-            }
+            notify_connection_lost();
             break;
         }
+        fw_status_board_beat();
 
         // 等待下一次心跳
-        usleep(interval_ms * 1000);
+        fw_wakeup_sleep_ms(wakeup_id, interval_ms);
     }
 
     return true;
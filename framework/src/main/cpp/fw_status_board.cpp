@@ -0,0 +1,567 @@
+/**
+ * ============================================================================
+ * fw_status_board.cpp - 跨进程状态板实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   共享内存中的所有字段都是无锁原子类型（地址无关，可跨进程使用），
+ *   读写都使用 relaxed 访问，顺序由 seqlock 的序号和内存屏障保证。
+ *
+ *   槽位的归属由 owner 字段的 CAS 决定；快照中的 pid 字段在 seqlock 内写入，
+ *   读者只看 pid，不会读到刚被占用、还未初始化的槽位。
+ *   同一进程内的多个线程写自己的槽位时由进程内互斥锁串行（无竞争时不进入内核）。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_status_board.h"
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <android/log.h>
+#ifdef __ANDROID__
+#include <linux/ashmem.h>
+#endif
+#include "fw_tokenlog.h"
+
+#define LOG_TAG "FwStatusBoard"
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+#define BOARD_MAGIC 0x46575342u     // "FWSB"
+#define BOARD_VERSION 1u
+#define BOARD_NAME "fw_status_board"
+// 读者遇到写入中途的数据时的最大重试次数
+#define READ_RETRIES 64
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+#define NAME_WORDS (FW_STATUS_NAME_LEN / sizeof(uint64_t))
+
+// ==================== 共享内存布局 ====================
+
+struct alignas(64) BoardHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+};
+
+struct alignas(64) BoardSlot {
+    std::atomic<uint32_t> seq;                  // 奇数表示写入中
+    std::atomic<int32_t> owner;                 // 占用槽位的 PID，0 表示空闲（只用于 CAS 占用）
+    std::atomic<int32_t> pid;                   // 以下字段在 seqlock 内写入
+    std::atomic<int32_t> status;
+    std::atomic<uint64_t> start_time;
+    std::atomic<uint64_t> heartbeat;
+    std::atomic<int64_t> update_ns;
+    std::atomic<int64_t> gauges[FW_STATUS_GAUGES];
+    std::atomic<uint64_t> name[NAME_WORDS];
+};
+
+struct Board {
+    BoardHeader header;
+    BoardSlot slots[FW_STATUS_BOARD_SLOTS];
+};
+
+static_assert(sizeof(BoardSlot) % 64 == 0, "槽位必须按缓存行对齐");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "共享内存中的原子类型必须无锁");
+static_assert(FW_STATUS_NAME_LEN % sizeof(uint64_t) == 0, "名称长度必须是 8 的倍数");
+
+// ==================== 进程内状态 ====================
+
+static pthread_mutex_t g_board_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_write_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::atomic<Board *> g_board{nullptr};
+static int g_board_fd = -1;
+static int g_own_slot = -1;                     // 由 g_write_lock 保护
+
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * 读取进程启动时间（/proc/<pid>/stat 第 22 项），失败返回 0
+ */
+static uint64_t read_start_time(pid_t pid) {
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    char buffer[512];
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buffer[n] = '\0';
+
+    // 进程名可能包含空格和括号，从最后一个 ')' 之后开始数：其后第 1 项是第 3 项（state）
+    char *p = strrchr(buffer, ')');
+    if (p == nullptr) return 0;
+    for (int field = 2; field < 22 && p != nullptr; field++) {
+        p = strchr(p + 1, ' ');
+    }
+    return p != nullptr ? strtoull(p + 1, nullptr, 10) : 0;
+}
+
+static void read_process_name(char *name, size_t size) {
+    name[0] = '\0';
+    int fd = open("/proc/self/cmdline", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t n = read(fd, name, size - 1);
+        close(fd);
+        name[n > 0 ? n : 0] = '\0';
+    }
+    if (name[0] == '\0') snprintf(name, size, "pid_%d", getpid());
+}
+
+/**
+ * 槽位原进程已退出或 PID 已被复用
+ */
+static bool slot_is_stale(const BoardSlot &slot, pid_t owner) {
+    if (kill(owner, 0) < 0 && errno == ESRCH) return true;
+    const uint64_t start_time = slot.start_time.load(std::memory_order_relaxed);
+    const uint64_t actual = read_start_time(owner);
+    // 读不到（其它 UID 的进程）时按存活处理
+    return actual != 0 && start_time != 0 && actual != start_time;
+}
+
+// ==================== seqlock ====================
+
+static void write_begin(BoardSlot &slot) {
+    slot.seq.store(slot.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void write_end(BoardSlot &slot) {
+    slot.seq.store(slot.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+static bool read_slot(const BoardSlot &slot, int index, fw_status_snapshot *snapshot) {
+    for (int attempt = 0; attempt < READ_RETRIES; attempt++) {
+        const uint32_t begin = slot.seq.load(std::memory_order_acquire);
+        if ((begin & 1) != 0) continue;
+
+        snapshot->slot = index;
+        snapshot->pid = slot.pid.load(std::memory_order_relaxed);
+        snapshot->status = slot.status.load(std::memory_order_relaxed);
+        snapshot->start_time = slot.start_time.load(std::memory_order_relaxed);
+        snapshot->heartbeat = slot.heartbeat.load(std::memory_order_relaxed);
+        snapshot->update_ns = slot.update_ns.load(std::memory_order_relaxed);
+        for (int g = 0; g < FW_STATUS_GAUGES; g++) {
+            snapshot->gauges[g] = slot.gauges[g].load(std::memory_order_relaxed);
+        }
+        uint64_t words[NAME_WORDS];
+        for (size_t w = 0; w < NAME_WORDS; w++) {
+            words[w] = slot.name[w].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != begin) continue;
+
+        memcpy(snapshot->name, words, sizeof(snapshot->name));
+        snapshot->name[sizeof(snapshot->name) - 1] = '\0';
+        return snapshot->pid != 0;
+    }
+    return false;
+}
+
+// ==================== fork 处理 ====================
+
+static void atfork_prepare() {
+    pthread_mutex_lock(&g_board_lock);
+    pthread_mutex_lock(&g_write_lock);
+}
+
+static void atfork_parent() {
+    pthread_mutex_unlock(&g_write_lock);
+    pthread_mutex_unlock(&g_board_lock);
+}
+
+/**
+ * 子进程保留映射，但不能再写父进程的槽位，需要自己占用一个
+ */
+static void atfork_child() {
+    g_own_slot = -1;
+    pthread_mutex_unlock(&g_write_lock);
+    pthread_mutex_unlock(&g_board_lock);
+}
+
+static void init_once() {
+    pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+}
+
+// ==================== 创建与加入 ====================
+
+static int create_shared_fd() {
+    int fd = (int) syscall(__NR_memfd_create, BOARD_NAME, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd >= 0) {
+        if (ftruncate(fd, sizeof(Board)) < 0) {
+            close(fd);
+            return -1;
+        }
+#ifdef F_ADD_SEALS
+        // 防止其它进程截断导致映射方访问时 SIGBUS
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+#endif
+        return fd;
+    }
+
+#ifdef __ANDROID__
+    // 3.17 以下的内核没有 memfd
+    fd = open("/dev/ashmem", O_RDWR | O_CLOEXEC);
+    if (fd >= 0) {
+        char name[ASHMEM_NAME_LEN] = BOARD_NAME;
+        ioctl(fd, ASHMEM_SET_NAME, name);
+        if (ioctl(fd, ASHMEM_SET_SIZE, sizeof(Board)) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+#endif
+    return fd;
+}
+
+static size_t shared_fd_size(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) return 0;
+#ifdef __ANDROID__
+    // ashmem 的 fstat 大小为 0
+    if (st.st_size == 0) {
+        int size = ioctl(fd, ASHMEM_GET_SIZE, nullptr);
+        return size > 0 ? (size_t) size : 0;
+    }
+#endif
+    return (size_t) st.st_size;
+}
+
+static Board *map_board(int fd) {
+    void *addr = mmap(nullptr, sizeof(Board), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return addr != MAP_FAILED ? static_cast<Board *>(addr) : nullptr;
+}
+
+extern "C" bool fw_status_board_create() {
+    pthread_once(&g_init_once, init_once);
+
+    pthread_mutex_lock(&g_board_lock);
+    if (g_board.load(std::memory_order_relaxed) != nullptr) {
+        pthread_mutex_unlock(&g_board_lock);
+        return true;
+    }
+
+    int fd = create_shared_fd();
+    Board *board = fd >= 0 ? map_board(fd) : nullptr;
+    if (board == nullptr) {
+        LOGE("创建状态板失败: %s", strerror(errno));
+        if (fd >= 0) close(fd);
+        pthread_mutex_unlock(&g_board_lock);
+        return false;
+    }
+
+    // 新建的共享内存已清零，只需写头部
+    board->header.slot_count = FW_STATUS_BOARD_SLOTS;
+    board->header.slot_size = sizeof(BoardSlot);
+    board->header.version = BOARD_VERSION;
+    board->header.magic = BOARD_MAGIC;
+
+    g_board_fd = fd;
+    g_board.store(board, std::memory_order_release);
+    pthread_mutex_unlock(&g_board_lock);
+
+    LOGI("状态板已创建: fd=%d, 大小=%zu", fd, sizeof(Board));
+    return true;
+}
+
+extern "C" bool fw_status_board_attach(int fd) {
+    if (fd < 0) return false;
+    pthread_once(&g_init_once, init_once);
+
+    pthread_mutex_lock(&g_board_lock);
+    if (g_board.load(std::memory_order_relaxed) != nullptr) {
+        pthread_mutex_unlock(&g_board_lock);
+        return true;
+    }
+
+    Board *board = nullptr;
+    int own_fd = -1;
+    if (shared_fd_size(fd) >= sizeof(Board)) {
+        own_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        board = own_fd >= 0 ? map_board(own_fd) : nullptr;
+    }
+    if (board != nullptr && (board->header.magic != BOARD_MAGIC ||
+                             board->header.version != BOARD_VERSION ||
+                             board->header.slot_count != FW_STATUS_BOARD_SLOTS ||
+                             board->header.slot_size != sizeof(BoardSlot))) {
+        munmap(board, sizeof(Board));
+        board = nullptr;
+    }
+    if (board == nullptr) {
+        LOGW("加入状态板失败: fd=%d", fd);
+        if (own_fd >= 0) close(own_fd);
+        pthread_mutex_unlock(&g_board_lock);
+        return false;
+    }
+
+    g_board_fd = own_fd;
+    g_board.store(board, std::memory_order_release);
+    pthread_mutex_unlock(&g_board_lock);
+
+    LOGI("已加入状态板: fd=%d", own_fd);
+    return true;
+}
+
+extern "C" int fw_status_board_fd() {
+    pthread_mutex_lock(&g_board_lock);
+    int fd = g_board_fd;
+    pthread_mutex_unlock(&g_board_lock);
+    return fd;
+}
+
+// ==================== fd 传递 ====================
+
+extern "C" bool fw_status_board_send_fd(int socket_fd) {
+    const int fd = fw_status_board_fd();
+    if (fd < 0) return false;
+
+    char data = 'B';
+    struct iovec iov = {&data, 1};
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    return sendmsg(socket_fd, &msg, MSG_NOSIGNAL) == 1;
+}
+
+extern "C" bool fw_status_board_recv_fd(int socket_fd, int timeout_ms) {
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(socket_fd, &read_fds);
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    if (select(socket_fd + 1, &read_fds, nullptr, nullptr, &tv) <= 0) return false;
+
+    char data;
+    struct iovec iov = {&data, 1};
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC) <= 0) return false;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        return false;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    bool result = fw_status_board_attach(fd);
+    close(fd);
+    return result;
+}
+
+// ==================== 写入本进程槽位 ====================
+
+extern "C" int fw_status_board_claim(const char *name) {
+    Board *board = g_board.load(std::memory_order_acquire);
+    if (board == nullptr) return -1;
+
+    char process_name[FW_STATUS_NAME_LEN];
+    if (name != nullptr) {
+        strlcpy(process_name, name, sizeof(process_name));
+    } else {
+        read_process_name(process_name, sizeof(process_name));
+    }
+    uint64_t words[NAME_WORDS];
+    memset(words, 0, sizeof(words));
+    memcpy(words, process_name, strlen(process_name));
+
+    const pid_t self = getpid();
+    pthread_mutex_lock(&g_write_lock);
+    int index = g_own_slot;
+    for (int i = 0; index < 0 && i < FW_STATUS_BOARD_SLOTS; i++) {
+        BoardSlot &slot = board->slots[i];
+        int32_t owner = slot.owner.load(std::memory_order_relaxed);
+        if (owner != 0 && (owner == self || !slot_is_stale(slot, owner))) continue;
+        if (slot.owner.compare_exchange_strong(owner, self, std::memory_order_relaxed)) {
+            index = i;
+        }
+    }
+    if (index < 0) {
+        pthread_mutex_unlock(&g_write_lock);
+        LOGW("状态板已满");
+        return -1;
+    }
+
+    BoardSlot &slot = board->slots[index];
+    if (index != g_own_slot) {
+        // 原进程可能死在写入中途，先把序号恢复为偶数
+        const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        if ((seq & 1) != 0) slot.seq.store(seq + 1, std::memory_order_relaxed);
+    }
+    write_begin(slot);
+    if (index != g_own_slot) {
+        slot.start_time.store(read_start_time(self), std::memory_order_relaxed);
+        slot.heartbeat.store(0, std::memory_order_relaxed);
+        slot.status.store(FW_STATUS_UNKNOWN, std::memory_order_relaxed);
+        for (auto &gauge : slot.gauges) gauge.store(0, std::memory_order_relaxed);
+        slot.pid.store(self, std::memory_order_relaxed);
+    }
+    for (size_t w = 0; w < NAME_WORDS; w++) {
+        slot.name[w].store(words[w], std::memory_order_relaxed);
+    }
+    slot.update_ns.store(monotonic_ns(), std::memory_order_relaxed);
+    write_end(slot);
+    g_own_slot = index;
+    pthread_mutex_unlock(&g_write_lock);
+
+    LOGI("已占用状态板槽位 %d: %s", index, process_name);
+    return index;
+}
+
+extern "C" void fw_status_board_release() {
+    Board *board = g_board.load(std::memory_order_acquire);
+    if (board == nullptr) return;
+
+    pthread_mutex_lock(&g_write_lock);
+    if (g_own_slot >= 0) {
+        BoardSlot &slot = board->slots[g_own_slot];
+        write_begin(slot);
+        slot.pid.store(0, std::memory_order_relaxed);
+        write_end(slot);
+        slot.owner.store(0, std::memory_order_release);
+        g_own_slot = -1;
+    }
+    pthread_mutex_unlock(&g_write_lock);
+}
+
+/**
+ * 在 seqlock 内更新本进程槽位，同时计一次心跳
+ */
+template <typename Update>
+static void update_own_slot(Update update) {
+    Board *board = g_board.load(std::memory_order_acquire);
+    if (board == nullptr) return;
+
+    pthread_mutex_lock(&g_write_lock);
+    if (g_own_slot >= 0) {
+        BoardSlot &slot = board->slots[g_own_slot];
+        write_begin(slot);
+        update(slot);
+        slot.heartbeat.store(slot.heartbeat.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_relaxed);
+        slot.update_ns.store(monotonic_ns(), std::memory_order_relaxed);
+        write_end(slot);
+    }
+    pthread_mutex_unlock(&g_write_lock);
+}
+
+extern "C" void fw_status_board_beat() {
+    update_own_slot([](BoardSlot &) {});
+}
+
+extern "C" void fw_status_board_set_status(int status) {
+    update_own_slot([status](BoardSlot &slot) {
+        slot.status.store(status, std::memory_order_relaxed);
+    });
+}
+
+extern "C" void fw_status_board_set_gauge(int index, int64_t value) {
+    if (index < 0 || index >= FW_STATUS_GAUGES) return;
+    update_own_slot([index, value](BoardSlot &slot) {
+        slot.gauges[index].store(value, std::memory_order_relaxed);
+    });
+}
+
+// ==================== 读取 ====================
+
+extern "C" bool fw_status_board_read(int slot, fw_status_snapshot *snapshot) {
+    if (slot < 0 || slot >= FW_STATUS_BOARD_SLOTS || snapshot == nullptr) return false;
+    Board *board = g_board.load(std::memory_order_acquire);
+    if (board == nullptr) return false;
+    return read_slot(board->slots[slot], slot, snapshot);
+}
+
+extern "C" bool fw_status_board_find(pid_t pid, fw_status_snapshot *snapshot) {
+    if (pid <= 0 || snapshot == nullptr) return false;
+    Board *board = g_board.load(std::memory_order_acquire);
+    if (board == nullptr) return false;
+
+    for (int i = 0; i < FW_STATUS_BOARD_SLOTS; i++) {
+        if (read_slot(board->slots[i], i, snapshot) && snapshot->pid == pid) return true;
+    }
+    return false;
+}
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...)
+        __attribute__((format(printf, 4, 5)));
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...) {
+    if (*used >= size) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + *used, size - *used, format, args);
+    va_end(args);
+    if (n > 0) *used += ((size_t) n < size - *used) ? (size_t) n : size - *used - 1;
+}
+
+extern "C" size_t fw_status_board_dump(char *buffer, size_t size) {
+    if (buffer == nullptr || size == 0) return 0;
+    buffer[0] = '\0';
+    size_t used = 0;
+
+    const int64_t now = monotonic_ns();
+    fw_status_snapshot snapshot;
+    for (int i = 0; i < FW_STATUS_BOARD_SLOTS; i++) {
+        if (!fw_status_board_read(i, &snapshot)) continue;
+        append(buffer, size, &used, "%d %s pid=%d status=%d heartbeat=%llu age=%lldms gauges=",
+               i, snapshot.name, snapshot.pid, snapshot.status,
+               (unsigned long long) snapshot.heartbeat,
+               (long long) ((now - snapshot.update_ns) / 1000000));
+        for (int g = 0; g < FW_STATUS_GAUGES; g++) {
+            append(buffer, size, &used, g == 0 ? "%lld" : ",%lld", (long long) snapshot.gauges[g]);
+        }
+        append(buffer, size, &used, "\n");
+    }
+    return used;
+}
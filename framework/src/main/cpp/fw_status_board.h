@@ -0,0 +1,136 @@
+/**
+ * ============================================================================
+ * fw_status_board.h - 跨进程状态板
+ * ============================================================================
+ *
+ * 功能简介：
+ *   此前查询另一个进程的状态只能通过 IPC（Socket 心跳、守护进程轮询）。
+ *   状态板是一块共享内存（memfd，旧内核回退到 ashmem），每个进程占一个槽位：
+ *     - 心跳计数（单调递增）、最近更新时间（CLOCK_MONOTONIC，跨进程可比较）
+ *     - 进程启动时间（/proc/<pid>/stat 第 22 项，用于识别 PID 复用）
+ *     - 健康状态和若干计量值
+ *
+ *   每个槽位按缓存行对齐，由 seqlock 保护：
+ *     - 进程只写自己的槽位，写入全部是普通存储，不需要系统调用
+ *     - 任何进程都可以读取任意槽位，读到写入中途的数据时重试，同样不需要系统调用
+ *
+ * 共享方式：
+ *   - 主进程启动 Socket 服务时创建状态板，心跳客户端连接后通过 SCM_RIGHTS 取得 fd
+ *   - fork 出的守护进程直接继承映射
+ *
+ * 加载方式：
+ *   代码位于按需加载的 libfw_diag.so（见 fw_diag.h）。模块加载前创建 / 加入状态板
+ *   返回失败，更新为空操作；因此需在启动 Socket 服务、守护进程之前开启诊断功能。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_STATUS_BOARD_H
+#define FW_STATUS_BOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "fw_module.h"
+
+#define FW_STATUS_BOARD_SLOTS       32
+#define FW_STATUS_NAME_LEN          32
+#define FW_STATUS_GAUGES            4
+
+// 健康状态
+#define FW_STATUS_UNKNOWN           0
+#define FW_STATUS_OK                1
+#define FW_STATUS_DEGRADED          2
+#define FW_STATUS_FAILING           3
+
+// 计量值下标
+#define FW_STATUS_GAUGE_RSS_KB      0   // 常驻内存
+#define FW_STATUS_GAUGE_THREADS     1   // 线程数
+#define FW_STATUS_GAUGE_STALLS      2   // 循环卡顿次数
+#define FW_STATUS_GAUGE_USER        3   // 由调用方定义
+
+// 一个槽位的快照
+struct fw_status_snapshot {
+    int slot;
+    pid_t pid;
+    uint64_t start_time;        // 进程启动时间（开机后的时钟节拍数）
+    uint64_t heartbeat;         // 心跳计数
+    int64_t update_ns;          // 最近一次更新（CLOCK_MONOTONIC）
+    int status;                 // FW_STATUS_*
+    int64_t gauges[FW_STATUS_GAUGES];
+    char name[FW_STATUS_NAME_LEN];
+};
+
+extern "C" {
+
+/**
+ * 创建状态板（已创建或已加入时直接返回 true）
+ */
+FW_MODULE_API bool fw_status_board_create();
+
+/**
+ * 加入其它进程创建的状态板（fd 由调用方关闭）
+ */
+FW_MODULE_API bool fw_status_board_attach(int fd);
+
+/**
+ * 状态板的 fd，未创建或加入时返回 -1
+ */
+FW_MODULE_API int fw_status_board_fd();
+
+/**
+ * 通过 Unix Domain Socket 发送 / 接收状态板 fd（SCM_RIGHTS）
+ */
+FW_MODULE_API bool fw_status_board_send_fd(int socket_fd);
+FW_MODULE_API bool fw_status_board_recv_fd(int socket_fd, int timeout_ms);
+
+/**
+ * 为本进程占用一个槽位（已占用时只更新名称），name 为 nullptr 时使用进程名
+ * 原进程已退出或 PID 已被复用的槽位会被回收
+ *
+ * @return 槽位下标，状态板不可用或已满返回 -1
+ */
+FW_MODULE_API int fw_status_board_claim(const char *name);
+
+/**
+ * 释放本进程的槽位
+ */
+FW_MODULE_API void fw_status_board_release();
+
+/**
+ * 心跳：计数加 1 并更新时间（未占用槽位时为空操作）
+ */
+FW_MODULE_API void fw_status_board_beat();
+
+/**
+ * 设置健康状态 / 计量值，同时计一次心跳
+ */
+FW_MODULE_API void fw_status_board_set_status(int status);
+FW_MODULE_API void fw_status_board_set_gauge(int index, int64_t value);
+
+/**
+ * 读取槽位快照（无系统调用）
+ *
+ * @return 槽位空闲或状态板不可用返回 false
+ */
+FW_MODULE_API bool fw_status_board_read(int slot, fw_status_snapshot *snapshot);
+
+/**
+ * 按 PID 查找槽位快照
+ */
+FW_MODULE_API bool fw_status_board_find(pid_t pid, fw_status_snapshot *snapshot);
+
+/**
+ * 输出所有已占用的槽位，每行
+ * `<slot> <name> pid=<pid> status=<status> heartbeat=<n> age=<ms>ms gauges=<g0>,<g1>,...`
+ *
+ * @return 写入的字节数（不含 NUL）
+ */
+FW_MODULE_API size_t fw_status_board_dump(char *buffer, size_t size);
+
+}
+
+#endif // FW_STATUS_BOARD_H
@@ -0,0 +1,497 @@
+/**
+ * ============================================================================
+ * fw_thread.cpp - Native 线程登记与泄漏检测实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   固定容量的登记表（互斥锁保护），线程入口包装函数负责设置线程名、
+ *   记录 tid，并通过 pthread_cleanup 在线程返回或 pthread_exit 时注销。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_thread.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <android/log.h>
+#include "fw_tokenlog.h"
+
+#define LOG_TAG "FwThread"
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// /proc/self/task 中最多检查的线程数
+#define MAX_TASKS 512
+
+struct ThreadRecord {
+    bool used;
+    pid_t tid;              // 线程启动前为 0
+    size_t stack_size;
+    int64_t start_ms;
+    char name[FW_THREAD_NAME_LEN];
+    char role[FW_THREAD_ROLE_LEN];
+};
+
+struct RoleLimit {
+    char role[FW_THREAD_ROLE_LEN];
+    int max_alive;
+};
+
+struct StartArgs {
+    int slot;               // 登记表下标，-1 表示未登记
+    char name[FW_THREAD_NAME_LEN];
+    fw_thread_entry entry;
+    void *arg;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadRecord g_records[FW_THREAD_MAX_RECORDS];
+static RoleLimit g_role_limits[FW_THREAD_MAX_ROLES];
+static int g_role_limit_count = 0;
+static uint64_t g_created = 0;
+static uint64_t g_exited = 0;
+static uint64_t g_untracked = 0;
+static int g_task_baseline = -1;
+
+// 周期检查
+static pthread_mutex_t g_monitor_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_monitor_cond;
+static pthread_t g_monitor_thread;
+static bool g_monitor_running = false;
+static int g_monitor_interval_ms = 0;
+
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+static int64_t boottime_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ==================== fork 处理 ====================
+
+static void atfork_prepare() {
+    pthread_mutex_lock(&g_monitor_lock);
+    pthread_mutex_lock(&g_lock);
+}
+
+static void atfork_parent() {
+    pthread_mutex_unlock(&g_lock);
+    pthread_mutex_unlock(&g_monitor_lock);
+}
+
+/**
+ * 子进程中其它线程都不存在，清空登记表
+ */
+static void atfork_child() {
+    memset(g_records, 0, sizeof(g_records));
+    g_task_baseline = -1;
+    g_monitor_running = false;
+    pthread_mutex_unlock(&g_lock);
+    pthread_mutex_unlock(&g_monitor_lock);
+}
+
+static void init_once() {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_monitor_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+}
+
+// ==================== 创建与注销 ====================
+
+static void on_thread_exit(void *arg) {
+    const int slot = static_cast<int>(reinterpret_cast<intptr_t>(arg));
+    pthread_mutex_lock(&g_lock);
+    g_exited++;
+    if (slot >= 0) {
+        g_records[slot].used = false;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void *thread_trampoline(void *arg) {
+    StartArgs start = *static_cast<StartArgs *>(arg);
+    free(arg);
+
+    pthread_setname_np(pthread_self(), start.name);
+    if (start.slot >= 0) {
+        pthread_mutex_lock(&g_lock);
+        g_records[start.slot].tid = gettid();
+        pthread_mutex_unlock(&g_lock);
+    }
+
+    void *result;
+    pthread_cleanup_push(on_thread_exit, reinterpret_cast<void *>(static_cast<intptr_t>(start.slot)));
+    result = start.entry(start.arg);
+    pthread_cleanup_pop(1);
+    return result;
+}
+
+extern "C" int fw_thread_create(pthread_t *thread, const char *name, const char *role,
+                                size_t stack_size, bool detached, fw_thread_entry entry,
+                                void *arg) {
+    if (name == nullptr || role == nullptr || entry == nullptr ||
+        (thread == nullptr && !detached)) {
+        return EINVAL;
+    }
+    pthread_once(&g_init_once, init_once);
+
+    if (strncmp(name, FW_THREAD_NAME_PREFIX, strlen(FW_THREAD_NAME_PREFIX)) != 0) {
+        LOGW("线程名 %s 不以 %s 开头，检查时无法识别", name, FW_THREAD_NAME_PREFIX);
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (stack_size > 0) {
+        const size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+        if (stack_size < (size_t) PTHREAD_STACK_MIN) stack_size = PTHREAD_STACK_MIN;
+        stack_size = (stack_size + page_size - 1) & ~(page_size - 1);
+        pthread_attr_setstacksize(&attr, stack_size);
+        pthread_attr_setguardsize(&attr, page_size);
+    }
+    if (detached) {
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    }
+    size_t actual_stack = 0;
+    pthread_attr_getstacksize(&attr, &actual_stack);
+
+    StartArgs *start = static_cast<StartArgs *>(malloc(sizeof(StartArgs)));
+    if (start == nullptr) {
+        pthread_attr_destroy(&attr);
+        return ENOMEM;
+    }
+    strlcpy(start->name, name, sizeof(start->name));
+    start->entry = entry;
+    start->arg = arg;
+    start->slot = -1;
+
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < FW_THREAD_MAX_RECORDS; i++) {
+        if (!g_records[i].used) {
+            ThreadRecord &record = g_records[i];
+            memset(&record, 0, sizeof(record));
+            record.used = true;
+            record.stack_size = actual_stack;
+            record.start_ms = boottime_ms();
+            strlcpy(record.name, name, sizeof(record.name));
+            strlcpy(record.role, role, sizeof(record.role));
+            start->slot = i;
+            break;
+        }
+    }
+    if (start->slot < 0) g_untracked++;
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_t handle;
+    int ret = pthread_create(&handle, &attr, thread_trampoline, start);
+    pthread_attr_destroy(&attr);
+
+    pthread_mutex_lock(&g_lock);
+    if (ret == 0) {
+        g_created++;
+    } else if (start->slot >= 0) {
+        g_records[start->slot].used = false;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (ret != 0) {
+        LOGE("创建线程 %s 失败: %s", name, strerror(ret));
+        free(start);
+        return ret;
+    }
+    if (thread != nullptr) *thread = handle;
+    return 0;
+}
+
+extern "C" void fw_thread_set_role_limit(const char *role, int max_alive) {
+    if (role == nullptr) return;
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < g_role_limit_count; i++) {
+        if (strcmp(g_role_limits[i].role, role) == 0) {
+            g_role_limits[i].max_alive = max_alive;
+            pthread_mutex_unlock(&g_lock);
+            return;
+        }
+    }
+    if (g_role_limit_count < FW_THREAD_MAX_ROLES) {
+        RoleLimit &limit = g_role_limits[g_role_limit_count++];
+        strlcpy(limit.role, role, sizeof(limit.role));
+        limit.max_alive = max_alive;
+    } else {
+        LOGW("角色上限表已满，忽略 %s", role);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+// ==================== 检查 ====================
+
+static int role_limit_locked(const char *role) {
+    for (int i = 0; i < g_role_limit_count; i++) {
+        if (strcmp(g_role_limits[i].role, role) == 0) return g_role_limits[i].max_alive;
+    }
+    return 1;
+}
+
+/**
+ * 读取 /proc/self/task/<tid>/comm
+ */
+static void read_task_name(pid_t tid, char *name, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    name[0] = '\0';
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    ssize_t n = read(fd, name, size - 1);
+    close(fd);
+    if (n <= 0) return;
+    name[n] = '\0';
+    if (name[n - 1] == '\n') name[n - 1] = '\0';
+}
+
+/**
+ * 列出 /proc/self/task 中的线程
+ *
+ * @return 线程数，失败返回 -1
+ */
+static int list_tasks(pid_t *tids, int capacity) {
+    DIR *dir = opendir("/proc/self/task");
+    if (dir == nullptr) return -1;
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        if (count < capacity) tids[count] = (pid_t) atoi(entry->d_name);
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+/**
+ * 追加一行到 report 并输出警告日志
+ */
+static void report_issue(char *report, size_t size, size_t *used, const char *format, ...) {
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    LOGW("%s", line);
+    if (report != nullptr && *used < size) {
+        int n = snprintf(report + *used, size - *used, "%s\n", line);
+        if (n > 0) *used += ((size_t) n < size - *used) ? (size_t) n : size - *used - 1;
+    }
+}
+
+extern "C" int fw_thread_check(char *report, size_t size) {
+    pthread_once(&g_init_once, init_once);
+    if (report != nullptr && size > 0) report[0] = '\0';
+    size_t used = 0;
+    int issues = 0;
+
+    pid_t tids[MAX_TASKS];
+    const int task_count = list_tasks(tids, MAX_TASKS);
+    if (task_count < 0) {
+        LOGE("无法读取 /proc/self/task");
+        return 0;
+    }
+    const int listed = task_count < MAX_TASKS ? task_count : MAX_TASKS;
+
+    // 读取线程名不需要持锁，先收集 "fw_" 前缀的线程
+    pid_t named[MAX_TASKS];
+    char named_comm[MAX_TASKS][FW_THREAD_NAME_LEN];
+    int named_count = 0;
+    for (int i = 0; i < listed; i++) {
+        char comm[FW_THREAD_NAME_LEN];
+        read_task_name(tids[i], comm, sizeof(comm));
+        if (strncmp(comm, FW_THREAD_NAME_PREFIX, strlen(FW_THREAD_NAME_PREFIX)) == 0) {
+            named[named_count] = tids[i];
+            memcpy(named_comm[named_count], comm, sizeof(comm));
+            named_count++;
+        }
+    }
+
+    pthread_mutex_lock(&g_lock);
+
+    // 1. 未登记的 fw_ 线程
+    for (int i = 0; i < named_count; i++) {
+        bool registered = false;
+        for (int j = 0; j < FW_THREAD_MAX_RECORDS && !registered; j++) {
+            registered = g_records[j].used && g_records[j].tid == named[i];
+        }
+        if (!registered) {
+            issues++;
+            report_issue(report, size, &used, "unregistered %s tid=%d", named_comm[i], named[i]);
+        }
+    }
+
+    // 2. 登记为存活但已不存在的线程
+    for (int j = 0; j < FW_THREAD_MAX_RECORDS; j++) {
+        ThreadRecord &record = g_records[j];
+        if (!record.used || record.tid == 0) continue;
+        bool present = false;
+        for (int i = 0; i < listed && !present; i++) {
+            present = tids[i] == record.tid;
+        }
+        if (!present && listed == task_count) {
+            issues++;
+            report_issue(report, size, &used, "stale %s role=%s tid=%d", record.name,
+                         record.role, record.tid);
+            record.used = false;
+        }
+    }
+
+    // 3. 角色存活数超过上限
+    for (int j = 0; j < FW_THREAD_MAX_RECORDS; j++) {
+        if (!g_records[j].used) continue;
+        bool seen = false;
+        for (int k = 0; k < j && !seen; k++) {
+            seen = g_records[k].used && strcmp(g_records[k].role, g_records[j].role) == 0;
+        }
+        if (seen) continue;
+
+        int alive = 0;
+        for (int k = j; k < FW_THREAD_MAX_RECORDS; k++) {
+            if (g_records[k].used && strcmp(g_records[k].role, g_records[j].role) == 0) alive++;
+        }
+        const int limit = role_limit_locked(g_records[j].role);
+        if (limit > 0 && alive > limit) {
+            issues++;
+            report_issue(report, size, &used, "leak role=%s alive=%d limit=%d",
+                         g_records[j].role, alive, limit);
+        }
+    }
+
+    // 4. 进程总线程数增长
+    if (g_task_baseline < 0) {
+        g_task_baseline = task_count;
+    } else if (task_count > g_task_baseline + FW_THREAD_CREEP_THRESHOLD) {
+        issues++;
+        report_issue(report, size, &used, "creep tasks=%d baseline=%d", task_count,
+                     g_task_baseline);
+    }
+
+    pthread_mutex_unlock(&g_lock);
+    return issues;
+}
+
+extern "C" size_t fw_thread_dump(char *buffer, size_t size) {
+    if (buffer == nullptr || size == 0) return 0;
+    buffer[0] = '\0';
+
+    pid_t tids[MAX_TASKS];
+    const int task_count = list_tasks(tids, MAX_TASKS);
+    const int64_t now = boottime_ms();
+
+    size_t used = 0;
+    pthread_mutex_lock(&g_lock);
+    int registered = 0;
+    for (int i = 0; i < FW_THREAD_MAX_RECORDS; i++) {
+        const ThreadRecord &record = g_records[i];
+        if (!record.used) continue;
+        registered++;
+        if (used < size) {
+            int n = snprintf(buffer + used, size - used,
+                             "%s role=%s tid=%d stack=%zuKB age=%llds\n",
+                             record.name, record.role, record.tid, record.stack_size / 1024,
+                             (long long) ((now - record.start_ms) / 1000));
+            if (n > 0) used += ((size_t) n < size - used) ? (size_t) n : size - used - 1;
+        }
+    }
+    if (used < size) {
+        int n = snprintf(buffer + used, size - used,
+                         "registered=%d tasks=%d created=%llu exited=%llu untracked=%llu\n",
+                         registered, task_count, (unsigned long long) g_created,
+                         (unsigned long long) g_exited, (unsigned long long) g_untracked);
+        if (n > 0) used += ((size_t) n < size - used) ? (size_t) n : size - used - 1;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return used;
+}
+
+// ==================== 周期检查 ====================
+
+static void *monitor_thread(void * /* arg */) {
+    pthread_mutex_lock(&g_monitor_lock);
+    while (g_monitor_running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += g_monitor_interval_ms / 1000;
+        deadline.tv_nsec += (long) (g_monitor_interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        int ret = 0;
+        while (g_monitor_running && ret != ETIMEDOUT) {
+            ret = pthread_cond_timedwait(&g_monitor_cond, &g_monitor_lock, &deadline);
+        }
+        if (!g_monitor_running) break;
+
+        pthread_mutex_unlock(&g_monitor_lock);
+        int issues = fw_thread_check(nullptr, 0);
+        if (issues > 0) {
+            LOGW("线程检查发现 %d 个问题", issues);
+        }
+        pthread_mutex_lock(&g_monitor_lock);
+    }
+    pthread_mutex_unlock(&g_monitor_lock);
+    return nullptr;
+}
+
+extern "C" bool fw_thread_monitor_start(int interval_ms) {
+    if (interval_ms <= 0) return false;
+    pthread_once(&g_init_once, init_once);
+
+    pthread_mutex_lock(&g_monitor_lock);
+    g_monitor_interval_ms = interval_ms;
+    if (g_monitor_running) {
+        pthread_cond_signal(&g_monitor_cond);
+        pthread_mutex_unlock(&g_monitor_lock);
+        return true;
+    }
+    g_monitor_running = true;
+    pthread_mutex_unlock(&g_monitor_lock);
+
+    // 记录基线
+    fw_thread_check(nullptr, 0);
+
+    int ret = fw_thread_create(&g_monitor_thread, "fw_thread_mon", "thread_monitor", 0, false,
+                               monitor_thread, nullptr);
+    if (ret != 0) {
+        pthread_mutex_lock(&g_monitor_lock);
+        g_monitor_running = false;
+        pthread_mutex_unlock(&g_monitor_lock);
+        return false;
+    }
+    LOGI("线程周期检查已启动，间隔 %d ms", interval_ms);
+    return true;
+}
+
+extern "C" void fw_thread_monitor_stop() {
+    pthread_mutex_lock(&g_monitor_lock);
+    if (!g_monitor_running) {
+        pthread_mutex_unlock(&g_monitor_lock);
+        return;
+    }
+    g_monitor_running = false;
+    pthread_cond_signal(&g_monitor_cond);
+    pthread_mutex_unlock(&g_monitor_lock);
+    pthread_join(g_monitor_thread, nullptr);
+}
@@ -0,0 +1,100 @@
+/**
+ * ============================================================================
+ * fw_thread.h - Native 线程登记与泄漏检测
+ * ============================================================================
+ *
+ * 功能简介：
+ *   所有 Native 线程通过 fw_thread_create 创建：设置线程名（pthread_setname_np），
+ *   登记角色、栈大小、tid 和起止时间。fw_thread_check 对照 /proc/self/task 检查：
+ *   - 未登记：线程名以 "fw_" 开头却不在登记表中（绕过 fw_thread_create 创建）
+ *   - 泄漏：同一角色同时存活的线程数超过上限（默认 1，见 fw_thread_set_role_limit）
+ *   - 增长：进程总线程数比首次检查时的基线多出 FW_THREAD_CREEP_THRESHOLD 以上
+ *   - 失效：登记为存活的线程已不在 /proc/self/task 中
+ *
+ * 命名约定：
+ *   线程名以 "fw_" 开头，最长 15 字节（内核 comm 限制）。
+ *
+ * 栈大小：
+ *   默认属性下每个线程预留 1MB 左右的栈，按角色使用 FW_THREAD_STACK_* 显式指定。
+ *   指定栈大小时同时设置一页保护页。
+ *
+ * fork：
+ *   子进程中只有调用 fork 的线程存活，登记表在子进程中清空，基线重新计算。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_THREAD_H
+#define FW_THREAD_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "fw_module.h"
+
+#define FW_THREAD_NAME_PREFIX       "fw_"
+#define FW_THREAD_NAME_LEN          16      // 含结尾 NUL
+#define FW_THREAD_ROLE_LEN          24
+#define FW_THREAD_MAX_RECORDS       64      // 登记表容量，超出的线程照常创建但不登记
+#define FW_THREAD_MAX_ROLES         16
+#define FW_THREAD_CREEP_THRESHOLD   8
+
+// 按角色的栈大小
+#define FW_THREAD_STACK_SMALL       (64 * 1024)     // 只做系统调用和日志格式化
+#define FW_THREAD_STACK_MEDIUM      (256 * 1024)    // 通用工作线程
+#define FW_THREAD_STACK_JNI         (512 * 1024)    // 附加到虚拟机并回调 Java
+
+typedef void *(*fw_thread_entry)(void *arg);
+
+extern "C" {
+
+/**
+ * 创建并登记线程
+ *
+ * @param thread     输出线程句柄，可为 nullptr（此时必须 detached）
+ * @param name       线程名（"fw_" 开头，超长截断）
+ * @param role       角色，用于分组统计和泄漏检测
+ * @param stack_size 栈大小（向上取整到页），0 使用系统默认
+ * @param detached   是否分离（分离的线程不能 join）
+ * @return 0 成功，失败返回错误码（与 pthread_create 一致）
+ */
+FW_EXPORT int fw_thread_create(pthread_t *thread, const char *name, const char *role,
+                               size_t stack_size, bool detached, fw_thread_entry entry, void *arg);
+
+/**
+ * 设置某角色同时存活的线程数上限，超出时 fw_thread_check 报告泄漏
+ *
+ * @param max_alive 0 表示不限制
+ */
+FW_EXPORT void fw_thread_set_role_limit(const char *role, int max_alive);
+
+/**
+ * 检查线程状态，每个问题一行写入 report（可为 nullptr）
+ *
+ * @return 发现的问题数
+ */
+FW_EXPORT int fw_thread_check(char *report, size_t size);
+
+/**
+ * 输出登记表：每个线程一行 `name role=<role> tid=<tid> stack=<KB>KB age=<s>s`，
+ * 末行为汇总 `registered=<n> tasks=<n> created=<n> exited=<n> untracked=<n>`
+ *
+ * @return 写入的字节数（不含 NUL）
+ */
+FW_EXPORT size_t fw_thread_dump(char *buffer, size_t size);
+
+/**
+ * 启动后台周期检查（发现问题时输出警告日志），重复调用只更新间隔
+ */
+FW_EXPORT bool fw_thread_monitor_start(int interval_ms);
+
+/**
+ * 停止后台周期检查
+ */
+FW_EXPORT void fw_thread_monitor_stop();
+
+}
+
+#endif // FW_THREAD_H
@@ -0,0 +1,191 @@
+/**
+ * ============================================================================
+ * fw_tokenlog.cpp - 令牌化二进制日志实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   进程内固定大小的字节环形缓冲区，记录以长度前缀串联。
+ *   空间不足时从头部丢弃最旧的记录。写入只在锁内做一次 memcpy，
+ *   不做任何格式化。
+ *
+ *   该文件编译进 fw_native，fw_binder / fw_mediaroute 在令牌化模式下
+ *   链接 fw_native，共用同一个缓冲区。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_tokenlog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOG_TAG "FwNative"
+
+// 环形缓冲区大小（2 的幂）
+#define TOKENLOG_RING_SIZE (64 * 1024)
+
+// 导出文件格式
+#define TOKENLOG_FILE_MAGIC "FWTL"
+#define TOKENLOG_FILE_VERSION 1
+
+// 记录头部最大字节数：长度(3) + 级别(1) + 令牌(8) + 时间戳(10) + 线程 ID(5)
+#define TOKENLOG_MAX_HEADER 27
+
+static pthread_mutex_t g_tokenlog_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_tokenlog_atfork_once = PTHREAD_ONCE_INIT;
+static uint8_t g_tokenlog_ring[TOKENLOG_RING_SIZE];
+static size_t g_tokenlog_head = 0;   // 最旧记录的起始偏移（单调递增，取模使用）
+static size_t g_tokenlog_tail = 0;   // 下一条记录的写入偏移（单调递增，取模使用）
+
+static size_t put_varint(uint8_t *out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+// fw_daemon 在多线程进程中 fork 后子进程继续写日志，
+// fork 期间持有锁，保证子进程中的锁和缓冲区处于一致状态
+static void tokenlog_atfork_prepare() {
+    pthread_mutex_lock(&g_tokenlog_lock);
+}
+
+static void tokenlog_atfork_release() {
+    pthread_mutex_unlock(&g_tokenlog_lock);
+}
+
+static void tokenlog_register_atfork() {
+    pthread_atfork(tokenlog_atfork_prepare, tokenlog_atfork_release, tokenlog_atfork_release);
+}
+
+static uint8_t ring_at(size_t offset) {
+    return g_tokenlog_ring[offset % TOKENLOG_RING_SIZE];
+}
+
+/**
+ * 读取 offset 处记录的总长度（含长度前缀）
+ */
+static size_t ring_record_size(size_t offset) {
+    uint64_t length = 0;
+    size_t prefix = 0;
+    uint8_t byte;
+    do {
+        byte = ring_at(offset + prefix);
+        length |= static_cast<uint64_t>(byte & 0x7f) << (7 * prefix);
+        prefix++;
+    } while ((byte & 0x80) != 0 && prefix < 3);
+    return prefix + static_cast<size_t>(length);
+}
+
+static void ring_copy_in(size_t offset, const uint8_t *data, size_t size) {
+    size_t start = offset % TOKENLOG_RING_SIZE;
+    size_t first = TOKENLOG_RING_SIZE - start;
+    if (first > size) first = size;
+    memcpy(g_tokenlog_ring + start, data, first);
+    if (size > first) {
+        memcpy(g_tokenlog_ring, data + first, size - first);
+    }
+}
+
+extern "C" void fw_tokenlog_write(int level, uint32_t tag_token, uint32_t format_token,
+                                  const uint8_t *args, size_t args_size) {
+    uint8_t header[TOKENLOG_MAX_HEADER];
+    uint8_t *p = header + 3;    // 预留长度前缀
+
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    uint64_t timestamp_us = static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+
+    *p++ = static_cast<uint8_t>(level);
+    put_u32(p, tag_token);
+    p += 4;
+    put_u32(p, format_token);
+    p += 4;
+    p += put_varint(p, timestamp_us);
+    p += put_varint(p, static_cast<uint64_t>(gettid()));
+
+    size_t body_size = (p - (header + 3)) + args_size;
+    uint8_t prefix[3];
+    size_t prefix_size = put_varint(prefix, body_size);
+    uint8_t *record = header + 3 - prefix_size;
+    memcpy(record, prefix, prefix_size);
+    size_t header_size = p - record;
+    size_t record_size = header_size + args_size;
+
+    pthread_once(&g_tokenlog_atfork_once, tokenlog_register_atfork);
+    pthread_mutex_lock(&g_tokenlog_lock);
+    // 丢弃最旧的记录直到放得下
+    while (g_tokenlog_tail + record_size - g_tokenlog_head > TOKENLOG_RING_SIZE) {
+        g_tokenlog_head += ring_record_size(g_tokenlog_head);
+    }
+    ring_copy_in(g_tokenlog_tail, record, header_size);
+    ring_copy_in(g_tokenlog_tail + header_size, args, args_size);
+    g_tokenlog_tail += record_size;
+    pthread_mutex_unlock(&g_tokenlog_lock);
+}
+
+static bool write_full(int fd, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+extern "C" bool fw_tokenlog_dump(const char *path) {
+    if (path == nullptr) return false;
+
+    // 先在锁内复制出线性快照，再写文件，避免持锁做 I/O
+    static uint8_t snapshot[TOKENLOG_RING_SIZE];
+    static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&snapshot_lock);
+    pthread_mutex_lock(&g_tokenlog_lock);
+    size_t size = g_tokenlog_tail - g_tokenlog_head;
+    for (size_t i = 0; i < size; i++) {
+        snapshot[i] = ring_at(g_tokenlog_head + i);
+    }
+    pthread_mutex_unlock(&g_tokenlog_lock);
+
+    bool ok = false;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+        uint8_t header[8];
+        memcpy(header, TOKENLOG_FILE_MAGIC, 4);
+        put_u32(header + 4, TOKENLOG_FILE_VERSION);
+        ok = write_full(fd, header, sizeof(header)) && write_full(fd, snapshot, size);
+        close(fd);
+    }
+    pthread_mutex_unlock(&snapshot_lock);
+
+    if (!ok) {
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "导出令牌化日志失败: %s", path);
+    }
+    return ok;
+}
+
+extern "C" bool fw_tokenlog_enabled() {
+#ifdef FW_TOKENIZED_LOG
+    return true;
+#else
+    return false;
+#endif
+}
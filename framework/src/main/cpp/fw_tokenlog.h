@@ -0,0 +1,191 @@
+/**
+ * ============================================================================
+ * fw_tokenlog.h - 令牌化二进制日志
+ * ============================================================================
+ *
+ * 功能简介：
+ *   各文件的 LOGx 宏统一通过 FW_LOG 输出：
+ *   - 默认：直接调用 __android_log_print，行为与原来一致
+ *   - 定义 FW_TOKENIZED_LOG（CMake 选项 -DFW_TOKENIZED_LOG=ON）时：
+ *     格式字符串在编译期哈希为 32 位令牌（FNV-1a，constexpr），
+ *     运行时只把 令牌 + 参数原始字节 写入进程内的二进制环形缓冲区，
+ *     不做格式化，也不发送到 logd
+ *
+ * 记录格式（小端）：
+ *   varint 记录长度 | u8 级别 | u32 标签令牌 | u32 格式令牌 |
+ *   varint 时间戳(us, CLOCK_BOOTTIME) | varint 线程 ID | 参数...
+ *
+ * 参数编码（按实参类型）：
+ *   - 整数 / 枚举 / bool / 指针：转为 int64 后 zigzag varint
+ *   - 浮点：8 字节 double
+ *   - 字符串（char* / const char*）：varint 长度 + 字节（最长 255）
+ *
+ * 字符串表：
+ *   格式字符串和标签以 NUL 结尾写入 fw_tokens 段，运行时不引用。
+ *   主机端工具 tools/fw_tokenlog.py 从未 strip 的 .so 中提取该段生成字符串表，
+ *   再把 fw_tokenlog_dump 导出的二进制日志还原为文本。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_TOKENLOG_H
+#define FW_TOKENLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <android/log.h>
+
+#include "fw_module.h"
+
+// 单条记录中参数部分的最大字节数
+#define FW_TOKENLOG_MAX_ARGS_SIZE 512
+
+// 单个字符串参数的最大字节数
+#define FW_TOKENLOG_MAX_STRING 255
+
+extern "C" {
+
+/**
+ * 写入一条记录（由 FW_LOG 宏调用）
+ */
+FW_EXPORT void fw_tokenlog_write(int level, uint32_t tag_token, uint32_t format_token,
+                                 const uint8_t *args, size_t args_size);
+
+/**
+ * 将环形缓冲区中的记录（从旧到新）写入文件
+ *
+ * 文件格式："FWTL" | u32 版本 | 记录...
+ *
+ * @return 是否成功
+ */
+FW_EXPORT bool fw_tokenlog_dump(const char *path);
+
+/**
+ * 是否以令牌化模式编译
+ */
+FW_EXPORT bool fw_tokenlog_enabled();
+
+}
+
+namespace fw {
+namespace tokenlog {
+
+/**
+ * FNV-1a 32 位哈希（编译期求值）
+ */
+constexpr uint32_t hash(const char *str) {
+    uint32_t h = 2166136261u;
+    while (*str != '\0') {
+        h ^= static_cast<uint8_t>(*str++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * 参数编码器（写入栈上缓冲区）
+ */
+class Encoder {
+public:
+    Encoder(uint8_t *buffer, size_t capacity) : mPos(buffer), mEnd(buffer + capacity) {}
+
+    void putVarint(uint64_t value) {
+        while (value >= 0x80 && mPos < mEnd) {
+            *mPos++ = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        if (mPos < mEnd) *mPos++ = static_cast<uint8_t>(value);
+    }
+
+    void putSigned(int64_t value) {
+        putVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void putDouble(double value) {
+        if (mEnd - mPos < static_cast<ptrdiff_t>(sizeof(value))) {
+            mPos = mEnd;
+            return;
+        }
+        memcpy(mPos, &value, sizeof(value));
+        mPos += sizeof(value);
+    }
+
+    void putString(const char *str) {
+        if (str == nullptr) str = "(null)";
+        size_t len = strnlen(str, FW_TOKENLOG_MAX_STRING);
+        putVarint(len);
+        if (static_cast<size_t>(mEnd - mPos) < len) len = mEnd - mPos;
+        memcpy(mPos, str, len);
+        mPos += len;
+    }
+
+    uint8_t *position() const { return mPos; }
+
+private:
+    uint8_t *mPos;
+    uint8_t *mEnd;
+};
+
+template<typename T>
+inline void encode(Encoder &encoder, T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+        encoder.putDouble(static_cast<double>(value));
+    } else if constexpr (std::is_same<T, const char *>::value || std::is_same<T, char *>::value) {
+        encoder.putString(value);
+    } else if constexpr (std::is_pointer<T>::value) {
+        encoder.putSigned(static_cast<int64_t>(reinterpret_cast<uintptr_t>(value)));
+    } else if constexpr (std::is_enum<T>::value) {
+        encoder.putSigned(static_cast<int64_t>(value));
+    } else {
+        static_assert(std::is_integral<T>::value, "不支持的日志参数类型");
+        encoder.putSigned(static_cast<int64_t>(value));
+    }
+}
+
+template<typename... Args>
+inline void write(int level, uint32_t tagToken, uint32_t formatToken, Args... args) {
+    uint8_t buffer[FW_TOKENLOG_MAX_ARGS_SIZE];
+    Encoder encoder(buffer, sizeof(buffer));
+    (encode(encoder, args), ...);
+    fw_tokenlog_write(level, tagToken, formatToken, buffer, encoder.position() - buffer);
+}
+
+} // namespace tokenlog
+} // namespace fw
+
+#ifdef FW_TOKENIZED_LOG
+
+#if defined(__has_attribute)
+#if __has_attribute(retain)
+#define FW_TOKEN_RETAIN __attribute__((retain))
+#endif
+#endif
+#ifndef FW_TOKEN_RETAIN
+#define FW_TOKEN_RETAIN
+#endif
+
+// 字符串表条目：只用于主机端生成字符串表，运行时不引用
+#define FW_TOKEN_STRING(name, str) \
+    static const char name[] __attribute__((section("fw_tokens"), used, aligned(1))) \
+            FW_TOKEN_RETAIN = str
+
+#define FW_LOG(level, tag, format, ...) \
+    do { \
+        FW_TOKEN_STRING(_fw_token_tag, tag); \
+        FW_TOKEN_STRING(_fw_token_format, format); \
+        constexpr uint32_t _fw_tag_token = fw::tokenlog::hash(tag); \
+        constexpr uint32_t _fw_format_token = fw::tokenlog::hash(format); \
+        fw::tokenlog::write(level, _fw_tag_token, _fw_format_token, ##__VA_ARGS__); \
+    } while (0)
+
+#else
+
+#define FW_LOG(level, tag, ...) __android_log_print(level, tag, __VA_ARGS__)
+
+#endif // FW_TOKENIZED_LOG
+
+#endif // FW_TOKENLOG_H
@@ -0,0 +1,315 @@
+/**
+ * ============================================================================
+ * fw_wakeup.cpp - Native 唤醒归因统计实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   计数全部为原子操作，不加锁。每个线程记住最近一次醒来的组件和当时的
+ *   线程 CPU 时间（CLOCK_THREAD_CPUTIME_ID），下一次进入阻塞时把这段 CPU 时间
+ *   记到该组件上。schedstat 只在输出报告时读取，不增加阻塞调用点的开销。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_wakeup.h"
+
+#include <atomic>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REASON_COUNT 4
+
+struct WakeupComponent {
+    std::atomic<bool> used;
+    char name[FW_WAKEUP_NAME_LEN];
+    std::atomic<int64_t> start_ns;
+    std::atomic<uint64_t> reasons[REASON_COUNT];
+    std::atomic<int64_t> blocked_ns;
+    std::atomic<int64_t> cpu_ns;
+    std::atomic<pid_t> tids[FW_WAKEUP_MAX_THREADS];
+};
+
+/**
+ * 本线程最近一次醒来的组件
+ */
+struct ThreadWake {
+    int id = -1;
+    uint32_t epoch = 0;
+    int64_t cpu_ns = 0;
+};
+
+static pthread_mutex_t g_register_lock = PTHREAD_MUTEX_INITIALIZER;
+static WakeupComponent g_components[FW_WAKEUP_MAX_COMPONENTS];
+static std::atomic<uint32_t> g_epoch{0};        // fork 后加 1，使线程记录的醒来状态作废
+static pthread_once_t g_init_once = PTHREAD_ONCE_INIT;
+
+static thread_local ThreadWake t_last;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t thread_cpu_ns() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void reset_component(WakeupComponent &component, int64_t now) {
+    component.start_ns.store(now, std::memory_order_relaxed);
+    for (auto &reason : component.reasons) reason.store(0, std::memory_order_relaxed);
+    component.blocked_ns.store(0, std::memory_order_relaxed);
+    component.cpu_ns.store(0, std::memory_order_relaxed);
+    for (auto &tid : component.tids) tid.store(0, std::memory_order_relaxed);
+}
+
+// ==================== fork 处理 ====================
+
+static void atfork_prepare() {
+    pthread_mutex_lock(&g_register_lock);
+}
+
+static void atfork_parent() {
+    pthread_mutex_unlock(&g_register_lock);
+}
+
+/**
+ * 父进程的线程不存在于子进程，统计从 fork 开始重新计算
+ */
+static void atfork_child() {
+    g_epoch.fetch_add(1, std::memory_order_relaxed);
+    const int64_t now = monotonic_ns();
+    for (WakeupComponent &component : g_components) reset_component(component, now);
+    pthread_mutex_unlock(&g_register_lock);
+}
+
+static void init_once() {
+    pthread_atfork(atfork_prepare, atfork_parent, atfork_child);
+}
+
+// ==================== 登记与记录 ====================
+
+extern "C" int fw_wakeup_register(const char *component) {
+    if (component == nullptr) return -1;
+    pthread_once(&g_init_once, init_once);
+
+    pthread_mutex_lock(&g_register_lock);
+    int id = -1;
+    for (int i = 0; i < FW_WAKEUP_MAX_COMPONENTS; i++) {
+        WakeupComponent &slot = g_components[i];
+        if (slot.used.load(std::memory_order_relaxed)) {
+            if (strcmp(slot.name, component) == 0) {
+                id = i;
+                break;
+            }
+        } else if (id < 0) {
+            id = i;
+        }
+    }
+    if (id >= 0 && !g_components[id].used.load(std::memory_order_relaxed)) {
+        WakeupComponent &slot = g_components[id];
+        strlcpy(slot.name, component, sizeof(slot.name));
+        reset_component(slot, monotonic_ns());
+        slot.used.store(true, std::memory_order_release);
+    }
+    pthread_mutex_unlock(&g_register_lock);
+    return id;
+}
+
+static bool valid_id(int id) {
+    return id >= 0 && id < FW_WAKEUP_MAX_COMPONENTS &&
+           g_components[id].used.load(std::memory_order_acquire);
+}
+
+/**
+ * 记录组件使用的线程（已满时不再记录）
+ */
+static void note_thread(WakeupComponent &component, pid_t tid) {
+    for (auto &slot : component.tids) {
+        pid_t current = slot.load(std::memory_order_relaxed);
+        if (current == tid) return;
+        if (current == 0 && slot.compare_exchange_strong(current, tid, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+extern "C" int64_t fw_wakeup_begin(int id) {
+    // 上一次醒来之后的 CPU 时间记到醒来的组件上（不一定是本组件）
+    if (t_last.id >= 0 && t_last.epoch == g_epoch.load(std::memory_order_relaxed)) {
+        const int64_t cpu = thread_cpu_ns() - t_last.cpu_ns;
+        if (cpu > 0) g_components[t_last.id].cpu_ns.fetch_add(cpu, std::memory_order_relaxed);
+    }
+    t_last.id = -1;
+    return valid_id(id) ? monotonic_ns() : 0;
+}
+
+extern "C" void fw_wakeup_end(int id, int reason, int64_t begin_ns) {
+    if (begin_ns == 0 || !valid_id(id) || reason < 0 || reason >= REASON_COUNT) return;
+    WakeupComponent &component = g_components[id];
+    component.reasons[reason].fetch_add(1, std::memory_order_relaxed);
+    component.blocked_ns.fetch_add(monotonic_ns() - begin_ns, std::memory_order_relaxed);
+    note_thread(component, gettid());
+
+    t_last.id = id;
+    t_last.epoch = g_epoch.load(std::memory_order_relaxed);
+    t_last.cpu_ns = thread_cpu_ns();
+}
+
+// ==================== 包装函数 ====================
+
+/**
+ * 按返回值记录醒来原因，保持原调用的 errno
+ */
+static int finish(int id, int64_t begin_ns, int ret) {
+    const int saved_errno = errno;
+    int reason = ret > 0 ? FW_WAKEUP_EVENT : ret == 0 ? FW_WAKEUP_TIMEOUT
+               : saved_errno == EINTR ? FW_WAKEUP_INTERRUPTED : FW_WAKEUP_ERROR;
+    fw_wakeup_end(id, reason, begin_ns);
+    errno = saved_errno;
+    return ret;
+}
+
+extern "C" int fw_wakeup_select(int id, int nfds, fd_set *readfds, fd_set *writefds,
+                                fd_set *exceptfds, struct timeval *timeout) {
+    const int64_t begin = fw_wakeup_begin(id);
+    return finish(id, begin, select(nfds, readfds, writefds, exceptfds, timeout));
+}
+
+extern "C" int fw_wakeup_poll(int id, struct pollfd *fds, nfds_t nfds, int timeout_ms) {
+    const int64_t begin = fw_wakeup_begin(id);
+    return finish(id, begin, poll(fds, nfds, timeout_ms));
+}
+
+extern "C" int fw_wakeup_epoll_wait(int id, int epfd, struct epoll_event *events,
+                                    int max_events, int timeout_ms) {
+    const int64_t begin = fw_wakeup_begin(id);
+    return finish(id, begin, epoll_wait(epfd, events, max_events, timeout_ms));
+}
+
+extern "C" void fw_wakeup_sleep_ms(int id, int64_t ms) {
+    if (ms <= 0) return;
+    struct timespec request;
+    request.tv_sec = ms / 1000;
+    request.tv_nsec = (ms % 1000) * 1000000L;
+    for (;;) {
+        struct timespec remaining;
+        const int64_t begin = fw_wakeup_begin(id);
+        int ret = nanosleep(&request, &remaining);
+        finish(id, begin, ret);
+        if (ret == 0 || errno != EINTR) break;
+        request = remaining;
+    }
+}
+
+// ==================== 统计 ====================
+
+extern "C" bool fw_wakeup_get_stats(int id, fw_wakeup_stats *stats) {
+    if (!valid_id(id) || stats == nullptr) return false;
+    const WakeupComponent &component = g_components[id];
+    stats->timeouts = component.reasons[FW_WAKEUP_TIMEOUT].load(std::memory_order_relaxed);
+    stats->events = component.reasons[FW_WAKEUP_EVENT].load(std::memory_order_relaxed);
+    stats->interrupted = component.reasons[FW_WAKEUP_INTERRUPTED].load(std::memory_order_relaxed);
+    stats->errors = component.reasons[FW_WAKEUP_ERROR].load(std::memory_order_relaxed);
+    stats->wakeups = stats->timeouts + stats->events + stats->interrupted + stats->errors;
+    stats->blocked_ns = component.blocked_ns.load(std::memory_order_relaxed);
+    stats->cpu_ns = component.cpu_ns.load(std::memory_order_relaxed);
+    stats->elapsed_ns = monotonic_ns() - component.start_ns.load(std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * 读取线程的 schedstat：运行时间、运行队列等待时间（纳秒）、调度次数
+ */
+static bool read_schedstat(pid_t tid, unsigned long long *run_ns,
+                           unsigned long long *wait_ns, unsigned long long *slices) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/schedstat", tid);
+    FILE *fp = fopen(path, "re");
+    if (fp == nullptr) return false;
+    bool ok = fscanf(fp, "%llu %llu %llu", run_ns, wait_ns, slices) == 3;
+    fclose(fp);
+    return ok;
+}
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...)
+        __attribute__((format(printf, 4, 5)));
+
+static void append(char *buffer, size_t size, size_t *used, const char *format, ...) {
+    if (*used >= size) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + *used, size - *used, format, args);
+    va_end(args);
+    if (n > 0) *used += ((size_t) n < size - *used) ? (size_t) n : size - *used - 1;
+}
+
+static double per_minute(uint64_t count, int64_t elapsed_ns) {
+    return elapsed_ns > 0 ? (double) count * 60e9 / (double) elapsed_ns : 0.0;
+}
+
+extern "C" size_t fw_wakeup_dump(char *buffer, size_t size) {
+    if (buffer == nullptr || size == 0) return 0;
+    buffer[0] = '\0';
+    size_t used = 0;
+
+    uint64_t attributed = 0;
+    for (int i = 0; i < FW_WAKEUP_MAX_COMPONENTS; i++) {
+        fw_wakeup_stats stats;
+        if (!fw_wakeup_get_stats(i, &stats)) continue;
+        attributed += stats.wakeups;
+        append(buffer, size, &used,
+               "%s wakeups=%llu per_min=%.1f idle_per_min=%.1f timeouts=%llu events=%llu "
+               "eintr=%llu errors=%llu avg_block=%lldms cpu_per_wake=%lldus\n",
+               g_components[i].name, (unsigned long long) stats.wakeups,
+               per_minute(stats.wakeups, stats.elapsed_ns),
+               per_minute(stats.timeouts, stats.elapsed_ns),
+               (unsigned long long) stats.timeouts, (unsigned long long) stats.events,
+               (unsigned long long) stats.interrupted, (unsigned long long) stats.errors,
+               stats.wakeups > 0 ? (long long) (stats.blocked_ns / 1000000 / (int64_t) stats.wakeups) : 0LL,
+               stats.wakeups > 0 ? (long long) (stats.cpu_ns / 1000 / (int64_t) stats.wakeups) : 0LL);
+
+        for (const auto &slot : g_components[i].tids) {
+            const pid_t tid = slot.load(std::memory_order_relaxed);
+            if (tid == 0) continue;
+            unsigned long long run_ns, wait_ns, slices;
+            if (read_schedstat(tid, &run_ns, &wait_ns, &slices)) {
+                append(buffer, size, &used, "  tid=%d run=%llums runq_wait=%llums slices=%llu\n",
+                       tid, run_ns / 1000000, wait_ns / 1000000, slices);
+            } else {
+                append(buffer, size, &used, "  tid=%d exited\n", tid);
+            }
+        }
+    }
+
+    // 进程所有线程的调度次数，与已归因的唤醒次数对照可看出未包装的唤醒来源
+    unsigned long long total_slices = 0;
+    int threads = 0;
+    DIR *dir = opendir("/proc/self/task");
+    if (dir != nullptr) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+            unsigned long long run_ns, wait_ns, slices;
+            if (read_schedstat((pid_t) atoi(entry->d_name), &run_ns, &wait_ns, &slices)) {
+                total_slices += slices;
+                threads++;
+            }
+        }
+        closedir(dir);
+    }
+    append(buffer, size, &used, "process threads=%d slices=%llu attributed_wakeups=%llu\n",
+           threads, total_slices, (unsigned long long) attributed);
+    return used;
+}
@@ -0,0 +1,117 @@
+/**
+ * ============================================================================
+ * fw_wakeup.h - Native 唤醒归因统计
+ * ============================================================================
+ *
+ * 功能简介：
+ *   守护进程主循环的 usleep、Socket 服务 1 秒的 select 超时、心跳客户端的等待
+ *   都会周期性唤醒 CPU，此前无法区分哪个循环造成了多少次唤醒。
+ *
+ *   - 每个阻塞调用点通过 fw_wakeup_* 包装函数（或 begin / end）调用，
+ *     按组件记录每次醒来的原因：超时、事件、被信号中断、出错
+ *   - 记录阻塞时间，以及从醒来到下一次阻塞之间本线程消耗的 CPU 时间
+ *   - 记录每个组件使用过的线程，报告时读取 /proc/self/task/<tid>/schedstat
+ *     （运行时间、在运行队列中等待的时间、调度次数）与唤醒次数对照
+ *   - 报告按组件给出每分钟唤醒次数和其中的空闲（超时）唤醒次数
+ *
+ *   超时唤醒没有处理任何事件，是优先去除的对象。
+ *
+ * fork：
+ *   子进程中所有组件的统计清零（登记保留），统计时间从 fork 开始计算。
+ *
+ * 加载方式：
+ *   代码位于按需加载的 libfw_diag.so（见 fw_diag.h）。模块加载前 fw_wakeup_register
+ *   返回 -1，包装函数直接调用对应的系统调用、不做统计；
+ *   模块加载前登记的组件（ID 为 -1）不会被统计。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_WAKEUP_H
+#define FW_WAKEUP_H
+
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/select.h>
+
+#include "fw_module.h"
+
+#define FW_WAKEUP_MAX_COMPONENTS    16
+#define FW_WAKEUP_NAME_LEN          24
+#define FW_WAKEUP_MAX_THREADS       4       // 每个组件记录的线程数
+
+// 醒来原因
+#define FW_WAKEUP_TIMEOUT           0       // 等待超时 / 睡眠到期
+#define FW_WAKEUP_EVENT             1       // 有事件就绪
+#define FW_WAKEUP_INTERRUPTED       2       // 被信号中断（EINTR）
+#define FW_WAKEUP_ERROR             3
+
+struct fw_wakeup_stats {
+    uint64_t wakeups;
+    uint64_t timeouts;
+    uint64_t events;
+    uint64_t interrupted;
+    uint64_t errors;
+    int64_t blocked_ns;         // 阻塞总时间
+    int64_t cpu_ns;             // 醒来到下一次阻塞之间的线程 CPU 时间
+    int64_t elapsed_ns;         // 统计时长（登记或 fork 至今）
+};
+
+extern "C" {
+
+/**
+ * 登记组件，同名组件返回同一 ID
+ *
+ * @return 组件 ID，登记表已满返回 -1（此时包装函数只做原调用）
+ */
+FW_MODULE_API int fw_wakeup_register(const char *component);
+
+/**
+ * 阻塞前调用：结算上一次醒来之后本线程的 CPU 时间
+ *
+ * @return 开始时间，传给 fw_wakeup_end
+ */
+FW_MODULE_API int64_t fw_wakeup_begin(int id);
+
+/**
+ * 醒来后调用：记录原因（FW_WAKEUP_*）和阻塞时间
+ */
+FW_MODULE_API void fw_wakeup_end(int id, int reason, int64_t begin_ns);
+
+// ==================== 包装函数 ====================
+// 返回值与 errno 与原调用相同
+
+FW_MODULE_API int fw_wakeup_select(int id, int nfds, fd_set *readfds, fd_set *writefds,
+                                   fd_set *exceptfds, struct timeval *timeout);
+FW_MODULE_API int fw_wakeup_poll(int id, struct pollfd *fds, nfds_t nfds, int timeout_ms);
+FW_MODULE_API int fw_wakeup_epoll_wait(int id, int epfd, struct epoll_event *events,
+                                       int max_events, int timeout_ms);
+
+/**
+ * 睡眠指定毫秒数（被信号中断时记录一次 INTERRUPTED 后继续睡完剩余时间）
+ */
+FW_MODULE_API void fw_wakeup_sleep_ms(int id, int64_t ms);
+
+/**
+ * 获取组件统计
+ */
+FW_MODULE_API bool fw_wakeup_get_stats(int id, fw_wakeup_stats *stats);
+
+/**
+ * 输出统计：每个组件一行
+ * `<component> wakeups=<n> per_min=<x> idle_per_min=<x> timeouts=<n> events=<n> eintr=<n>
+ *  errors=<n> avg_block=<ms>ms cpu_per_wake=<us>us`，
+ * 之后每个线程一行 `  tid=<tid> run=<ms>ms runq_wait=<ms>ms slices=<n>`（来自 schedstat），
+ * 末行为进程所有线程的调度次数合计与已归因的唤醒次数
+ *
+ * @return 写入的字节数（不含 NUL）
+ */
+FW_MODULE_API size_t fw_wakeup_dump(char *buffer, size_t size);
+
+}
+
+#endif // FW_WAKEUP_H
@@ -0,0 +1,237 @@
+/**
+ * ============================================================================
+ * fw_worker_pool.cpp - Native 工作线程池实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   互斥锁 + 条件变量 + 任务队列。工作线程为分离线程，空闲时在条件变量上
+ *   限时等待，超时且队列为空时退出；销毁时等待最后一个线程退出。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "fw_worker_pool.h"
+
+#include <deque>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <android/log.h>
+#include "fw_thread.h"
+#include "fw_tokenlog.h"
+
+#define LOG_TAG "FwWorkerPool"
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+struct WorkerTask {
+    fw_worker_task task;
+    void *arg;
+};
+
+struct fw_worker_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;       // 有新任务或正在销毁
+    pthread_cond_t exit_cond;       // 最后一个线程退出
+    std::deque<WorkerTask> queue;
+    char name[FW_THREAD_NAME_LEN];
+    char role[FW_THREAD_ROLE_LEN];
+    int max_threads;
+    size_t stack_size;
+    int idle_timeout_ms;
+    int threads = 0;
+    int idle = 0;
+    bool stopping = false;
+    uint64_t spawned = 0;
+    uint64_t completed = 0;
+};
+
+static fw_worker_pool *g_shared_pool = nullptr;
+static pthread_once_t g_shared_once = PTHREAD_ONCE_INIT;
+
+static void init_pool_sync(fw_worker_pool *pool) {
+    pthread_mutex_init(&pool->lock, nullptr);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pool->work_cond, &attr);
+    pthread_cond_init(&pool->exit_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void deadline_after(struct timespec *deadline, int timeout_ms) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (long) (timeout_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+// ==================== 工作线程 ====================
+
+static void *worker_thread(void *arg) {
+    fw_worker_pool *pool = static_cast<fw_worker_pool *>(arg);
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        if (pool->queue.empty()) {
+            if (pool->stopping) break;
+
+            pool->idle++;
+            bool timed_out = false;
+            if (pool->idle_timeout_ms < 0) {
+                pthread_cond_wait(&pool->work_cond, &pool->lock);
+            } else {
+                struct timespec deadline;
+                deadline_after(&deadline, pool->idle_timeout_ms);
+                timed_out = pthread_cond_timedwait(&pool->work_cond, &pool->lock,
+                                                   &deadline) == ETIMEDOUT;
+            }
+            pool->idle--;
+            if (timed_out && pool->queue.empty()) break;
+            continue;
+        }
+
+        WorkerTask task = pool->queue.front();
+        pool->queue.pop_front();
+        pthread_mutex_unlock(&pool->lock);
+
+        task.task(task.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->completed++;
+    }
+
+    pool->threads--;
+    if (pool->threads == 0) {
+        pthread_cond_broadcast(&pool->exit_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return nullptr;
+}
+
+// ==================== 公共接口 ====================
+
+extern "C" fw_worker_pool *fw_worker_pool_create(const char *name, const char *role,
+                                                 int max_threads, size_t stack_size,
+                                                 int idle_timeout_ms) {
+    if (name == nullptr || role == nullptr || max_threads <= 0) return nullptr;
+
+    fw_worker_pool *pool = new fw_worker_pool;
+    init_pool_sync(pool);
+    strlcpy(pool->name, name, sizeof(pool->name));
+    strlcpy(pool->role, role, sizeof(pool->role));
+    pool->max_threads = max_threads;
+    pool->stack_size = stack_size;
+    pool->idle_timeout_ms = idle_timeout_ms;
+    fw_thread_set_role_limit(role, max_threads);
+    return pool;
+}
+
+extern "C" void fw_worker_pool_destroy(fw_worker_pool *pool) {
+    if (pool == nullptr) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    while (pool->threads > 0) {
+        pthread_cond_wait(&pool->exit_cond, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_cond_destroy(&pool->exit_cond);
+    pthread_mutex_destroy(&pool->lock);
+    delete pool;
+}
+
+extern "C" bool fw_worker_pool_submit(fw_worker_pool *pool, fw_worker_task task, void *arg) {
+    if (pool == nullptr || task == nullptr) return false;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->stopping) {
+        pthread_mutex_unlock(&pool->lock);
+        return false;
+    }
+    pool->queue.push_back(WorkerTask{task, arg});
+
+    // 已排队的任务数不超过空闲线程数时，唤醒一个空闲线程即可
+    if (pool->idle >= (int) pool->queue.size()) {
+        pthread_cond_signal(&pool->work_cond);
+        pthread_mutex_unlock(&pool->lock);
+        return true;
+    }
+
+    if (pool->threads < pool->max_threads) {
+        // 线程创建很少发生（空闲线程会被复用），在锁内创建以保证计数一致
+        int ret = fw_thread_create(nullptr, pool->name, pool->role, pool->stack_size, true,
+                                   worker_thread, pool);
+        if (ret == 0) {
+            pool->threads++;
+            pool->spawned++;
+        } else if (pool->threads == 0) {
+            // 没有线程能执行该任务
+            pool->queue.pop_back();
+            pthread_mutex_unlock(&pool->lock);
+            LOGE("线程池 %s 创建线程失败: %s", pool->name, strerror(ret));
+            return false;
+        } else {
+            LOGW("线程池 %s 创建线程失败，任务排队: %s", pool->name, strerror(ret));
+        }
+    }
+    if (pool->idle > 0) {
+        pthread_cond_signal(&pool->work_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+extern "C" void fw_worker_pool_get_stats(fw_worker_pool *pool, fw_worker_pool_stats *stats) {
+    if (pool == nullptr || stats == nullptr) return;
+    pthread_mutex_lock(&pool->lock);
+    stats->threads = pool->threads;
+    stats->idle = pool->idle;
+    stats->queued = (int) pool->queue.size();
+    stats->spawned = pool->spawned;
+    stats->completed = pool->completed;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// ==================== 共享池 ====================
+
+static void shared_pool_atfork_prepare() {
+    pthread_mutex_lock(&g_shared_pool->lock);
+}
+
+static void shared_pool_atfork_parent() {
+    pthread_mutex_unlock(&g_shared_pool->lock);
+}
+
+/**
+ * 子进程中没有工作线程，重置计数，已排队的任务丢弃（由父进程执行）
+ */
+static void shared_pool_atfork_child() {
+    g_shared_pool->queue.clear();
+    g_shared_pool->threads = 0;
+    g_shared_pool->idle = 0;
+    init_pool_sync(g_shared_pool);
+}
+
+static void create_shared_pool() {
+    g_shared_pool = fw_worker_pool_create("fw_worker", "worker_pool",
+                                          FW_WORKER_POOL_SHARED_THREADS,
+                                          FW_THREAD_STACK_MEDIUM,
+                                          FW_WORKER_POOL_SHARED_IDLE_MS);
+    pthread_atfork(shared_pool_atfork_prepare, shared_pool_atfork_parent,
+                   shared_pool_atfork_child);
+}
+
+extern "C" fw_worker_pool *fw_worker_pool_shared() {
+    pthread_once(&g_shared_once, create_shared_pool);
+    return g_shared_pool;
+}
@@ -0,0 +1,88 @@
+/**
+ * ============================================================================
+ * fw_worker_pool.h - Native 工作线程池
+ * ============================================================================
+ *
+ * 功能简介：
+ *   短时 Native 任务提交到线程池执行，复用空闲线程，避免每次 pthread_create
+ *   的开销以及默认属性下每个线程预留 1MB 左右的栈。
+ *
+ *   - 线程按需创建，数量不超过 max_threads；空闲超过 idle_timeout_ms 的线程退出
+ *   - 每个池使用显式的栈大小（见 fw_thread.h 中的 FW_THREAD_STACK_*），
+ *     栈底带一页保护页，溢出时立即崩溃而不是破坏相邻内存
+ *   - 线程通过 fw_thread_create 创建并登记，角色上限为 max_threads
+ *
+ *   任务不能无限期阻塞，否则会长期占用一个线程，池中可用于短任务的线程随之减少；
+ *   长期运行的循环（如 Socket 服务）应使用 fw_thread_create 创建独立线程。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef FW_WORKER_POOL_H
+#define FW_WORKER_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fw_module.h"
+
+// 共享池配置
+#define FW_WORKER_POOL_SHARED_THREADS   4
+#define FW_WORKER_POOL_SHARED_IDLE_MS   30000
+
+struct fw_worker_pool;
+
+typedef void (*fw_worker_task)(void *arg);
+
+struct fw_worker_pool_stats {
+    int threads;            // 当前线程数
+    int idle;               // 其中空闲的线程数
+    int queued;             // 等待执行的任务数
+    uint64_t spawned;       // 累计创建的线程数
+    uint64_t completed;     // 累计完成的任务数
+};
+
+extern "C" {
+
+/**
+ * 创建线程池（不预先创建线程）
+ *
+ * @param name            线程名（"fw_" 开头，同一池的线程同名）
+ * @param role            fw_thread 登记角色
+ * @param max_threads     线程数上限
+ * @param stack_size      每个线程的栈大小
+ * @param idle_timeout_ms 空闲线程退出前的等待时间，< 0 表示不退出
+ */
+FW_EXPORT fw_worker_pool *fw_worker_pool_create(const char *name, const char *role,
+                                                int max_threads, size_t stack_size,
+                                                int idle_timeout_ms);
+
+/**
+ * 执行完已提交的任务后销毁线程池
+ */
+FW_EXPORT void fw_worker_pool_destroy(fw_worker_pool *pool);
+
+/**
+ * 提交任务
+ *
+ * 有空闲线程时直接唤醒，否则在未达上限时创建新线程，都不满足时排队
+ *
+ * @return 池正在销毁或内存不足返回 false
+ */
+FW_EXPORT bool fw_worker_pool_submit(fw_worker_pool *pool, fw_worker_task task, void *arg);
+
+/**
+ * 获取统计信息
+ */
+FW_EXPORT void fw_worker_pool_get_stats(fw_worker_pool *pool, fw_worker_pool_stats *stats);
+
+/**
+ * 进程共享的线程池（首次调用时创建，不销毁）
+ */
+FW_EXPORT fw_worker_pool *fw_worker_pool_shared();
+
+}
+
+#endif // FW_WORKER_POOL_H
@@ -11,7 +11,7 @@
  *
  * 核心机制：
  *   - 通过 JNI 与 Java 层交互
- *   - 记录服务启停状态
+ *   - 记录服务启停状态，并发布到 fw_native 的事件总线（fw_event_bus.h）
  *   - 提供底层心跳机制
  *
  * @author Pangu-Immortal
@@ -21,16 +21,18 @@
 
 #include <jni.h>
 #include <android/log.h>
-#include <string>
+#include "../fw_tokenlog.h"
+#include "../fw_event_bus.h"
+#include <cstring>
 #include <ctime>
 #include <atomic>
 
 // 日志标签
 #define TAG "FwMediaRouteNative"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGD(...) FW_LOG(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+#define LOGI(...) FW_LOG(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGW(...) FW_LOG(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+#define LOGE(...) FW_LOG(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 
 // 命名空间
 namespace fw {
@@ -42,9 +44,10 @@ struct ServiceState {
     std::atomic<bool> isService2Running{false};   // MediaRoute2ProviderService 运行状态
     std::atomic<long> lastHeartbeatTime{0};       // 上次心跳时间戳
     std::atomic<int> heartbeatCount{0};           // 心跳计数
-    std::string packageName;                       // 应用包名
-    std::string service1Name;                      // 服务1类名
-    std::string service2Name;                      // 服务2类名
+    // 使用定长数组而非 std::string，避免全局构造/析构函数拖慢 dlopen
+    char packageName[256] = {};                   // 应用包名
+    char service1Name[512] = {};                  // 服务1类名
+    char service2Name[512] = {};                  // 服务2类名
 };
 
 // 全局服务状态
@@ -62,6 +65,13 @@ static long getCurrentTimeMs() {
     return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
 }
 
+/**
+ * 发布服务启停事件（fw_native 中的转发接口，没有订阅者时直接丢弃）
+ */
+static void publishServiceEvent(int service, bool running) {
+    fw_event_publish(fw_mediaroute_event{service, running ? 1 : 0});
+}
+
 /**
  * 初始化
  */
@@ -98,13 +108,14 @@ void checkWakeLock() {
 /**
  * 服务1启动通知
  */
-void onServiceStarted(const std::string& packageName, const std::string& serviceName) {
-    LOGI("Service1 started: %s", serviceName.c_str());
+void onServiceStarted(const char* packageName, const char* serviceName) {
+    LOGI("Service1 started: %s", serviceName);
 
     g_serviceState.isService1Running = true;
-    g_serviceState.packageName = packageName;
-    g_serviceState.service1Name = serviceName;
+    strlcpy(g_serviceState.packageName, packageName, sizeof(g_serviceState.packageName));
+    strlcpy(g_serviceState.service1Name, serviceName, sizeof(g_serviceState.service1Name));
     g_serviceState.lastHeartbeatTime = getCurrentTimeMs();
+    publishServiceEvent(1, true);
 }
 
 /**
@@ -113,18 +124,20 @@ void onServiceStarted(const std::string& packageName, const std::string& service
 void onServiceStopped() {
     LOGW("Service1 stopped");
     g_serviceState.isService1Running = false;
+    publishServiceEvent(1, false);
 }
 
 /**
  * 服务2启动通知
  */
-void onService2Started(const std::string& packageName, const std::string& serviceName) {
-    LOGI("Service2 started: %s", serviceName.c_str());
+void onService2Started(const char* packageName, const char* serviceName) {
+    LOGI("Service2 started: %s", serviceName);
 
     g_serviceState.isService2Running = true;
-    g_serviceState.packageName = packageName;
-    g_serviceState.service2Name = serviceName;
+    strlcpy(g_serviceState.packageName, packageName, sizeof(g_serviceState.packageName));
+    strlcpy(g_serviceState.service2Name, serviceName, sizeof(g_serviceState.service2Name));
     g_serviceState.lastHeartbeatTime = getCurrentTimeMs();
+    publishServiceEvent(2, true);
 }
 
 /**
@@ -133,6 +146,7 @@ void onService2Started(const std::string& packageName, const std::string& servic
 void onService2Stopped() {
     LOGW("Service2 stopped");
     g_serviceState.isService2Running = false;
+    publishServiceEvent(2, false);
 }
 
 /**
@@ -225,7 +239,7 @@ Java_com_service_framework_mediaroute_FwMediaRouteNative_nativeOnServiceStarted(
     const char *pkgName = env->GetStringUTFChars(packageName, nullptr);
     const char *svcName = env->GetStringUTFChars(serviceName, nullptr);
 
-    fw::mediaroute::onServiceStarted(std::string(pkgName), std::string(svcName));
+    fw::mediaroute::onServiceStarted(pkgName, svcName);
 
     env->ReleaseStringUTFChars(packageName, pkgName);
     env->ReleaseStringUTFChars(serviceName, svcName);
@@ -253,7 +267,7 @@ Java_com_service_framework_mediaroute_FwMediaRouteNative_nativeOnService2Started
     const char *pkgName = env->GetStringUTFChars(packageName, nullptr);
     const char *svcName = env->GetStringUTFChars(serviceName, nullptr);
 
-    fw::mediaroute::onService2Started(std::string(pkgName), std::string(svcName));
+    fw::mediaroute::onService2Started(pkgName, svcName);
 
     env->ReleaseStringUTFChars(packageName, pkgName);
     env->ReleaseStringUTFChars(serviceName, svcName);
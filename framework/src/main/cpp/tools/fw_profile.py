@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+# ============================================================================
+# fw_profile.py - CPU 采样结果符号化工具
+# ============================================================================
+#
+# 功能简介：
+#   把 fw_profiler_write_folded 输出的 folded 文件中的 `模块+0x偏移` 帧
+#   替换为函数名（见 fw_profiler.h），结果可直接交给 flamegraph.pl 生成火焰图。
+#   在 --libs 目录中找不到的模块（系统库等）保留原样。
+#
+# 用法：
+#   adb shell run-as com.service.framework cat files/fw_profile.folded > fw_profile.folded
+#   fw_profile.py --libs build/intermediates/merged_native_libs/release/out/lib/arm64-v8a \
+#       fw_profile.folded > symbolized.folded
+#   flamegraph.pl symbolized.folded > profile.svg
+#
+#   需要 NDK 中的 llvm-symbolizer（在 PATH 中，或通过 --symbolizer 指定）
+#
+# @author Pangu-Immortal
+# @github https://github.com/Pangu-Immortal/KeepLiveService
+# @since 2.3.0
+# ============================================================================
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+
+FRAME = re.compile(r"^(?P<module>.+)\+0x(?P<offset>[0-9a-fA-F]+)$")
+
+
+def read_folded(path):
+    """读取 folded 文件，返回 [(帧列表, 次数)]"""
+    stacks = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not line:
+                continue
+            stack, _, count = line.rpartition(" ")
+            stacks.append((stack.split(";"), int(count)))
+    return stacks
+
+
+def load_segments(path):
+    """读取 ELF 的 PT_LOAD 段，返回 [(文件偏移, 文件大小, 虚拟地址)]"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF":
+        raise ValueError("%s 不是 ELF 文件" % path)
+
+    is64 = data[4] == 2
+    endian = "<" if data[5] == 1 else ">"
+    if is64:
+        phoff, = struct.unpack_from(endian + "Q", data, 0x20)
+        phentsize, phnum = struct.unpack_from(endian + "HH", data, 0x36)
+    else:
+        phoff, = struct.unpack_from(endian + "I", data, 0x1C)
+        phentsize, phnum = struct.unpack_from(endian + "HH", data, 0x2A)
+
+    segments = []
+    for i in range(phnum):
+        base = phoff + i * phentsize
+        if is64:
+            p_type, _, p_offset, p_vaddr, _, p_filesz = struct.unpack_from(endian + "IIQQQQ",
+                                                                          data, base)
+        else:
+            p_type, p_offset, p_vaddr, _, p_filesz = struct.unpack_from(endian + "IIIII",
+                                                                        data, base)
+        if p_type == 1:  # PT_LOAD
+            segments.append((p_offset, p_filesz, p_vaddr))
+    return segments
+
+
+def offset_to_vaddr(segments, offset):
+    """/proc/self/maps 给出的是文件偏移，llvm-symbolizer 需要虚拟地址"""
+    for p_offset, p_filesz, p_vaddr in segments:
+        if p_offset <= offset < p_offset + p_filesz:
+            return offset - p_offset + p_vaddr
+    return offset
+
+
+def symbolize_module(symbolizer, library, offsets):
+    """一次调用 llvm-symbolizer 符号化同一模块的所有偏移"""
+    segments = load_segments(library)
+    query = "".join("0x%x\n" % offset_to_vaddr(segments, offset) for offset in offsets)
+    result = subprocess.run([symbolizer, "--obj=" + library, "--functions=linkage", "--demangle",
+                             "--no-inlines"],
+                            input=query, capture_output=True, text=True, check=True)
+    # 每个地址输出 函数名、文件:行号 和一个空行
+    blocks = [block.split("\n") for block in result.stdout.strip("\n").split("\n\n")]
+    names = {}
+    for offset, block in zip(offsets, blocks):
+        if block and block[0] and block[0] != "??":
+            names[offset] = block[0]
+    return names
+
+
+def symbolize(stacks, libs_dir, symbolizer):
+    # 按模块收集偏移
+    wanted = {}
+    for frames, _ in stacks:
+        for frame in frames[1:]:
+            match = FRAME.match(frame)
+            if match:
+                wanted.setdefault(match.group("module"), set()).add(int(match.group("offset"), 16))
+
+    names = {}
+    for module, offsets in wanted.items():
+        library = os.path.join(libs_dir, module)
+        if not os.path.isfile(library):
+            continue
+        ordered = sorted(offsets)
+        for offset, name in symbolize_module(symbolizer, library, ordered).items():
+            names[(module, offset)] = name
+
+    def rename(frame):
+        match = FRAME.match(frame)
+        if not match:
+            return frame
+        key = (match.group("module"), int(match.group("offset"), 16))
+        return names.get(key, frame)
+
+    return [([frames[0]] + [rename(frame) for frame in frames[1:]], count)
+            for frames, count in stacks]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="CPU 采样结果符号化")
+    parser.add_argument("--libs", required=True, help="未 strip 的 .so 所在目录")
+    parser.add_argument("--symbolizer", default="llvm-symbolizer", help="llvm-symbolizer 路径")
+    parser.add_argument("folded", help="fw_profiler_write_folded 输出的文件")
+    args = parser.parse_args()
+
+    stacks = symbolize(read_folded(args.folded), args.libs, args.symbolizer)
+    merged = {}
+    for frames, count in stacks:
+        key = ";".join(frames)
+        merged[key] = merged.get(key, 0) + count
+    for key in sorted(merged):
+        sys.stdout.write("%s %d\n" % (key, merged[key]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# ============================================================================
+# fw_tokenlog.py - 令牌化日志主机端工具
+# ============================================================================
+#
+# 功能简介：
+#   配合 FW_TOKENIZED_LOG 构建使用（见 fw_tokenlog.h）：
+#   - table：从未 strip 的 .so 中提取 fw_tokens 段，生成 令牌 -> 字符串 表
+#   - decode：按字符串表将 fw_tokenlog_dump 导出的二进制日志还原为文本
+#
+# 用法：
+#   fw_tokenlog.py table libfw_native.so libfw_binder.so libfw_mediaroute.so -o tokens.csv
+#   adb shell run-as com.service.framework cat files/fw_tokenlog.bin > fw_tokenlog.bin
+#   fw_tokenlog.py decode --table tokens.csv fw_tokenlog.bin
+#
+#   未 strip 的 .so 位于
+#   build/intermediates/merged_native_libs/<variant>/out/lib/<abi>/
+#
+# @author Pangu-Immortal
+# @github https://github.com/Pangu-Immortal/KeepLiveService
+# @since 2.3.0
+# ============================================================================
+
+import argparse
+import csv
+import re
+import struct
+import sys
+
+TOKEN_SECTION = "fw_tokens"
+FILE_MAGIC = b"FWTL"
+FILE_VERSION = 1
+
+LEVEL_NAMES = {2: "V", 3: "D", 4: "I", 5: "W", 6: "E", 7: "F"}
+
+# printf 转换说明
+FORMAT_SPEC = re.compile(r"%[-+ #0]*(\*|\d+)?(\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGaAcspn%])")
+
+
+def fnv1a(data):
+    """FNV-1a 32 位哈希，与 fw::tokenlog::hash 一致"""
+    h = 2166136261
+    for byte in data:
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+# ==================== 字符串表 ====================
+
+def read_section(path, name):
+    """读取 ELF 文件中指定名称的段，不存在返回 None"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF":
+        raise ValueError("%s 不是 ELF 文件" % path)
+
+    is64 = data[4] == 2
+    endian = "<" if data[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", data, 0x3A)
+        header = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", data, 0x2E)
+        header = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(header, data, shoff + i * shentsize) for i in range(shnum)]
+    names_offset = sections[shstrndx][4]
+    for section in sections:
+        start = names_offset + section[0]
+        section_name = data[start:data.index(b"\0", start)].decode()
+        if section_name == name:
+            offset, size = section[4], section[5]
+            return data[offset:offset + size]
+    return None
+
+
+def build_table(libraries):
+    table = {}
+    for path in libraries:
+        section = read_section(path, TOKEN_SECTION)
+        if section is None:
+            print("警告: %s 中没有 %s 段（未使用 FW_TOKENIZED_LOG 构建或已被 strip）"
+                  % (path, TOKEN_SECTION), file=sys.stderr)
+            continue
+        for entry in section.split(b"\0"):
+            if not entry:
+                continue
+            token = fnv1a(entry)
+            text = entry.decode("utf-8", "replace")
+            if token in table and table[token] != text:
+                print("警告: 令牌冲突 %08x: %r / %r" % (token, table[token], text), file=sys.stderr)
+            table[token] = text
+    return table
+
+
+def save_table(table, path):
+    with open(path, "w", newline="", encoding="utf-8") as f:
+        writer = csv.writer(f)
+        for token in sorted(table):
+            writer.writerow(["%08x" % token, table[token]])
+
+
+def load_table(path):
+    with open(path, newline="", encoding="utf-8") as f:
+        return {int(row[0], 16): row[1] for row in csv.reader(f) if row}
+
+
+# ==================== 日志还原 ====================
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def remaining(self):
+        return len(self.data) - self.pos
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return value
+
+    def signed(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def u8(self):
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def u32(self):
+        value, = struct.unpack_from("<I", self.data, self.pos)
+        self.pos += 4
+        return value
+
+    def double(self):
+        value, = struct.unpack_from("<d", self.data, self.pos)
+        self.pos += 8
+        return value
+
+    def string(self):
+        length = self.varint()
+        value = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return value.decode("utf-8", "replace")
+
+
+def format_message(fmt, args):
+    """按格式串依次解码参数并格式化，参数不足时保留原始转换说明"""
+
+    def convert(match):
+        spec = match.group(0)
+        conversion = match.group(5)
+        if conversion == "%":
+            return "%"
+        if args.remaining() <= 0:
+            return spec
+        # 长度修饰符对 Python 无意义，去掉后交给 % 运算符
+        pyspec = re.sub(r"(hh|h|ll|l|j|z|t|L)(?=[a-zA-Z]$)", "", spec)
+        try:
+            if conversion in "eEfFgGaA":
+                value = args.double()
+                if conversion in "aA":
+                    return value.hex()
+                return pyspec % value
+            if conversion == "s":
+                return pyspec % args.string()
+            value = args.signed()
+            if conversion == "p":
+                return "0x%x" % (value & 0xFFFFFFFFFFFFFFFF)
+            if conversion == "c":
+                return chr(value & 0xFF)
+            if conversion in "ouxX" and value < 0:
+                bits = 64 if match.group(4) in ("l", "ll", "j", "z", "t") else 32
+                value &= (1 << bits) - 1
+            if conversion in "iu":
+                pyspec = pyspec[:-1] + "d"
+            if conversion == "n":
+                return ""
+            return pyspec % value
+        except (IndexError, struct.error):
+            return spec
+
+    return FORMAT_SPEC.sub(convert, fmt)
+
+
+def decode(table, path, out):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != FILE_MAGIC:
+        raise ValueError("%s 不是令牌化日志文件" % path)
+    version, = struct.unpack_from("<I", data, 4)
+    if version != FILE_VERSION:
+        raise ValueError("不支持的日志版本 %d" % version)
+
+    reader = Reader(data)
+    reader.pos = 8
+    while reader.remaining() > 0:
+        length = reader.varint()
+        record = Reader(data[reader.pos:reader.pos + length])
+        reader.pos += length
+
+        level = record.u8()
+        tag_token = record.u32()
+        format_token = record.u32()
+        timestamp_us = record.varint()
+        tid = record.varint()
+        args = Reader(record.data[record.pos:])
+
+        tag = table.get(tag_token, "<%08x>" % tag_token)
+        fmt = table.get(format_token)
+        if fmt is None:
+            message = "<未知令牌 %08x> %s" % (format_token, args.data.hex())
+        else:
+            message = format_message(fmt, args)
+        out.write("%6d.%06d %5d %s %s: %s\n" % (timestamp_us // 1000000, timestamp_us % 1000000,
+                                              tid, LEVEL_NAMES.get(level, "?"), tag, message))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="令牌化日志主机端工具")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    table_parser = commands.add_parser("table", help="从 .so 生成字符串表")
+    table_parser.add_argument("libraries", nargs="+", help="未 strip 的 .so 文件")
+    table_parser.add_argument("-o", "--output", required=True, help="输出 CSV 文件")
+
+    decode_parser = commands.add_parser("decode", help="还原二进制日志")
+    decode_parser.add_argument("--table", required=True, help="table 命令生成的 CSV 文件")
+    decode_parser.add_argument("dump", help="fw_tokenlog_dump 导出的文件")
+
+    args = parser.parse_args()
+    if args.command == "table":
+        table = build_table(args.libraries)
+        save_table(table, args.output)
+        print("%d 个字符串 -> %s" % (len(table), args.output))
+    else:
+        decode(load_table(args.table), args.dump, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,250 @@
+/**
+ * ============================================================================
+ * AllocTag.cpp - 按调用路径的内存分配标签实现
+ * ============================================================================
+ *
+ * 功能简介：
+ *   每个线程首次记录时分配一组计数器并挂到全局链表上，记录时只写本线程的
+ *   计数器；快照时加锁遍历链表合并。线程退出时（pthread key 析构）计数器
+ *   并入全局已退出计数后释放。
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#include "AllocTag.h"
+
+#include <atomic>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace android {
+
+    /**
+     * 单个线程的计数器（只有所属线程写入，快照线程读取）
+     */
+    struct ThreadAllocCounters {
+        std::atomic<int64_t> allocBytes[ALLOC_TAG_MAX];
+        std::atomic<int64_t> freeBytes[ALLOC_TAG_MAX];
+        std::atomic<uint64_t> allocCount[ALLOC_TAG_MAX];
+        std::atomic<uint64_t> freeCount[ALLOC_TAG_MAX];
+        std::atomic<int64_t> highWater[ALLOC_TAG_MAX];   // 本线程存活字节数的最高水位
+        ThreadAllocCounters *prev;
+        ThreadAllocCounters *next;
+    };
+
+    static pthread_mutex_t gAllocTagLock = PTHREAD_MUTEX_INITIALIZER;
+    static const char *gAllocTagNames[ALLOC_TAG_MAX] = {"untagged"};
+    static size_t gAllocTagCount = 1;
+
+    // 存活线程的计数器链表
+    static ThreadAllocCounters *gAllocTagThreads = NULL;
+
+    // 已退出线程的合并计数
+    static int64_t gRetiredAllocBytes[ALLOC_TAG_MAX];
+    static int64_t gRetiredFreeBytes[ALLOC_TAG_MAX];
+    static uint64_t gRetiredAllocCount[ALLOC_TAG_MAX];
+    static uint64_t gRetiredFreeCount[ALLOC_TAG_MAX];
+
+    // 已知的峰值（快照观察值与线程最高水位的最大值）
+    static int64_t gAllocTagPeak[ALLOC_TAG_MAX];
+
+    static pthread_once_t gAllocTagKeyOnce = PTHREAD_ONCE_INIT;
+    static pthread_key_t gAllocTagKey;
+
+    static thread_local ThreadAllocCounters *tAllocCounters = NULL;
+    static thread_local alloc_tag_t tAllocTag = 0;
+
+    /**
+     * 单写者递增：只有所属线程写入，无需原子读-改-写
+     */
+    template<typename T>
+    static inline T bump(std::atomic<T> &counter, T delta) {
+        T value = counter.load(std::memory_order_relaxed) + delta;
+        counter.store(value, std::memory_order_relaxed);
+        return value;
+    }
+
+    static void retireThreadCounters(void *arg) {
+        ThreadAllocCounters *counters = static_cast<ThreadAllocCounters *>(arg);
+        if (counters == NULL) return;
+
+        pthread_mutex_lock(&gAllocTagLock);
+        for (size_t i = 0; i < ALLOC_TAG_MAX; i++) {
+            gRetiredAllocBytes[i] += counters->allocBytes[i].load(std::memory_order_relaxed);
+            gRetiredFreeBytes[i] += counters->freeBytes[i].load(std::memory_order_relaxed);
+            gRetiredAllocCount[i] += counters->allocCount[i].load(std::memory_order_relaxed);
+            gRetiredFreeCount[i] += counters->freeCount[i].load(std::memory_order_relaxed);
+            int64_t high = counters->highWater[i].load(std::memory_order_relaxed);
+            if (high > gAllocTagPeak[i]) gAllocTagPeak[i] = high;
+        }
+        if (counters->prev != NULL) {
+            counters->prev->next = counters->next;
+        } else {
+            gAllocTagThreads = counters->next;
+        }
+        if (counters->next != NULL) {
+            counters->next->prev = counters->prev;
+        }
+        pthread_mutex_unlock(&gAllocTagLock);
+
+        tAllocCounters = NULL;
+        delete counters;
+    }
+
+    static void createAllocTagKey() {
+        pthread_key_create(&gAllocTagKey, retireThreadCounters);
+    }
+
+    static ThreadAllocCounters *threadCounters() {
+        ThreadAllocCounters *counters = tAllocCounters;
+        if (counters != NULL) return counters;
+
+        pthread_once(&gAllocTagKeyOnce, createAllocTagKey);
+
+        counters = new ThreadAllocCounters();
+        pthread_mutex_lock(&gAllocTagLock);
+        counters->prev = NULL;
+        counters->next = gAllocTagThreads;
+        if (gAllocTagThreads != NULL) gAllocTagThreads->prev = counters;
+        gAllocTagThreads = counters;
+        pthread_mutex_unlock(&gAllocTagLock);
+
+        pthread_setspecific(gAllocTagKey, counters);
+        tAllocCounters = counters;
+        return counters;
+    }
+
+    alloc_tag_t allocTagRegister(const char *name) {
+        if (name == NULL) return 0;
+
+        pthread_mutex_lock(&gAllocTagLock);
+        alloc_tag_t tag = 0;
+        for (size_t i = 1; i < gAllocTagCount; i++) {
+            if (strcmp(gAllocTagNames[i], name) == 0) {
+                tag = (alloc_tag_t) i;
+                break;
+            }
+        }
+        if (tag == 0 && gAllocTagCount < ALLOC_TAG_MAX) {
+            char *copy = strdup(name);
+            if (copy != NULL) {
+                tag = (alloc_tag_t) gAllocTagCount;
+                gAllocTagNames[gAllocTagCount++] = copy;
+            }
+        }
+        pthread_mutex_unlock(&gAllocTagLock);
+        return tag;
+    }
+
+    alloc_tag_t allocTagCurrent() {
+        return tAllocTag;
+    }
+
+    void allocTagRecordAlloc(alloc_tag_t tag, size_t bytes) {
+        if (tag >= ALLOC_TAG_MAX) tag = 0;
+        ThreadAllocCounters *counters = threadCounters();
+        int64_t allocated = bump<int64_t>(counters->allocBytes[tag], (int64_t) bytes);
+        bump<uint64_t>(counters->allocCount[tag], 1);
+
+        int64_t live = allocated - counters->freeBytes[tag].load(std::memory_order_relaxed);
+        if (live > counters->highWater[tag].load(std::memory_order_relaxed)) {
+            counters->highWater[tag].store(live, std::memory_order_relaxed);
+        }
+    }
+
+    void allocTagRecordFree(alloc_tag_t tag, size_t bytes) {
+        if (tag >= ALLOC_TAG_MAX) tag = 0;
+        ThreadAllocCounters *counters = threadCounters();
+        bump<int64_t>(counters->freeBytes[tag], (int64_t) bytes);
+        bump<uint64_t>(counters->freeCount[tag], 1);
+    }
+
+    void allocTagRecordResize(alloc_tag_t tag, size_t oldBytes, size_t newBytes) {
+        if (tag >= ALLOC_TAG_MAX) tag = 0;
+        ThreadAllocCounters *counters = threadCounters();
+        if (newBytes >= oldBytes) {
+            int64_t allocated = bump<int64_t>(counters->allocBytes[tag],
+                                              (int64_t) (newBytes - oldBytes));
+            int64_t live = allocated - counters->freeBytes[tag].load(std::memory_order_relaxed);
+            if (live > counters->highWater[tag].load(std::memory_order_relaxed)) {
+                counters->highWater[tag].store(live, std::memory_order_relaxed);
+            }
+        } else {
+            bump<int64_t>(counters->freeBytes[tag], (int64_t) (oldBytes - newBytes));
+        }
+    }
+
+    size_t allocTagSnapshot(AllocTagStats *out, size_t maxCount) {
+        size_t count = 0;
+
+        pthread_mutex_lock(&gAllocTagLock);
+        for (size_t i = 0; i < gAllocTagCount && count < maxCount; i++) {
+            int64_t allocBytes = gRetiredAllocBytes[i];
+            int64_t freeBytes = gRetiredFreeBytes[i];
+            uint64_t allocCount = gRetiredAllocCount[i];
+            uint64_t freeCount = gRetiredFreeCount[i];
+            int64_t peak = gAllocTagPeak[i];
+
+            for (ThreadAllocCounters *t = gAllocTagThreads; t != NULL; t = t->next) {
+                allocBytes += t->allocBytes[i].load(std::memory_order_relaxed);
+                freeBytes += t->freeBytes[i].load(std::memory_order_relaxed);
+                allocCount += t->allocCount[i].load(std::memory_order_relaxed);
+                freeCount += t->freeCount[i].load(std::memory_order_relaxed);
+                int64_t high = t->highWater[i].load(std::memory_order_relaxed);
+                if (high > peak) peak = high;
+            }
+
+            int64_t live = allocBytes - freeBytes;
+            if (live > peak) peak = live;
+            gAllocTagPeak[i] = peak;
+
+            if (allocCount == 0) continue;
+            out[count].name = gAllocTagNames[i];
+            out[count].liveBytes = live;
+            out[count].peakBytes = peak;
+            out[count].allocCount = allocCount;
+            out[count].freeCount = freeCount;
+            count++;
+        }
+        pthread_mutex_unlock(&gAllocTagLock);
+        return count;
+    }
+
+    size_t allocTagDump(char *buffer, size_t bufferSize) {
+        if (buffer == NULL || bufferSize == 0) return 0;
+        buffer[0] = '\0';
+
+        AllocTagStats stats[ALLOC_TAG_MAX];
+        size_t count = allocTagSnapshot(stats, ALLOC_TAG_MAX);
+
+        size_t length = 0;
+        for (size_t i = 0; i < count && length < bufferSize; i++) {
+            int n = snprintf(buffer + length, bufferSize - length,
+                             "%s live=%lld peak=%lld allocs=%llu frees=%llu\n",
+                             stats[i].name,
+                             (long long) stats[i].liveBytes, (long long) stats[i].peakBytes,
+                             (unsigned long long) stats[i].allocCount,
+                             (unsigned long long) stats[i].freeCount);
+            if (n < 0) break;
+            length += (size_t) n;
+        }
+        return length < bufferSize ? length : bufferSize - 1;
+    }
+
+    AllocTagScope::AllocTagScope(alloc_tag_t tag) : mPrevious(tAllocTag) {
+        tAllocTag = tag < ALLOC_TAG_MAX ? tag : 0;
+    }
+
+    AllocTagScope::AllocTagScope(const char *name) : mPrevious(tAllocTag) {
+        tAllocTag = allocTagRegister(name);
+    }
+
+    AllocTagScope::~AllocTagScope() {
+        tAllocTag = mPrevious;
+    }
+
+}; // namespace android
@@ -0,0 +1,132 @@
+/**
+ * ============================================================================
+ * AllocTag.h - 按调用路径的内存分配标签
+ * ============================================================================
+ *
+ * 功能简介：
+ *   Parcel::getGlobalAllocSize 只能给出进程级总量。AllocTag 允许在调用路径上
+ *   通过 RAII 作用域设置一个轻量标签（如 "getServiceHandle"），作用域内
+ *   Parcel 和 SharedBuffer 的分配都归属到该标签，按标签统计：
+ *   - 存活字节数 / 峰值字节数
+ *   - 分配次数 / 释放次数
+ *
+ * 实现要点：
+ *   - 标签名只在首次使用时登记（加锁），之后使用数字 id
+ *   - 计数写入线程本地计数器（单写者，relaxed 原子操作），不与其它线程竞争
+ *   - 快照时合并所有线程的计数器；线程退出时计数并入全局已退出计数
+ *   - 分配对象记录自己的标签 id，释放时总是记到分配时的标签上
+ *
+ * 峰值字节数说明：
+ *   线程本地计数无法得到精确的全局峰值，这里取以下两者中的较大值：
+ *   1. 每次快照时观察到的存活字节数
+ *   2. 单个线程内存活字节数的最高水位
+ *   两者都是真实峰值的下界；分配和释放在同一线程的调用路径（Parcel 的典型
+ *   用法）下第 2 项即为精确值。
+ *
+ * 使用方式：
+ *   {
+ *       ALLOC_TAG_SCOPE("getServiceHandle");
+ *       Parcel data;   // 归属到 getServiceHandle
+ *       ...
+ *   }
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+
+#ifndef ANDROID_ALLOC_TAG_H
+#define ANDROID_ALLOC_TAG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+    // 标签 id，0 表示未打标签
+    typedef uint32_t alloc_tag_t;
+
+    // 最多支持的标签数（包括 0 号 "untagged"）
+    enum {
+        ALLOC_TAG_MAX = 32
+    };
+
+    /**
+     * 单个标签的统计快照
+     */
+    struct AllocTagStats {
+        const char *name;       // 标签名
+        int64_t liveBytes;      // 存活字节数
+        int64_t peakBytes;      // 峰值字节数（见文件头说明）
+        uint64_t allocCount;    // 分配次数
+        uint64_t freeCount;     // 释放次数
+    };
+
+    /**
+     * 登记标签名，返回 id（同名返回同一 id；标签数超出上限时返回 0）
+     */
+    alloc_tag_t allocTagRegister(const char *name);
+
+    /**
+     * 当前线程的标签 id
+     */
+    alloc_tag_t allocTagCurrent();
+
+    /**
+     * 记录一次分配 / 释放 / 调整大小
+     */
+    void allocTagRecordAlloc(alloc_tag_t tag, size_t bytes);
+
+    void allocTagRecordFree(alloc_tag_t tag, size_t bytes);
+
+    void allocTagRecordResize(alloc_tag_t tag, size_t oldBytes, size_t newBytes);
+
+    /**
+     * 合并所有线程的计数器，输出有过分配的标签
+     *
+     * @return 写入 out 的条目数
+     */
+    size_t allocTagSnapshot(AllocTagStats *out, size_t maxCount);
+
+    /**
+     * 以文本形式输出快照，每个标签一行：
+     *   name live=<bytes> peak=<bytes> allocs=<n> frees=<n>
+     *
+     * @return 写入的字符数（不含结尾 NUL）
+     */
+    size_t allocTagDump(char *buffer, size_t bufferSize);
+
+    /**
+     * 标签作用域：构造时设置当前线程的标签，析构时恢复
+     */
+    class AllocTagScope {
+    public:
+        explicit AllocTagScope(alloc_tag_t tag);
+
+        explicit AllocTagScope(const char *name);
+
+        ~AllocTagScope();
+
+    private:
+        AllocTagScope(const AllocTagScope &);
+
+        AllocTagScope &operator=(const AllocTagScope &);
+
+        alloc_tag_t mPrevious;
+    };
+
+}; // namespace android
+
+#define ALLOC_TAG_CONCAT_INNER(a, b) a##b
+#define ALLOC_TAG_CONCAT(a, b) ALLOC_TAG_CONCAT_INNER(a, b)
+
+/**
+ * 在当前作用域设置标签，标签 id 在首次执行时登记并缓存
+ */
+#define ALLOC_TAG_SCOPE(name) \
+    static const android::alloc_tag_t ALLOC_TAG_CONCAT(_allocTagId, __LINE__) = \
+            android::allocTagRegister(name); \
+    android::AllocTagScope ALLOC_TAG_CONCAT(_allocTagScope, __LINE__)( \
+            ALLOC_TAG_CONCAT(_allocTagId, __LINE__))
+
+#endif // ANDROID_ALLOC_TAG_H
@@ -31,6 +31,7 @@
 #define LOG_TAG "sharedbuffer"
 
 #include "SharedBuffer.h"
+#include "AllocTag.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -52,12 +53,16 @@ namespace android {
             // The following is OK on Android-supported platforms.
             sb->mRefs.store(1, std::memory_order_relaxed);
             sb->mSize = size;
+            // mReserved[0] 保存分配标签，释放时记到同一标签上
+            sb->mReserved[0] = allocTagCurrent();
+            allocTagRecordAlloc(sb->mReserved[0], sizeof(SharedBuffer) + size);
         }
         return sb;
     }
 
 
     void SharedBuffer::dealloc(const SharedBuffer *released) {
+        allocTagRecordFree(released->mReserved[0], sizeof(SharedBuffer) + released->mSize);
         free(const_cast<SharedBuffer *>(released));
     }
 
@@ -84,6 +89,7 @@ namespace android {
 
             buf = (SharedBuffer *) realloc(buf, sizeof(SharedBuffer) + newSize);
             if (buf != NULL) {
+                allocTagRecordResize(buf->mReserved[0], buf->mSize, newSize);
                 buf->mSize = newSize;
                 return buf;
             }
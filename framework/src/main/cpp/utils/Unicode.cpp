@@ -541,6 +541,49 @@ static inline uint32_t utf8_to_utf32_codepoint(const uint8_t *src, size_t length
     //printf("Char at %p: len=%d, utf-16=%p\n", src, length, (void*)result);
 }
 
+// ==================== ASCII 快速路径 ====================
+
+// 8 字节中任一字节最高位为 1 即含非 ASCII
+static const uint64_t kAsciiHighBits = 0x8080808080808080ULL;
+
+/**
+ * 返回 src 开头连续 ASCII 字节数（最多 len），按 8 字节整字检查
+ */
+static inline size_t utf8_ascii_prefix_len(const uint8_t *src, size_t len) {
+    size_t i = 0;
+    while (i + 8 <= len) {
+        uint64_t word;
+        memcpy(&word, src + i, sizeof(word));
+        if (word & kAsciiHighBits) break;
+        i += 8;
+    }
+    while (i < len && src[i] < 0x80) i++;
+    return i;
+}
+
+/**
+ * 把 src 开头的连续 ASCII 字节展宽写入 dst（最多 len 个），返回处理的字节数
+ *
+ * 整字检查通过后逐字节展宽，循环体固定 8 次，编译器会向量化
+ */
+static inline size_t utf8_ascii_widen(const uint8_t *src, size_t len, Char16 *dst) {
+    size_t i = 0;
+    while (i + 8 <= len) {
+        uint64_t word;
+        memcpy(&word, src + i, sizeof(word));
+        if (word & kAsciiHighBits) break;
+        for (size_t k = 0; k < 8; k++) {
+            dst[i + k] = src[i + k];
+        }
+        i += 8;
+    }
+    while (i < len && src[i] < 0x80) {
+        dst[i] = src[i];
+        i++;
+    }
+    return i;
+}
+
 ssize_t utf8_to_utf16_length(const uint8_t *u8str, size_t u8len, bool overreadIsFatal) {
     const uint8_t *const u8end = u8str + u8len;
     const uint8_t *u8cur = u8str;
@@ -548,6 +591,12 @@ ssize_t utf8_to_utf16_length(const uint8_t *u8str, size_t u8len, bool overreadIs
     /* Validate that the UTF-8 is the correct len */
     size_t u16measuredLen = 0;
     while (u8cur < u8end) {
+        if (*u8cur < 0x80) {
+            size_t ascii = utf8_ascii_prefix_len(u8cur, u8end - u8cur);
+            u16measuredLen += ascii;
+            u8cur += ascii;
+            continue;
+        }
         u16measuredLen++;
         int u8charLen = utf8_codepoint_len(*u8cur);
         // Malformed utf8, some characters are beyond the end.
@@ -601,6 +650,14 @@ Char16 *utf8_to_utf16_no_null_terminator(
     Char16 *u16cur = dst;
 
     while (u8cur < u8end && u16cur < u16end) {
+        if (*u8cur < 0x80) {
+            size_t n = (size_t) (u8end - u8cur);
+            if (n > (size_t) (u16end - u16cur)) n = u16end - u16cur;
+            size_t ascii = utf8_ascii_widen(u8cur, n, u16cur);
+            u8cur += ascii;
+            u16cur += ascii;
+            continue;
+        }
         size_t u8len = utf8_codepoint_len(*u8cur);
         uint32_t codepoint = utf8_to_utf32_codepoint(u8cur, u8len);
 
@@ -624,4 +681,106 @@ Char16 *utf8_to_utf16_no_null_terminator(
     return u16cur;
 }
 
+// ==================== 流式 UTF-8 解码 ====================
+
+static const Char16 kReplacementChar = 0xFFFD;
+
+static inline void utf8_stream_reset(utf8_stream_t *state) {
+    state->codepoint = 0;
+    state->bytes_needed = 0;
+    state->bytes_seen = 0;
+    state->lower = 0x80;
+    state->upper = 0xBF;
+}
+
+void utf8_stream_init(utf8_stream_t *state) {
+    utf8_stream_reset(state);
+}
+
+size_t utf8_stream_decode(utf8_stream_t *state, const uint8_t *src, size_t srcLen,
+                          size_t *srcConsumed, Char16 *dst, size_t dstLen) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < srcLen) {
+        const uint8_t byte = src[in];
+
+        if (state->bytes_needed == 0) {
+            if (byte < 0x80) {
+                size_t n = srcLen - in;
+                if (n > dstLen - out) n = dstLen - out;
+                if (n == 0) break;
+                size_t ascii = utf8_ascii_widen(src + in, n, dst + out);
+                in += ascii;
+                out += ascii;
+                continue;
+            }
+            // 非 ASCII 最多产生两个 UTF-16 单元，剩余空间不足时先返回
+            if (dstLen - out < 2) break;
+            in++;
+            if (byte >= 0xC2 && byte <= 0xDF) {
+                state->bytes_needed = 1;
+                state->codepoint = byte & 0x1F;
+            } else if (byte >= 0xE0 && byte <= 0xEF) {
+                if (byte == 0xE0) state->lower = 0xA0;       // 排除超长编码
+                if (byte == 0xED) state->upper = 0x9F;       // 排除代理区 D800-DFFF
+                state->bytes_needed = 2;
+                state->codepoint = byte & 0x0F;
+            } else if (byte >= 0xF0 && byte <= 0xF4) {
+                if (byte == 0xF0) state->lower = 0x90;       // 排除超长编码
+                if (byte == 0xF4) state->upper = 0x8F;       // 不超过 U+10FFFF
+                state->bytes_needed = 3;
+                state->codepoint = byte & 0x07;
+            } else {
+                // 孤立的后续字节或 C0/C1/F5-FF
+                dst[out++] = kReplacementChar;
+            }
+            continue;
+        }
+
+        if (dstLen - out < 2) break;
+        if (byte < state->lower || byte > state->upper) {
+            // 序列被截断：已读部分替换为 U+FFFD，当前字节不消耗，作为新序列的开头重新处理
+            utf8_stream_reset(state);
+            dst[out++] = kReplacementChar;
+            continue;
+        }
+        in++;
+        state->lower = 0x80;
+        state->upper = 0xBF;
+        state->codepoint = (state->codepoint << 6) | (byte & 0x3F);
+        if (++state->bytes_seen < state->bytes_needed) {
+            continue;
+        }
+
+        uint32_t codepoint = state->codepoint;
+        utf8_stream_reset(state);
+        if (codepoint <= 0xFFFF) {
+            dst[out++] = (Char16) codepoint;
+        } else {
+            codepoint -= 0x10000;
+            dst[out++] = (Char16) ((codepoint >> 10) + 0xD800);
+            dst[out++] = (Char16) ((codepoint & 0x3FF) + 0xDC00);
+        }
+    }
+
+    if (srcConsumed != NULL) {
+        *srcConsumed = in;
+    }
+    return out;
+}
+
+bool utf8_stream_pending(const utf8_stream_t *state) {
+    return state->bytes_needed != 0;
+}
+
+size_t utf8_stream_finish(utf8_stream_t *state, Char16 *dst, size_t dstLen) {
+    if (state->bytes_needed == 0 || dstLen == 0) {
+        return 0;
+    }
+    utf8_stream_reset(state);
+    dst[0] = kReplacementChar;
+    return 1;
+}
+
 }
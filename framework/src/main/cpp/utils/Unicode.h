@@ -187,6 +187,54 @@ Char16 *utf8_to_utf16_no_null_terminator(
 Char16 *utf8_to_utf16(
         const uint8_t *src, size_t srcLen, Char16 *dst, size_t dstLen);
 
+// ==================== 流式 UTF-8 解码 ====================
+
+/**
+ * 流式 UTF-8 → UTF-16 解码状态
+ *
+ * Socket 每次读取的数据块可能在任意字节处截断一个字符，上面的整块转换函数会把
+ * 截断的尾部当作非法数据。流式解码把未完成的字符保存在状态中，与下一块拼接。
+ *
+ * 非法序列（超长编码、代理区、超出 U+10FFFF、截断的序列）按最大子序列替换为
+ * U+FFFD，不会失败，也不会越界读取。
+ */
+typedef struct {
+    uint32_t codepoint;     // 已解码的高位
+    uint8_t bytes_needed;   // 当前字符还需要的后续字节总数，0 表示处于字符边界
+    uint8_t bytes_seen;     // 已读取的后续字节数
+    uint8_t lower;          // 下一个后续字节的合法下界
+    uint8_t upper;          // 下一个后续字节的合法上界
+} utf8_stream_t;
+
+/**
+ * 初始化流式解码状态
+ */
+void utf8_stream_init(utf8_stream_t *state);
+
+/**
+ * 解码一个数据块，不写入 NUL 结尾
+ *
+ * dst 剩余空间不足时提前返回，*srcConsumed 之后的字节需要再次传入。
+ * dstLen >= 2 时每次调用至少处理一个字节；dstLen >= srcLen + 2 时一次处理完整个数据块。
+ *
+ * @param srcConsumed 输出已处理的字节数，可为 NULL（此时调用方需保证 dstLen >= srcLen + 2）
+ * @return 写入 dst 的 UTF-16 单元数
+ */
+size_t utf8_stream_decode(utf8_stream_t *state, const uint8_t *src, size_t srcLen,
+                          size_t *srcConsumed, Char16 *dst, size_t dstLen);
+
+/**
+ * 是否有未完成的字符（处于字符中间）
+ */
+bool utf8_stream_pending(const utf8_stream_t *state);
+
+/**
+ * 结束解码：未完成的字符输出为一个 U+FFFD，并重置状态
+ *
+ * @return 写入的单元数（0 或 1）
+ */
+size_t utf8_stream_finish(utf8_stream_t *state, Char16 *dst, size_t dstLen);
+
 }
 
 #endif
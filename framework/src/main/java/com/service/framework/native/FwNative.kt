@@ -10,6 +10,7 @@
  *   - Socket 保活通道（进程间心跳通信）
  *   - 系统信息获取（内存、进程数等）
  *   - 无法强制停止策略（文件锁监控）
+ *   - Native 事件回调（Socket 断开等，批量投递）
  *
  * 安全研究要点：
  *   - Native 层可绕过部分 Java 层限制
@@ -24,6 +25,7 @@ package com.service.framework.native
 
 import android.content.Context
 import com.service.framework.util.FwLog
+import java.util.concurrent.CopyOnWriteArrayList
 
 /**
  * Native 层保活接口
@@ -214,6 +216,36 @@ object FwNative {
     @JvmStatic
     external fun getProcessCount(): Int
 
+    /** /proc 采样缓存的指标，与 fw_proc_cache.h 中的 FW_PROC_METRIC_* 一致 */
+    const val PROC_METRIC_MEMORY = 0
+    const val PROC_METRIC_STATUS = 1
+    const val PROC_METRIC_OOM_ADJ = 2
+    const val PROC_METRIC_PROCESS_COUNT = 3
+
+    /**
+     * 设置 /proc 采样缓存的有效期
+     *
+     * getMemoryInfo / getProcessStatus / getOomAdj / getProcessCount 在有效期内
+     * 直接返回上一次的结果，并发调用只读取一次 /proc。
+     * 缓存默认不开启（每次都读取 /proc），首次调用本方法时加载缓存模块，
+     * 其余指标使用默认有效期：内存 500ms、进程状态 200ms、OOM adj 1000ms、进程数 2000ms
+     *
+     * @param metric PROC_METRIC_* 之一
+     * @param ttlMs 有效期（毫秒），0 表示每次都读取
+     * @return 参数无效或缓存模块加载失败返回 false
+     */
+    @JvmStatic
+    external fun setProcCacheTtl(metric: Int, ttlMs: Int): Boolean
+
+    /**
+     * 获取 /proc 采样缓存统计
+     *
+     * 每项指标一行：`<metric> ttl=<ms> hits=<n> loads=<n> waits=<n> hit_rate=<%> age=<ms> max_served_age=<ms>`；
+     * 未开启缓存时为空字符串
+     */
+    @JvmStatic
+    external fun getProcCacheStats(): String
+
     // ==================== Socket 通信 ====================
 
     /**
@@ -252,6 +284,91 @@ object FwNative {
     @JvmStatic
     external fun sendHeartbeat(socketFd: Int): Boolean
 
+    // ==================== Native 事件 ====================
+
+    /** 心跳客户端与服务端的连接断开 */
+    const val EVENT_SOCKET_CONNECTION_LOST = 1
+
+    /** Socket 服务端接受了新客户端 */
+    const val EVENT_SOCKET_CLIENT_CONNECTED = 2
+
+    /** Socket 服务端的客户端断开 */
+    const val EVENT_SOCKET_CLIENT_DISCONNECTED = 3
+
+    /** 守护子进程已创建 */
+    const val EVENT_DAEMON_STARTED = 4
+
+    /** 请求停止守护进程 */
+    const val EVENT_DAEMON_STOP_REQUESTED = 5
+
+    /** MediaRouteProviderService 启动 */
+    const val EVENT_MEDIAROUTE_STARTED = 6
+
+    /** MediaRouteProviderService 停止 */
+    const val EVENT_MEDIAROUTE_STOPPED = 7
+
+    /** MediaRoute2ProviderService 启动 */
+    const val EVENT_MEDIAROUTE2_STARTED = 8
+
+    /** MediaRoute2ProviderService 停止 */
+    const val EVENT_MEDIAROUTE2_STOPPED = 9
+
+    /**
+     * Native 事件监听器
+     *
+     * 在 Native 分发线程上回调，同一突发中的事件合并为一批
+     */
+    fun interface NativeEventListener {
+        /**
+         * @param codes 事件码（EVENT_*）
+         * @param timestampsMs 事件时间，与 SystemClock.elapsedRealtime() 同一时钟
+         */
+        fun onNativeEvents(codes: IntArray, timestampsMs: LongArray)
+    }
+
+    private val eventListeners = CopyOnWriteArrayList<NativeEventListener>()
+
+    /**
+     * 注册 Native 事件监听器
+     *
+     * 注册时订阅 Native 事件总线（首次订阅时加载 libfw_event_bus.so），
+     * 没有监听器的进程不会加载事件总线
+     */
+    fun addNativeEventListener(listener: NativeEventListener) {
+        eventListeners.addIfAbsent(listener)
+        if (isLoaded && !subscribeNativeEvents()) {
+            FwLog.w("FwNative: 订阅 Native 事件失败")
+        }
+    }
+
+    /**
+     * 移除 Native 事件监听器
+     */
+    fun removeNativeEventListener(listener: NativeEventListener) {
+        eventListeners.remove(listener)
+    }
+
+    /**
+     * 订阅 Native 事件总线，事件经 onNativeEvents 投递（重复调用无副作用）
+     */
+    @JvmStatic
+    private external fun subscribeNativeEvents(): Boolean
+
+    /**
+     * Native 层批量投递事件的入口（由 fw_jni_dispatch.cpp 调用，勿混淆）
+     */
+    @JvmStatic
+    fun onNativeEvents(codes: IntArray, timestampsMs: LongArray) {
+        FwLog.d("FwNative: 收到 ${codes.size} 个 Native 事件")
+        for (listener in eventListeners) {
+            try {
+                listener.onNativeEvents(codes, timestampsMs)
+            } catch (e: Exception) {
+                FwLog.e("FwNative: Native 事件监听器异常 - ${e.message}", e)
+            }
+        }
+    }
+
     // ==================== 辅助方法 ====================
 
     /**
@@ -405,4 +522,210 @@ object FwNative {
         serviceName: String,
         sdkVersion: Int
     )
+
+    // ==================== 内存诊断 ====================
+
+    /**
+     * 获取按调用路径标签统计的 Native 内存分配（Parcel / SharedBuffer）
+     *
+     * 每个标签一行：`name live=<bytes> peak=<bytes> allocs=<n> frees=<n>`
+     * Binder 模块未加载时返回空字符串
+     */
+    @JvmStatic
+    external fun getAllocTagStats(): String
+
+    /**
+     * 获取 Binder 直接调用等待响应超时的累计次数
+     *
+     * 超时的调用返回 TIMED_OUT，迟到的回复在同一线程下一次调用前释放
+     * Binder 模块未加载时返回 0
+     */
+    @JvmStatic
+    external fun getBinderTimeoutCount(): Long
+
+    /**
+     * 构造 startService 的 Binder 事务数据（与守护进程发送给 AMS 的内容一致）
+     *
+     * 返回的 [FwParcelBuffer] 直接引用 Native Parcel 的数据区，通过 [FwParcelBuffer.withBuffer]
+     * 在作用域内读取，使用完毕后需要 close
+     *
+     * @param packageName 包名
+     * @param serviceName 服务类全名
+     * @param sdkVersion 按该 SDK 版本的接口布局构造
+     * @return Parcel 数据视图，失败返回 null
+     */
+    @JvmStatic
+    external fun buildStartServiceParcel(
+        packageName: String,
+        serviceName: String,
+        sdkVersion: Int
+    ): FwParcelBuffer?
+
+    /**
+     * 释放 [FwParcelBuffer] 持有的 Native Parcel（仅供 FwParcelBuffer 内部调用）
+     */
+    @JvmStatic
+    external fun releaseParcelBuffer(handle: Long)
+
+    /**
+     * 导出令牌化日志到文件
+     *
+     * 仅在 Native 以 -DFW_TOKENIZED_LOG=ON 构建时可用，此时 Native 日志不进入 logcat，
+     * 需要导出后在主机上用 tools/fw_tokenlog.py 还原为文本
+     *
+     * @param path 输出文件路径（应用私有目录）
+     * @return 是否成功，普通构建返回 false
+     */
+    @JvmStatic
+    external fun dumpTokenizedLog(path: String): Boolean
+
+    // ==================== 线程诊断 ====================
+
+    /**
+     * 获取 Native 线程报告
+     *
+     * 前几行为检查发现的问题（未登记 / 泄漏 / 线程数增长 / 失效登记），
+     * 之后每个登记的线程一行：`name role=<role> tid=<tid> stack=<KB>KB age=<s>s`，
+     * 末行为汇总 `registered=<n> tasks=<n> created=<n> exited=<n> untracked=<n>`
+     */
+    @JvmStatic
+    external fun getNativeThreadReport(): String
+
+    /**
+     * 启动 Native 线程周期检查，发现问题时输出警告日志
+     *
+     * @param intervalMs 检查间隔（毫秒），重复调用只更新间隔
+     * @return 是否成功
+     */
+    @JvmStatic
+    external fun startNativeThreadMonitor(intervalMs: Int): Boolean
+
+    /**
+     * 开始 Native CPU 采样（默认关闭，可只对一部分设备开启）
+     *
+     * 只对开始时已存在的线程生效，样本数达到 maxSamples 后不再记录
+     *
+     * @param frequencyHz 每个线程每 CPU 秒的采样次数（1-1000）
+     * @param maxSamples 样本缓冲区容量
+     * @param maxSamplesPerSec 全进程每秒样本上限，0 表示不限制
+     * @param allThreads false 时只采样 Native 层创建的 "fw_" 线程
+     * @return 是否成功，已在采样时返回 false
+     */
+    @JvmStatic
+    external fun startNativeProfiler(
+        frequencyHz: Int,
+        maxSamples: Int,
+        maxSamplesPerSec: Int,
+        allThreads: Boolean
+    ): Boolean
+
+    /**
+     * 停止 Native CPU 采样并写出 folded 格式结果
+     *
+     * 每行 `线程;根帧;...;叶帧 次数`，帧为 `模块+0x偏移`，
+     * 在主机端用 tools/fw_profile.py 符号化后生成火焰图
+     *
+     * @param path 输出文件路径（应用私有目录）
+     * @return 样本数，从未开启过采样或写文件失败返回 -1
+     */
+    @JvmStatic
+    external fun stopNativeProfiler(path: String): Int
+
+    /**
+     * 开启 Native 诊断功能（循环卡顿监控、唤醒归因、跨进程状态板）
+     *
+     * 诊断代码位于单独的 libfw_diag.so，默认不加载；未开启时相关报告为空字符串，
+     * 状态板相关方法为空操作。开启前已启动的 Socket 服务、守护进程循环不会被统计，
+     * 应在启动它们之前调用
+     *
+     * @return 诊断模块是否已加载
+     */
+    @JvmStatic
+    external fun enableNativeDiagnostics(): Boolean
+
+    /**
+     * 启动 Native 循环卡顿看门狗
+     *
+     * Socket 服务、Binder 等待回复等循环的单次迭代超过阈值时，
+     * 采集该线程的调用栈并输出警告日志
+     *
+     * 诊断功能未开启时先开启（见 enableNativeDiagnostics）
+     *
+     * @param tickMs 检查间隔（毫秒），<= 0 使用默认值 100
+     * @return 是否成功
+     */
+    @JvmStatic
+    external fun startNativeLoopWatchdog(tickMs: Int): Boolean
+
+    /**
+     * 获取 Native 循环统计
+     *
+     * 每个循环一行：`name tid=<tid> iterations=<n> stalls=<n> max=<ms>ms hist=<...>`，
+     * 有卡顿时下一行为最近一次卡顿的调用栈，末行为看门狗唤醒偏差；
+     * hist 按 2 的幂分桶（<1ms, 1ms, 2ms, 4ms ...）
+     */
+    @JvmStatic
+    external fun getNativeLoopReport(): String
+
+    // ==================== 进程状态板 ====================
+
+    /** 健康状态，与 fw_status_board.h 中的 FW_STATUS_* 一致 */
+    const val HEALTH_UNKNOWN = 0
+    const val HEALTH_OK = 1
+    const val HEALTH_DEGRADED = 2
+    const val HEALTH_FAILING = 3
+
+    /** 计量值下标 */
+    const val GAUGE_RSS_KB = 0
+    const val GAUGE_THREADS = 1
+    const val GAUGE_STALLS = 2
+    const val GAUGE_USER = 3
+
+    /**
+     * 更新本进程在状态板中的健康状态
+     *
+     * 状态板由启动 Socket 服务的进程创建，心跳客户端和守护进程自动加入；
+     * 需要各进程在启动 Socket 服务 / 心跳客户端之前开启诊断功能（enableNativeDiagnostics），
+     * 本进程未加入状态板时为空操作
+     */
+    @JvmStatic
+    external fun setNativeHealth(status: Int)
+
+    /**
+     * 更新本进程在状态板中的计量值
+     *
+     * @param index GAUGE_* 之一
+     */
+    @JvmStatic
+    external fun setNativeGauge(index: Int, value: Long)
+
+    /**
+     * 读取状态板中所有进程的状态（只读共享内存，不经过 IPC）
+     *
+     * 每个进程一行：`<slot> <name> pid=<pid> status=<status> heartbeat=<n> age=<ms>ms gauges=<...>`
+     */
+    @JvmStatic
+    external fun getNativeStatusBoard(): String
+
+    /**
+     * 获取 Native 事件总线统计
+     *
+     * 首行：`published=<n> lanes=<发布线程数> no_lane=<n>`，
+     * 之后每个订阅者一行：`<name> mask=<类型位> delivered=<n> dropped=<n>`；
+     * 事件总线在第一个订阅者订阅时才加载，此前为空字符串
+     */
+    @JvmStatic
+    external fun getNativeEventBusReport(): String
+
+    /**
+     * 获取 Native 唤醒归因统计
+     *
+     * 每个阻塞调用点所属组件一行：
+     * `<component> wakeups=<n> per_min=<x> idle_per_min=<x> timeouts=<n> events=<n> eintr=<n> errors=<n> avg_block=<ms>ms cpu_per_wake=<us>us`，
+     * 之后是该组件线程的 schedstat：`  tid=<tid> run=<ms>ms runq_wait=<ms>ms slices=<n>`，
+     * 末行 `process threads=<n> slices=<n> attributed_wakeups=<n>`。
+     * idle_per_min 为超时唤醒（没有处理任何事件）的频率。
+     */
+    @JvmStatic
+    external fun getNativeWakeupReport(): String
 }
@@ -0,0 +1,136 @@
+/**
+ * ============================================================================
+ * FwParcelBuffer.kt - Native Parcel 数据区的零拷贝视图
+ * ============================================================================
+ *
+ * 功能简介：
+ *   持有一个 Native Parcel，[withBuffer] 在作用域内提供直接指向其数据区的只读
+ *   DirectByteBuffer，读取大块数据时不经过 jbyteArray 复制。
+ *
+ * 生命周期：
+ *   - 持有期间 Native 侧不会重新分配数据区
+ *   - 调用 [close]（推荐配合 use {}）立即释放 Native Parcel
+ *   - 忘记关闭时，对象被 GC 回收后由后台清理线程释放
+ *     （minSdk 24 不能使用 java.lang.ref.Cleaner，使用 PhantomReference 实现）
+ *   - ByteBuffer 不持有本对象的引用（DirectByteBuffer 不能扩展），只在 [withBuffer]
+ *     的 block 内有效：保存到外部后，本对象一旦被回收或关闭，其指向的内存即被释放
+ *
+ * 使用方式：
+ * ```kotlin
+ * FwNative.buildStartServiceParcel(packageName, serviceName, Build.VERSION.SDK_INT)?.use { parcel ->
+ *     val headerWord = parcel.withBuffer { it.getInt(0) }
+ * }
+ * ```
+ *
+ * @author Pangu-Immortal
+ * @github https://github.com/Pangu-Immortal/KeepLiveService
+ * @since 2.3.0
+ */
+package com.service.framework.native
+
+import java.lang.ref.PhantomReference
+import java.lang.ref.ReferenceQueue
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.util.Collections
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Native Parcel 数据区视图（由 Native 代码构造）
+ */
+class FwParcelBuffer private constructor(handle: Long, buffer: ByteBuffer) : AutoCloseable {
+
+    private val state = State(handle)
+    private val rawBuffer: ByteBuffer = buffer.asReadOnlyBuffer().order(ByteOrder.LITTLE_ENDIAN)
+
+    // withBuffer 结束时读取，保证本对象在 block 执行期间可达（minSdk 24 没有 reachabilityFence）
+    @Volatile
+    private var reachable = true
+
+    init {
+        Releaser.register(this, state)
+    }
+
+    /**
+     * 在 [block] 内访问 Parcel 数据区（只读、小端，与 Parcel 的写入字节序一致）
+     *
+     * 每次调用得到独立的 position / limit。ByteBuffer 不能在 block 之外保存或使用，
+     * 也不能与 [close] 并发调用。关闭后调用抛出 IllegalStateException
+     */
+    fun <R> withBuffer(block: (ByteBuffer) -> R): R {
+        check(state.handle.get() != 0L) { "FwParcelBuffer 已关闭" }
+        try {
+            return block(rawBuffer.duplicate().order(ByteOrder.LITTLE_ENDIAN))
+        } finally {
+            check(reachable)
+        }
+    }
+
+    /**
+     * 数据字节数
+     */
+    val size: Int
+        get() = rawBuffer.capacity()
+
+    /**
+     * 是否已关闭
+     */
+    val isClosed: Boolean
+        get() = state.handle.get() == 0L
+
+    override fun close() {
+        state.release()
+    }
+
+    /**
+     * Native 句柄，只释放一次
+     */
+    private class State(handle: Long) {
+        val handle = AtomicLong(handle)
+
+        fun release() {
+            val h = handle.getAndSet(0L)
+            if (h != 0L) {
+                FwNative.releaseParcelBuffer(h)
+            }
+        }
+    }
+
+    /**
+     * 回收未关闭的 FwParcelBuffer
+     */
+    private class Cleanup(
+        owner: FwParcelBuffer,
+        queue: ReferenceQueue<FwParcelBuffer>,
+        val state: State
+    ) : PhantomReference<FwParcelBuffer>(owner, queue)
+
+    private object Releaser {
+        private val queue = ReferenceQueue<FwParcelBuffer>()
+
+        // 保持 PhantomReference 本身可达，直到其入队
+        private val pending: MutableSet<Cleanup> = Collections.synchronizedSet(HashSet())
+
+        private val thread: Thread by lazy {
+            Thread({
+                while (true) {
+                    try {
+                        val ref = queue.remove() as Cleanup
+                        pending.remove(ref)
+                        ref.state.release()
+                    } catch (_: InterruptedException) {
+                        // 守护线程，忽略中断
+                    }
+                }
+            }, "FwParcelBufferCleaner").apply {
+                isDaemon = true
+                start()
+            }
+        }
+
+        fun register(owner: FwParcelBuffer, state: State) {
+            thread
+            pending.add(Cleanup(owner, queue, state))
+        }
+    }
+}